@@ -52,6 +52,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <errno.h>
+#include <time.h>
 
 #include <ctype.h>
 #include <assert.h>
@@ -106,6 +107,7 @@ static int parse_location (char *e);
 static int parse_comment (char *e);
 static int expand_macro (char *e);
 static void raw_tt_data_to_app (int chan, char *msg);
+static void ttloc_index_build (void);
 static int find_ttloc_match (char *e, char *xstr, char *ystr, char *zstr, char *bstr, char *dstr, size_t valstrsize);
 
 #if TT_MAIN
@@ -183,6 +185,7 @@ void aprs_tt_init (struct tt_config_s *p)
 	  msg_str[c][0] = '\0';
 	}
 
+	ttloc_index_build ();
 }
 
 
@@ -435,7 +438,7 @@ void aprs_tt_sequence (int chan, char *msg)
 	  return;
 	}
 
-	tq_append (chan, TQ_PRIO_0_HI, pp);
+	tq_append (chan, TQ_PRIO_0_HI, TQ_SRC_APRSTT, pp);
 
 #endif  /* ifndef TT_MAIN */
 
@@ -1403,6 +1406,129 @@ static int parse_location (char *e)
 } /* end parse_location */
 
 
+/*------------------------------------------------------------------
+ *
+ * Name:        ttloc_index_build
+ *
+ * Purpose:     Build an index for quickly finding the location or
+ *		macro pattern which matches a received entry.
+ *
+ * Inputs:      tt_config.ttloc_ptr, tt_config.ttloc_len
+ *
+ * Description:	Some sites have large tables of points or grids so
+ *		trying every pattern, in order, can be slow.
+ *
+ *		Only patterns of the same length can match so they are
+ *		grouped by length.  Within each group, they are sorted by
+ *		the fixed characters before the first x, y, z, b, or d.
+ *		Those with the same prefix are kept in their original
+ *		order so the first one in the configuration file still wins.
+ *
+ *		There are usually only a few different prefix lengths so
+ *		a binary search for each quickly finds the candidates.
+ *
+ *----------------------------------------------------------------*/
+
+#define TTLOC_MAX_PAT ((int)sizeof(((struct ttloc_s *)0)->pattern))
+
+#define TTLOC_FIXED "B0123456789ACD"	/* Must match exactly. */
+#define TTLOC_VAR "xyzbd"		/* Any digit, which is extracted. */
+
+struct ttloc_ent_s {
+	int ipat;			/* Index into tt_config.ttloc_ptr. */
+	int plen;			/* Number of fixed characters at beginning. */
+};
+
+static struct {
+	int count;
+	struct ttloc_ent_s *ent;	/* Sorted by plen, prefix, then ipat. */
+	int num_plen;			/* Number of different prefix lengths. */
+	int plen[TTLOC_MAX_PAT];	/* Those prefix lengths. */
+} ttloc_index[TTLOC_MAX_PAT];		/* Subscript is pattern length. */
+
+
+static int ttloc_ent_compare (const void *a, const void *b)
+{
+	const struct ttloc_ent_s *ea = a;
+	const struct ttloc_ent_s *eb = b;
+	int n;
+
+	if (ea->plen != eb->plen) {
+	  return (ea->plen - eb->plen);
+	}
+	n = memcmp (tt_config.ttloc_ptr[ea->ipat].pattern, tt_config.ttloc_ptr[eb->ipat].pattern, ea->plen);
+	if (n != 0) {
+	  return (n);
+	}
+	return (ea->ipat - eb->ipat);
+}
+
+
+static void ttloc_index_build (void)
+{
+	int len, ipat, k;
+
+	for (len = 0; len < TTLOC_MAX_PAT; len++) {
+	  if (ttloc_index[len].ent != NULL) {
+	    free (ttloc_index[len].ent);
+	  }
+	}
+	memset (ttloc_index, 0, sizeof(ttloc_index));
+
+/*
+ * First count how many of each length so we know how much to allocate.
+ */
+	for (ipat = 0; ipat < tt_config.ttloc_len; ipat++) {
+	  char *pat = tt_config.ttloc_ptr[ipat].pattern;
+
+	  len = strlen(pat);
+	  if (len > 0 && len < TTLOC_MAX_PAT && strspn(pat, TTLOC_FIXED TTLOC_VAR) == len) {
+	    ttloc_index[len].count++;
+	  }
+	  else {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Touch tone location or macro pattern \"%s\" is not valid.\n", pat);
+	  }
+	}
+
+	for (len = 0; len < TTLOC_MAX_PAT; len++) {
+	  if (ttloc_index[len].count > 0) {
+	    ttloc_index[len].ent = malloc (ttloc_index[len].count * sizeof(struct ttloc_ent_s));
+	    assert (ttloc_index[len].ent != NULL);
+	    ttloc_index[len].count = 0;
+	  }
+	}
+
+	for (ipat = 0; ipat < tt_config.ttloc_len; ipat++) {
+	  char *pat = tt_config.ttloc_ptr[ipat].pattern;
+	  struct ttloc_ent_s *ent;
+
+	  len = strlen(pat);
+	  if (len > 0 && len < TTLOC_MAX_PAT && strspn(pat, TTLOC_FIXED TTLOC_VAR) == len) {
+	    ent = &(ttloc_index[len].ent[ttloc_index[len].count++]);
+	    ent->ipat = ipat;
+	    ent->plen = strspn(pat, TTLOC_FIXED);
+	  }
+	}
+
+/*
+ * Sort each group and make a list of the different prefix lengths.
+ */
+	for (len = 0; len < TTLOC_MAX_PAT; len++) {
+	  if (ttloc_index[len].count > 0) {
+	    qsort (ttloc_index[len].ent, ttloc_index[len].count, sizeof(struct ttloc_ent_s), ttloc_ent_compare);
+
+	    for (k = 0; k < ttloc_index[len].count; k++) {
+	      if (k == 0 || ttloc_index[len].ent[k].plen != ttloc_index[len].ent[k-1].plen) {
+	        ttloc_index[len].plen[ttloc_index[len].num_plen++] = ttloc_index[len].ent[k].plen;
+	      }
+	    }
+	  }
+	}
+
+} /* end ttloc_index_build */
+
+
 /*------------------------------------------------------------------
  *
  * Name:        find_ttloc_match
@@ -1425,132 +1551,118 @@ static int parse_location (char *e)
  * Returns:     >= 0 for index into table if found.
  *		-1 if not found.
  *
- * Description:	
+ * Description:	Use the index from ttloc_index_build to find the first
+ *		pattern, in configuration file order, which matches.
+ *		Then pick out the digits for x, y, z, b, d positions.
  *
  *----------------------------------------------------------------*/
 
+/*
+ * Compare index entry to the same number of characters at the beginning of e.
+ */
+
+static int ttloc_key_compare (struct ttloc_ent_s *ent, int plen, char *e)
+{
+	if (ent->plen != plen) {
+	  return (ent->plen - plen);
+	}
+	return (memcmp (tt_config.ttloc_ptr[ent->ipat].pattern, e, plen));
+}
+
+
 static int find_ttloc_match (char *e, char *xstr, char *ystr, char *zstr, char *bstr, char *dstr, size_t valstrsize)
 {
-	int ipat;	/* Index into patterns from configuration file */
-	int len;	/* Length of pattern we are trying to match. */
-	int match;
-	char mc;
-	int k;
+	int len;	/* Length of entry and patterns to try. */
+	int found = -1;
+	int j, k;
 
 	// debug dw_printf ("find_ttloc_match: e=%s\n", e);
 
-	for (ipat=0; ipat<tt_config.ttloc_len; ipat++) {
-	  
-	  len = strlen(tt_config.ttloc_ptr[ipat].pattern);
-
-	  if (strlen(e) == len) {
-
-	    match = 1;
-	    strlcpy (xstr, "", valstrsize);
-	    strlcpy (ystr, "", valstrsize);
-	    strlcpy (zstr, "", valstrsize);
-	    strlcpy (bstr, "", valstrsize);
-	    strlcpy (dstr, "", valstrsize);
-
-	    for (k=0; k<len; k++) {
-	      mc = tt_config.ttloc_ptr[ipat].pattern[k];
-	      switch (mc) {
-
-	        case 'B':
-	        case '0':
-	        case '1':
-	        case '2':
-	        case '3':
-	        case '4':
-	        case '5':
-	        case '6':
-	        case '7':
-	        case '8':
-	        case '9':
-	        case 'A':	/* Allow A,C,D after the B? */
-	        case 'C':
-	        case 'D':
-
-		  if (e[k] != mc) {
-		    match = 0;
-		  }
-		  break;
-
-		case 'x':
-		   if (isdigit(e[k])) {
-	             char stemp[2];
-		     stemp[0] = e[k];
-		     stemp[1] = '\0';
-		     strlcat (xstr, stemp, valstrsize);
-		   }
-		   else {
-		     match = 0;
-	           }
-		  break;
-
-		case 'y':
-		   if (isdigit(e[k])) {
-	             char stemp[2];
-		     stemp[0] = e[k];
-		     stemp[1] = '\0';
-		     strlcat (ystr, stemp, valstrsize);
-		   }
-		   else {
-		     match = 0;
-	           }
-		  break;
-
-		case 'z':
-		   if (isdigit(e[k])) {
-	             char stemp[2];
-		     stemp[0] = e[k];
-		     stemp[1] = '\0';
-		     strlcat (zstr, stemp, valstrsize);
-		   }
-		   else {
-		     match = 0;
-	           }
-		  break;
-
-		case 'b':
-		   if (isdigit(e[k])) {
-	             char stemp[2];
-		     stemp[0] = e[k];
-		     stemp[1] = '\0';
-		     strlcat (bstr, stemp, valstrsize);
-		   }
-		   else {
-		     match = 0;
-	           }
-		  break;
-
-		case 'd':
-		   if (isdigit(e[k])) {
-	             char stemp[2];
-		     stemp[0] = e[k];
-		     stemp[1] = '\0';
-		     strlcat (dstr, stemp, valstrsize);
-		   }
-		   else {
-		     match = 0;
-	           }
-		  break;
-
-		default:
-		  dw_printf ("find_ttloc_match: shouldn't be here.\n");
-		  /* Shouldn't be here. */
-		  match = 0;
-		  break;
-
-	      } /* switch */
-	    } /* for k */
-	  
-	    if (match) {
-	      return (ipat);
+	strlcpy (xstr, "", valstrsize);
+	strlcpy (ystr, "", valstrsize);
+	strlcpy (zstr, "", valstrsize);
+	strlcpy (bstr, "", valstrsize);
+	strlcpy (dstr, "", valstrsize);
+
+	len = strlen(e);
+	if (len >= TTLOC_MAX_PAT) {
+	  return (-1);
+	}
+
+	for (j = 0; j < ttloc_index[len].num_plen; j++) {
+	  int plen = ttloc_index[len].plen[j];
+	  int lo = 0;
+	  int hi = ttloc_index[len].count;
+
+/* Find the first one with this prefix, if any. */
+
+	  while (lo < hi) {
+	    int mid = (lo + hi) / 2;
+
+	    if (ttloc_key_compare (&(ttloc_index[len].ent[mid]), plen, e) < 0) {
+	      lo = mid + 1;
 	    }
-	  } /* if strlen */
+	    else {
+	      hi = mid;
+	    }
+	  }
+
+/* Those with the same prefix are in configuration file order. */
+
+	  for (k = lo; k < ttloc_index[len].count && ttloc_key_compare(&(ttloc_index[len].ent[k]), plen, e) == 0; k++) {
+	    int ipat = ttloc_index[len].ent[k].ipat;
+	    char *pat = tt_config.ttloc_ptr[ipat].pattern;
+	    int n;
+
+	    if (found >= 0 && ipat > found) {
+	      break;
+	    }
+
+	    for (n = plen; n < len; n++) {
+	      if (strchr(TTLOC_VAR, pat[n]) != NULL ? ! isdigit(e[n]) : e[n] != pat[n]) {
+	        break;
+	      }
+	    }
+	    if (n == len) {
+	      found = ipat;
+	      break;
+	    }
+	  }
 	}
-	return (-1);
+
+	if (found < 0) {
+	  return (-1);
+	}
+
+/*
+ * Pick out the digits for each of the letters.
+ */
+	char x[TTLOC_MAX_PAT], y[TTLOC_MAX_PAT], z[TTLOC_MAX_PAT], b[TTLOC_MAX_PAT], d[TTLOC_MAX_PAT];
+	int nx = 0, ny = 0, nz = 0, nb = 0, nd = 0;
+
+	for (k = 0; k < len; k++) {
+	  switch (tt_config.ttloc_ptr[found].pattern[k]) {
+	    case 'x':  x[nx++] = e[k];  break;
+	    case 'y':  y[ny++] = e[k];  break;
+	    case 'z':  z[nz++] = e[k];  break;
+	    case 'b':  b[nb++] = e[k];  break;
+	    case 'd':  d[nd++] = e[k];  break;
+	    default:  break;
+	  }
+	}
+	x[nx] = '\0';
+	y[ny] = '\0';
+	z[nz] = '\0';
+	b[nb] = '\0';
+	d[nd] = '\0';
+
+	strlcpy (xstr, x, valstrsize);
+	strlcpy (ystr, y, valstrsize);
+	strlcpy (zstr, z, valstrsize);
+	strlcpy (bstr, b, valstrsize);
+	strlcpy (dstr, d, valstrsize);
+
+	return (found);
 
 } /* end find_ttloc_match */
 
@@ -1980,6 +2092,122 @@ static void check_result (void)
 }
 
 
+/*
+ * Benchmark for location pattern matching with a large table.
+ * Results are compared with the simple method of trying each pattern in order.
+ */
+
+#define BENCH_PATTERNS 5000
+#define BENCH_LOOKUPS 20000
+
+static int linear_ttloc_match (char *e)
+{
+	int ipat, k;
+
+	for (ipat = 0; ipat < tt_config.ttloc_len; ipat++) {
+	  char *pat = tt_config.ttloc_ptr[ipat].pattern;
+
+	  if (strlen(pat) == strlen(e)) {
+	    for (k = 0; pat[k] != '\0'; k++) {
+	      if (strchr("xyzbd", pat[k]) != NULL ? ! isdigit(e[k]) : e[k] != pat[k]) break;
+	    }
+	    if (pat[k] == '\0') {
+	      return (ipat);
+	    }
+	  }
+	}
+	return (-1);
+}
+
+static void ttloc_benchmark (void)
+{
+	static struct ttloc_s bench_config[BENCH_PATTERNS];
+	static char entry[BENCH_LOOKUPS][TTLOC_MAX_PAT];
+	static int expected[BENCH_LOOKUPS];
+	struct tt_config_s save_config = tt_config;
+	char xstr[VALSTRSIZE], ystr[VALSTRSIZE], zstr[VALSTRSIZE], bstr[VALSTRSIZE], dstr[VALSTRSIZE];
+	clock_t start;
+	double linear_time, index_time;
+	int n, k, found = 0;
+
+/*
+ * Mostly individual points, like a large table of trail markers,
+ * then some grids, vectors, and macros.  Some are duplicates.
+ */
+	srand (1);
+	for (n = 0; n < BENCH_PATTERNS; n++) {
+	  struct ttloc_s *p = &(bench_config[n]);
+
+	  memset (p, 0, sizeof(struct ttloc_s));
+	  switch (n % 10) {
+	    default:
+	      p->type = TTLOC_POINT;
+	      snprintf (p->pattern, sizeof(p->pattern), "B%d", rand() % 100000);
+	      break;
+	    case 7:
+	      p->type = TTLOC_GRID;
+	      snprintf (p->pattern, sizeof(p->pattern), "B%02dxxyy", rand() % 100);
+	      break;
+	    case 8:
+	      p->type = TTLOC_VECTOR;
+	      snprintf (p->pattern, sizeof(p->pattern), "B%dbbbddd", rand() % 10);
+	      break;
+	    case 9:
+	      p->type = TTLOC_MACRO;
+	      snprintf (p->pattern, sizeof(p->pattern), "%dxx%dyy", rand() % 1000, rand() % 10);
+	      break;
+	  }
+	}
+
+	tt_config.ttloc_ptr = bench_config;
+	tt_config.ttloc_len = BENCH_PATTERNS;
+	tt_config.ttloc_size = BENCH_PATTERNS;
+
+/*
+ * Entries to look up are made from random patterns, with random
+ * digits for the variable parts.  Some won't match anything.
+ */
+	for (n = 0; n < BENCH_LOOKUPS; n++) {
+	  char *pat = bench_config[rand() % BENCH_PATTERNS].pattern;
+
+	  for (k = 0; pat[k] != '\0'; k++) {
+	    entry[n][k] = strchr("xyzbd", pat[k]) != NULL ? '0' + rand() % 10 : pat[k];
+	  }
+	  entry[n][k] = '\0';
+	  if (n % 4 == 3) {
+	    entry[n][rand() % k] = '0' + rand() % 10;
+	  }
+	}
+
+	start = clock();
+	for (n = 0; n < BENCH_LOOKUPS; n++) {
+	  expected[n] = linear_ttloc_match (entry[n]);
+	}
+	linear_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	start = clock();
+	ttloc_index_build ();
+	for (n = 0; n < BENCH_LOOKUPS; n++) {
+	  int ipat = find_ttloc_match (entry[n], xstr, ystr, zstr, bstr, dstr, VALSTRSIZE);
+
+	  if (ipat != expected[n]) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("ERROR: \"%s\" matched pattern %d rather than %d.\n", entry[n], ipat, expected[n]);
+	    error_count++;
+	  }
+	  if (ipat >= 0) found++;
+	}
+	index_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\n%d lookups in %d patterns, %d found.  Linear search %.3f sec.  Indexed, including build, %.3f sec.\n",
+			BENCH_LOOKUPS, BENCH_PATTERNS, found, linear_time, index_time);
+
+	tt_config = save_config;
+	ttloc_index_build ();
+}
+
+
 int main (int argc, char *argv[])
 {
 	aprs_tt_init (NULL);
@@ -1994,6 +2222,8 @@ int main (int argc, char *argv[])
 	  aprs_tt_sequence (0, testcases[test_num].toneseq);
 	}
 
+	ttloc_benchmark ();
+
 	if (error_count != 0) {
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("\n\nTEST FAILED, Total of %d errors.\n", error_count);
@@ -55,6 +55,25 @@
  *
  *	  Only process one channel.  
  *
+ *
+ *	Benchmark:
+ *
+ *	  With "-M manifest" we run a list of tests, several at once,
+ *	  and summarize the results.  Each line of the manifest has:
+ *
+ *		name  min  max  atest-options  wav-file
+ *
+ *	  where min and max are the acceptable range for the number
+ *	  of frames decoded.  Use "-" for no limit.
+ *	  For example:
+ *
+ *		afsk1200-E   70  71   -PE -F0   /tmp/test1.wav
+ *
+ *	  Each test runs in a separate process because the demodulators
+ *	  keep their state in static variables.  Results, including CPU
+ *	  time and samples per second, can be written in JSON form with
+ *	  -J to keep track of performance changes.
+ *
  *--------------------------------------------------------------------*/
 
 // #define X 1
@@ -67,6 +86,13 @@
 #include <string.h>
 #include <time.h>
 #include <getopt.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if ! __WIN32__
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
 
 
 #define ATEST_C 1
@@ -79,6 +105,10 @@
 #include "hdlc_rec2.h"
 #include "dlq.h"
 #include "ptt.h"
+#include "dtime_now.h"
+#include "dsp_stats.h"
+#include "dsp_kernel.h"
+#include "rx_latency.h"
 
 
 
@@ -133,7 +163,10 @@ static struct {
 } wav_data;
 
 
-static FILE *fp;
+static unsigned char *wav_buf;		/* Entire file in memory. */
+static size_t wav_len;
+static size_t wav_pos;			/* Next byte to read. */
+
 static int e_o_f;
 static int packets_decoded = 0;
 static int decimate = 0;		/* Reduce that sampling rate if set. */
@@ -172,13 +205,36 @@ static int sample_number = -1;		/* Sample number from the file. */
 					/* Use to print timestamp, relative to beginning */
 					/* of file, when frame was decoded. */
 
+static int result_fd = -1;		/* When running from a manifest, */
+					/* results are written here for the parent process. */
+
+static unsigned char *wav_load (char *fname, size_t *len);
+static int wav_read (void *dest, size_t n);
+static int run_manifest (char *manifest, int jobs, char *json_file, char *prog);
+static int run_sweep (char *sweep, int nwav, char **wav, int jobs, char *json_file, char *profile_file, char *prog);
+
 int main (int argc, char *argv[])
 {
 
 	int err;
 	int c;
 	int channel;
-	time_t start_time;
+	double start_time;
+	int timing = 0;			/* -T print receive processing time. */
+	char json_file[80];		/* -J write it in JSON form. */
+	char manifest[80];		/* -M run tests listed in this file. */
+	char sweep[80];			/* -S sweep demodulator parameters listed in this file. */
+	char profile_file[80];		/* -O write best parameters found here. */
+	char kernel[16];		/* -I DSP kernel type to use. */
+	int jobs = 0;			/* -j number to run at the same time. */
+	size_t audio_samples;
+	double cpu_start;
+
+	strlcpy (json_file, "", sizeof(json_file));
+	strlcpy (manifest, "", sizeof(manifest));
+	strlcpy (sweep, "", sizeof(sweep));
+	strlcpy (profile_file, "", sizeof(profile_file));
+	strlcpy (kernel, "", sizeof(kernel));
 
 
 #if defined(EXPERIMENT_G) || defined(EXPERIMENT_H)
@@ -267,6 +323,8 @@ int main (int argc, char *argv[])
 
 	  my_audio_config.achan[channel].passall = 0;				
 	  //my_audio_config.achan[channel].passall = 1;				
+
+	  my_audio_config.achan[channel].rx_hold_bits = DEFAULT_RX_HOLD_BITS;
 	}
 
 	while (1) {
@@ -281,7 +339,7 @@ int main (int argc, char *argv[])
 
 	  /* ':' following option character means arg is required. */
 
-          c = getopt_long(argc, argv, "B:P:D:F:L:G:012",
+          c = getopt_long(argc, argv, "B:P:D:F:K:H:L:G:012TJ:M:j:X:S:O:I:",
                         long_options, &option_index);
           if (c == -1)
             break;
@@ -353,6 +411,28 @@ int main (int argc, char *argv[])
 	      }
 	      break;	
 
+	    case 'K':				/* -K try fixing only the n least confident bits. */
+
+	      my_audio_config.achan[0].fix_soft = atoi(optarg);
+
+	      if (my_audio_config.achan[0].fix_soft < 0 || my_audio_config.achan[0].fix_soft > MAX_FIX_SOFT) {
+		text_color_set(DW_COLOR_ERROR);
+		dw_printf ("Number of bits for -K must be 0 to %d.\n", MAX_FIX_SOFT);
+		exit (1);
+	      }
+	      break;
+
+	    case 'H':				/* -H bit times to wait for other demodulators. */
+
+	      my_audio_config.achan[0].rx_hold_bits = atoi(optarg);
+
+	      if (my_audio_config.achan[0].rx_hold_bits < 0 || my_audio_config.achan[0].rx_hold_bits > MAX_RX_HOLD_BITS) {
+		text_color_set(DW_COLOR_ERROR);
+		dw_printf ("Invalid hold time.\n");
+		exit (1);
+	      }
+	      break;
+
 	    case 'L':				/* -L error if less than this number decoded. */
 
 	      error_if_less_than = atoi(optarg);
@@ -378,6 +458,49 @@ int main (int argc, char *argv[])
 	       decode_only = 2;
 	       break;
 
+	     case 'T':				/* -T print time for each step of receive processing. */
+
+	       timing = 1;
+	       break;
+
+	     case 'J':				/* -J write receive processing time to file in JSON form. */
+
+	       timing = 1;
+	       strlcpy (json_file, optarg, sizeof(json_file));
+	       break;
+
+	     case 'M':				/* -M run benchmark from manifest file. */
+
+	       strlcpy (manifest, optarg, sizeof(manifest));
+	       break;
+
+	     case 'j':				/* -j number of benchmark tests at same time. */
+
+	       jobs = atoi(optarg);
+	       break;
+
+	     case 'X':				/* -X name=value change demodulator parameter. */
+
+	       if (demod_tune_parse (&my_audio_config.achan[0].tune, optarg) != 0) {
+		 exit (1);
+	       }
+	       break;
+
+	     case 'S':				/* -S sweep demodulator parameters. */
+
+	       strlcpy (sweep, optarg, sizeof(sweep));
+	       break;
+
+	     case 'O':				/* -O write best parameters from sweep. */
+
+	       strlcpy (profile_file, optarg, sizeof(profile_file));
+	       break;
+
+	     case 'I':				/* -I DSP kernel type, to compare performance. */
+
+	       strlcpy (kernel, optarg, sizeof(kernel));
+	       break;
+
              case '?':
 
               /* Unknown option message was already printed. */
@@ -396,21 +519,33 @@ int main (int argc, char *argv[])
 	memcpy (&my_audio_config.achan[1], &my_audio_config.achan[0], sizeof(my_audio_config.achan[0]));
 
 
+	if (strlen(manifest) > 0) {
+	  exit (run_manifest (manifest, jobs, json_file, argv[0]));
+	}
+
+	if (strlen(sweep) > 0) {
+	  exit (run_sweep (sweep, argc - optind, argv + optind, jobs, json_file, profile_file, argv[0]));
+	}
+
 	if (optind >= argc) {
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("Specify .WAV file name on command line.\n");
 	  usage ();
 	}
 
-	fp = fopen(argv[optind], "rb");
-        if (fp == NULL) {
+	dsp_kernel_init (kernel);
+
+	start_time = dtime_now();
+	cpu_start = (double)clock() / CLOCKS_PER_SEC;
+
+	wav_buf = wav_load (argv[optind], &wav_len);
+        if (wav_buf == NULL) {
 	  text_color_set(DW_COLOR_ERROR);
           dw_printf ("Couldn't open file for read: %s\n", argv[optind]);
 	  //perror ("more info?");
           exit (1);
         }
-
-	start_time = time(NULL);
+	wav_pos = 0;
 
 
 /*
@@ -418,7 +553,7 @@ int main (int argc, char *argv[])
  * Doesn't handle all possible cases but good enough for our purposes.
  */
 
-        err= fread (&header, (size_t)12, (size_t)1, fp);
+        err = wav_read (&header, (size_t)12);
 	(void)(err);
 
 	if (strncmp(header.riff, "RIFF", 4) != 0 || strncmp(header.wave, "WAVE", 4) != 0) {
@@ -427,11 +562,11 @@ int main (int argc, char *argv[])
           exit (EXIT_FAILURE);
 	}
 
-	err = fread (&chunk, (size_t)8, (size_t)1, fp);
+	err = wav_read (&chunk, (size_t)8);
 
 	if (strncmp(chunk.id, "LIST", 4) == 0) {
-	  err = fseek (fp, (long)chunk.datasize, SEEK_CUR);
-	  err = fread (&chunk, (size_t)8, (size_t)1, fp);
+	  err = wav_read (NULL, (size_t)chunk.datasize);
+	  err = wav_read (&chunk, (size_t)8);
 	}
 
 	if (strncmp(chunk.id, "fmt ", 4) != 0) {
@@ -445,9 +580,9 @@ int main (int argc, char *argv[])
 	  exit(1);
 	}
 
-        err = fread (&format, (size_t)chunk.datasize, (size_t)1, fp);	
+        err = wav_read (&format, (size_t)chunk.datasize);
 
-	err = fread (&wav_data, (size_t)8, (size_t)1, fp);
+	err = wav_read (&wav_data, (size_t)8);
 
 	if (strncmp(wav_data.data, "data", 4) != 0) {
 	  text_color_set(DW_COLOR_ERROR);
@@ -466,12 +601,21 @@ int main (int argc, char *argv[])
 	my_audio_config.achan[0].valid = 1;
 	if (format.nchannels == 2) my_audio_config.achan[1].valid = 1;
 
+	if ((size_t)wav_data.datasize > wav_len - wav_pos) {
+	  wav_data.datasize = wav_len - wav_pos;	/* Truncated file or stream. */
+	}
+
 	text_color_set(DW_COLOR_INFO);
 	dw_printf ("%d samples per second\n", my_audio_config.adev[0].samples_per_sec);
 	dw_printf ("%d bits per sample\n", my_audio_config.adev[0].bits_per_sample);
 	dw_printf ("%d audio channels\n", my_audio_config.adev[0].num_channels);
 	dw_printf ("%d audio bytes in file\n", (int)(wav_data.datasize));
 	dw_printf ("Fix Bits level = %d\n", my_audio_config.achan[0].fix_bits);
+	if (my_audio_config.achan[0].fix_soft > 0) {
+	  dw_printf ("Fix only the %d least confident bits\n", my_audio_config.achan[0].fix_soft);
+	}
+
+	audio_samples = wav_data.datasize / (format.wbitspersample / 8);
 
 		
 /*
@@ -479,6 +623,10 @@ int main (int argc, char *argv[])
  */
 	multi_modem_init (&my_audio_config);
 
+	if (timing) {
+	  dsp_stats_init (&my_audio_config, 0, NULL);
+	}
+
 
 	e_o_f = 0;
 	while ( ! e_o_f) 
@@ -494,8 +642,14 @@ int main (int argc, char *argv[])
             /* This reads either 1 or 2 bytes depending on */
             /* bits per sample.  */
 
+	    ds_ticks_t t_read = 0;
+
+	    if (dsp_stats_enabled) t_read = dsp_stats_ticks();
+
             audio_sample = demod_get_sample (ACHAN2ADEV(c));
 
+	    if (dsp_stats_enabled) dsp_stats_record (DS_AUDIO_READ, c, 0, 0, dsp_stats_ticks() - t_read);
+
             if (audio_sample >= 256 * 256)
                e_o_f = 1;
 
@@ -527,7 +681,57 @@ int main (int argc, char *argv[])
 	  dw_printf ("%d\n", count[j]);
 	}
 #endif
-	dw_printf ("%d packets decoded in %d seconds.\n", packets_decoded, (int)(time(NULL) - start_time));
+	dw_printf ("%d packets decoded in %.3f seconds.\n", packets_decoded, dtime_now() - start_time);
+
+	struct hdlc_rec2_fix_stats_s fs;
+
+	hdlc_rec2_get_fix_stats (0, &fs);
+	if (my_audio_config.achan[1].valid) {
+	  struct hdlc_rec2_fix_stats_s fs1;
+
+	  hdlc_rec2_get_fix_stats (1, &fs1);
+	  fs.attempted += fs1.attempted;
+	  fs.fixed += fs1.fixed;
+	  fs.tries += fs1.tries;
+	  fs.elapsed += fs1.elapsed;
+	}
+	if (fs.attempted > 0) {
+	  dw_printf ("Fixed %d of %d frames with bad CRC, %ld tries, %.3f ms per frame.\n",
+			fs.fixed, fs.attempted, fs.tries, 1000. * fs.elapsed / fs.attempted);
+	}
+
+	if (result_fd >= 0) {
+	  char result[200];
+
+	  snprintf (result, sizeof(result), "%d %lu %d %d %.6f %.6f %d %d %ld %.6f\n", packets_decoded, (unsigned long)audio_samples,
+			format.nchannels, format.nsamplespersec,
+			dtime_now() - start_time, (double)clock() / CLOCKS_PER_SEC - cpu_start,
+			fs.fixed, fs.attempted, fs.tries, fs.elapsed);
+	  if (write (result_fd, result, strlen(result)) < 0) {
+	    exit (1);
+	  }
+	}
+
+	if (timing) {
+	  if (strlen(json_file) > 0) {
+	    FILE *jfp = fopen (json_file, "w");
+	    if (jfp != NULL) {
+	      dsp_stats_write_json (jfp);
+	      fclose (jfp);
+	    }
+	    else {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Can't open %s for write.\n", json_file);
+	    }
+	  }
+	  else {
+	    dsp_stats_print ();
+	    rx_latency_print_stats (0);
+	    if (my_audio_config.achan[1].valid) {
+	      rx_latency_print_stats (1);
+	    }
+	  }
+	}
 
 	if (error_if_less_than != -1 && packets_decoded < error_if_less_than) {
 	  text_color_set(DW_COLOR_ERROR);
@@ -557,16 +761,111 @@ int audio_get (int a)
 	  return (-1);
 	}
 
-	ch = getc(fp);
+	ch = wav_buf[wav_pos++];
 	wav_data.datasize--;
 
-	if (ch < 0) {
-	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("Unexpected end of file.\n");
-	  e_o_f = 1;
+	return (ch);
+}
+
+
+/*
+ * Get the whole file into memory.
+ * Map it where available.  Otherwise read it.
+ * "-" reads from stdin, e.g. piped from "gen_packets -o -".
+ */
+
+static unsigned char *wav_load (char *fname, size_t *len)
+{
+	unsigned char *buf;
+	struct stat st;
+	int fd;
+
+	if (strcmp(fname, "-") == 0) {
+	  size_t alloc = 1024 * 1024;
+	  int n;
+
+#if __WIN32__
+	  setmode (STDIN_FILENO, O_BINARY);
+#endif
+	  buf = malloc (alloc);
+	  *len = 0;
+	  while (buf != NULL && (n = read (STDIN_FILENO, buf + *len, alloc - *len)) > 0) {
+	    *len += n;
+	    if (*len == alloc) {
+	      unsigned char *more;
+
+	      alloc *= 2;
+	      more = realloc (buf, alloc);
+	      if (more == NULL) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Out of memory reading standard input after %lu bytes.\n", (unsigned long)*len);
+	        free (buf);
+	        exit (1);
+	      }
+	      buf = more;
+	    }
+	  }
+	  if (*len == 0) {
+	    free (buf);
+	    return (NULL);
+	  }
+	  return (buf);
 	}
 
-	return (ch);
+	fd = open (fname, O_RDONLY
+#if __WIN32__
+			| O_BINARY
+#endif
+			);
+	if (fd < 0) {
+	  return (NULL);
+	}
+	if (fstat (fd, &st) != 0 || st.st_size <= 0) {
+	  close (fd);
+	  return (NULL);
+	}
+	*len = st.st_size;
+
+#if __WIN32__
+	buf = malloc (*len);
+	if (buf != NULL) {
+	  size_t got = 0;
+	  int n;
+
+	  while (got < *len && (n = read (fd, buf + got, *len - got)) > 0) {
+	    got += n;
+	  }
+	  *len = got;
+	}
+#else
+	buf = mmap (NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (buf == MAP_FAILED) {
+	  buf = NULL;
+	}
+	else {
+	  madvise (buf, *len, MADV_SEQUENTIAL);
+	}
+#endif
+	close (fd);
+	return (buf);
+}
+
+
+/*
+ * Take next n bytes from the file header.  dest can be NULL to skip.
+ * Returns 1 for success, 0 if not enough data.
+ */
+
+static int wav_read (void *dest, size_t n)
+{
+	if (n > wav_len - wav_pos) {
+	  if (dest != NULL) memset (dest, 0, n);
+	  wav_pos = wav_len;
+	  return (0);
+	}
+	if (dest != NULL) memcpy (dest, wav_buf + wav_pos, n);
+	wav_pos += n;
+	return (1);
 }
 
 
@@ -710,6 +1009,685 @@ int get_input (int it, int chan)
 	return -1;
 }
 
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        run_manifest
+ *
+ * Purpose:     Run a list of decoding tests and summarize the results.
+ *
+ * Inputs:	manifest	- File name.  See description at beginning.
+ *
+ *		jobs		- How many to run at the same time.
+ *				  0 means number of processors.
+ *
+ *		json_file	- Write summary here if not empty.
+ *
+ *		prog		- Name of this program, for reporting.
+ *
+ * Returns:	Exit status.  0 if all decoded an acceptable number of frames.
+ *
+ * Description:	Each test is run in a child process by calling main again
+ *		with the options from the manifest.  Normal output is discarded
+ *		and the child sends back one line with the results.
+ *
+ *--------------------------------------------------------------------*/
+
+#define MAX_BENCH 100
+#define MAX_BENCH_ARGS 40
+
+struct bench_s {
+	char line[800];			/* Manifest or sweep line.  argv points into here. */
+					/* Enough for sweep options, -X for each */
+					/* parameter, and WAV file name. */
+	char *name;
+	int min, max;			/* Acceptable range or -1 for none. */
+	int argc;
+	char *argv[MAX_BENCH_ARGS+2];
+
+	int pid;
+	int fd;				/* Read results from child. */
+	int status;			/* Exit status of child. */
+	int ok;				/* Got results. */
+
+	int decoded;
+	unsigned long samples;		/* All audio channels. */
+	int nchan;
+	int rate;
+	double wall;			/* Seconds. */
+	double cpu;
+
+	int fixed;			/* Frames fixed by FIX_BITS. */
+	int fix_attempted;		/* Frames with bad CRC where fixing was tried. */
+	long fix_tries;
+	double fix_sec;
+};
+
+
+#if ! __WIN32__
+
+/*
+ * Run each test in a child process, up to "jobs" at the same time,
+ * and collect the results.
+ */
+
+static void run_jobs (struct bench_s *b, int n, int jobs)
+{
+	int i, next, running;
+
+	next = 0;
+	running = 0;
+
+	while (next < n || running > 0) {
+	  int pid, status;
+	  char result[200];
+	  int len, k;
+
+	  while (next < n && running < jobs) {
+	    struct bench_s *p = &b[next];
+	    int fds[2];
+
+	    if (pipe (fds) != 0) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Can't create pipe for %s.\n", p->name);
+	      next++;
+	      continue;
+	    }
+
+	    fflush (stdout);
+	    p->pid = fork ();
+	    if (p->pid == 0) {
+
+	      /* Child.  Start over with different options. */
+
+	      close (fds[0]);
+	      result_fd = fds[1];
+	      if (freopen ("/dev/null", "w", stdout) == NULL) {
+	        exit (1);
+	      }
+	      optind = 1;
+#if __APPLE__
+	      optreset = 1;
+#endif
+	      exit (main (p->argc, p->argv));
+	    }
+
+	    close (fds[1]);
+	    if (p->pid < 0) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Can't start process for %s.\n", p->name);
+	      close (fds[0]);
+	      next++;
+	      continue;
+	    }
+	    p->fd = fds[0];
+	    running++;
+	    next++;
+	  }
+
+	  if (running == 0) break;
+
+	  pid = waitpid (-1, &status, 0);
+	  if (pid < 0) break;
+
+	  for (i = 0; i < next; i++) {
+	    if (b[i].pid == pid && b[i].fd > 0) break;
+	  }
+	  if (i >= next) continue;
+
+	  running--;
+	  b[i].status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+	  len = 0;
+	  while (len < (int)sizeof(result) - 1 && (k = read (b[i].fd, result + len, sizeof(result) - 1 - len)) > 0) {
+	    len += k;
+	  }
+	  result[len] = '\0';
+	  close (b[i].fd);
+	  b[i].fd = -1;
+
+	  b[i].ok = sscanf (result, "%d %lu %d %d %lf %lf %d %d %ld %lf", &b[i].decoded, &b[i].samples,
+				&b[i].nchan, &b[i].rate, &b[i].wall, &b[i].cpu,
+				&b[i].fixed, &b[i].fix_attempted, &b[i].fix_tries, &b[i].fix_sec) >= 6;
+	}
+
+} /* end run_jobs */
+
+#endif
+
+
+static int run_manifest (char *manifest, int jobs, char *json_file, char *prog)
+{
+#if __WIN32__
+
+	text_color_set(DW_COLOR_ERROR);
+	dw_printf ("Running tests from a manifest is not available for Windows.\n");
+	return (1);
+#else
+	static struct bench_s b[MAX_BENCH];
+	int n = 0;
+	int i, failed;
+	char stuff[200];
+	FILE *mfp;
+	double t_start, t_total, cpu_total;
+
+	mfp = fopen (manifest, "r");
+	if (mfp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't open manifest file %s.\n", manifest);
+	  return (1);
+	}
+
+	while (fgets (stuff, sizeof(stuff), mfp) != NULL && n < MAX_BENCH) {
+	  struct bench_s *p = &b[n];
+	  char *t, *lim;
+
+	  memset (p, 0, sizeof(*p));
+	  strlcpy (p->line, stuff, sizeof(p->line));
+
+	  p->name = strtok (p->line, " \t\r\n");
+	  if (p->name == NULL || *(p->name) == '#') continue;
+
+	  lim = strtok (NULL, " \t\r\n");
+	  p->min = (lim == NULL || strcmp(lim, "-") == 0) ? -1 : atoi(lim);
+	  lim = strtok (NULL, " \t\r\n");
+	  p->max = (lim == NULL || strcmp(lim, "-") == 0) ? -1 : atoi(lim);
+
+	  p->argv[p->argc++] = prog;
+	  while ((t = strtok (NULL, " \t\r\n")) != NULL && p->argc < MAX_BENCH_ARGS) {
+	    p->argv[p->argc++] = t;
+	  }
+	  p->argv[p->argc] = NULL;
+
+	  if (t != NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Manifest %s: More than %d arguments for %s.\n", manifest, MAX_BENCH_ARGS - 1, p->name);
+	    continue;
+	  }
+
+	  if (p->argc < 2) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Manifest %s: No WAV file for %s.\n", manifest, p->name);
+	    continue;
+	  }
+	  n++;
+	}
+	fclose (mfp);
+
+	if (jobs <= 0) {
+	  jobs = sysconf (_SC_NPROCESSORS_ONLN);
+	  if (jobs <= 0) jobs = 1;
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Running %d tests, %d at a time.\n", n, jobs);
+
+	t_start = dtime_now();
+	run_jobs (b, n, jobs);
+	t_total = dtime_now() - t_start;
+
+/*
+ * Summary.
+ */
+	failed = 0;
+	cpu_total = 0;
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\n%-16s %8s %11s  %-6s %8s %8s %12s %9s %11s %8s\n", "test", "decoded", "expected", "result", "wall", "cpu", "samples/sec", "realtime", "fixed", "ms/fix");
+
+	for (i = 0; i < n; i++) {
+	  struct bench_s *p = &b[i];
+	  char range[30];
+	  int pass;
+
+	  pass = p->ok && p->status == 0 &&
+		(p->min < 0 || p->decoded >= p->min) &&
+		(p->max < 0 || p->decoded <= p->max);
+	  if ( ! pass) failed++;
+	  cpu_total += p->cpu;
+
+	  strlcpy (range, "", sizeof(range));
+	  if (p->min >= 0) snprintf (range, sizeof(range), "%d", p->min);
+	  strlcat (range, "-", sizeof(range));
+	  if (p->max >= 0) snprintf (range + strlen(range), sizeof(range) - strlen(range), "%d", p->max);
+	  text_color_set(pass ? DW_COLOR_INFO : DW_COLOR_ERROR);
+	  if (p->ok) {
+	    double audio_sec = (double)(p->samples) / (p->nchan > 0 ? p->nchan : 1) / (p->rate > 0 ? p->rate : 1);
+
+	    char fixed[30];
+
+	    snprintf (fixed, sizeof(fixed), "%d/%d", p->fixed, p->fix_attempted);
+	    dw_printf ("%-16s %8d %11s  %-6s %8.3f %8.3f %12.0f %8.1fx %11s %8.3f\n", p->name, p->decoded, range,
+			pass ? "ok" : "FAILED", p->wall, p->cpu,
+			p->cpu > 0 ? p->samples / p->cpu : 0.,
+			p->cpu > 0 ? audio_sec / p->cpu : 0.,
+			fixed, p->fix_attempted > 0 ? 1000. * p->fix_sec / p->fix_attempted : 0.);
+	  }
+	  else {
+	    dw_printf ("%-16s %8s %11s  %-6s   exit status %d\n", p->name, "-", range, "FAILED", p->status);
+	  }
+	}
+
+	text_color_set(failed ? DW_COLOR_ERROR : DW_COLOR_INFO);
+	dw_printf ("\n%d tests, %d failed, %.3f seconds elapsed, %.3f seconds CPU.\n", n, failed, t_total, cpu_total);
+
+	if (strlen(json_file) > 0) {
+	  FILE *jfp = fopen (json_file, "w");
+
+	  if (jfp == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Can't open %s for write.\n", json_file);
+	    return (1);
+	  }
+
+	  fprintf (jfp, "{\n  \"time\": %.3f,\n  \"manifest\": \"%s\",\n  \"jobs\": %d,\n  \"tests\": %d,\n  \"failed\": %d,\n",
+			dtime_now(), manifest, jobs, n, failed);
+	  fprintf (jfp, "  \"wall_sec\": %.3f,\n  \"cpu_sec\": %.3f,\n  \"results\": [", t_total, cpu_total);
+
+	  for (i = 0; i < n; i++) {
+	    struct bench_s *p = &b[i];
+	    int j;
+
+	    fprintf (jfp, "%s\n    { \"name\": \"%s\", \"args\": \"", i == 0 ? "" : ",", p->name);
+	    for (j = 1; j < p->argc; j++) {
+	      fprintf (jfp, "%s%s", j == 1 ? "" : " ", p->argv[j]);
+	    }
+	    fprintf (jfp, "\", \"decoded\": %d, \"min\": %d, \"max\": %d, \"pass\": %s, "
+			"\"wall_sec\": %.3f, \"cpu_sec\": %.3f, \"samples\": %lu, \"samples_per_sec\": %.0f, "
+			"\"fixed\": %d, \"fix_attempted\": %d, \"fix_tries\": %ld, \"fix_sec\": %.6f }",
+			p->decoded, p->min, p->max,
+			(p->ok && p->status == 0 && (p->min < 0 || p->decoded >= p->min) && (p->max < 0 || p->decoded <= p->max)) ? "true" : "false",
+			p->wall, p->cpu, p->samples, p->cpu > 0 ? p->samples / p->cpu : 0.,
+			p->fixed, p->fix_attempted, p->fix_tries, p->fix_sec);
+	  }
+	  fprintf (jfp, "\n  ]\n}\n");
+	  fclose (jfp);
+	}
+
+	return (failed ? 1 : 0);
+#endif
+
+} /* end run_manifest */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        run_sweep
+ *
+ * Purpose:     Try many combinations of demodulator parameters to find
+ *		those which decode the most with the least CPU time.
+ *
+ * Inputs:	sweep		- File name.  Each line has a keyword followed by values:
+ *
+ *				    options  atest options applied to every run, e.g. -PE -F0
+ *				    wav      one or more audio files
+ *				    name     values to try for a parameter accepted by -X.
+ *
+ *				  For example:
+ *
+ *				    options      -PE
+ *				    wav          /tmp/track1.wav /tmp/track2.wav
+ *				    pll_locked   0.65 0.70 0.74 0.78
+ *				    agc_fast     0.5 0.82
+ *
+ *		nwav, wav	- More audio files from the command line.
+ *
+ *		jobs		- How many to run at the same time.
+ *
+ *		json_file	- Write all results here if not empty.
+ *
+ *		profile_file	- Write DEMODTUNE line for the best here if not empty.
+ *
+ *		prog		- Name of this program.
+ *
+ * Returns:	Exit status.
+ *
+ * Description:	Every combination of parameter values is run on every audio
+ *		file, along with the profile defaults for comparison.
+ *		Combinations are scored by total frames decoded and total CPU time.
+ *		Those which are not beaten on both counts by any other form the
+ *		"Pareto front" which is displayed.  The one decoding the most,
+ *		with the least CPU time to break ties, is saved for use in
+ *		the configuration file.
+ *
+ *--------------------------------------------------------------------*/
+
+#define MAX_SWEEP_WAV 20
+#define MAX_SWEEP_VALUES 16
+#define MAX_SWEEP_COMBOS 2000
+
+struct sweep_combo_s {
+	char tune[200];			/* name=value ... for DEMODTUNE.  Empty for baseline. */
+	int decoded;			/* Total for all files. */
+	double cpu;
+	double wall;
+	int failed;			/* Number of runs which didn't complete. */
+	int pareto;			/* Not beaten by any other. */
+};
+
+
+static int run_sweep (char *sweep, int nwav, char **wav, int jobs, char *json_file, char *profile_file, char *prog)
+{
+#if __WIN32__
+
+	text_color_set(DW_COLOR_ERROR);
+	dw_printf ("Parameter sweep is not available for Windows.\n");
+	return (1);
+#else
+	char options[200];
+	char wav_list[MAX_SWEEP_WAV][100];
+	int num_wav = 0;
+	char param_name[DT_NUM_PARAMS][40];
+	char param_value[DT_NUM_PARAMS][MAX_SWEEP_VALUES][20];
+	int num_values[DT_NUM_PARAMS];
+	int num_param = 0;
+	int num_combos, ncb, nb;
+	struct sweep_combo_s *cb;
+	struct bench_s *b;
+	char stuff[400];
+	FILE *sfp;
+	int i, j, k, best;
+	double t_start, t_total;
+
+	strlcpy (options, "", sizeof(options));
+
+	sfp = fopen (sweep, "r");
+	if (sfp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't open sweep file %s.\n", sweep);
+	  return (1);
+	}
+
+	while (fgets (stuff, sizeof(stuff), sfp) != NULL) {
+	  char *t, *v;
+
+	  t = strtok (stuff, " \t\r\n");
+	  if (t == NULL || *t == '#') continue;
+
+	  if (strcasecmp(t, "options") == 0) {
+	    while ((v = strtok (NULL, " \t\r\n")) != NULL) {
+	      if (strlen(options) + 1 + strlen(v) >= sizeof(options)) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Sweep %s: Options are too long.  Maximum is %d characters.\n", sweep, (int)sizeof(options) - 1);
+	        fclose (sfp);
+	        return (1);
+	      }
+	      strlcat (options, " ", sizeof(options));
+	      strlcat (options, v, sizeof(options));
+	    }
+	  }
+	  else if (strcasecmp(t, "wav") == 0) {
+	    while ((v = strtok (NULL, " \t\r\n")) != NULL && num_wav < MAX_SWEEP_WAV) {
+	      if (strlen(v) >= sizeof(wav_list[0])) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Sweep %s: WAV file name %s is too long.\n", sweep, v);
+	        fclose (sfp);
+	        return (1);
+	      }
+	      strlcpy (wav_list[num_wav++], v, sizeof(wav_list[0]));
+	    }
+	  }
+	  else if (num_param < DT_NUM_PARAMS) {
+	    strlcpy (param_name[num_param], t, sizeof(param_name[0]));
+	    num_values[num_param] = 0;
+	    while ((v = strtok (NULL, " \t\r\n")) != NULL && num_values[num_param] < MAX_SWEEP_VALUES) {
+	      struct demod_tune_s check;
+	      char nv[80];
+
+	      /* Catch mistakes now rather than in every child process. */
+
+	      memset (&check, 0, sizeof(check));
+	      if (strlen(t) >= sizeof(param_name[0]) || strlen(v) >= sizeof(param_value[0][0]) ||
+	          snprintf (nv, sizeof(nv), "%s=%s", t, v) >= (int)sizeof(nv)) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Sweep %s: %s=%s is too long.\n", sweep, t, v);
+	        fclose (sfp);
+	        return (1);
+	      }
+	      if (demod_tune_parse (&check, nv) != 0) {
+	        fclose (sfp);
+	        return (1);
+	      }
+	      strlcpy (param_value[num_param][num_values[num_param]++], v, sizeof(param_value[0][0]));
+	    }
+	    if (num_values[num_param] > 0) num_param++;
+	  }
+	}
+	fclose (sfp);
+
+	for (i = 0; i < nwav && num_wav < MAX_SWEEP_WAV; i++) {
+	  if (strlen(wav[i]) >= sizeof(wav_list[0])) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Sweep %s: WAV file name %s is too long.\n", sweep, wav[i]);
+	    return (1);
+	  }
+	  strlcpy (wav_list[num_wav++], wav[i], sizeof(wav_list[0]));
+	}
+
+	if (num_wav == 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Sweep %s: No WAV files.\n", sweep);
+	  return (1);
+	}
+
+/*
+ * Combination 0 is the profile defaults.  The rest are all combinations of the values.
+ */
+	num_combos = 1;
+	for (j = 0; j < num_param; j++) {
+	  num_combos *= num_values[j];
+	  if (num_combos > MAX_SWEEP_COMBOS) break;
+	}
+	if (num_combos > MAX_SWEEP_COMBOS) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Sweep %s: Too many combinations.  Maximum is %d.\n", sweep, MAX_SWEEP_COMBOS);
+	  return (1);
+	}
+	ncb = (num_param > 0 ? num_combos : 0) + 1;
+	nb = ncb * num_wav;
+
+	cb = calloc (ncb, sizeof(struct sweep_combo_s));
+	b = calloc (nb, sizeof(struct bench_s));
+	if (cb == NULL || b == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Sweep %s: Out of memory.\n", sweep);
+	  return (1);
+	}
+
+	for (i = 1; i < ncb; i++) {
+	  int r = i - 1;
+
+	  for (j = 0; j < num_param; j++) {
+	    char nv[80];
+
+	    if (snprintf (nv, sizeof(nv), "%s%s=%s", j == 0 ? "" : " ", param_name[j], param_value[j][r % num_values[j]]) >= (int)sizeof(nv) ||
+	        strlen(cb[i].tune) + strlen(nv) >= sizeof(cb[i].tune)) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Sweep %s: Too many parameters.  \"%s\" is too long.\n", sweep, cb[i].tune);
+	      free (cb);
+	      free (b);
+	      return (1);
+	    }
+	    strlcat (cb[i].tune, nv, sizeof(cb[i].tune));
+	    r /= num_values[j];
+	  }
+	}
+
+	for (i = 0; i < ncb; i++) {
+	  for (k = 0; k < num_wav; k++) {
+	    struct bench_s *p = &b[i * num_wav + k];
+	    char *t, *v, xopt[sizeof(cb[0].tune) * 2];
+
+	    strlcpy (xopt, "", sizeof(xopt));
+	    strlcpy (stuff, cb[i].tune, sizeof(stuff));
+	    for (v = strtok (stuff, " "); v != NULL; v = strtok (NULL, " ")) {
+	      strlcat (xopt, " -X ", sizeof(xopt));
+	      strlcat (xopt, v, sizeof(xopt));
+	    }
+	    if (snprintf (p->line, sizeof(p->line), "%d %s%s %s", i, options, xopt, wav_list[k]) >= (int)sizeof(p->line)) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Sweep %s: Command line for \"%s\" is too long.\n", sweep, cb[i].tune);
+	      free (cb);
+	      free (b);
+	      return (1);
+	    }
+
+	    p->name = strtok (p->line, " ");
+	    p->min = -1;
+	    p->max = -1;
+	    p->argv[p->argc++] = prog;
+	    while ((t = strtok (NULL, " ")) != NULL && p->argc < MAX_BENCH_ARGS) {
+	      p->argv[p->argc++] = t;
+	    }
+	    p->argv[p->argc] = NULL;
+
+	    if (t != NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Sweep %s: More than %d arguments for \"%s\".\n", sweep, MAX_BENCH_ARGS - 1, cb[i].tune);
+	      free (cb);
+	      free (b);
+	      return (1);
+	    }
+	  }
+	}
+
+	if (jobs <= 0) {
+	  jobs = sysconf (_SC_NPROCESSORS_ONLN);
+	  if (jobs <= 0) jobs = 1;
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Trying %d combinations of %d parameters on %d files, %d runs, %d at a time.\n",
+			ncb, num_param, num_wav, nb, jobs);
+
+	t_start = dtime_now();
+	run_jobs (b, nb, jobs);
+	t_total = dtime_now() - t_start;
+
+/*
+ * Add up results for each combination and find the Pareto front.
+ */
+	for (i = 0; i < ncb; i++) {
+	  for (k = 0; k < num_wav; k++) {
+	    struct bench_s *p = &b[i * num_wav + k];
+
+	    if (p->ok && p->status == 0) {
+	      cb[i].decoded += p->decoded;
+	      cb[i].cpu += p->cpu;
+	      cb[i].wall += p->wall;
+	    }
+	    else {
+	      cb[i].failed++;
+	    }
+	  }
+	}
+
+	best = -1;
+	for (i = 0; i < ncb; i++) {
+	  if (cb[i].failed) continue;
+
+	  cb[i].pareto = 1;
+	  for (j = 0; j < ncb && cb[i].pareto; j++) {
+	    if (j == i || cb[j].failed) continue;
+	    if (cb[j].decoded >= cb[i].decoded && cb[j].cpu <= cb[i].cpu &&
+			(cb[j].decoded > cb[i].decoded || cb[j].cpu < cb[i].cpu)) {
+	      cb[i].pareto = 0;
+	    }
+	  }
+	  if (best < 0 || cb[i].decoded > cb[best].decoded ||
+			(cb[i].decoded == cb[best].decoded && cb[i].cpu < cb[best].cpu)) {
+	    best = i;
+	  }
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\nPareto front, %d files, options:%s\n\n", num_wav, options);
+	dw_printf ("%8s %8s  %s\n", "decoded", "cpu", "parameters");
+
+	/* Display in order of increasing CPU time.  Simple selection is fine for these numbers. */
+
+	for (k = 0; k < ncb; k++) {
+	  int m = -1;
+
+	  for (i = 0; i < ncb; i++) {
+	    if (cb[i].pareto == 1 && (m < 0 || cb[i].cpu < cb[m].cpu)) m = i;
+	  }
+	  if (m < 0) break;
+	  cb[m].pareto = 2;		/* Displayed. */
+
+	  dw_printf ("%8d %8.3f  %s%s\n", cb[m].decoded, cb[m].cpu,
+			m == 0 ? "(profile defaults)" : cb[m].tune, m == best ? "   <-- best" : "");
+	}
+
+	if ( ! cb[0].pareto && ! cb[0].failed) {
+	  dw_printf ("%8d %8.3f  (profile defaults, not on front)\n", cb[0].decoded, cb[0].cpu);
+	}
+
+	for (i = 0, k = 0; i < ncb; i++) {
+	  if (cb[i].failed) k++;
+	}
+	if (k > 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\n%d combinations had runs which did not complete.\n", k);
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\n%d runs, %.3f seconds elapsed.\n", nb, t_total);
+
+	if (strlen(json_file) > 0) {
+	  FILE *jfp = fopen (json_file, "w");
+
+	  if (jfp == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Can't open %s for write.\n", json_file);
+	  }
+	  else {
+	    fprintf (jfp, "{\n  \"time\": %.3f,\n  \"sweep\": \"%s\",\n  \"options\": \"%s\",\n  \"files\": %d,\n  \"jobs\": %d,\n",
+			dtime_now(), sweep, options[0] == ' ' ? options + 1 : options, num_wav, jobs);
+	    fprintf (jfp, "  \"wall_sec\": %.3f,\n  \"best\": %d,\n  \"combinations\": [", t_total, best);
+	    for (i = 0; i < ncb; i++) {
+	      fprintf (jfp, "%s\n    { \"tune\": \"%s\", \"decoded\": %d, \"cpu_sec\": %.3f, \"wall_sec\": %.3f, \"failed\": %d, \"pareto\": %s }",
+			i == 0 ? "" : ",", cb[i].tune, cb[i].decoded, cb[i].cpu, cb[i].wall, cb[i].failed,
+			cb[i].pareto ? "true" : "false");
+	    }
+	    fprintf (jfp, "\n  ]\n}\n");
+	    fclose (jfp);
+	  }
+	}
+
+	if (strlen(profile_file) > 0 && best >= 0) {
+	  FILE *pfp = fopen (profile_file, "w");
+
+	  if (pfp == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Can't open %s for write.\n", profile_file);
+	  }
+	  else {
+	    fprintf (pfp, "#\n# Demodulator tuning found by \"atest -S %s\".\n", sweep);
+	    fprintf (pfp, "# atest options:%s\n", options);
+	    fprintf (pfp, "# %d decoded, %.3f sec CPU, from %d files.  Profile defaults: %d decoded, %.3f sec CPU.\n",
+			cb[best].decoded, cb[best].cpu, num_wav, cb[0].decoded, cb[0].cpu);
+	    fprintf (pfp, "# Put this after the CHANNEL and MODEM lines in the configuration file.\n#\n");
+	    if (best == 0) {
+	      fprintf (pfp, "# Profile defaults were best.  Nothing to change.\n");
+	    }
+	    else {
+	      fprintf (pfp, "DEMODTUNE %s\n", cb[best].tune);
+	    }
+	    fclose (pfp);
+	    dw_printf ("Best parameters written to %s.\n", profile_file);
+	  }
+	}
+
+	free (cb);
+	free (b);
+
+	return (best < 0 ? 1 : 0);
+#endif
+
+} /* end run_sweep */
+
+
 static void usage (void) {
 
 	text_color_set(DW_COLOR_ERROR);
@@ -722,6 +1700,8 @@ static void usage (void) {
 	dw_printf ("usage:\n");
 	dw_printf ("\n");
 	dw_printf ("        atest [ options ] wav-file-in\n");
+	dw_printf ("        atest -M manifest [ -j n ] [ -J file ]\n");
+	dw_printf ("        atest -S sweep [ -j n ] [ -J file ] [ -O file ] [ wav-file ... ]\n");
 	dw_printf ("\n");
 	dw_printf ("        -B n   Bits/second  for data.  Proper modem automatically selected for speed.\n");
 	dw_printf ("               300 baud uses 1600/1800 Hz AFSK.\n");
@@ -735,6 +1715,11 @@ static void usage (void) {
 	dw_printf ("               1 = Try to fix only a single bit.  \n");
 	dw_printf ("               more = Try modifying more bits to get a good CRC.\n");
 	dw_printf ("\n");
+	dw_printf ("        -K n   With -F, try changing only the n bits with lowest confidence\n");
+	dw_printf ("               from the demodulator, and pairs of them.\n");
+	dw_printf ("\n");
+	dw_printf ("        -H n   Bit times to wait for other demodulators before picking best.  Default 2.\n");
+	dw_printf ("\n");
 	dw_printf ("        -P m   Select  the  demodulator  type such as A, B, C, D (default for 300 baud),\n");
 	dw_printf ("               E (default for 1200 baud), F, A+, B+, C+, D+, E+, F+.\n");
 	dw_printf ("\n");
@@ -742,7 +1727,23 @@ static void usage (void) {
 	dw_printf ("        -1     use channel 1 (right) of stereo audio.\n");
 	dw_printf ("        -1     decode both channels of stereo audio.\n");
 	dw_printf ("\n");
-	dw_printf ("        wav-file-in is a WAV format audio file.\n");
+	dw_printf ("        -T     Print time taken by each step of receive processing.\n");
+	dw_printf ("        -J f   Write that information to file f in JSON format.\n");
+	dw_printf ("\n");
+	dw_printf ("        -M f   Run tests listed in manifest file f, several at once, and summarize.\n");
+	dw_printf ("               Each line has:  name  min  max  options  wav-file\n");
+	dw_printf ("        -j n   Number of tests to run at the same time.  Default is number of CPUs.\n");
+	dw_printf ("               With -M, -J writes the summary in JSON format.\n");
+	dw_printf ("\n");
+	dw_printf ("        -X n=v Change demodulator parameter n to value v.  Same as DEMODTUNE in config file.\n");
+	dw_printf ("        -S f   Try all combinations of parameter values listed in file f and show\n");
+	dw_printf ("               those which decode the most for the CPU time used.\n");
+	dw_printf ("        -O f   With -S, write best parameters to file f for the configuration file.\n");
+	dw_printf ("\n");
+	dw_printf ("        -I k   Use DSP kernel type k: scalar, sse2, avx2, or avx512.\n");
+	dw_printf ("               Default is the best supported by this processor.\n");
+	dw_printf ("\n");
+	dw_printf ("        wav-file-in is a WAV format audio file.  \"-\" for stdin.\n");
 	dw_printf ("\n");
 	dw_printf ("Examples:\n");
 	dw_printf ("\n");
@@ -94,6 +94,8 @@
 #include "textcolor.h"
 #include "dtime_now.h"
 #include "demod.h"		/* for alevel_t & demod_get_audio_level() */
+#include "ptt.h"		/* for ptt_audio_written() */
+#include "channelizer.h"
 
 
 /* Audio configuration. */
@@ -296,6 +298,9 @@ int audio_open (struct audio_s *pa)
 	        snprintf (pa->adev[a].adevice_in, sizeof(pa->adev[a].adevice_in), "udp:%d", DEFAULT_UDP_AUDIO_PORT);
 	      }
 	    } 
+	    if (strcasecmp(pa->adev[a].adevice_in, "iq") == 0) {
+	      adev[a].g_audio_in_type = AUDIO_IN_TYPE_IQ;
+	    }
 
 /* Let user know what is going on. */
 
@@ -315,7 +320,10 @@ int audio_open (struct audio_s *pa)
 
             text_color_set(DW_COLOR_INFO);
 
-	    if (strcmp(audio_in_name,audio_out_name) == 0) {
+	    if (adev[a].g_audio_in_type == AUDIO_IN_TYPE_IQ) {
+              dw_printf ("Receive only from wideband I/Q input %s\n", ctemp);
+	    }
+	    else if (strcmp(audio_in_name,audio_out_name) == 0) {
               dw_printf ("Audio device for both receive and transmit: %s %s\n", audio_in_name, ctemp);
 	    }
 	    else {
@@ -412,6 +420,19 @@ int audio_open (struct audio_s *pa)
 	    
 	        break;
 
+/*
+ * Channel(s) from wideband I/Q input.  Receive only.
+ */
+	      case AUDIO_IN_TYPE_IQ:
+
+	        if (channelizer_init (pa) < 0) {
+	          return (-1);
+	        }
+
+	        adev[a].inbuf_size_in_bytes = 1024;
+	        adev[a].outbuf_size_in_bytes = 1024;
+	        break;
+
 	      default:
 
 	        text_color_set(DW_COLOR_ERROR);
@@ -421,24 +442,27 @@ int audio_open (struct audio_s *pa)
 
 /*
  * Output device.  Only "soundcard" is supported at this time. 
+ * None for channels from I/Q input.
  */
 
 #if USE_ALSA
-	    err = snd_pcm_open (&(adev[a].audio_out_handle), audio_out_name, SND_PCM_STREAM_PLAYBACK, 0);
+	    if (adev[a].g_audio_in_type != AUDIO_IN_TYPE_IQ) {
+	      err = snd_pcm_open (&(adev[a].audio_out_handle), audio_out_name, SND_PCM_STREAM_PLAYBACK, 0);
 
-	    if (err < 0) {
-	      text_color_set(DW_COLOR_ERROR);
-	      dw_printf ("Could not open audio device %s for output\n%s\n", 
+	      if (err < 0) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Could not open audio device %s for output\n%s\n", 
 			audio_out_name, snd_strerror(err));
-	      return (-1);
-	    }
+	        return (-1);
+	      }
 
-	    adev[a].outbuf_size_in_bytes = set_alsa_params (a, adev[a].audio_out_handle, pa, audio_out_name, "output");
+	      adev[a].outbuf_size_in_bytes = set_alsa_params (a, adev[a].audio_out_handle, pa, audio_out_name, "output");
 
-	    if (adev[a].inbuf_size_in_bytes <= 0 || adev[a].outbuf_size_in_bytes <= 0) {
-	      return (-1);
-	    }
+	      if (adev[a].inbuf_size_in_bytes <= 0 || adev[a].outbuf_size_in_bytes <= 0) {
+	        return (-1);
+	      }
 
+	    }
 #endif
 
 /*
@@ -1057,6 +1081,13 @@ int audio_get (int a)
 	    }
 
 	    break;
+
+/*
+ * Wideband I/Q input.
+ */
+	  case AUDIO_IN_TYPE_IQ:
+
+	    return (channelizer_get (a));
 	}
 
 
@@ -1102,6 +1133,11 @@ int audio_get (int a)
 
 int audio_put (int a, int c)
 {
+	/* Channels from I/Q input are receive only. */
+	if (adev[a].g_audio_in_type == AUDIO_IN_TYPE_IQ) {
+	  return (0);
+	}
+
 	/* Should never be full at this point. */
 	assert (adev[a].outbuf_len < adev[a].outbuf_size_in_bytes);
 
@@ -1138,8 +1174,14 @@ int audio_flush (int a)
 	int retries = 10;
 	snd_pcm_status_t *status;
 
+	if (adev[a].g_audio_in_type == AUDIO_IN_TYPE_IQ) {
+	  return (0);
+	}
+
 	assert (adev[a].audio_out_handle != NULL);
 
+	ptt_audio_written (a);
+
 
 /*
  * Trying to set the automatic start threshold didn't have the desired
@@ -1230,6 +1272,12 @@ int audio_flush (int a)
 	unsigned char *ptr;	
 	int len;
 
+	if (adev[a].g_audio_in_type == AUDIO_IN_TYPE_IQ) {
+	  return (0);
+	}
+
+	ptt_audio_written (a);
+
 	ptr = adev[a].outbuf_ptr;
 	len = adev[a].outbuf_len;
 
@@ -1301,6 +1349,10 @@ int audio_flush (int a)
 void audio_wait (int a)
 {	
 
+	if (adev[a].g_audio_in_type == AUDIO_IN_TYPE_IQ) {
+	  return;
+	}
+
 	audio_flush (a);
 
 #if USE_ALSA
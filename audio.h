@@ -18,6 +18,7 @@
 
 #include "direwolf.h"		/* for MAX_CHANS used throughout the application. */
 #include "ax25_pad.h"		/* for AX25_MAX_ADDR_LEN */
+#include "tq.h"			/* for TQ_NUM_PRIO, TQ_NUM_SRC */
 
 				
 
@@ -40,7 +41,16 @@ typedef enum ptt_line_e ptt_line_t;
 enum audio_in_type_e {
 	AUDIO_IN_TYPE_SOUNDCARD,
 	AUDIO_IN_TYPE_SDR_UDP,
-	AUDIO_IN_TYPE_STDIN };
+	AUDIO_IN_TYPE_STDIN,
+	AUDIO_IN_TYPE_IQ };		/* Channel from wideband I/Q input.  See channelizer.c. */
+
+/* Sample formats for wideband I/Q input. */
+
+enum iq_format_e {
+	IQ_FORMAT_CU8,		/* Unsigned 8 bit, as from rtl_sdr. */
+	IQ_FORMAT_CS8,		/* Signed 8 bit, as from hackrf_transfer. */
+	IQ_FORMAT_CS16,		/* Signed 16 bit, little endian. */
+	IQ_FORMAT_CF32 };	/* 32 bit float, little endian. */
 
 /* For option to try fixing frames with bad CRC. */
 
@@ -54,6 +64,38 @@ typedef enum retry_e {
 
 
 typedef enum sanity_e { SANITY_APRS, SANITY_AX25, SANITY_NONE } sanity_t;
+
+
+/*
+ * Demodulator parameters that can be changed from the values
+ * built into each profile.  Set with DEMODTUNE in the configuration
+ * file or -X for atest.  Names are in demod.c.
+ */
+
+enum demod_tune_e {
+	DT_PRE_BAUD,		/* Bandpass prefilter, beyond tones, as fraction of baud. */
+	DT_PRE_LEN,		/* Prefilter length in bit times. */
+	DT_PRE_WINDOW,		/* Prefilter window type, BP_WINDOW_... */
+	DT_MS_LEN,		/* Mark and space filter length in bit times. */
+	DT_MS_WINDOW,
+	DT_LPF_BAUD,		/* Lowpass cutoff as fraction of baud. */
+	DT_LP_LEN,		/* Lowpass filter length in bit times. */
+	DT_LP_WINDOW,
+	DT_AGC_FAST,		/* AGC fast attack. */
+	DT_AGC_SLOW,		/* AGC slow decay. */
+	DT_HYST,		/* Hysteresis for 0 / 1 decision. */
+	DT_PLL_LOCKED,		/* PLL inertia when locked on to signal. */
+	DT_PLL_SEARCHING,	/* PLL inertia when searching. */
+	DT_FIXED,		/* 1 for integer fixed point demodulator. */
+	DT_NUM_PARAMS
+};
+
+struct demod_tune_s {
+	unsigned int set;		/* Bit mask, 1 << DT_..., for those specified. */
+	float value[DT_NUM_PARAMS];
+};
+
+#define DEMOD_TUNED(t,p) ((t) != NULL && ((t)->set & (1 << (p))))
 			 
 
 struct audio_s {
@@ -81,6 +123,30 @@ struct audio_s {
 	} adev[MAX_ADEVS];
 
 
+	/* Optional wideband I/Q input which is split up into */
+	/* several radio channels.  See channelizer.c. */
+
+	struct iq_param_s {
+
+	    char source[80];		/* File name, "stdin", or "udp:port". */
+					/* Empty string if not used. */
+
+	    int samples_per_sec;	/* Complex samples per second. */
+
+	    enum iq_format_e format;
+
+	    int spacing;		/* Distance between channels, Hz.  Rate / spacing */
+					/* must be a power of 2. */
+
+	    int num_chans;		/* Number of radio channels from I/Q input. */
+
+	    int chan_used[MAX_CHANS];	/* Non-zero if radio channel comes from I/Q input. */
+
+	    int chan_offset[MAX_CHANS];	/* Frequency relative to center of the I/Q input, Hz. */
+					/* Must be a multiple of spacing. */
+	} iq;
+
+
 	/* Common to all channels. */
 
 	char tts_script[80];		/* Script for text to speech. */
@@ -163,6 +229,30 @@ struct audio_s {
 
 	    int passall;		/* Allow thru even with bad CRC. */
 
+	    int fix_soft;		/* If non-zero, try changing only this many */
+					/* bits with the lowest confidence from the */
+					/* demodulator, and pairs of them, rather */
+					/* than every bit position. */
+
+	    int rx_hold_bits;		/* When using multiple demodulators or slicers, */
+					/* wait this many bit times after the first good */
+					/* frame for others to finish, then pick the best. */
+					/* Smaller reduces latency but the same frame */
+					/* might be sent twice. */
+
+	    int trigger_seconds;	/* Keep this many seconds of received audio, */
+					/* for AUDIOTRIGGER, and save it to a WAV */
+					/* file when something interesting happens. */
+					/* 0 for none. */
+
+	    int trigger_events;		/* When to save it.  AUDIO_TRIGGER_CRC, etc. */
+
+	    retry_t trigger_fix;	/* Bit fixing effort for AUDIO_TRIGGER_FIX. */
+
+	    char trigger_dir[80];	/* Where to put the WAV files. */
+
+	    struct demod_tune_s tune;	/* Changes to demodulator profile parameters. */
+
 
 	/* Additional properties for transmit. */
 	
@@ -236,6 +326,24 @@ struct audio_s {
 					/* of the frame.  Again 10 mS units. */
 					/* At this point, I'm thinking of 10 as the default. */
 
+	    int max_burst;		/* Combine queued frames into one transmission */
+					/* up to this many mSec.  0 (default) for */
+					/* the original behavior. */
+
+	    int digi_latency;		/* Don't add low priority frames to a burst */
+					/* after this many mSec so digipeated frames */
+					/* don't wait too long.  0 for no limit. */
+
+	/* Transmit queue limits.  These apply only to APRS packets. */
+	/* Packets are discarded when the queue already has more than this many. */
+	/* 0 means no limit. */
+
+	    int txq_limit_prio[TQ_NUM_PRIO];	/* For each priority. */
+						/* Default DEFAULT_TXQ_LIMIT. */
+
+	    int txq_limit_src[TQ_NUM_SRC];	/* From each source such as beacon, */
+						/* digipeater, KISS client.  Default 0. */
+
 	} achan[MAX_CHANS];
 
 #ifdef USE_HAMLIB
@@ -265,6 +373,13 @@ struct audio_s {
 
 #define DEFAULT_UDP_AUDIO_PORT 7355
 
+/*
+ * Wideband I/Q input.
+ */
+
+#define DEFAULT_IQ_SPACING 12500
+#define DEFAULT_IQ_FORMAT IQ_FORMAT_CU8
+
 
 // Maximum size of the UDP buffer (for allowing IP routing, udp packets are often limited to 1472 bytes)
 
@@ -285,6 +400,12 @@ struct audio_s {
 
 #define DEFAULT_FIX_BITS RETRY_INVERT_SINGLE
 
+#define DEFAULT_FIX_SOFT 16	/* For FIX_BITS SOFT option without a number. */
+#define MAX_FIX_SOFT 64
+
+#define DEFAULT_RX_HOLD_BITS 2
+#define MAX_RX_HOLD_BITS 100
+
 /* 
  * Standard for AFSK on VHF FM. 
  * Reversing mark and space makes no difference because
@@ -316,7 +437,8 @@ struct audio_s {
 #define DEFAULT_SLOTTIME	10
 #define DEFAULT_PERSIST		63
 #define DEFAULT_TXDELAY		30
-#define DEFAULT_TXTAIL		10	
+#define DEFAULT_TXTAIL		10
+#define DEFAULT_TXQ_LIMIT	100	
 
 
 /* 
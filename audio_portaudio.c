@@ -60,6 +60,8 @@
 #include "textcolor.h"
 #include "dtime_now.h"
 #include "demod.h"		/* for alevel_t & demod_get_audio_level() */
+#include "ptt.h"		/* for ptt_audio_written() */
+#include "channelizer.h"
 
 #include "portaudio.h"
 
@@ -609,6 +611,10 @@ int audio_open (struct audio_s *pa)
 				}
 			}
 
+			if (strcasecmp(pa->adev[a].adevice_in, "iq") == 0) {
+				adev[a].g_audio_in_type = AUDIO_IN_TYPE_IQ;
+			}
+
 			/* Let user know what is going on. */
 			/* If not specified, the device names should be "default". */
 
@@ -703,6 +709,15 @@ int audio_open (struct audio_s *pa)
 
 					break;
 
+					/*
+					 * Channel(s) from wideband I/Q input.  Receive only.
+					 */
+				case AUDIO_IN_TYPE_IQ:
+
+					if (channelizer_init (pa) < 0) return -1;
+
+					break;
+
 				default:
 
 					text_color_set(DW_COLOR_ERROR);
@@ -1096,6 +1111,13 @@ int audio_get (int a)
 			}
 
 			break;
+
+			/*
+			 * Wideband I/Q input.
+			 */
+		case AUDIO_IN_TYPE_IQ:
+
+			return (channelizer_get (a));
 	}
 
 
@@ -1142,6 +1164,11 @@ int audio_put (int a, int c)
 	int err = 0;
 	size_t frames = 0;
 
+	/* Channels from I/Q input are receive only. */
+	if (adev[a].g_audio_in_type == AUDIO_IN_TYPE_IQ) {
+		return (0);
+	}
+
 	//#define __TIMED__
 #ifdef __TIMED__
 	static int count = 0;
@@ -1208,6 +1235,7 @@ int audio_put (int a, int c)
 
 int audio_flush (int a)
 {
+	ptt_audio_written (a);
 	audio_put(a, -1);
 	return 0;
 } /* end audio_flush */
@@ -0,0 +1,696 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2016  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      audio_ring.c
+ *
+ * Purpose:   	Keep the last few seconds of received audio for each
+ *		channel and save it to a WAV file when something
+ *		interesting happens.
+ *
+ * Description:	When a frame can't be decoded, the audio that produced
+ *		it is gone.  Recording everything for hours, to find
+ *		those few cases, is not practical.  Instead we keep the
+ *		most recent audio in a ring buffer and save it only when
+ *		triggered by one of these conditions:
+ *
+ *		CRC	- Frame with bad CRC that couldn't be fixed, while
+ *			  data carrier was detected, and no other demodulator
+ *			  or slicer got the same frame.
+ *
+ *		DCD	- Data carrier was detected but nothing was decoded.
+ *
+ *		FIX	- Frame decoded but needed at least the specified
+ *			  amount of bit fixing effort.
+ *
+ *		The saved audio goes from the configured number of seconds
+ *		before the event to half a second after it.  The files
+ *		can be played back with atest when tuning the demodulators.
+ *
+ *		Samples and all events for a channel come from the same
+ *		receive thread so that state needs no locking.  Writing
+ *		files is slow so it is done by a separate thread.  The
+ *		receive thread hands off a request, with a flag, and
+ *		never waits.  The writer copies the samples out of the
+ *		ring.  There is some extra space in the ring so they
+ *		are not overwritten while that is happening.
+ *
+ *---------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <unistd.h>
+
+#if __WIN32__
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "direwolf.h"
+#include "textcolor.h"
+#include "audio.h"
+#include "dtime_now.h"
+#include "audio_ring.h"
+
+
+#define TAIL_SECONDS 0.5		/* Keep going this long after event. */
+
+#define MARGIN_SECONDS 1		/* Extra room in ring for writer to copy it out. */
+
+#define WRITER_INTERVAL_MS 100		/* How often writer thread looks for something to do. */
+
+
+/*
+ * Positions are counts of samples modulo 2**32.
+ * Compare with (int)(a - b) so wrap around doesn't matter.
+ * That's good for more than 12 hours, much longer than anything we care about.
+ */
+
+static struct ring_s {
+
+	short *buf;			/* NULL if not enabled for channel. */
+	unsigned int size;		/* Number of samples.  Power of 2. */
+	unsigned int count;		/* Number of samples put in so far. */
+
+	int window;			/* Number of samples to save. */
+	int tail;			/* Number of those after the event. */
+	int samples_per_sec;
+	int events;			/* AUDIO_TRIGGER_CRC, etc. */
+	retry_t fix;
+	char dir[80];
+
+/* Used only by receive thread. */
+
+	int reason;			/* Pending trigger, 0 for none. */
+	unsigned int due;		/* Hand off to writer when count gets here. */
+	unsigned int check_from;	/* A decode after this cancels a CRC or DCD trigger. */
+	unsigned int next_allowed;	/* Don't overlap previous one. */
+	unsigned int last_decode;
+	int decoded_once;
+	unsigned int dcd_on;
+	int dcd_active;
+	int dropped;			/* Triggers lost because writer was busy. */
+
+/* Hand off to writer. */
+
+	int req_ready;			/* Set by receive thread, cleared by writer. */
+	unsigned int req_end;
+	int req_reason;
+	double req_time;
+
+} ring[MAX_CHANS];
+
+
+static int saved_count;			/* Number of files written, */
+static char last_saved[200];		/* and name of the latest, for unit test. */
+
+static void handoff (int chan, struct ring_s *r);
+
+static void save_wav (int chan, struct ring_s *r, short *samples, int n);
+
+#if __WIN32__
+static unsigned __stdcall writer_thread (void *arg);
+#else
+static void * writer_thread (void *arg);
+#endif
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        audio_ring_init
+ *
+ * Purpose:     Set up ring buffers for channels with the AUDIOTRIGGER
+ *		option and start the writer thread.
+ *
+ * Inputs:	pa		- Audio configuration.
+ *
+ *------------------------------------------------------------------*/
+
+void audio_ring_init (struct audio_s *pa)
+{
+	int chan;
+	int any = 0;
+
+	memset (ring, 0, sizeof(ring));
+
+	for (chan = 0; chan < MAX_CHANS; chan++) {
+	  struct ring_s *r = &(ring[chan]);
+	  int rate, need;
+
+	  if ( ! pa->achan[chan].valid || pa->achan[chan].trigger_seconds <= 0) continue;
+
+	  rate = pa->adev[ACHAN2ADEV(chan)].samples_per_sec;
+	  r->samples_per_sec = rate;
+	  r->tail = (int)(TAIL_SECONDS * rate);
+	  r->window = pa->achan[chan].trigger_seconds * rate + r->tail;
+	  need = r->window + MARGIN_SECONDS * rate;
+	  for (r->size = 1; r->size < need; r->size <<= 1) ;
+
+	  r->events = pa->achan[chan].trigger_events;
+	  r->fix = pa->achan[chan].trigger_fix;
+	  strlcpy (r->dir, pa->achan[chan].trigger_dir, sizeof(r->dir));
+
+	  r->buf = calloc (r->size, sizeof(short));
+	  if (r->buf == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Not enough memory for AUDIOTRIGGER on channel %d.\n", chan);
+	    continue;
+	  }
+
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Channel %d: Keeping last %d seconds of audio, saved to \"%s\" for%s%s%s.\n",
+			chan, pa->achan[chan].trigger_seconds, r->dir,
+			r->events & AUDIO_TRIGGER_CRC ? " CRC" : "",
+			r->events & AUDIO_TRIGGER_DCD ? " DCD" : "",
+			r->events & AUDIO_TRIGGER_FIX ? " FIX" : "");
+	  any = 1;
+	}
+
+	if ( ! any) return;
+
+#if __WIN32__
+	HANDLE writer_th;
+
+	writer_th = (HANDLE)_beginthreadex (NULL, 0, writer_thread, NULL, 0, NULL);
+	if (writer_th == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not create audio trigger writer thread\n");
+	  return;
+	}
+#else
+	pthread_t writer_tid;
+	int e;
+
+	e = pthread_create (&writer_tid, NULL, writer_thread, NULL);
+	if (e != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror("Could not create audio trigger writer thread");
+	  return;
+	}
+#endif
+
+} /* end audio_ring_init */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        audio_ring_put
+ *
+ * Purpose:     Save one received audio sample.
+ *
+ * Inputs:	chan	- Radio channel.
+ *
+ *		sam	- Audio sample, 16 bit signed.
+ *
+ * Description:	This is called for every sample so keep it short.
+ *
+ *------------------------------------------------------------------*/
+
+__attribute__((hot))
+void audio_ring_put (int chan, int sam)
+{
+	struct ring_s *r = &(ring[chan]);
+
+	if (r->buf == NULL) return;
+
+	r->buf[r->count & (r->size - 1)] = sam;
+	__atomic_store_n (&(r->count), r->count + 1, __ATOMIC_RELAXED);
+
+	if (r->reason != 0 && r->count == r->due) {
+	  handoff (chan, r);
+	}
+
+} /* end audio_ring_put */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        start_trigger
+ *
+ * Purpose:     Save audio up to a little after now unless something
+ *		else is already pending or it would overlap the last one.
+ *
+ * Inputs:	r		- Ring for channel.
+ *
+ *		reason		- AUDIO_TRIGGER_CRC, etc.
+ *
+ *		check_from	- For CRC and DCD, cancel if a frame is
+ *				  decoded after this position.
+ *
+ *------------------------------------------------------------------*/
+
+static void start_trigger (struct ring_s *r, int reason, unsigned int check_from)
+{
+	if (r->reason != 0) return;
+	if ((int)(r->count - r->next_allowed) < 0) return;
+
+	r->reason = reason;
+	r->check_from = check_from;
+	r->due = r->count + r->tail;
+}
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        audio_ring_crc_fail
+ *
+ * Purpose:     Called when a frame had a bad CRC and couldn't be fixed.
+ *
+ * Inputs:	chan	- Radio channel.
+ *
+ * Description:	With multiple demodulators or slicers, some of them will
+ *		usually fail while others get the frame.  The good one
+ *		might already be here or come a little later.
+ *
+ *------------------------------------------------------------------*/
+
+void audio_ring_crc_fail (int chan)
+{
+	struct ring_s *r = &(ring[chan]);
+
+	if (r->buf == NULL || ! (r->events & AUDIO_TRIGGER_CRC)) return;
+
+	if (r->decoded_once && (int)(r->count - r->last_decode) <= r->tail) return;
+
+	start_trigger (r, AUDIO_TRIGGER_CRC, r->count - r->tail);
+}
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        audio_ring_decoded
+ *
+ * Purpose:     Called when a frame has been decoded.
+ *
+ * Inputs:	chan	- Radio channel.
+ *
+ *		retries	- Bit fixing effort needed.
+ *
+ *------------------------------------------------------------------*/
+
+void audio_ring_decoded (int chan, retry_t retries)
+{
+	struct ring_s *r = &(ring[chan]);
+
+	if (r->buf == NULL) return;
+
+	r->last_decode = r->count;
+	r->decoded_once = 1;
+
+	if ((r->reason == AUDIO_TRIGGER_CRC || r->reason == AUDIO_TRIGGER_DCD) &&
+	    (int)(r->count - r->check_from) >= 0) {
+	  r->reason = 0;
+	}
+
+	if ((r->events & AUDIO_TRIGGER_FIX) && retries >= r->fix) {
+	  start_trigger (r, AUDIO_TRIGGER_FIX, 0);
+	}
+}
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        audio_ring_dcd
+ *
+ * Purpose:     Called when data carrier detect for the channel changes.
+ *
+ * Inputs:	chan	- Radio channel.
+ *
+ *		state	- 1 for on, 0 for off.
+ *
+ * Description:	A good frame might come along a little after DCD goes
+ *		off when we wait for all of the decoders to finish.
+ *
+ *------------------------------------------------------------------*/
+
+void audio_ring_dcd (int chan, int state)
+{
+	struct ring_s *r = &(ring[chan]);
+
+	if (r->buf == NULL) return;
+
+	if (state) {
+	  r->dcd_on = r->count;
+	  r->dcd_active = 1;
+	}
+	else if (r->dcd_active) {
+	  r->dcd_active = 0;
+	  if ((r->events & AUDIO_TRIGGER_DCD) &&
+	      ( ! r->decoded_once || (int)(r->last_decode - r->dcd_on) < 0)) {
+	    start_trigger (r, AUDIO_TRIGGER_DCD, r->dcd_on);
+	  }
+	}
+}
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        handoff
+ *
+ * Purpose:     Give the window of audio to the writer thread.
+ *		Don't wait if it is still busy with the previous one.
+ *
+ *------------------------------------------------------------------*/
+
+static void handoff (int chan, struct ring_s *r)
+{
+	if (__atomic_load_n (&(r->req_ready), __ATOMIC_ACQUIRE)) {
+	  r->dropped++;
+	}
+	else {
+	  r->req_end = r->due;
+	  r->req_reason = r->reason;
+	  r->req_time = dtime_now();
+	  __atomic_store_n (&(r->req_ready), 1, __ATOMIC_RELEASE);
+	}
+
+	r->reason = 0;
+	r->next_allowed = r->due;
+}
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        writer_thread
+ *
+ * Purpose:     Copy audio out of the rings and save to WAV files.
+ *
+ *------------------------------------------------------------------*/
+
+#if __WIN32__
+static unsigned __stdcall writer_thread (void *arg)
+#else
+static void * writer_thread (void *arg)
+#endif
+{
+	short *samples;
+	int max_window = 0;
+	int chan;
+
+	for (chan = 0; chan < MAX_CHANS; chan++) {
+	  if (ring[chan].window > max_window) max_window = ring[chan].window;
+	}
+	samples = malloc (max_window * sizeof(short));
+	assert (samples != NULL);
+
+	while (1) {
+
+	  SLEEP_MS (WRITER_INTERVAL_MS);
+
+	  for (chan = 0; chan < MAX_CHANS; chan++) {
+	    struct ring_s *r = &(ring[chan]);
+
+	    if (r->buf != NULL && __atomic_load_n (&(r->req_ready), __ATOMIC_ACQUIRE)) {
+	      unsigned int start = r->req_end - r->window;
+	      unsigned int now;
+	      int j, lost;
+
+	      for (j = 0; j < r->window; j++) {
+	        samples[j] = r->buf[(start + j) & (r->size - 1)];
+	      }
+
+	      // Did any of it get overwritten while copying?  Shouldn't happen
+	      // but drop the beginning if it did.
+
+	      now = __atomic_load_n (&(r->count), __ATOMIC_RELAXED);
+	      lost = (int)(now - start) - (int)(r->size);
+	      if (lost > 0) {
+	        if (lost > r->window) lost = r->window;
+	        memmove (samples, samples + lost, (r->window - lost) * sizeof(short));
+	      }
+	      else {
+	        lost = 0;
+	      }
+
+	      save_wav (chan, r, samples, r->window - lost);
+
+	      __atomic_store_n (&(r->req_ready), 0, __ATOMIC_RELEASE);
+	    }
+	  }
+	}
+
+	return (0);	/* Unreachable but avoid compiler warning. */
+
+} /* end writer_thread */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        save_wav
+ *
+ * Purpose:     Write audio to a WAV file, 16 bit mono, at the
+ *		channel sample rate, so atest can read it.
+ *
+ *		File name has channel, date and time, UTC, and reason.
+ *		e.g.  chan0-20160612-143005.123-crc.wav
+ *
+ *------------------------------------------------------------------*/
+
+struct wav_header {             /* .WAV file header. */
+        char riff[4];           /* "RIFF" */
+        int filesize;          /* file length - 8 */
+        char wave[4];           /* "WAVE" */
+        char fmt[4];            /* "fmt " */
+        int fmtsize;           /* 16. */
+        short wformattag;       /* 1 for PCM. */
+        short nchannels;        /* 1 for mono, 2 for stereo. */
+        int nsamplespersec;    /* sampling freq, Hz. */
+        int navgbytespersec;   /* = nblockalign * nsamplespersec. */
+        short nblockalign;      /* = wbitspersample / 8 * nchannels. */
+        short wbitspersample;   /* 16 or 8. */
+        char data[4];           /* "data" */
+        int datasize;          /* number of bytes following. */
+} ;
+
+
+static void save_wav (int chan, struct ring_s *r, short *samples, int n)
+{
+	struct wav_header header;
+	char fname[200];
+	char stime[32];
+	time_t t = (time_t)(r->req_time);
+	struct tm tm;
+	FILE *fp;
+
+	(void)gmtime_r (&t, &tm);
+	strftime (stime, sizeof(stime), "%Y%m%d-%H%M%S", &tm);
+
+	snprintf (fname, sizeof(fname), "%s%schan%d-%s.%03d-%s.wav",
+			r->dir,
+#if __WIN32__
+			"\\",
+#else
+			"/",
+#endif
+			chan, stime, (int)((r->req_time - t) * 1000),
+			r->req_reason == AUDIO_TRIGGER_CRC ? "crc" :
+			r->req_reason == AUDIO_TRIGGER_DCD ? "dcd" : "fix");
+
+	fp = fopen (fname, "wb");
+	if (fp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Couldn't open file for write: %s\n", fname);
+	  return;
+	}
+
+	memset (&header, 0, sizeof(header));
+	memcpy (header.riff, "RIFF", (size_t)4);
+	memcpy (header.wave, "WAVE", (size_t)4);
+	memcpy (header.fmt, "fmt ", (size_t)4);
+	header.fmtsize = 16;
+	header.wformattag = 1;
+	header.nchannels = 1;
+	header.nsamplespersec = r->samples_per_sec;
+	header.wbitspersample = 16;
+	header.nblockalign = header.wbitspersample / 8 * header.nchannels;
+	header.navgbytespersec = header.nblockalign * header.nsamplespersec;
+	memcpy (header.data, "data", (size_t)4);
+	header.datasize = n * sizeof(short);
+	header.filesize = header.datasize + sizeof(header) - 8;
+
+	fwrite (&header, sizeof(header), 1, fp);
+	fwrite (samples, sizeof(short), n, fp);
+	fclose (fp);
+
+	strlcpy (last_saved, fname, sizeof(last_saved));
+	saved_count++;
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Saved %.1f seconds of audio, channel %d, to %s\n", (double)n / r->samples_per_sec, chan, fname);
+	if (r->dropped > 0) {
+	  dw_printf ("%d more were not saved because the writer was busy.\n", r->dropped);
+	}
+
+} /* end save_wav */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Unit test.  Feed in a known signal, trigger, and check the file.
+ *
+ *------------------------------------------------------------------*/
+
+#if AUDIO_RING_TEST
+
+#define TEST_DIR "/tmp"
+#define TEST_RATE 8000
+
+static void feed (int n)
+{
+	int j;
+
+	for (j = 0; j < n; j++) {
+	  audio_ring_put (0, (int)(ring[0].count & 0x7fff));
+	}
+}
+
+static int check_file (const char *suffix, int expect_n)
+{
+	char end[16];
+	FILE *fp;
+	struct wav_header h;
+	short *s;
+	int n, j, errors = 0;
+
+	snprintf (end, sizeof(end), "-%s.wav", suffix);
+	if (strlen(last_saved) < strlen(end) || strcmp(last_saved + strlen(last_saved) - strlen(end), end) != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("No %s file.\n", suffix);
+	  return (1);
+	}
+
+	fp = fopen (last_saved, "rb");
+	assert (fp != NULL);
+	n = fread (&h, sizeof(h), 1, fp);
+	assert (n == 1);
+	n = h.datasize / 2;
+	if (n != expect_n || h.nsamplespersec != TEST_RATE || h.nchannels != 1 || h.wbitspersample != 16) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("%s: %d samples, expected %d.\n", last_saved, n, expect_n);
+	  errors++;
+	}
+	s = malloc (n * sizeof(short));
+	n = fread (s, sizeof(short), n, fp);
+	fclose (fp);
+
+	// Samples are consecutive so the window is in one piece.
+
+	for (j = 1; j < n; j++) {
+	  if (s[j] != ((s[j-1] + 1) & 0x7fff)) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("%s: discontinuity at sample %d.\n", last_saved, j);
+	    errors++;
+	    break;
+	  }
+	}
+	free (s);
+	remove (last_saved);
+	strlcpy (last_saved, "", sizeof(last_saved));
+	return (errors);
+}
+
+
+int main (int argc, char *argv[])
+{
+	struct audio_s audio;
+	int errors = 0;
+	int window;
+
+	memset (&audio, 0, sizeof(audio));
+	audio.adev[0].samples_per_sec = TEST_RATE;
+	audio.achan[0].valid = 1;
+	audio.achan[0].trigger_seconds = 2;
+	audio.achan[0].trigger_events = AUDIO_TRIGGER_CRC | AUDIO_TRIGGER_DCD | AUDIO_TRIGGER_FIX;
+	audio.achan[0].trigger_fix = RETRY_INVERT_SINGLE;
+	strlcpy (audio.achan[0].trigger_dir, TEST_DIR, sizeof(audio.achan[0].trigger_dir));
+
+	audio_ring_init (&audio);
+	window = 2 * TEST_RATE + (int)(TAIL_SECONDS * TEST_RATE);
+
+/* CRC failure, with nothing else decoded, is saved. */
+
+	feed (3 * TEST_RATE);
+	audio_ring_crc_fail (0);
+	feed (TEST_RATE);
+	SLEEP_MS (3 * WRITER_INTERVAL_MS);
+	errors += check_file ("crc", window);
+
+/* CRC failure, when another slicer got it a little later, is not. */
+
+	feed (3 * TEST_RATE);
+	audio_ring_crc_fail (0);
+	feed (10);
+	audio_ring_decoded (0, RETRY_NONE);
+	feed (TEST_RATE);
+
+/* DCD without a decode is saved. */
+
+	audio_ring_dcd (0, 1);
+	feed (TEST_RATE);
+	audio_ring_dcd (0, 0);
+	feed (TEST_RATE);
+	SLEEP_MS (3 * WRITER_INTERVAL_MS);
+	errors += check_file ("dcd", window);
+
+/* Fixed frame is saved. */
+
+	feed (3 * TEST_RATE);
+	audio_ring_decoded (0, RETRY_INVERT_SINGLE);
+	feed (TEST_RATE);
+	SLEEP_MS (3 * WRITER_INTERVAL_MS);
+	errors += check_file ("fix", window);
+
+/* Cancelled CRC trigger should not have been saved. */
+
+	if (saved_count != 3) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Saved %d files, expected 3.\n", saved_count);
+	  errors++;
+	}
+
+	if (errors != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\nAudio ring test FAILED.\n");
+	  exit (EXIT_FAILURE);
+	}
+
+	text_color_set(DW_COLOR_REC);
+	dw_printf ("\nAudio ring test passed.\n");
+	exit (EXIT_SUCCESS);
+}
+
+#endif
+
+/* end audio_ring.c */
@@ -0,0 +1,29 @@
+
+/* audio_ring.h */
+
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H 1
+
+#include "audio.h"		/* for struct audio_s, retry_t */
+
+
+/* Conditions for saving recent audio.  Bit mask for AUDIOTRIGGER option. */
+
+#define AUDIO_TRIGGER_CRC 1	/* Frame with bad CRC that couldn't be fixed. */
+#define AUDIO_TRIGGER_DCD 2	/* Data carrier detected but nothing decoded. */
+#define AUDIO_TRIGGER_FIX 4	/* Frame needed at least the specified bit fixing effort. */
+
+
+void audio_ring_init (struct audio_s *pa);
+
+void audio_ring_put (int chan, int sam);
+
+void audio_ring_crc_fail (int chan);
+
+void audio_ring_decoded (int chan, retry_t retries);
+
+void audio_ring_dcd (int chan, int state);
+
+#endif
+
+/* end audio_ring.h */
@@ -63,6 +63,13 @@
 #include "textcolor.h"
 #include "dtime_now.h"
 #include "demod.h"		/* for alevel_t & demod_get_audio_level() */
+#include "tq.h"			/* for tq_print_stats() */
+#include "xmit.h"		/* for xmit_print_stats() */
+#include "dsp_stats.h"		/* for dsp_stats_poll() */
+#include "rx_latency.h"		/* for rx_latency_print_stats() */
+#include "ptt.h"		/* for ptt_print_stats() */
+#include "ax25_pad.h"		/* for ax25_print_stats() */
+#include "telemetry.h"		/* for telemetry_print_stats() */
 
 
 
@@ -102,6 +109,10 @@ void audio_stats (int adev, int nchan, int nsamp, int interval)
 	static int suppress_first[MAX_ADEVS];
 
 
+	/* Receive processing time report has its own interval. */
+
+	dsp_stats_poll ();
+
 	if (interval <= 0) {
 	  return;
 	}
@@ -167,6 +178,19 @@ void audio_stats (int adev, int nchan, int nsamp, int interval)
 	        dw_printf ("\nADEVICE%d: Sample rate approx. %.1f k, %d errors, receive audio level CH%d %d\n\n", 
 			adev, ave_rate, error_count[adev], ch0, alevel0.rec);
 	      }
+
+	      rx_latency_print_stats (ADEVFIRSTCHAN(adev));
+	      tq_print_stats (ADEVFIRSTCHAN(adev));
+	      xmit_print_stats (ADEVFIRSTCHAN(adev));
+	      ptt_print_stats (ADEVFIRSTCHAN(adev));
+	      if (nchan > 1) {
+	        rx_latency_print_stats (ADEVFIRSTCHAN(adev) + 1);
+	        tq_print_stats (ADEVFIRSTCHAN(adev) + 1);
+	        xmit_print_stats (ADEVFIRSTCHAN(adev) + 1);
+	        ptt_print_stats (ADEVFIRSTCHAN(adev) + 1);
+	      }
+	      ax25_print_stats ();
+	      telemetry_print_stats ();
 	    }
 	    last_time[adev] = this_time[adev];
 	    sample_count[adev] = 0;
@@ -995,6 +995,8 @@ int audio_flush (int a)
 	struct adev_s *A;
 
 	A = &(adev[a]); 
+
+	ptt_audio_written (a);
 	
 	p = (LPWAVEHDR)(&(A->out_wavehdr[A->out_current]));
 
@@ -161,6 +161,8 @@
 
 #if __WIN32__
 char *strtok_r(char *str, const char *delim, char **saveptr);
+#else
+#include <unistd.h>		/* for sysconf */
 #endif
 
 #include "direwolf.h"
@@ -178,6 +180,14 @@ static volatile int new_count = 0;
 static volatile int delete_count = 0;
 static volatile int last_seq_num = 0;
 
+/*
+ * Frames too large for the space inside the packet object.
+ * Same idea as above.
+ */
+
+static volatile int large_new_count = 0;
+static volatile int large_delete_count = 0;
+
 #if AX25MEMDEBUG
 
 int ax25memdebug = 0;
@@ -203,6 +213,54 @@ int ax25memdebug_seq (packet_t this_p)
 
 
 
+/*------------------------------------------------------------------------------
+ *
+ * Name:	frame_reserve
+ * 
+ * Purpose:	Make sure there is enough space for a frame of given length.
+ *
+ * Inputs:	this_p	- Packet object.
+ *
+ *		len	- Frame length needed, not counting the terminating nul.
+ *
+ * Description:	Originally every packet object had space for the largest
+ *		possible frame, over 2 KB, even though typical APRS packets
+ *		are under 200 bytes.  That adds up with thousands of packets
+ *		waiting in the various queues on a busy IGate.
+ *
+ *		Now the frame is kept inside the packet object if it fits.
+ *		Otherwise, it is moved to separately allocated space
+ *		large enough for anything.  It never moves back.
+ *
+ *------------------------------------------------------------------------------*/
+
+static void frame_reserve (packet_t this_p, int len)
+{
+	unsigned char *p;
+
+	assert (len >= 0 && len <= AX25_MAX_PACKET_LEN);
+
+	if (len < this_p->frame_size) {
+	  return;
+	}
+
+	p = calloc ((size_t)(AX25_MAX_PACKET_LEN + 1), (size_t)1);
+
+	if (p == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("ERROR - can't allocate memory in frame_reserve.\n");
+	}
+
+	assert (p != NULL);
+
+	large_new_count++;
+
+	memcpy (p, this_p->frame_data, this_p->frame_size);
+	this_p->frame_data = p;
+	this_p->frame_size = AX25_MAX_PACKET_LEN + 1;
+}
+
+
 #define CLEAR_LAST_ADDR_FLAG  this_p->frame_data[this_p->num_addr*7-1] &= ~ SSID_LAST_MASK
 #define SET_LAST_ADDR_FLAG  this_p->frame_data[this_p->num_addr*7-1] |= SSID_LAST_MASK
 
@@ -257,6 +315,8 @@ packet_t ax25_new (void)
 	this_p->seq = last_seq_num;
 	this_p->magic2 = MAGIC;
 	this_p->num_addr = (-1);
+	this_p->frame_data = this_p->frame_small;
+	this_p->frame_size = sizeof (this_p->frame_small);
 
 	return (this_p);
 }
@@ -302,6 +362,11 @@ void ax25_delete (packet_t this_p)
 	this_p->magic1 = 0;
 	this_p->magic1 = 0;
 
+	if (this_p->frame_data != this_p->frame_small) {
+	  large_delete_count++;
+	  free (this_p->frame_data);
+	}
+
 	//memset (this_p, 0, sizeof (struct packet_s));
 	free (this_p);
 }
@@ -399,7 +464,7 @@ packet_t ax25_from_text (char *monitor, int strict)
 	ax25_safe_print (stuff, -1, 0);
 	dw_printf ("\n");
 #endif
-	keep_going = 1;
+	keep_going = strstr (stuff, "<0x") != NULL;	/* Most don't have any.  Skip the regex. */
 	while (keep_going) {
 	  if (regexec (&unhex_re, stuff, MAXMATCH, match, 0) == 0) {
 	    int n;
@@ -544,7 +609,8 @@ packet_t ax25_from_text (char *monitor, int strict)
 /*
  * Append the info part.  
  */
-	strlcpy ((char*)(this_p->frame_data+this_p->frame_len), pinfo, sizeof(this_p->frame_data)-this_p->frame_len);
+	frame_reserve (this_p, this_p->frame_len + strlen(pinfo));
+	strlcpy ((char*)(this_p->frame_data+this_p->frame_len), pinfo, this_p->frame_size-this_p->frame_len);
 	this_p->frame_len += strlen(pinfo);
 
 	return (this_p);
@@ -616,6 +682,7 @@ packet_t ax25_from_frame (unsigned char *fbuf, int flen, alevel_t alevel)
 
 /* Copy the whole thing intact. */
 
+	frame_reserve (this_p, flen);
 	memcpy (this_p->frame_data, fbuf, flen);
 	this_p->frame_data[flen] = 0;
 	this_p->frame_len = flen;
@@ -661,6 +728,15 @@ packet_t ax25_dup (packet_t copy_from)
 	memcpy (this_p, copy_from, sizeof (struct packet_s));
 	this_p->seq = save_seq;
 
+/* Don't share the frame if it was separately allocated. */
+
+	this_p->frame_data = this_p->frame_small;
+	this_p->frame_size = sizeof (this_p->frame_small);
+	if (copy_from->frame_data != copy_from->frame_small) {
+	  frame_reserve (this_p, copy_from->frame_len);
+	  memcpy (this_p->frame_data, copy_from->frame_data, copy_from->frame_len + 1);
+	}
+
 #if AX25MEMDEBUG
 	if (ax25memdebug) {	
 	  text_color_set(DW_COLOR_DEBUG);
@@ -1020,6 +1096,8 @@ void ax25_insert_addr (packet_t this_p, int n, char *ad)
 	  return;
 	}
 
+	frame_reserve (this_p, this_p->frame_len + 7);
+
 	CLEAR_LAST_ADDR_FLAG;
 
 	this_p->num_addr++;
@@ -1675,6 +1753,119 @@ double ax25_get_release_time (packet_t this_p)
 
 
 
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_set_queue_info
+ *
+ * Purpose:	Remember when, and by whom, packet was put in the transmit queue.
+ *
+ * Inputs:	this_p		- Current packet object.
+ *
+ *		src		- Source, one of TQ_SRC_...
+ *
+ *		queue_time	- Time as returned by dtime_now().
+ *
+ *------------------------------------------------------------------------------*/
+
+void ax25_set_queue_info (packet_t this_p, int src, double queue_time)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+	
+	this_p->queue_src = src;
+	this_p->queue_time = queue_time;
+}
+
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_get_queue_src, ax25_get_queue_time
+ *
+ * Purpose:	Get values saved by ax25_set_queue_info.
+ *
+ *------------------------------------------------------------------------------*/
+
+int ax25_get_queue_src (packet_t this_p)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+
+	return (this_p->queue_src);
+}
+
+double ax25_get_queue_time (packet_t this_p)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+
+	return (this_p->queue_time);
+}
+
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_set_rx_time, ax25_get_rx_time
+ *
+ * Purpose:	Remember when the end of a received frame was found.
+ *		This also sets the "mark" for the end of the most
+ *		recent processing step.
+ *
+ * Inputs:	this_p		- Current packet object.
+ *
+ *		rx_time		- Time of closing flag, as returned by dtime_now().
+ *
+ * Description:	This is used for measuring how long it takes to get the
+ *		frame through the various stages and on to the applications.
+ *
+ *------------------------------------------------------------------------------*/
+
+void ax25_set_rx_time (packet_t this_p, double rx_time)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+
+	this_p->rx_time = rx_time;
+	this_p->rx_mark = rx_time;
+}
+
+double ax25_get_rx_time (packet_t this_p)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+
+	return (this_p->rx_time);
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_set_rx_mark, ax25_get_rx_mark
+ *
+ * Purpose:	Time, from dtime_now(), when the most recent step of
+ *		receive processing was finished.
+ *
+ *------------------------------------------------------------------------------*/
+
+void ax25_set_rx_mark (packet_t this_p, double rx_mark)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+
+	this_p->rx_mark = rx_mark;
+}
+
+double ax25_get_rx_mark (packet_t this_p)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+
+	return (this_p->rx_mark);
+}
+
+
+
 /*------------------------------------------------------------------
  *
  * Function:	ax25_format_addrs
@@ -2451,4 +2642,57 @@ int ax25_alevel_to_text (alevel_t alevel, char text[AX25_ALEVEL_TO_TEXT_SIZE])
 } /* end ax25_alevel_to_text */
 
 
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_print_stats
+ *
+ * Purpose:	Print memory used by packet objects.
+ *
+ * Description:	This is called along with the audio statistics, "-a" option.
+ *		Nothing is printed if no packets were created or deleted
+ *		since last time.
+ *
+ *		Most packets should fit in the packet object itself.
+ *		Resident memory for the whole process is included, where
+ *		available, for comparison.
+ *
+ *------------------------------------------------------------------------------*/
+
+void ax25_print_stats (void)
+{
+	static int last_new_count = 0;
+	static int last_delete_count = 0;
+	int in_use, large;
+	long bytes;
+
+	if (new_count == last_new_count && delete_count == last_delete_count) {
+	  return;
+	}
+	last_new_count = new_count;
+	last_delete_count = delete_count;
+
+	in_use = new_count - delete_count;
+	large = large_new_count - large_delete_count;
+	bytes = (long)in_use * sizeof(struct packet_s) + (long)large * (AX25_MAX_PACKET_LEN + 1);
+
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("Packet objects: %d in use, %d with large frame, %ld bytes each on average, %ld KB total",
+		in_use, large, in_use > 0 ? bytes / in_use : 0L, bytes / 1024);
+
+#ifndef __WIN32__
+	FILE *fp = fopen ("/proc/self/statm", "r");
+	if (fp != NULL) {
+	  long size, resident;
+
+	  if (fscanf (fp, "%ld %ld", &size, &resident) == 2) {
+	    dw_printf (", process resident %ld KB", resident * (sysconf(_SC_PAGESIZE) / 1024));
+	  }
+	  fclose (fp);
+	}
+#endif
+	dw_printf ("\n");
+
+} /* end ax25_print_stats */
+
+
 /* end ax25_pad.c */
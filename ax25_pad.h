@@ -79,6 +79,16 @@ struct packet_s {
 	double release_time;	/* Time stamp in format returned by dtime_now(). */
 				/* When to release from the SATgate mode delay queue. */
 
+	double queue_time;	/* When it was put in the transmit queue, dtime_now() format. */
+
+	int queue_src;		/* Which part of application put it there.  TQ_SRC_... */
+
+	double rx_time;		/* When the closing flag was found, dtime_now() format. */
+				/* 0 if it did not come from a demodulator. */
+
+	double rx_mark;		/* End of most recent receive processing step. */
+				/* Used by rx_latency to measure each step. */
+
 #define MAGIC 0x41583235
 
 	struct packet_s *nextp;	/* Pointer to next in queue. */
@@ -124,9 +134,18 @@ struct packet_s {
 	int frame_len;		/* Frame length without CRC. */
 
 
-	unsigned char frame_data[AX25_MAX_PACKET_LEN+1];
+	unsigned char *frame_data;
 				/* Raw frame contents, without the CRC. */
-				
+				/* Points to frame_small, below, for typical */
+				/* APRS packets or to separately allocated */
+				/* space of AX25_MAX_PACKET_LEN+1 for larger ones. */
+
+	int frame_size;		/* Number of bytes available at frame_data, */
+				/* including one for a terminating nul. */
+
+#define AX25_SMALL_FRAME_SIZE 256
+
+	unsigned char frame_small[AX25_SMALL_FRAME_SIZE];
 
 	int magic2;		/* Will get stomped on if above overflows. */
 };
@@ -357,6 +376,15 @@ extern packet_t ax25_get_nextp (packet_t this_p);
 extern void ax25_set_release_time (packet_t this_p, double release_time);
 extern double ax25_get_release_time (packet_t this_p);
 
+extern void ax25_set_queue_info (packet_t this_p, int src, double queue_time);
+extern int ax25_get_queue_src (packet_t this_p);
+extern double ax25_get_queue_time (packet_t this_p);
+
+extern void ax25_set_rx_time (packet_t this_p, double rx_time);
+extern double ax25_get_rx_time (packet_t this_p);
+extern void ax25_set_rx_mark (packet_t this_p, double rx_mark);
+extern double ax25_get_rx_mark (packet_t this_p);
+
 extern void ax25_format_addrs (packet_t pp, char *);
 
 extern int ax25_pack (packet_t pp, unsigned char result[AX25_MAX_PACKET_LEN]);
@@ -381,6 +409,8 @@ extern void ax25_safe_print (char *, int, int ascii_only);
 #define AX25_ALEVEL_TO_TEXT_SIZE 32	// overkill but safe.
 extern int ax25_alevel_to_text (alevel_t alevel, char text[AX25_ALEVEL_TO_TEXT_SIZE]);
 
+extern void ax25_print_stats (void);
+
 
 #endif /* AX25_PAD_H */
 
@@ -57,26 +57,6 @@
 #include "aprs_tt.h"		// for dw_run_cmd - should relocate someday.
 
 
-#if __WIN32__
-
-/* 
- * Windows doesn't have localtime_r.
- * It should have the equivalent localtime_s, with opposite parameter
- * order,  but I get undefined reference when trying to use it.
- */
-
-struct tm *localtime_r(time_t *clock, struct tm *res)
-{
-	struct tm *tm;
-
-	tm = localtime (clock);
-	memcpy (res, tm, sizeof(struct tm));
-	return (res);
-}
-
-#endif
-
-
 /*
  * Save pointers to configuration settings.
  */
@@ -906,7 +886,7 @@ static void beacon_send (int j, dwgps_info_t *gpsinfo)
 		  case SENDTO_XMIT:
 		  default:
 
-	            tq_append (g_misc_config_p->beacon[j].sendto_chan, TQ_PRIO_1_LO, pp);
+	            tq_append (g_misc_config_p->beacon[j].sendto_chan, TQ_PRIO_1_LO, TQ_SRC_BEACON, pp);
 		    break;
 
 		  case SENDTO_RECV:
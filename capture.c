@@ -0,0 +1,883 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2016  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * File:	capture.c
+ *
+ * Purpose:	Save received frames, exactly as they were heard, in a
+ *		compact binary form for later analysis, and play them
+ *		back later.
+ *
+ * Description: The CSV log file is good for reading but loses the
+ *		original frame and details about how it was received.
+ *		This keeps everything needed to put the frame back into
+ *		the received frame queue as if it had just been heard.
+ *		That is useful for load testing the digipeater, IGate,
+ *		and client applications with real traffic.
+ *
+ *		Files are written in the specified directory with names
+ *		from the UTC date and time they were started, e.g.
+ *		20160612-143005.dwcap.  A new file is started when the
+ *		current one reaches the size limit.  If that happens within
+ *		the same second, a sequence number is added, e.g.
+ *		20160612-143005-1.dwcap.
+ *
+ *		Writes are buffered.  A separate thread flushes the buffer
+ *		periodically so a quiet channel doesn't leave frames
+ *		sitting in memory.
+ *
+ * File format:	All numbers are little endian.
+ *
+ *		File header, 16 bytes:
+ *
+ *		  0	8	"DWCAPTUR"
+ *		  8	2	Version, currently 1.
+ *		  10	2	Size of file header.
+ *		  12	2	Size of record header.
+ *		  14	2	Reserved, 0.
+ *
+ *		Followed by any number of records.
+ *		Each has a 24 byte header followed by the frame.
+ *
+ *		  0	2	Frame length, without FCS.
+ *		  2	1	Radio channel.
+ *		  3	1	Subchannel, signed.  -1 for DTMF.
+ *		  4	1	Slicer, signed.
+ *		  5	1	Retries.  Effort to get a good CRC.
+ *		  6	2	Audio level, received signal, signed.
+ *		  8	2	Audio level, mark tone, signed.
+ *		  10	2	Audio level, space tone, signed.
+ *		  12	4	Microseconds.
+ *		  16	8	Seconds since 1970, UTC, signed.
+ *
+ *		Readers should use the header sizes from the file
+ *		header so fields can be added later.
+ *
+ *------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <time.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+
+#if __WIN32__
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "direwolf.h"
+#include "ax25_pad.h"
+#include "textcolor.h"
+#include "audio.h"
+#include "dlq.h"
+#include "dtime_now.h"
+#include "capture.h"
+
+
+#define CAPTURE_MAGIC "DWCAPTUR"
+
+#define CAPTURE_VERSION 1
+
+#define FILE_HEADER_SIZE 16
+
+#define REC_HEADER_SIZE 24
+
+#define CAPTURE_BUF_SIZE (1024*1024)	/* Write in large chunks. */
+
+#define CAPTURE_FLUSH_INTERVAL 10	/* Flush thread writes out the buffer this often, in seconds. */
+
+#define REPLAY_MAX_QUEUE 100		/* Wait if this many frames are added to queue without it emptying. */
+
+
+static char g_capture_dir[80];		/* Empty for disabled. */
+static int64_t g_max_bytes;		/* Start new file at this size. */
+static FILE *g_capture_fp;
+static char g_capture_fname[120];	/* Full path of current file. */
+static int64_t g_capture_bytes;		/* Size of current file. */
+static char *g_capture_buf;
+static int g_unflushed;			/* Something written since last flush. */
+
+static dw_mutex_t capture_mutex;	/* Replay or signal handler might be in another thread. */
+
+static volatile int g_replaying;	/* Don't capture what we are playing back. */
+
+
+static void capture_open (int64_t sec);
+static void capture_close (void);
+
+#if __WIN32__
+static unsigned __stdcall capture_flush_thread (void *arg);
+#else
+static void * capture_flush_thread (void *arg);
+#endif
+
+
+/*
+ * Little endian numbers regardless of what processor we are running on.
+ */
+
+static void put16 (unsigned char *p, int x)
+{
+	p[0] = x & 0xff;
+	p[1] = (x >> 8) & 0xff;
+}
+
+static void put32 (unsigned char *p, uint32_t x)
+{
+	put16 (p, x & 0xffff);
+	put16 (p + 2, (x >> 16) & 0xffff);
+}
+
+static void put64 (unsigned char *p, int64_t x)
+{
+	put32 (p, (uint64_t)x & 0xffffffff);
+	put32 (p + 4, ((uint64_t)x >> 32) & 0xffffffff);
+}
+
+static int get16 (const unsigned char *p)
+{
+	return (p[0] | (p[1] << 8));
+}
+
+static uint32_t get32 (const unsigned char *p)
+{
+	return ((uint32_t)get16(p) | ((uint32_t)get16(p + 2) << 16));
+}
+
+static int64_t get64 (const unsigned char *p)
+{
+	return ((int64_t)((uint64_t)get32(p) | ((uint64_t)get32(p + 4) << 32)));
+}
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	capture_init
+ *
+ * Purpose:	Initialization at start of application.
+ *
+ * Inputs:	dir		- Directory for capture files.
+ *				  Empty string disables feature.
+ *
+ *		max_mb		- Start new file after this many megabytes.
+ *
+ *------------------------------------------------------------------*/
+
+void capture_init (char *dir, int max_mb)
+{
+	struct stat st;
+
+	strlcpy (g_capture_dir, "", sizeof(g_capture_dir));
+	g_capture_fp = NULL;
+	strlcpy (g_capture_fname, "", sizeof(g_capture_fname));
+	g_max_bytes = (int64_t)(max_mb > 0 ? max_mb : 1) * 1024 * 1024;
+
+	dw_mutex_init (&capture_mutex);
+
+	if (strlen(dir) == 0) {
+	  return;
+	}
+
+	if (stat(dir,&st) == 0) {
+	  if ( ! S_ISDIR(st.st_mode)) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Capture file location \"%s\" is not a directory.\n", dir);
+	    return;
+	  }
+	}
+	else {
+	  // Doesn't exist.  Try to create it.  Parent directory must exist.
+#if __WIN32__
+	  if (_mkdir (dir) != 0) {
+#else
+	  if (mkdir (dir, 0777) != 0) {
+#endif
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Failed to create capture file location \"%s\".\n", dir);
+	    dw_printf ("%s\n", strerror(errno));
+	    return;
+	  }
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Capture file location \"%s\" has been created.\n", dir);
+	}
+
+	g_capture_buf = malloc (CAPTURE_BUF_SIZE);
+	if (g_capture_buf == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not allocate capture buffer.  Capture is disabled.\n");
+	  return;
+	}
+	g_unflushed = 0;
+
+/*
+ * Start up thread to flush the buffer periodically.
+ */
+
+#if __WIN32__
+	HANDLE flush_th;
+
+	flush_th = (HANDLE)_beginthreadex (NULL, 0, capture_flush_thread, NULL, 0, NULL);
+	if (flush_th == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not create capture flush thread\n");
+	  return;
+	}
+#else
+	pthread_t flush_tid;
+	int e;
+
+	e = pthread_create (&flush_tid, NULL, capture_flush_thread, NULL);
+	if (e != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror("Could not create capture flush thread");
+	  return;
+	}
+#endif
+
+	strlcpy (g_capture_dir, dir, sizeof(g_capture_dir));
+
+} /* end capture_init */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	capture_flush_thread
+ *
+ * Purpose:	Periodically write out anything in the buffer.
+ *
+ *------------------------------------------------------------------*/
+
+#if __WIN32__
+static unsigned __stdcall capture_flush_thread (void *arg)
+#else
+static void * capture_flush_thread (void *arg)
+#endif
+{
+	while (1) {
+
+	  SLEEP_SEC (CAPTURE_FLUSH_INTERVAL);
+
+	  dw_mutex_lock (&capture_mutex);
+	  if (g_capture_fp != NULL && g_unflushed) {
+	    fflush (g_capture_fp);
+	    g_unflushed = 0;
+	  }
+	  dw_mutex_unlock (&capture_mutex);
+	}
+
+	return (0);	/* Unreachable but avoid compiler warning. */
+
+} /* end capture_flush_thread */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	capture_write
+ *
+ * Purpose:	Save received frame to capture file.
+ *
+ * Inputs:	chan	- Radio channel where heard.
+ *
+ *		subchan	- Which modem caught it.  -1 for DTMF.
+ *
+ *		slice	- Which slicer caught it.
+ *
+ *		pp	- Received packet object.
+ *
+ * 		alevel	- Audio level.
+ *
+ *		retries	- Amount of effort to get a good CRC.
+ *
+ *------------------------------------------------------------------*/
+
+void capture_write (int chan, int subchan, int slice, packet_t pp, alevel_t alevel, retry_t retries)
+{
+	unsigned char hdr[REC_HEADER_SIZE];
+	unsigned char frame[AX25_MAX_PACKET_LEN];
+	int flen;
+	double now;
+	int64_t sec;
+
+
+	if (strlen(g_capture_dir) == 0 || g_replaying) return;
+
+	flen = ax25_pack (pp, frame);
+
+	now = dtime_now ();
+	sec = (int64_t)now;
+
+	put16 (hdr + 0, flen);
+	hdr[2] = chan;
+	hdr[3] = (signed char)subchan;
+	hdr[4] = (signed char)slice;
+	hdr[5] = (int)retries;
+	put16 (hdr + 6, alevel.rec);
+	put16 (hdr + 8, alevel.mark);
+	put16 (hdr + 10, alevel.space);
+	put32 (hdr + 12, (uint32_t)((now - sec) * 1000000.));
+	put64 (hdr + 16, sec);
+
+	dw_mutex_lock (&capture_mutex);
+
+	if (g_capture_fp != NULL && g_capture_bytes + REC_HEADER_SIZE + flen > g_max_bytes) {
+	  capture_close ();
+	}
+
+	if (g_capture_fp == NULL) {
+	  capture_open (sec);
+	}
+
+	if (g_capture_fp != NULL) {
+	  fwrite (hdr, REC_HEADER_SIZE, 1, g_capture_fp);
+	  fwrite (frame, flen, 1, g_capture_fp);
+	  g_capture_bytes += REC_HEADER_SIZE + flen;
+	  g_unflushed = 1;
+	}
+
+	dw_mutex_unlock (&capture_mutex);
+
+} /* end capture_write */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	capture_open
+ *
+ * Purpose:	Start a new capture file.  Caller must hold capture_mutex.
+ *
+ * Inputs:	sec	- Current time, for the file name.
+ *
+ *------------------------------------------------------------------*/
+
+static void capture_open (int64_t sec)
+{
+	time_t t = (time_t)sec;
+	struct tm tm;
+	char stamp[20];
+	char fname[32];
+	struct stat st;
+	int seq;
+	unsigned char fhdr[FILE_HEADER_SIZE];
+
+	(void)gmtime_r (&t, &tm);
+	strftime (stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+
+// The previous file might have filled up in the same second.
+// Don't append to it.  Add a sequence number instead.
+
+	for (seq = 0; seq < 1000; seq++) {
+	  if (seq == 0) {
+	    snprintf (fname, sizeof(fname), "%s.dwcap", stamp);
+	  }
+	  else {
+	    snprintf (fname, sizeof(fname), "%s-%d.dwcap", stamp, seq);
+	  }
+
+	  strlcpy (g_capture_fname, g_capture_dir, sizeof(g_capture_fname));
+#if __WIN32__
+	  strlcat (g_capture_fname, "\\", sizeof(g_capture_fname));
+#else
+	  strlcat (g_capture_fname, "/", sizeof(g_capture_fname));
+#endif
+	  strlcat (g_capture_fname, fname, sizeof(g_capture_fname));
+
+	  if (stat(g_capture_fname, &st) != 0) {
+	    break;
+	  }
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf("Opening capture file \"%s\".\n", g_capture_fname);
+
+	g_capture_fp = fopen (g_capture_fname, "wb");
+	if (g_capture_fp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf("Can't open capture file \"%s\" for write.\n", g_capture_fname);
+	  dw_printf ("%s\n", strerror(errno));
+	  dw_printf ("Capture is disabled.\n");
+	  strlcpy (g_capture_dir, "", sizeof(g_capture_dir));
+	  return;
+	}
+
+	if (g_capture_buf != NULL) {
+	  setvbuf (g_capture_fp, g_capture_buf, _IOFBF, CAPTURE_BUF_SIZE);
+	}
+
+	memset (fhdr, 0, sizeof(fhdr));
+	memcpy (fhdr, CAPTURE_MAGIC, 8);
+	put16 (fhdr + 8, CAPTURE_VERSION);
+	put16 (fhdr + 10, FILE_HEADER_SIZE);
+	put16 (fhdr + 12, REC_HEADER_SIZE);
+	fwrite (fhdr, sizeof(fhdr), 1, g_capture_fp);
+	g_capture_bytes = FILE_HEADER_SIZE;
+	g_unflushed = 1;
+
+} /* end capture_open */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	capture_close
+ *
+ * Purpose:	Close current file.  Caller must hold capture_mutex.
+ *
+ *------------------------------------------------------------------*/
+
+static void capture_close (void)
+{
+	if (g_capture_fp != NULL) {
+
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf("Closing capture file \"%s\".\n", g_capture_fname);
+
+	  fclose (g_capture_fp);
+	  g_capture_fp = NULL;
+	}
+
+} /* end capture_close */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	capture_term
+ *
+ * Purpose:	Write anything remaining in the buffer and close the
+ *		file.  Called when exiting.
+ *
+ * Description:	This is called from the signal handler which might
+ *		have interrupted capture_write.  Don't wait forever.
+ *
+ *------------------------------------------------------------------*/
+
+void capture_term (void)
+{
+	int n;
+
+	if (strlen(g_capture_dir) == 0) return;
+
+	for (n = 0; n < 20; n++) {
+	  if (dw_mutex_try_lock (&capture_mutex)) {
+	    capture_close ();
+	    dw_mutex_unlock (&capture_mutex);
+	    return;
+	  }
+	  SLEEP_MS (50);
+	}
+
+} /* end capture_term */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	read_record
+ *
+ * Purpose:	Read one record from a capture file.
+ *
+ * Inputs:	fp		- File positioned at start of record.
+ *
+ *		rec_header_size	- From the file header.
+ *
+ * Outputs:	chan, subchan, slice, alevel, retries - As for dlq_append.
+ *				  chan is -1 if any of these is out of range,
+ *				  e.g. from a damaged or foreign file,
+ *				  so the caller can skip the record.
+ *
+ *		t		- When heard.
+ *
+ *		frame		- Frame without FCS.
+ *
+ * Returns:	Frame length, 0 at end of file, -1 for error.
+ *
+ *------------------------------------------------------------------*/
+
+static int read_record (FILE *fp, int rec_header_size, int *chan, int *subchan, int *slice,
+			alevel_t *alevel, retry_t *retries, double *t, unsigned char *frame)
+{
+	unsigned char hdr[256];
+	int flen;
+
+	if (fread (hdr, rec_header_size, 1, fp) != 1) {
+	  return (0);
+	}
+
+	flen = get16 (hdr + 0);
+	if (flen < 1 || flen > AX25_MAX_PACKET_LEN) {
+	  return (-1);
+	}
+
+	*chan = hdr[2];
+	*subchan = (signed char)hdr[3];
+	*slice = (signed char)hdr[4];
+	*retries = (retry_t)hdr[5];
+	alevel->rec = (short)get16 (hdr + 6);
+	alevel->mark = (short)get16 (hdr + 8);
+	alevel->space = (short)get16 (hdr + 10);
+	*t = (double)get64 (hdr + 16) + get32 (hdr + 12) * 0.000001;
+
+	if (fread (frame, flen, 1, fp) != 1) {
+	  return (-1);
+	}
+
+	if (*chan < 0 || *chan >= MAX_CHANS ||
+	    *subchan < -1 || *subchan >= MAX_SUBCHANS ||
+	    *slice < 0 || *slice >= MAX_SLICERS ||
+	    (int)(*retries) < RETRY_NONE || (int)(*retries) >= RETRY_MAX) {
+	  *chan = -1;
+	}
+
+	return (flen);
+
+} /* end read_record */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	capture_replay
+ *
+ * Purpose:	Start playing back a capture file.
+ *
+ * Inputs:	fname	- Capture file name.
+ *
+ *		speed	- 1 for original timing, 10 for ten times as fast, etc.
+ *			  0 means as fast as the frames can be processed.
+ *
+ *		pa	- Audio configuration, for channels in use.
+ *			  Frames for other channels are skipped.
+ *			  NULL to accept all.
+ *
+ * Returns:	0 for success, -1 if file can't be used.
+ *
+ * Description:	Frames are put into the received frame queue, by a
+ *		separate thread, as if they had just been heard.
+ *		Frames heard while playing back are not captured.
+ *
+ *------------------------------------------------------------------*/
+
+static FILE *replay_fp;
+static char replay_fname[120];
+static int replay_rec_header_size;
+static double replay_speed;
+static struct audio_s *replay_pa;
+
+#if __WIN32__
+static unsigned __stdcall replay_thread (void *arg);
+#else
+static void * replay_thread (void *arg);
+#endif
+
+
+int capture_replay (char *fname, double speed, struct audio_s *pa)
+{
+	unsigned char fhdr[FILE_HEADER_SIZE];
+
+	replay_fp = fopen (fname, "rb");
+	if (replay_fp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't open capture file \"%s\" for replay.\n", fname);
+	  dw_printf ("%s\n", strerror(errno));
+	  return (-1);
+	}
+
+	if (fread (fhdr, sizeof(fhdr), 1, replay_fp) != 1 ||
+	    memcmp (fhdr, CAPTURE_MAGIC, 8) != 0 ||
+	    get16 (fhdr + 10) < FILE_HEADER_SIZE ||
+	    get16 (fhdr + 12) < REC_HEADER_SIZE || get16 (fhdr + 12) > 256) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\"%s\" is not a Dire Wolf capture file.\n", fname);
+	  fclose (replay_fp);
+	  return (-1);
+	}
+
+	fseek (replay_fp, get16 (fhdr + 10), SEEK_SET);
+	replay_rec_header_size = get16 (fhdr + 12);
+
+	strlcpy (replay_fname, fname, sizeof(replay_fname));
+	replay_speed = speed;
+	replay_pa = pa;
+	g_replaying = 1;
+
+#if __WIN32__
+	HANDLE replay_th;
+
+	replay_th = (HANDLE)_beginthreadex (NULL, 0, replay_thread, NULL, 0, NULL);
+	if (replay_th == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not create replay thread\n");
+	  fclose (replay_fp);
+	  g_replaying = 0;
+	  return (-1);
+	}
+#else
+	pthread_t replay_tid;
+	int e;
+
+	e = pthread_create (&replay_tid, NULL, replay_thread, NULL);
+	if (e != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror("Could not create replay thread");
+	  fclose (replay_fp);
+	  g_replaying = 0;
+	  return (-1);
+	}
+#endif
+
+	return (0);
+
+} /* end capture_replay */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	replay_thread
+ *
+ * Purpose:	Put frames from the capture file into the received
+ *		frame queue, with the original spacing in time
+ *		divided by the speed.
+ *
+ * Description:	If the frames can't be processed that fast, don't let
+ *		the queue grow without limit.  Wait for it to catch up.
+ *
+ *------------------------------------------------------------------*/
+
+#if __WIN32__
+static unsigned __stdcall replay_thread (void *arg)
+#else
+static void * replay_thread (void *arg)
+#endif
+{
+	unsigned char frame[AX25_MAX_PACKET_LEN];
+	int flen;
+	int chan, subchan, slice;
+	alevel_t alevel;
+	retry_t retries;
+	double t, t0 = 0, start;
+	int count = 0, skipped = 0, pending = 0;
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Replaying capture file \"%s\".\n", replay_fname);
+
+	start = dtime_now ();
+
+	while ((flen = read_record (replay_fp, replay_rec_header_size, &chan, &subchan, &slice, &alevel, &retries, &t, frame)) > 0) {
+	  packet_t pp;
+
+	  if (count + skipped == 0) {
+	    t0 = t;
+	  }
+
+	  if (replay_speed > 0) {
+	    double delay = start + (t - t0) / replay_speed - dtime_now();
+
+	    if (delay >= 0.001) {
+	      SLEEP_MS ((int)(delay * 1000));
+	    }
+	  }
+
+	  if (chan < 0 || (replay_pa != NULL && ! replay_pa->achan[chan].valid)) {
+	    skipped++;
+	    continue;
+	  }
+
+	  pp = ax25_from_frame (frame, flen, alevel);
+	  if (pp == NULL) {
+	    skipped++;
+	    continue;
+	  }
+
+	  if (dlq_is_empty ()) {
+	    pending = 0;
+	  }
+	  while (pending >= REPLAY_MAX_QUEUE && ! dlq_is_empty ()) {
+	    SLEEP_MS (1);
+	  }
+	  if (pending >= REPLAY_MAX_QUEUE) pending = 0;
+
+	  dlq_append (DLQ_REC_FRAME, chan, subchan, slice, pp, alevel, retries, "");
+	  count++;
+	  pending++;
+	}
+
+	text_color_set(flen < 0 ? DW_COLOR_ERROR : DW_COLOR_INFO);
+	if (flen < 0) {
+	  dw_printf ("Capture file \"%s\" is damaged after %d records.\n", replay_fname, count + skipped);
+	}
+	dw_printf ("Replay finished.  %d frames in %.1f seconds.", count, dtime_now() - start);
+	if (skipped > 0) {
+	  dw_printf ("  %d skipped for channels not configured or invalid records.", skipped);
+	}
+	dw_printf ("\n");
+
+	fclose (replay_fp);
+	g_replaying = 0;
+
+	return (0);
+
+} /* end replay_thread */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Unit test.  Capture some frames, play them back, and compare.
+ *
+ *------------------------------------------------------------------*/
+
+#if CAPTEST
+
+#define CAPTEST_DIR "/tmp/captest"
+
+int main (int argc, char *argv[])
+{
+	static char *test[] = {
+		"WB2OSZ-15>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Dire Wolf",
+		"N1EDF-9>T2QT8Y,W1CLA-1,WIDE1*,WIDE2-2,00000:`bSbl!Mv/`\"4%}_ <0x0d>",
+		"K1NRO-1>APDW12:>status",
+	};
+	int ntest = sizeof(test) / sizeof(test[0]);
+	int errors = 0;
+	int n;
+	char fname[120];
+
+	dlq_init ();
+
+	capture_init (CAPTEST_DIR, 10);
+	if (strlen(g_capture_dir) == 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not set up capture directory.\n");
+	  exit (EXIT_FAILURE);
+	}
+
+/* Record with a slicer out of range, as from a damaged file, should be skipped. */
+
+	{
+	  packet_t pp = ax25_from_text (test[0], 1);
+	  alevel_t alevel;
+
+	  memset (&alevel, 0, sizeof(alevel));
+	  capture_write (0, 0, MAX_SLICERS, pp, alevel, RETRY_NONE);
+	  ax25_delete (pp);
+	}
+
+	for (n = 0; n < ntest; n++) {
+	  packet_t pp = ax25_from_text (test[n], 1);
+	  alevel_t alevel;
+
+	  assert (pp != NULL);
+	  alevel.rec = 50 + n;
+	  alevel.mark = -1;
+	  alevel.space = 1000 + n;
+	  capture_write (n, n - 1, n * 2, pp, alevel, (retry_t)n);
+	  ax25_delete (pp);
+	}
+
+	strlcpy (fname, g_capture_fname, sizeof(fname));
+	capture_term ();
+
+	if (capture_replay (fname, 0, NULL) != 0) {
+	  exit (EXIT_FAILURE);
+	}
+
+	for (n = 0; n < ntest; n++) {
+	  dlq_type_t type;
+	  int chan, subchan, slice;
+	  packet_t pp, expect;
+	  alevel_t alevel;
+	  retry_t retries;
+	  char spectrum[40];
+	  unsigned char f1[AX25_MAX_PACKET_LEN], f2[AX25_MAX_PACKET_LEN];
+	  int len1, len2;
+
+	  dlq_wait_while_empty ();
+	  if ( ! dlq_remove (&type, &chan, &subchan, &slice, &pp, &alevel, &retries, spectrum, sizeof(spectrum))) {
+	    n--;
+	    continue;
+	  }
+
+	  expect = ax25_from_text (test[n], 1);
+	  len1 = ax25_pack (expect, f1);
+	  len2 = ax25_pack (pp, f2);
+
+	  if (chan != n || subchan != n - 1 || slice != n * 2 || (int)retries != n ||
+	      alevel.rec != 50 + n || alevel.mark != -1 || alevel.space != 1000 + n ||
+	      len1 != len2 || memcmp (f1, f2, len1) != 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Record %d did not match.\n", n);
+	    errors++;
+	  }
+
+	  ax25_delete (expect);
+	  ax25_delete (pp);
+	}
+
+	remove (fname);
+
+/* A new file in the same second must not reuse the name. */
+
+	{
+	  char first[120];
+
+	  capture_init (CAPTEST_DIR, 10);
+	  capture_open (0);
+	  strlcpy (first, g_capture_fname, sizeof(first));
+	  capture_close ();
+	  capture_open (0);
+	  if (strcmp (first, g_capture_fname) == 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("New file in same second has same name \"%s\".\n", first);
+	    errors++;
+	  }
+	  capture_close ();
+	  remove (first);
+	  remove (g_capture_fname);
+	}
+
+	rmdir (CAPTEST_DIR);
+
+	if (errors != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\nCapture test FAILED.\n");
+	  exit (EXIT_FAILURE);
+	}
+
+	text_color_set(DW_COLOR_REC);
+	dw_printf ("\nCapture test passed.\n");
+	exit (EXIT_SUCCESS);
+}
+
+#endif
+
+/* end capture.c */
@@ -0,0 +1,24 @@
+
+/* capture.h */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H 1
+
+#include "ax25_pad.h"		/* for packet_t, alevel_t */
+
+#include "hdlc_rec2.h"		/* for retry_t */
+
+#include "audio.h"		/* for struct audio_s */
+
+
+void capture_init (char *dir, int max_mb);
+
+void capture_write (int chan, int subchan, int slice, packet_t pp, alevel_t alevel, retry_t retries);
+
+void capture_term (void);
+
+int capture_replay (char *fname, double speed, struct audio_s *pa);
+
+#endif
+
+/* end capture.h */
@@ -0,0 +1,953 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2016  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      channelizer.c
+ *
+ * Purpose:   	Receive several radio channels from one wideband I/Q stream.
+ *
+ * Description:	An inexpensive SDR receiver, such as an RTL-SDR dongle, can
+ *		capture a large part of the 2 meter band at once.  Previously,
+ *		each frequency needed a separate rtl_fm process and a separate
+ *		audio stream.
+ *
+ *		Here we take the raw I/Q samples, from a file, stdin, or UDP,
+ *		and split them into equally spaced channels with a polyphase
+ *		filter bank:  One long lowpass filter is divided into M
+ *		branches and a single M point FFT produces all M channels
+ *		at once.  The cost is about the same whether we want one
+ *		channel or all of them.
+ *
+ *		Channel k is centered k * spacing from the I/Q center
+ *		frequency.  M = I/Q rate / spacing must be a power of 2.
+ *		A new output sample is produced every M/2 input samples,
+ *		for twice the channel spacing, if that is within the
+ *		audio sample rate limits.  Otherwise it is every M samples.
+ *
+ *		The filter bank runs in its own thread.  Each group of
+ *		two radio channels looks like an "audio device" with
+ *		AUDIO_IN_TYPE_IQ.  audio_get calls channelizer_get which
+ *		does the FM discriminator and provides 16 bit audio samples.
+ *		That way the demodulators for each pair of channels run in
+ *		their own receive thread, just like multiple sound cards.
+ *
+ *		Channels from the I/Q input are receive only.
+ *
+ * Configuration:
+ *
+ *		IQINPUT  source  rate  [ format ]
+ *		IQSPACING  hz
+ *		IQCHANNEL  chan  offset-hz
+ *
+ *		See config.c for details.
+ *
+ *---------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "direwolf.h"
+#include "audio.h"
+#include "audio_stats.h"
+#include "textcolor.h"
+#include "fsk_demod_state.h"	/* for bp_window_t */
+#include "dsp.h"
+#include "channelizer.h"
+
+
+/*
+ * Length of the prototype lowpass filter, as a multiple of the FFT size.
+ * Longer gives a sharper transition between channels.
+ */
+
+#define CH_TAPS_PER_BRANCH 32
+
+
+/*
+ * Polyphase filter bank state.
+ */
+
+struct pfb_s {
+	int nfft;			/* M.  Number of channels and FFT size. */
+	int hop;			/* D.  Input samples for each output.  M or M/2. */
+	int ntaps;			/* L.  Length of prototype filter. */
+
+	float *proto_rev;		/* Prototype filter in reverse order. */
+
+	float *hist_i;			/* Input history, 2 * L so the most recent */
+	float *hist_q;			/* L samples are always contiguous. */
+	int w;				/* Position of most recent sample. */
+
+	int count;			/* Input samples since last output. */
+	int odd_frame;			/* Toggles for each output.  Needed for */
+					/* correction when hop is M/2. */
+
+	float *vi, *vq;			/* Sum of filter branches, FFT input & output. */
+
+	float *tw_cos, *tw_sin;		/* FFT twiddle factors. */
+	int *bitrev;			/* FFT bit reversal permutation. */
+};
+
+
+/*
+ * Channels are grouped by pseudo audio device, one or two for each.
+ * Filter bank output goes into a ring buffer for the receive thread.
+ */
+
+#define RING_FRAMES 16384		/* About 0.6 second at 25k samples / sec. */
+
+#define OUT_FRAMES 256			/* Number of audio samples converted at once. */
+
+static struct ring_s {
+
+	int nchan;			/* 0 if not used, otherwise 1 or 2. */
+
+	int bin[2];			/* FFT output for each channel. */
+
+	float *data;			/* RING_FRAMES * nchan complex samples. */
+
+	int head;			/* Next to be written. */
+	int tail;			/* Next to be read. */
+	int count;			/* Number of frames available. */
+
+	pthread_mutex_t mutex;
+	pthread_cond_t data_cond;	/* Receive thread waits for data. */
+	pthread_cond_t space_cond;	/* Filter bank thread waits for space. */
+
+	long dropped;			/* Frames discarded because receive thread */
+					/* was not keeping up.  UDP only. */
+
+	/* Following are used only by the receive thread. */
+
+	float prev_i[2], prev_q[2];	/* Previous sample for FM discriminator. */
+
+	unsigned char out[OUT_FRAMES * 2 * 2];
+	int out_len;
+	int out_next;
+
+} ring[MAX_ADEVS];
+
+
+static struct audio_s *save_audio_config_p;
+
+static struct pfb_s pfb;
+
+static int iq_fd = -1;			/* File, stdin, or UDP socket. */
+static int iq_is_udp = 0;
+static volatile int iq_eof = 0;
+
+static int bytes_per_sample;		/* For one complex sample. */
+
+
+static void pfb_init (struct pfb_s *p, int nfft, int hop, int taps_per_branch);
+static int pfb_push (struct pfb_s *p, float si, float sq);
+static void pfb_get (struct pfb_s *p, int bin, float *pi, float *pq);
+static inline float fm_disc (float *prev_i, float *prev_q, float si, float sq);
+
+static void * channelizer_thread (void *arg);
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        channelizer_init
+ *
+ * Purpose:     Open the I/Q source and start the filter bank thread.
+ *
+ * Inputs:	pa	- Audio configuration.  iq part has the source
+ *			  and channel assignments.  Sample rate for each
+ *			  pseudo audio device was set by config.c.
+ *
+ * Returns:	0 for success, -1 for failure.
+ *
+ * Description:	This is called by audio_open for each device with
+ *		AUDIO_IN_TYPE_IQ.  Only the first call does anything.
+ *
+ *--------------------------------------------------------------------*/
+
+int channelizer_init (struct audio_s *pa)
+{
+	static int done = 0;
+	int a, c, nfft, hop;
+	pthread_t tid;
+	int e;
+
+	if (done) {
+	  return (0);
+	}
+	done = 1;
+
+	save_audio_config_p = pa;
+
+	nfft = pa->iq.samples_per_sec / pa->iq.spacing;
+	hop = 0;
+
+	switch (pa->iq.format) {
+	  case IQ_FORMAT_CU8:  bytes_per_sample = 2; break;
+	  case IQ_FORMAT_CS8:  bytes_per_sample = 2; break;
+	  case IQ_FORMAT_CS16: bytes_per_sample = 4; break;
+	  case IQ_FORMAT_CF32: bytes_per_sample = 8; break;
+	}
+
+/*
+ * Set up ring buffer for each pseudo audio device.
+ * Output rate was chosen by config.c.
+ */
+	memset (ring, 0, sizeof(ring));
+
+	for (a = 0; a < MAX_ADEVS; a++) {
+	  struct ring_s *r = &(ring[a]);
+
+	  for (c = 0; c < 2; c++) {
+	    int chan = ADEVFIRSTCHAN(a) + c;
+
+	    if (pa->iq.chan_used[chan]) {
+	      int k = pa->iq.chan_offset[chan] / pa->iq.spacing;
+
+	      r->bin[c] = (k % nfft + nfft) % nfft;
+	      r->nchan = c + 1;
+	      hop = pa->iq.samples_per_sec / pa->adev[a].samples_per_sec;
+	    }
+	  }
+	  if (r->nchan > 0) {
+	    assert (pa->adev[a].num_channels == r->nchan);
+	    r->data = malloc (RING_FRAMES * r->nchan * 2 * sizeof(float));
+	    assert (r->data != NULL);
+	    pthread_mutex_init (&(r->mutex), NULL);
+	    pthread_cond_init (&(r->data_cond), NULL);
+	    pthread_cond_init (&(r->space_cond), NULL);
+	  }
+	}
+
+	if (hop != nfft && hop != nfft / 2) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Internal error, I/Q filter bank size %d and hop %d.\n", nfft, hop);
+	  return (-1);
+	}
+
+	pfb_init (&pfb, nfft, hop, CH_TAPS_PER_BRANCH);
+
+/*
+ * Open the source.
+ */
+	if (strcasecmp(pa->iq.source, "stdin") == 0 || strcmp(pa->iq.source, "-") == 0) {
+	  iq_fd = STDIN_FILENO;
+	}
+	else if (strncasecmp(pa->iq.source, "udp:", 4) == 0) {
+	  struct sockaddr_in si_me;
+
+	  iq_is_udp = 1;
+	  if ((iq_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Couldn't create socket for I/Q input, errno %d\n", errno);
+	    return (-1);
+	  }
+
+	  memset ((char *) &si_me, 0, sizeof(si_me));
+	  si_me.sin_family = AF_INET;
+	  si_me.sin_port = htons((short)atoi(pa->iq.source + 4));
+	  si_me.sin_addr.s_addr = htonl(INADDR_ANY);
+
+	  if (bind(iq_fd, (const struct sockaddr *) &si_me, sizeof(si_me)) == -1) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Couldn't bind socket for I/Q input %s, errno %d\n", pa->iq.source, errno);
+	    return (-1);
+	  }
+	}
+	else {
+	  iq_fd = open (pa->iq.source, O_RDONLY);
+	  if (iq_fd < 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Could not open I/Q input file %s: %s\n", pa->iq.source, strerror(errno));
+	    return (-1);
+	  }
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("I/Q input %s, %d samples per second, %d channels %d Hz apart, %d audio samples per second.\n",
+		pa->iq.source, pa->iq.samples_per_sec, nfft, pa->iq.spacing, pa->iq.samples_per_sec / hop);
+	for (c = 0; c < MAX_CHANS; c++) {
+	  if (pa->iq.chan_used[c]) {
+	    dw_printf ("    Channel %d: %+.1f kHz\n", c, pa->iq.chan_offset[c] * 0.001);
+	  }
+	}
+
+	e = pthread_create (&tid, NULL, channelizer_thread, NULL);
+	if (e != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror("Could not create I/Q channelizer thread");
+	  return (-1);
+	}
+
+	return (0);
+
+} /* end channelizer_init */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        pfb_init
+ *
+ * Purpose:     Set up the polyphase filter bank.
+ *
+ * Inputs:	nfft		- Number of channels.  Must be power of 2.
+ *		hop		- Input samples for each output.  nfft or nfft/2.
+ *		taps_per_branch	- Prototype filter length / nfft.
+ *
+ * Description:	The prototype is a lowpass with cutoff at half the channel
+ *		spacing and unity gain at DC.
+ *
+ *--------------------------------------------------------------------*/
+
+static void pfb_init (struct pfb_s *p, int nfft, int hop, int taps_per_branch)
+{
+	int j, k, bits;
+	double fc, g, center;
+
+	assert (nfft >= 2 && (nfft & (nfft - 1)) == 0);
+	assert (hop == nfft || hop == nfft / 2);
+
+	memset (p, 0, sizeof(struct pfb_s));
+	p->nfft = nfft;
+	p->hop = hop;
+	p->ntaps = nfft * taps_per_branch;
+
+	p->proto_rev = calloc (p->ntaps, sizeof(float));
+	p->hist_i = calloc (2 * p->ntaps, sizeof(float));
+	p->hist_q = calloc (2 * p->ntaps, sizeof(float));
+	p->vi = calloc (nfft, sizeof(float));
+	p->vq = calloc (nfft, sizeof(float));
+	p->tw_cos = calloc (nfft / 2 + 1, sizeof(float));
+	p->tw_sin = calloc (nfft / 2 + 1, sizeof(float));
+	p->bitrev = calloc (nfft, sizeof(int));
+	assert (p->proto_rev != NULL && p->hist_i != NULL && p->hist_q != NULL && p->bitrev != NULL);
+
+	fc = 0.5 / nfft;
+	center = 0.5 * (p->ntaps - 1);
+	g = 0;
+	for (j = 0; j < p->ntaps; j++) {
+	  double sinc;
+
+	  if (j - center == 0) {
+	    sinc = 2 * fc;
+	  }
+	  else {
+	    sinc = sin(2 * M_PI * fc * (j - center)) / (M_PI * (j - center));
+	  }
+	  p->proto_rev[p->ntaps - 1 - j] = sinc * window (BP_WINDOW_BLACKMAN, p->ntaps, j);
+	  g += p->proto_rev[p->ntaps - 1 - j];
+	}
+	for (j = 0; j < p->ntaps; j++) {
+	  p->proto_rev[j] /= g;
+	}
+
+	for (k = 0; k <= nfft / 2; k++) {
+	  p->tw_cos[k] = cos(2 * M_PI * k / nfft);
+	  p->tw_sin[k] = - sin(2 * M_PI * k / nfft);
+	}
+
+	for (bits = 0; (1 << bits) < nfft; bits++) ;
+	for (j = 0; j < nfft; j++) {
+	  int r = 0;
+	  for (k = 0; k < bits; k++) {
+	    if (j & (1 << k)) r |= 1 << (bits - 1 - k);
+	  }
+	  p->bitrev[j] = r;
+	}
+
+} /* end pfb_init */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        pfb_push
+ *
+ * Purpose:     Add one complex sample to the filter bank.
+ *
+ * Returns:	1 when a new output is available for all channels.
+ *		Get it with pfb_get.
+ *
+ * Description:	Output for channel k, decimated by D, is
+ *
+ *		  y[n] = sum(l) h[l] x[nD-l] exp(-j 2 pi k (nD-l) / M)
+ *
+ *		The inner sum is split into M branches, l = m + pM, which
+ *		are added up first.  What is left is a DFT of the branch sums.
+ *
+ *--------------------------------------------------------------------*/
+
+static int pfb_push (struct pfb_s *p, float si, float sq)
+{
+	int L = p->ntaps;
+	int M = p->nfft;
+	float *hi, *hq, *h;
+	int j, m, len, half, step;
+
+	p->w++;
+	if (p->w >= L) p->w = 0;
+	p->hist_i[p->w] = p->hist_i[p->w + L] = si;
+	p->hist_q[p->w] = p->hist_q[p->w + L] = sq;
+
+	if (++p->count < p->hop) {
+	  return (0);
+	}
+	p->count = 0;
+	p->odd_frame = ! p->odd_frame;
+
+/*
+ * Add up the filter branches.  Oldest sample is at w+1.
+ * With the filter reversed, position j in both is branch M-1-(j mod M).
+ */
+	hi = p->hist_i + p->w + 1;
+	hq = p->hist_q + p->w + 1;
+	h = p->proto_rev;
+
+	memset (p->vi, 0, M * sizeof(float));
+	memset (p->vq, 0, M * sizeof(float));
+
+	for (j = 0; j < L; j += M) {
+	  for (m = 0; m < M; m++) {
+	    p->vi[m] += h[j+m] * hi[j+m];
+	    p->vq[m] += h[j+m] * hq[j+m];
+	  }
+	}
+
+/*
+ * Radix 2 FFT, in place.
+ */
+	for (m = 0; m < M; m++) {
+	  int r = p->bitrev[m];
+	  if (r > m) {
+	    float t;
+	    t = p->vi[m]; p->vi[m] = p->vi[r]; p->vi[r] = t;
+	    t = p->vq[m]; p->vq[m] = p->vq[r]; p->vq[r] = t;
+	  }
+	}
+
+	for (len = 2; len <= M; len <<= 1) {
+	  half = len >> 1;
+	  step = M / len;
+	  for (j = 0; j < M; j += len) {
+	    for (m = 0; m < half; m++) {
+	      float wr = p->tw_cos[m * step];
+	      float wi = p->tw_sin[m * step];
+	      int a = j + m;
+	      int b = a + half;
+	      float tr = p->vi[b] * wr - p->vq[b] * wi;
+	      float ti = p->vi[b] * wi + p->vq[b] * wr;
+	      p->vi[b] = p->vi[a] - tr;
+	      p->vq[b] = p->vq[a] - ti;
+	      p->vi[a] += tr;
+	      p->vq[a] += ti;
+	    }
+	  }
+	}
+
+	return (1);
+
+} /* end pfb_push */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        pfb_get
+ *
+ * Purpose:     Get filter bank output for one channel.
+ *
+ * Inputs:	bin	- FFT output position, k mod M, for channel k.
+ *
+ * Description:	The branch sums u[m] are in reversed order, branch M-1-j
+ *		at position j, so the forward FFT gives us
+ *
+ *		  X[k] = exp(-j 2 pi k (M-1) / M) * sum(m) u[m] exp(+j 2 pi k m / M)
+ *
+ *		which is what we need for channel k except for a constant
+ *		phase.  That doesn't matter to the FM discriminator.
+ *
+ *		When the hop is M/2, the remaining factor exp(-j 2 pi k n D / M)
+ *		is -1 for odd k on every other output.  That does matter.
+ *
+ *--------------------------------------------------------------------*/
+
+static void pfb_get (struct pfb_s *p, int bin, float *pi, float *pq)
+{
+	if (p->hop != p->nfft && (bin & 1) && p->odd_frame) {
+	  *pi = - p->vi[bin];
+	  *pq = - p->vq[bin];
+	}
+	else {
+	  *pi = p->vi[bin];
+	  *pq = p->vq[bin];
+	}
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        fm_disc
+ *
+ * Purpose:     FM discriminator.
+ *
+ * Returns:	Phase change since previous sample, in range of -pi to +pi.
+ *
+ *--------------------------------------------------------------------*/
+
+static inline float fm_disc (float *prev_i, float *prev_q, float si, float sq)
+{
+	float re = si * *prev_i + sq * *prev_q;
+	float im = sq * *prev_i - si * *prev_q;
+
+	*prev_i = si;
+	*prev_q = sq;
+
+	return (atan2f(im, re));
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        put_frames
+ *
+ * Purpose:     Copy filter bank output into the ring buffer for one device.
+ *
+ * Inputs:	a	- Pseudo audio device.
+ *		buf	- n frames, each with nchan complex samples.
+ *
+ * Description:	For a file or stdin, we wait for the receive thread to
+ *		make room so nothing is lost.  For UDP we can't hold up
+ *		the sender so the excess is discarded.
+ *
+ *--------------------------------------------------------------------*/
+
+static void put_frames (int a, float *buf, int n)
+{
+	struct ring_s *r = &(ring[a]);
+	int fsize = r->nchan * 2;
+	static time_t last_report = 0;
+
+	pthread_mutex_lock (&(r->mutex));
+
+	while (n > 0) {
+	  int k;
+
+	  if (r->count == RING_FRAMES) {
+	    if (iq_is_udp) {
+	      r->dropped += n;
+	      if (time(NULL) - last_report >= 10) {
+	        last_report = time(NULL);
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("I/Q input overrun, %ld samples discarded for channel %d.  Is the CPU fast enough?\n",
+				r->dropped, ADEVFIRSTCHAN(a));
+	      }
+	      break;
+	    }
+	    pthread_cond_wait (&(r->space_cond), &(r->mutex));
+	    continue;
+	  }
+
+	  k = RING_FRAMES - r->count;
+	  if (k > RING_FRAMES - r->head) k = RING_FRAMES - r->head;
+	  if (k > n) k = n;
+
+	  memcpy (r->data + r->head * fsize, buf, k * fsize * sizeof(float));
+	  r->head = (r->head + k) % RING_FRAMES;
+	  r->count += k;
+	  buf += k * fsize;
+	  n -= k;
+	}
+
+	pthread_cond_signal (&(r->data_cond));
+	pthread_mutex_unlock (&(r->mutex));
+
+} /* end put_frames */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        channelizer_thread
+ *
+ * Purpose:     Read I/Q samples and run them through the filter bank.
+ *
+ *--------------------------------------------------------------------*/
+
+#define READ_SIZE 65536
+
+static void * channelizer_thread (void *arg)
+{
+	static unsigned char rbuf[READ_SIZE + 8];
+	int rlen = 0;
+	static float obuf[MAX_ADEVS][OUT_FRAMES * 2 * 2];
+	int olen = 0;
+	int a;
+
+	while (1) {
+	  int n, j, nsamp;
+	  unsigned char *p;
+
+	  if (iq_is_udp) {
+	    n = recv (iq_fd, rbuf + rlen, READ_SIZE, 0);
+	  }
+	  else {
+	    n = read (iq_fd, rbuf + rlen, READ_SIZE);
+	  }
+
+	  if (n <= 0) {
+	    if (iq_is_udp && n < 0 && errno == EINTR) continue;
+
+	    if (n < 0) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Error reading I/Q input %s: %s\n", save_audio_config_p->iq.source, strerror(errno));
+	    }
+
+	    for (a = 0; a < MAX_ADEVS; a++) {
+	      if (ring[a].nchan > 0) {
+	        if (olen > 0) put_frames (a, obuf[a], olen);
+	        pthread_mutex_lock (&(ring[a].mutex));
+	        iq_eof = 1;
+	        pthread_cond_broadcast (&(ring[a].data_cond));
+	        pthread_mutex_unlock (&(ring[a].mutex));
+	      }
+	    }
+	    return (NULL);
+	  }
+
+	  rlen += n;
+	  nsamp = rlen / bytes_per_sample;
+	  p = rbuf;
+
+	  for (j = 0; j < nsamp; j++) {
+	    float si, sq;
+
+	    switch (save_audio_config_p->iq.format) {
+	      case IQ_FORMAT_CU8:
+	        si = (p[0] - 127.5f) * (1.0f / 128);
+	        sq = (p[1] - 127.5f) * (1.0f / 128);
+	        break;
+	      case IQ_FORMAT_CS8:
+	        si = (signed char)p[0] * (1.0f / 128);
+	        sq = (signed char)p[1] * (1.0f / 128);
+	        break;
+	      case IQ_FORMAT_CS16:
+	        si = (short)(p[0] | (p[1] << 8)) * (1.0f / 32768);
+	        sq = (short)(p[2] | (p[3] << 8)) * (1.0f / 32768);
+	        break;
+	      case IQ_FORMAT_CF32:
+	      default:
+	        memcpy (&si, p, sizeof(float));
+	        memcpy (&sq, p + 4, sizeof(float));
+	        break;
+	    }
+	    p += bytes_per_sample;
+
+	    if (pfb_push (&pfb, si, sq)) {
+
+	      for (a = 0; a < MAX_ADEVS; a++) {
+	        int c;
+	        for (c = 0; c < ring[a].nchan; c++) {
+	          float *q = &(obuf[a][(olen * ring[a].nchan + c) * 2]);
+	          pfb_get (&pfb, ring[a].bin[c], q, q + 1);
+	        }
+	      }
+
+	      if (++olen == OUT_FRAMES) {
+	        for (a = 0; a < MAX_ADEVS; a++) {
+	          if (ring[a].nchan > 0) put_frames (a, obuf[a], olen);
+	        }
+	        olen = 0;
+	      }
+	    }
+	  }
+
+	  /* Keep any partial sample for next time. */
+
+	  rlen -= nsamp * bytes_per_sample;
+	  if (rlen > 0) {
+	    memmove (rbuf, p, rlen);
+	  }
+	}
+
+	return (NULL);
+
+} /* end channelizer_thread */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        channelizer_get
+ *
+ * Purpose:     Get one byte of audio for a pseudo audio device.
+ *
+ * Inputs:	a	- Audio device number.
+ *
+ * Returns:	0 - 255 for a valid sample.  Same as audio_get.
+ *		16 bit little endian, interleaved for 2 channels.
+ *
+ * Description:	This is called from the receive thread for the device
+ *		so the FM discriminator runs in parallel for each pair
+ *		of channels.  When the input ends, we exit the application
+ *		like the other audio input types.
+ *
+ *--------------------------------------------------------------------*/
+
+int channelizer_get (int a)
+{
+	struct ring_s *r = &(ring[a]);
+
+	assert (a >= 0 && a < MAX_ADEVS);
+	assert (r->nchan > 0);
+
+	if (r->out_next >= r->out_len) {
+	  float buf[OUT_FRAMES * 2 * 2];
+	  int n, k, j, c;
+	  unsigned char *o;
+
+	  pthread_mutex_lock (&(r->mutex));
+
+	  while (r->count == 0 && ! iq_eof) {
+	    pthread_cond_wait (&(r->data_cond), &(r->mutex));
+	  }
+
+	  if (r->count == 0) {
+	    pthread_mutex_unlock (&(r->mutex));
+	    text_color_set(DW_COLOR_INFO);
+	    dw_printf ("\nEnd of I/Q input.  Exiting.\n");
+	    exit (0);
+	  }
+
+	  n = r->count;
+	  if (n > OUT_FRAMES) n = OUT_FRAMES;
+	  k = RING_FRAMES - r->tail;
+	  if (k > n) k = n;
+	  memcpy (buf, r->data + r->tail * r->nchan * 2, k * r->nchan * 2 * sizeof(float));
+	  if (k < n) {
+	    memcpy (buf + k * r->nchan * 2, r->data, (n - k) * r->nchan * 2 * sizeof(float));
+	  }
+	  r->tail = (r->tail + n) % RING_FRAMES;
+	  r->count -= n;
+
+	  pthread_cond_signal (&(r->space_cond));
+	  pthread_mutex_unlock (&(r->mutex));
+
+/*
+ * FM discriminator.  Full scale is +-pi radians per sample.
+ */
+	  o = r->out;
+	  for (j = 0; j < n; j++) {
+	    for (c = 0; c < r->nchan; c++) {
+	      float *s = buf + (j * r->nchan + c) * 2;
+	      int v = (int)(fm_disc (&(r->prev_i[c]), &(r->prev_q[c]), s[0], s[1]) * (32767.0f / (float)M_PI));
+
+	      if (v > 32767) v = 32767;
+	      if (v < -32767) v = -32767;
+	      *o++ = v & 0xff;
+	      *o++ = (v >> 8) & 0xff;
+	    }
+	  }
+	  r->out_len = o - r->out;
+	  r->out_next = 0;
+
+	  audio_stats (a, r->nchan, n, save_audio_config_p->statistics_interval);
+	}
+
+	return (r->out[r->out_next++]);
+
+} /* end channelizer_get */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Unit test.  Put several FM signals into a wideband stream and
+ * check that each comes out of the right channel and nowhere else.
+ *
+ *	gcc -O3 -DCHANNELIZER_TEST channelizer.c dsp.c textcolor.c dtime_now.c -lm -lpthread
+ *
+ *--------------------------------------------------------------------*/
+
+#if CHANNELIZER_TEST
+
+#include "dtime_now.h"
+
+/* Not needed here and it would drag in most of the application. */
+
+void audio_stats (int adev, int nchan, int nsamp, int interval)
+{
+}
+
+/* Amplitude of a tone in a signal, like the DTMF decoder. */
+
+static double tone_amp (float *x, int n, double freq, int rate)
+{
+	double si = 0, sq = 0;
+	int j;
+
+	for (j = 0; j < n; j++) {
+	  si += x[j] * cos(2 * M_PI * freq * j / rate);
+	  sq += x[j] * sin(2 * M_PI * freq * j / rate);
+	}
+	return (2 * sqrt(si * si + sq * sq) / n);
+}
+
+
+#define NSIG 3
+
+static const int sig_chan[NSIG] = { -4, 2, 5 };		/* Channel number, multiple of spacing. */
+static const double sig_tone[NSIG] = { 1200, 2200, 1700 };
+static const double sig_dev = 3000;
+
+
+static int run_test (int rate, int spacing, int hop)
+{
+	int nfft = rate / spacing;
+	int out_rate = rate / hop;
+	int nin = rate;				/* One second. */
+	int nout = nin / hop;
+	int skip = CH_TAPS_PER_BRANCH * nfft / hop;	/* Filter transient. */
+	float *out[NSIG + 1];
+	float prev_i[NSIG + 1], prev_q[NSIG + 1];
+	double power[NSIG + 1];
+	double ph[NSIG];
+	int j, s, t, n, errors = 0;
+
+	pfb_init (&pfb, nfft, hop, CH_TAPS_PER_BRANCH);
+
+	for (s = 0; s <= NSIG; s++) {
+	  out[s] = calloc (nout, sizeof(float));
+	  prev_i[s] = prev_q[s] = 0;
+	  power[s] = 0;
+	}
+	memset (ph, 0, sizeof(ph));
+
+	n = 0;
+	for (j = 0; j < nin; j++) {
+	  float si = 0, sq = 0;
+
+	  for (s = 0; s < NSIG; s++) {
+	    double f = sig_chan[s] * spacing + sig_dev * sin(2 * M_PI * sig_tone[s] * j / rate);
+	    ph[s] += 2 * M_PI * f / rate;
+	    si += 0.3 * cos(ph[s]);
+	    sq += 0.3 * sin(ph[s]);
+	  }
+
+	  if (pfb_push (&pfb, si, sq)) {
+	    for (s = 0; s <= NSIG; s++) {
+	      int k = s < NSIG ? sig_chan[s] : 0;	/* Last one is an empty channel. */
+	      float yi, yq;
+	      pfb_get (&pfb, (k % nfft + nfft) % nfft, &yi, &yq);
+	      out[s][n] = fm_disc (&prev_i[s], &prev_q[s], yi, yq) * out_rate / (2 * M_PI);
+	      if (n >= skip) power[s] += yi * yi + yq * yq;
+	    }
+	    n++;
+	  }
+	}
+	assert (n == nout);
+
+	dw_printf ("Rate %d, spacing %d, %d channels, output %d:\n", rate, spacing, nfft, out_rate);
+
+/*
+ * Deviation should come through in its own channel and be absent
+ * in the others.  The FM discriminator will find something in an
+ * empty channel, no matter how weak, so look at the power there.
+ */
+	for (s = 0; s < NSIG; s++) {
+	  dw_printf ("  Channel %+d: ", sig_chan[s]);
+	  for (t = 0; t < NSIG; t++) {
+	    double amp = tone_amp (out[s] + skip, nout - skip, sig_tone[t], out_rate);
+
+	    dw_printf (" %4.0f Hz %6.1f", sig_tone[t], amp);
+
+	    if (s == t ? fabs(amp - sig_dev) > 0.05 * sig_dev : amp > 0.01 * sig_dev) {
+	      errors++;
+	      dw_printf (" ***");
+	    }
+	  }
+	  dw_printf ("\n");
+	}
+
+	dw_printf ("  Channel +0:  %.1f dB relative to others\n", 10 * log10(power[NSIG] / power[0]));
+	if (power[NSIG] > 1e-4 * power[0]) {
+	  errors++;
+	}
+
+	for (s = 0; s <= NSIG; s++) {
+	  free (out[s]);
+	}
+
+	return (errors);
+}
+
+
+int main ()
+{
+	int errors = 0;
+	int j, n, rate;
+	double start, elapsed;
+
+	errors += run_test (200000, 12500, 8);
+	errors += run_test (800000, 25000, 32);
+
+/*
+ * Speed with a typical RTL-SDR rate and 128 channels.
+ */
+	rate = 1600000;
+	pfb_init (&pfb, 128, 64, CH_TAPS_PER_BRANCH);
+	n = 0;
+	start = dtime_now();
+	for (j = 0; j < rate * 2; j++) {
+	  n += pfb_push (&pfb, (j & 1) ? 0.5 : -0.5, (j & 2) ? 0.5 : -0.5);
+	}
+	elapsed = dtime_now() - start;
+	dw_printf ("%d I/Q samples, %d outputs for 128 channels in %.3f seconds, %.1f x real time.\n",
+			rate * 2, n, elapsed, 2 / elapsed);
+
+	if (errors) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\nChannelizer test FAILED with %d errors.\n", errors);
+	  exit (1);
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\nChannelizer test passed.\n");
+	exit (0);
+}
+
+#endif
+
+/* end channelizer.c */
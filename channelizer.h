@@ -0,0 +1,16 @@
+
+/* channelizer.h */
+
+#ifndef CHANNELIZER_H
+#define CHANNELIZER_H 1
+
+#include "audio.h"		/* for struct audio_s */
+
+
+int channelizer_init (struct audio_s *pa);
+
+int channelizer_get (int a);
+
+#endif
+
+/* end channelizer.h */
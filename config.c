@@ -58,6 +58,10 @@
 #include "symbols.h"
 #include "xmit.h"
 #include "tt_text.h"
+#include "telemetry.h"
+#include "heard.h"
+#include "demod.h"
+#include "audio_ring.h"
 
 // geotranz
 
@@ -607,6 +611,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	int line;
 	int channel;
 	int adevice;
+	int adevice_given[MAX_ADEVS];	/* Set by ADEVICE, to detect conflict with IQCHANNEL. */
 	int m;
 
 #if DEBUG
@@ -636,8 +641,13 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 
 	p_audio_config->adev[0].defined = 1;
 
+	memset (adevice_given, 0, sizeof(adevice_given));
+
+	p_audio_config->iq.spacing = DEFAULT_IQ_SPACING;
+	p_audio_config->iq.format = DEFAULT_IQ_FORMAT;
+
 	for (channel=0; channel<MAX_CHANS; channel++) {
-	  int ot;
+	  int ot, p;
 
 	  p_audio_config->achan[channel].valid = 0;				/* One or both channels will be */
 								/* set to valid when corresponding */
@@ -656,6 +666,12 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	  p_audio_config->achan[channel].fix_bits = DEFAULT_FIX_BITS;
 	  p_audio_config->achan[channel].sanity_test = SANITY_APRS;
 	  p_audio_config->achan[channel].passall = 0;
+	  p_audio_config->achan[channel].fix_soft = 0;
+	  p_audio_config->achan[channel].rx_hold_bits = DEFAULT_RX_HOLD_BITS;
+	  p_audio_config->achan[channel].trigger_seconds = 0;
+	  p_audio_config->achan[channel].trigger_events = 0;
+	  p_audio_config->achan[channel].trigger_fix = RETRY_INVERT_SINGLE;
+	  strlcpy (p_audio_config->achan[channel].trigger_dir, "", sizeof(p_audio_config->achan[channel].trigger_dir));
 
 	  for (ot = 0; ot < NUM_OCTYPES; ot++) {
 	    p_audio_config->achan[channel].octrl[ot].ptt_method = PTT_METHOD_NONE;
@@ -673,6 +689,15 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	  p_audio_config->achan[channel].persist = DEFAULT_PERSIST;				
 	  p_audio_config->achan[channel].txdelay = DEFAULT_TXDELAY;				
 	  p_audio_config->achan[channel].txtail = DEFAULT_TXTAIL;				
+	  p_audio_config->achan[channel].max_burst = 0;
+	  p_audio_config->achan[channel].digi_latency = 0;
+
+	  for (p = 0; p < TQ_NUM_PRIO; p++) {
+	    p_audio_config->achan[channel].txq_limit_prio[p] = DEFAULT_TXQ_LIMIT;
+	  }
+	  for (p = 0; p < TQ_NUM_SRC; p++) {
+	    p_audio_config->achan[channel].txq_limit_src[p] = 0;
+	  }
 	}
 
 	/* First channel should always be valid. */
@@ -740,6 +765,11 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	p_misc_config->sb_turn_angle = 30;	/* degrees */
 	p_misc_config->sb_turn_slope = 255;	/* degrees * MPH */
 
+	p_misc_config->tlm_max_stations = TLM_DEFAULT_STATIONS;
+	p_misc_config->heard_max_stations = HEARD_DEFAULT_STATIONS;
+	p_misc_config->dsp_stats_interval = 0;
+	strlcpy (p_misc_config->dsp_stats_file, "", sizeof(p_misc_config->dsp_stats_file));
+
 	memset (p_igate_config, 0, sizeof(struct igate_config_s));
 	p_igate_config->t2_server_port = DEFAULT_IGATE_PORT;
 	p_igate_config->tx_chan = -1;			/* IS->RF not enabled */
@@ -756,6 +786,8 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	strlcpy (p_misc_config->gpsnmea_port, "", sizeof(p_misc_config->gpsnmea_port));
 	strlcpy (p_misc_config->nmea_port, "", sizeof(p_misc_config->nmea_port));
 	strlcpy (p_misc_config->logdir, "", sizeof(p_misc_config->logdir));
+	strlcpy (p_misc_config->capture_dir, "", sizeof(p_misc_config->capture_dir));
+	p_misc_config->capture_max_mb = 100;
 
 
 /* 
@@ -863,6 +895,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    }
 
 	    p_audio_config->adev[adevice].defined = 1;
+	    adevice_given[adevice] = 1;
 	
 	    /* First channel of device is valid. */
 	    p_audio_config->achan[ADEVFIRSTCHAN(adevice)].valid = 1;
@@ -1005,6 +1038,128 @@ void config_init (char *fname, struct audio_s *p_audio_config,
    	    }
 	  }
 
+/*
+ * IQINPUT  source  rate  [ format ]
+ *
+ *		Wideband I/Q input to be split into several radio channels.
+ *		See channelizer.c.
+ *
+ *		source	- File name, "-" or "stdin", or "udp:port".
+ *		rate	- Complex samples per second.
+ *		format	- CU8 (default, as from rtl_sdr), CS8, CS16, or CF32.
+ *
+ *		Example:  rtl_sdr -f 144.5M -s 1.6M - | direwolf
+ *
+ *			IQINPUT  -  1600000  CU8
+ */
+
+	  else if (strcasecmp(t, "IQINPUT") == 0) {
+#if __WIN32__
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Line %d: IQINPUT is not available for Windows.\n", line);
+#else
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing source for IQINPUT command.\n", line);
+	      continue;
+	    }
+	    strlcpy (p_audio_config->iq.source, t, sizeof(p_audio_config->iq.source));
+
+	    t = split(NULL,0);
+	    if (t == NULL || atoi(t) <= 0) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing or invalid sample rate for IQINPUT command.\n", line);
+	      strlcpy (p_audio_config->iq.source, "", sizeof(p_audio_config->iq.source));
+	      continue;
+	    }
+	    p_audio_config->iq.samples_per_sec = atoi(t);
+
+	    t = split(NULL,0);
+	    if (t != NULL) {
+	      if (strcasecmp(t, "CU8") == 0) p_audio_config->iq.format = IQ_FORMAT_CU8;
+	      else if (strcasecmp(t, "CS8") == 0) p_audio_config->iq.format = IQ_FORMAT_CS8;
+	      else if (strcasecmp(t, "CS16") == 0) p_audio_config->iq.format = IQ_FORMAT_CS16;
+	      else if (strcasecmp(t, "CF32") == 0) p_audio_config->iq.format = IQ_FORMAT_CF32;
+	      else {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Line %d: I/Q format must be CU8, CS8, CS16, or CF32.\n", line);
+	      }
+	    }
+#endif
+	  }
+
+/*
+ * IQSPACING  hz	- Distance between channels of the I/Q input.
+ *			  I/Q rate / spacing must be a power of 2.
+ */
+
+	  else if (strcasecmp(t, "IQSPACING") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing channel spacing for IQSPACING command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+	    if (n >= MIN_SAMPLES_PER_SEC / 2 && n <= MAX_SAMPLES_PER_SEC) {
+	      p_audio_config->iq.spacing = n;
+	    }
+	    else {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: I/Q channel spacing should be in range of %d to %d Hz.\n",
+						line, MIN_SAMPLES_PER_SEC / 2, MAX_SAMPLES_PER_SEC);
+	    }
+	  }
+
+/*
+ * IQCHANNEL  chan  offset	- Radio channel from I/Q input.
+ *
+ *		offset is the frequency, in Hz, relative to the center of the
+ *		I/Q input.  It must be a multiple of IQSPACING.
+ *
+ *		Channels 2n and 2n+1 take the place of audio device n.
+ *		They are receive only.  This also selects the channel
+ *		for following commands, like CHANNEL.
+ *
+ *		Example:  Center at 144.54 MHz, APRS at 144.39 and 144.99 MHz.
+ *
+ *			IQSPACING 12500
+ *			IQCHANNEL 0 -150000
+ *			IQCHANNEL 1 450000
+ */
+
+	  else if (strcasecmp(t, "IQCHANNEL") == 0) {
+	    int n, a;
+	    t = split(NULL,0);
+	    if (t == NULL || atoi(t) < 0 || atoi(t) >= MAX_CHANS) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing or invalid channel number for IQCHANNEL command.  Must be 0 - %d.\n", line, MAX_CHANS - 1);
+	      continue;
+	    }
+	    n = atoi(t);
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing frequency offset for IQCHANNEL command.\n", line);
+	      continue;
+	    }
+
+	    p_audio_config->iq.chan_used[n] = 1;
+	    p_audio_config->iq.chan_offset[n] = atoi(t);
+	    p_audio_config->achan[n].valid = 1;
+
+	    a = ACHAN2ADEV(n);
+	    p_audio_config->adev[a].defined = 1;
+	    strlcpy (p_audio_config->adev[a].adevice_in, "iq", sizeof(p_audio_config->adev[a].adevice_in));
+	    if (n == ADEVFIRSTCHAN(a) + 1) {
+	      p_audio_config->adev[a].num_channels = 2;
+	    }
+
+	    channel = n;
+	  }
+
 /*
  * ==================== Radio channel parameters ==================== 
  */
@@ -1377,9 +1532,10 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 
 
 /*
- * FIX_BITS  n  [ APRS | AX25 | NONE ] [ PASSALL ]
+ * FIX_BITS  n  [ APRS | AX25 | NONE ] [ PASSALL ] [ SOFT[=k] ]
  *
  *	- Attempt to fix frames with bad FCS. 
+ *	  SOFT means try only the k bits with lowest confidence, and pairs of them.
  */
 
 	  else if (strcasecmp(t, "FIX_BITS") == 0) {
@@ -1427,6 +1583,19 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      else if (strcasecmp(t, "NONE") == 0) {
 	        p_audio_config->achan[channel].sanity_test = SANITY_NONE;
 	      }
+	      else if (strncasecmp(t, "SOFT", 4) == 0 && (t[4] == '\0' || t[4] == '=')) {
+	        int k = t[4] == '=' ? atoi(t+5) : DEFAULT_FIX_SOFT;
+
+	        if (k >= 1 && k <= MAX_FIX_SOFT) {
+	          p_audio_config->achan[channel].fix_soft = k;
+	        }
+	        else {
+	          p_audio_config->achan[channel].fix_soft = DEFAULT_FIX_SOFT;
+	          text_color_set(DW_COLOR_ERROR);
+                  dw_printf ("Line %d: Number of bits for FIX_BITS SOFT option should be 1 to %d.  Using %d.\n",
+			line, MAX_FIX_SOFT, DEFAULT_FIX_SOFT);
+	        }
+	      }
 	      else if (strcasecmp(t, "PASSALL") == 0) {
 	        p_audio_config->achan[channel].passall = 1;
 	        text_color_set(DW_COLOR_ERROR);
@@ -1443,6 +1612,118 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    }
 	  }
 
+/*
+ * RXHOLD  n
+ *
+ *	- With multiple demodulators or slicers, wait n bit times after the
+ *	  first good frame, for the others, before picking the best.
+ *	  Smaller values reduce latency.  Default 2.
+ */
+
+	  else if (strcasecmp(t, "RXHOLD") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing number of bit times for RXHOLD command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+            if (n >= 0 && n <= MAX_RX_HOLD_BITS) {
+	      p_audio_config->achan[channel].rx_hold_bits = n;
+	    }
+	    else {
+	      p_audio_config->achan[channel].rx_hold_bits = DEFAULT_RX_HOLD_BITS;
+	      text_color_set(DW_COLOR_ERROR);
+              dw_printf ("Line %d: Invalid number of bit times for RXHOLD. Using %d.\n", 
+			line, p_audio_config->achan[channel].rx_hold_bits);
+	    }
+	    if (n == 0) {
+	      text_color_set(DW_COLOR_INFO);
+              dw_printf ("Line %d: With RXHOLD 0, the same frame from different demodulators will often be processed more than once.\n", line);
+	    }
+	  }
+
+/*
+ * AUDIOTRIGGER  seconds  directory  [ CRC ] [ DCD ] [ FIX=n ]
+ *
+ *	- Keep the last few seconds of received audio and save it to a
+ *	  WAV file in the directory when a frame can't be decoded (CRC),
+ *	  data carrier is detected without a frame (DCD), or a frame
+ *	  needed at least n for FIX_BITS.  Default is CRC.
+ */
+
+	  else if (strcasecmp(t, "AUDIOTRIGGER") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing number of seconds for AUDIOTRIGGER command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+	    if (n < 1 || n > 60) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Number of seconds for AUDIOTRIGGER should be 1 to 60.\n", line);
+	      continue;
+	    }
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing directory name for AUDIOTRIGGER command.\n", line);
+	      continue;
+	    }
+	    p_audio_config->achan[channel].trigger_seconds = n;
+	    strlcpy (p_audio_config->achan[channel].trigger_dir, t, sizeof(p_audio_config->achan[channel].trigger_dir));
+	    p_audio_config->achan[channel].trigger_events = 0;
+
+	    t = split(NULL,0);
+	    while (t != NULL) {
+	      if (strcasecmp(t, "CRC") == 0) {
+	        p_audio_config->achan[channel].trigger_events |= AUDIO_TRIGGER_CRC;
+	      }
+	      else if (strcasecmp(t, "DCD") == 0) {
+	        p_audio_config->achan[channel].trigger_events |= AUDIO_TRIGGER_DCD;
+	      }
+	      else if (strncasecmp(t, "FIX=", 4) == 0 && atoi(t+4) > RETRY_NONE && atoi(t+4) < RETRY_MAX) {
+	        p_audio_config->achan[channel].trigger_events |= AUDIO_TRIGGER_FIX;
+	        p_audio_config->achan[channel].trigger_fix = (retry_t)atoi(t+4);
+	      }
+	      else {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Line %d: Invalid option '%s' for AUDIOTRIGGER.\n", line, t);
+	      }
+	      t = split(NULL,0);
+	    }
+	    if (p_audio_config->achan[channel].trigger_events == 0) {
+	      p_audio_config->achan[channel].trigger_events = AUDIO_TRIGGER_CRC;
+	    }
+	  }
+
+/*
+ * DEMODTUNE  name=value  [ name=value ... ]
+ *
+ *	- Override demodulator parameters normally selected by the
+ *	  profile letter.  Typically from "atest -S" parameter sweep.
+ *	  Multiple lines accumulate.  See demod_tune_parse for names.
+ */
+
+	  else if (strcasecmp(t, "DEMODTUNE") == 0) {
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing name=value for DEMODTUNE command.\n", line);
+	      continue;
+	    }
+	    while (t != NULL) {
+	      if (demod_tune_parse (&(p_audio_config->achan[channel].tune), t) != 0) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Line %d: Ignoring invalid DEMODTUNE option.\n", line);
+	      }
+	      t = split(NULL,0);
+	    }
+	  }
+
 
 /*
  * PTT 		- Push To Talk signal line.
@@ -1834,6 +2115,102 @@ void config_init (char *fname, struct audio_s *p_audio_config,
    	    }
 	  }
 
+/*
+ * MAXBURST  n		- Combine queued frames into one transmission lasting up to n mSec.
+ *			  0 to send only one digipeated frame, or up to 7 others, at a time.
+ */
+
+	  else if (strcasecmp(t, "MAXBURST") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing time for MAXBURST command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+            if (n >= 0 && n <= 60000) {
+	      p_audio_config->achan[channel].max_burst = n;
+	    }
+	    else {
+	      p_audio_config->achan[channel].max_burst = 0;
+	      text_color_set(DW_COLOR_ERROR);
+              dw_printf ("Line %d: Invalid time for MAXBURST. Using %d.\n", 
+			line, p_audio_config->achan[channel].max_burst);
+   	    }
+	  }
+
+/*
+ * DIGILATENCY  n	- With MAXBURST, don't add low priority frames after n mSec
+ *			  so digipeated frames don't wait too long.
+ */
+
+	  else if (strcasecmp(t, "DIGILATENCY") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing time for DIGILATENCY command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+            if (n >= 0 && n <= 60000) {
+	      p_audio_config->achan[channel].digi_latency = n;
+	    }
+	    else {
+	      p_audio_config->achan[channel].digi_latency = 0;
+	      text_color_set(DW_COLOR_ERROR);
+              dw_printf ("Line %d: Invalid time for DIGILATENCY. Using %d.\n", 
+			line, p_audio_config->achan[channel].digi_latency);
+   	    }
+	  }
+
+/*
+ * TXQLIMIT  { HI | LO | source }  n	- Transmit queue length limit for current channel.
+ *
+ *		HI and LO apply to the high and low priority queues.
+ *		Source is one of BEACON, DIGI, IGATE, KISS, AGW, APRSTT, OTHER
+ *		and limits the number of packets waiting from that source.
+ *		Only APRS packets are counted against the limit.  0 for no limit.
+ */
+
+	  else if (strcasecmp(t, "TXQLIMIT") == 0) {
+	    int n, src;
+	    char *which;
+
+	    which = split(NULL,0);
+	    t = split(NULL,0);
+	    if (which == NULL || t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: TXQLIMIT requires HI, LO, or source name and a number.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+	    if (n < 0 || n > 10000) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Invalid transmit queue limit %s.\n", line, t);
+	      continue;
+	    }
+	    if (strcasecmp(which, "HI") == 0) {
+	      p_audio_config->achan[channel].txq_limit_prio[TQ_PRIO_0_HI] = n;
+	      continue;
+	    }
+	    if (strcasecmp(which, "LO") == 0) {
+	      p_audio_config->achan[channel].txq_limit_prio[TQ_PRIO_1_LO] = n;
+	      continue;
+	    }
+	    for (src = 0; src < TQ_NUM_SRC; src++) {
+	      if (strcasecmp(which, tq_src_name(src)) == 0) {
+	        p_audio_config->achan[channel].txq_limit_src[src] = n;
+	        break;
+	      }
+	    }
+	    if (src == TQ_NUM_SRC) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: TXQLIMIT needs HI, LO, BEACON, DIGI, IGATE, KISS, AGW, APRSTT, or OTHER, not %s.\n", line, which);
+	    }
+	  }
+
 /*
  * SPEECH  script 
  *
@@ -1932,6 +2309,10 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 							line, message);
 	      continue;
 	    }
+	    if (p_digi_config->alias_pattern[from_chan][to_chan] != NULL) {
+	      free (p_digi_config->alias_pattern[from_chan][to_chan]);
+	    }
+	    p_digi_config->alias_pattern[from_chan][to_chan] = strdup(t);
 
 	    t = split(NULL,0);
 	    if (t == NULL) {
@@ -1947,6 +2328,10 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 							line, message);
 	      continue;
 	    }
+	    if (p_digi_config->wide_pattern[from_chan][to_chan] != NULL) {
+	      free (p_digi_config->wide_pattern[from_chan][to_chan]);
+	    }
+	    p_digi_config->wide_pattern[from_chan][to_chan] = strdup(t);
 
 	    p_digi_config->enabled[from_chan][to_chan] = 1;
 	    p_digi_config->preempt[from_chan][to_chan] = PREEMPT_OFF;
@@ -3863,6 +4248,120 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    }
 	  }
 
+/*
+ * CAPTURE	- Directory name for binary capture of received frames.
+ *
+ * CAPTURE  directory  [ max-MB ]
+ */
+	  else if (strcasecmp(t, "capture") == 0) {
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Config file: Missing directory name for CAPTURE on line %d.\n", line);
+	      continue;
+	    }
+	    strlcpy (p_misc_config->capture_dir, t, sizeof(p_misc_config->capture_dir));
+
+	    t = split(NULL,0);
+	    if (t != NULL) {
+	      int n = atoi(t);
+	      if (n >= 1 && n <= 2000) {
+	        p_misc_config->capture_max_mb = n;
+	      }
+	      else {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Line %d: Invalid file size limit for CAPTURE. Using %d MB.\n", 
+				line, p_misc_config->capture_max_mb);
+	      }
+	    }
+	  }
+
+/*
+ * TLMSTATIONS	- Maximum number of stations with telemetry metadata.
+ *
+ * TLMSTATIONS  n
+ */
+
+	  else if (strcasecmp(t, "TLMSTATIONS") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing number for TLMSTATIONS command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+            if (n >= TLM_MIN_STATIONS && n <= TLM_MAX_STATIONS) {
+	      p_misc_config->tlm_max_stations = n;
+	    }
+	    else {
+	      p_misc_config->tlm_max_stations = TLM_DEFAULT_STATIONS;
+	      text_color_set(DW_COLOR_ERROR);
+              dw_printf ("Line %d: Invalid number of telemetry stations.  Must be in range of %d to %d.  Using %d.\n", 
+			line, TLM_MIN_STATIONS, TLM_MAX_STATIONS, p_misc_config->tlm_max_stations);
+   	    }
+	  }
+
+/*
+ * HEARDSTATIONS	- Maximum number of stations remembered on each channel
+ *			  for the heard list.
+ *
+ * HEARDSTATIONS  n
+ */
+
+	  else if (strcasecmp(t, "HEARDSTATIONS") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing number for HEARDSTATIONS command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+            if (n >= HEARD_MIN_STATIONS && n <= HEARD_MAX_STATIONS) {
+	      p_misc_config->heard_max_stations = n;
+	    }
+	    else {
+	      p_misc_config->heard_max_stations = HEARD_DEFAULT_STATIONS;
+	      text_color_set(DW_COLOR_ERROR);
+              dw_printf ("Line %d: Invalid number of heard stations.  Must be in range of %d to %d.  Using %d.\n", 
+			line, HEARD_MIN_STATIONS, HEARD_MAX_STATIONS, p_misc_config->heard_max_stations);
+   	    }
+	  }
+
+/*
+ * DSPSTATS	- Measure time taken by each step of receive processing.
+ *
+ * DSPSTATS  interval  [ file ]
+ *
+ *	Report every "interval" seconds.
+ *	If a file name is given, it is rewritten in JSON form each time
+ *	instead of printing.
+ */
+
+	  else if (strcasecmp(t, "DSPSTATS") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing interval for DSPSTATS command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+            if (n >= 1 && n <= 86400) {
+	      p_misc_config->dsp_stats_interval = n;
+	    }
+	    else {
+	      text_color_set(DW_COLOR_ERROR);
+              dw_printf ("Line %d: Invalid DSPSTATS interval.  Must be in range of 1 to 86400 seconds.\n", line);
+	      continue;
+   	    }
+	    t = split(NULL,0);
+	    if (t != NULL) {
+	      strlcpy (p_misc_config->dsp_stats_file, t, sizeof(p_misc_config->dsp_stats_file));
+	    }
+	  }
+
 /*
  * BEACON channel delay every message
  *
@@ -4001,6 +4500,94 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 
 	fclose (fp);
 
+/*
+ * Radio channels from wideband I/Q input.
+ * Now that we have everything, check the details and set the
+ * sample rate for the pseudo audio devices.
+ * Twice the channel spacing is preferred for less aliasing.
+ */
+	int nfft = 0;
+	int iq_rate = 0;
+	int iq_ok = 1;
+
+	p_audio_config->iq.num_chans = 0;
+	for (channel = 0; channel < MAX_CHANS; channel++) {
+	  if (p_audio_config->iq.chan_used[channel]) p_audio_config->iq.num_chans++;
+	}
+
+	if (p_audio_config->iq.num_chans > 0) {
+
+	  nfft = p_audio_config->iq.samples_per_sec / p_audio_config->iq.spacing;
+
+	  if (strlen(p_audio_config->iq.source) == 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Config file: IQCHANNEL requires IQINPUT.\n");
+	    iq_ok = 0;
+	  }
+	  else if (nfft < 4 || (nfft & (nfft - 1)) != 0 || nfft * p_audio_config->iq.spacing != p_audio_config->iq.samples_per_sec) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Config file: I/Q sample rate %d must be the channel spacing %d times a power of 2, such as %d.\n",
+			p_audio_config->iq.samples_per_sec, p_audio_config->iq.spacing, p_audio_config->iq.spacing * 128);
+	    iq_ok = 0;
+	  }
+
+	  iq_rate = 2 * p_audio_config->iq.spacing;
+	  if (iq_rate > MAX_SAMPLES_PER_SEC) {
+	    iq_rate = p_audio_config->iq.spacing;
+	  }
+	}
+	else if (strlen(p_audio_config->iq.source) > 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Config file: IQINPUT needs one or more IQCHANNEL.\n");
+	}
+
+	for (channel = 0; channel < MAX_CHANS; channel++) {
+	  int off = p_audio_config->iq.chan_offset[channel];
+
+	  if ( ! p_audio_config->iq.chan_used[channel]) continue;
+
+	  if (iq_ok && (off % p_audio_config->iq.spacing != 0 || abs(off / p_audio_config->iq.spacing) >= nfft / 2)) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Config file: IQCHANNEL %d offset %d must be a multiple of %d and less than %d.\n",
+			channel, off, p_audio_config->iq.spacing, p_audio_config->iq.spacing * (nfft / 2));
+	    p_audio_config->iq.chan_used[channel] = 0;
+	  }
+	  else if ((channel & 1) && ! p_audio_config->iq.chan_used[channel - 1]) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Config file: IQCHANNEL %d also needs IQCHANNEL %d.\n", channel, channel - 1);
+	    p_audio_config->iq.chan_used[channel] = 0;
+	  }
+	  if ( ! iq_ok) {
+	    p_audio_config->iq.chan_used[channel] = 0;
+	  }
+	  if ( ! p_audio_config->iq.chan_used[channel]) {
+	    p_audio_config->achan[channel].valid = 0;
+	    p_audio_config->iq.num_chans--;
+	  }
+	}
+
+	for (adevice = 0; adevice < MAX_ADEVS; adevice++) {
+	  int c0 = ADEVFIRSTCHAN(adevice);
+
+	  if (p_audio_config->iq.chan_used[c0]) {
+	    if (adevice_given[adevice]) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Config file: ADEVICE%d is replaced by I/Q input for channel %d.\n", adevice, c0);
+	    }
+	    p_audio_config->adev[adevice].defined = 1;
+	    strlcpy (p_audio_config->adev[adevice].adevice_in, "iq", sizeof(p_audio_config->adev[adevice].adevice_in));
+	    strlcpy (p_audio_config->adev[adevice].adevice_out, "", sizeof(p_audio_config->adev[adevice].adevice_out));
+	    p_audio_config->adev[adevice].num_channels = p_audio_config->iq.chan_used[c0 + 1] ? 2 : 1;
+	    p_audio_config->adev[adevice].samples_per_sec = iq_rate;
+	    p_audio_config->adev[adevice].bits_per_sample = 16;
+	    p_audio_config->achan[c0 + 1].valid = p_audio_config->iq.chan_used[c0 + 1];
+	  }
+	  else if (strcmp(p_audio_config->adev[adevice].adevice_in, "iq") == 0) {
+	    /* Only had channels with errors. */
+	    p_audio_config->adev[adevice].defined = 0;
+	  }
+	}
+
 /*
  * A little error checking for option interactions.
  */
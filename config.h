@@ -56,6 +56,21 @@ struct misc_config_s {
 
 	char logdir[80];	/* Directory for saving activity logs. */
 
+	char capture_dir[80];	/* Directory for binary capture of received frames. */
+	int capture_max_mb;	/* Start a new capture file after this many megabytes. */
+
+	int tlm_max_stations;	/* Maximum number of stations with telemetry metadata */
+				/* before least recently used is discarded. */
+
+	int heard_max_stations;	/* Maximum number of stations remembered for each */
+				/* channel in the heard list before least recently */
+				/* heard is discarded. */
+
+	int dsp_stats_interval;	/* Seconds between receive processing time reports. */
+				/* 0 (default) means don't collect. */
+
+	char dsp_stats_file[80];	/* Write report here in JSON form instead of printing. */
+
 	int sb_configured;	/* TRUE if SmartBeaconing is configured. */
 	int sb_fast_speed;	/* MPH */
 	int sb_fast_rate;	/* seconds */
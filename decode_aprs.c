@@ -3893,124 +3893,303 @@ static const char * s_ctcss[NUM_CTCSS] = {
 
 #define sign(x) (((x)>=0)?1:(-1))
 
-static void process_comment (decode_aprs_t *A, char *pstart, int clen)
+
+/*
+ * Originally we used regular expressions to find the special items in
+ * the comment.  That meant about a dozen calls to regexec for every
+ * position, object, and Mic-E packet, including each one going through
+ * the packet filter.  The patterns are simple enough that it is much 
+ * faster to look for them directly.
+ *
+ * These fill in match[] exactly like regexec would, with the original
+ * regular expression shown for each, so the code using the results
+ * did not need to change.
+ */
+
+#define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+#define IS_OCTAL(c) ((c) >= '0' && (c) <= '7')
+#define IS_UPPER(c) ((c) >= 'A' && (c) <= 'Z')
+#define IS_LOWER(c) ((c) >= 'a' && (c) <= 'z')
+
+static void set_match (regmatch_t *m, int so, int eo)
 {
-	static int first_time = 1;
-	static regex_t std_freq_re;	/* Frequency in standard format. */
-	static regex_t std_tone_re;	/* Tone in standard format. */
-	static regex_t std_toff_re;	/* Explicitly no tone. */
-	static regex_t std_dcs_re;	/* Digital codes squelch in standard format. */
-	static regex_t std_offset_re;	/* Xmit freq offset in standard format. */
-	static regex_t std_range_re;	/* Range in standard format. */
+	m->rm_so = so;
+	m->rm_eo = eo;
+}
 
-	static regex_t dao_re;		/* DAO */
-	static regex_t alt_re;		/* /A= altitude */
 
-	static regex_t bad_freq_re;	/* Likely frequency, not standard format */
-	static regex_t bad_tone_re;	/* Likely tone, not standard format */
+/*
+ * Frequency, tone, DCS, offset, and range must be at the beginning.
+ * They are optionally preceded by space or /.
+ *
+ *	^[/ ]?([0-9A-O][0-9][0-9]\.[0-9][0-9][0-9 ])([Mm][Hh][Zz])
+ *
+ * Third fractional digit can be space instead.
+ * "MHz" should be exactly that capitalization.  
+ * Print warning later it not.
+ */
 
-	static regex_t base91_tel_re;	/* Base 91 compressed telemetry data. */
+static int scan_std_freq (const char *s, regmatch_t *match)
+{
+	const char *p = s;
 
-	int e;
-	char emsg[100];
-#define MAXMATCH 4
-	regmatch_t match[MAXMATCH];
-	char temp[sizeof(A->g_comment)];
-	int keep_going;
+	if (*p == '/' || *p == ' ') p++;
+
+	if ((IS_DIGIT(p[0]) || (p[0] >= 'A' && p[0] <= 'O')) &&
+	    IS_DIGIT(p[1]) && IS_DIGIT(p[2]) && p[3] == '.' &&
+	    IS_DIGIT(p[4]) && IS_DIGIT(p[5]) && (IS_DIGIT(p[6]) || p[6] == ' ') &&
+	    (p[7] == 'M' || p[7] == 'm') && (p[8] == 'H' || p[8] == 'h') && (p[9] == 'Z' || p[9] == 'z')) {
+
+	  set_match (&match[0], 0, (p - s) + 10);
+	  set_match (&match[1], p - s, (p - s) + 7);
+	  set_match (&match[2], (p - s) + 7, (p - s) + 10);
+	  return (1);
+	}
+	return (0);
+}
 
 
 /*
- * No sense in recompiling the patterns and freeing every time.
- */	
-	if (first_time) 
-	{
-/*
- * Frequency must be at the at the beginning.
- * Others can be anywhere in the comment.
+ * All of these can appear, in any order, after a possible frequency.
+ * The first character tells us which one it might be so
+ * we need to look at the beginning of the comment only once.
+ *
+ *	^[/ ]?([TtCc][012][0-9][0-9])	Tone.  
+ *					If no tone, we might gobble up / after any data extension,
+ *					We could also have a space but it's not required.
+ *					I don't understand the difference between T and C so treat the same for now.
+ *	^[/ ]?[TtCc][Oo][Ff][Ff]	Explicitly no tone.
+ *	^[/ ]?[Dd]([0-7][0-7][0-7])	Digital code squelch.
+ *	^[/ ]?([+-][0-9][0-9][0-9])	Transmit frequency offset.
+ *	^[/ ]?[Rr]([0-9][0-9])([mk])	Range.
  */
-		
-	  //e = regcomp (&freq_re, "^[0-9A-O][0-9][0-9]\\.[0-9][0-9][0-9 ]MHz( [TCDtcd][0-9][0-9][0-9]| Toff)?( [+-][0-9][0-9][0-9])?", REG_EXTENDED);
 
-	  // Freq optionally preceded by space or /.
-	  // Third fractional digit can be space instead.
-	  // "MHz" should be exactly that capitalization.  
-	  // Print warning later it not.
+enum std_item_e { STD_NONE, STD_TONE, STD_TOFF, STD_DCS, STD_OFFSET, STD_RANGE };
 
-	  e = regcomp (&std_freq_re, "^[/ ]?([0-9A-O][0-9][0-9]\\.[0-9][0-9][0-9 ])([Mm][Hh][Zz])", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &std_freq_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
-	  }
+static enum std_item_e scan_std_item (const char *s, regmatch_t *match)
+{
+	const char *p = s;
+	int n;
 
-	  // If no tone, we might gobble up / after any data extension,
-	  // We could also have a space but it's not required.
-	  // I don't understand the difference between T and C so treat the same for now.
-	  // We can also have "off" instead of number to explicitly mean none.
+	if (*p == '/' || *p == ' ') p++;
+	n = p - s;
 
-	  e = regcomp (&std_tone_re, "^[/ ]?([TtCc][012][0-9][0-9])", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &std_tone_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
-	  }
+	switch (*p) {
 
-	  e = regcomp (&std_toff_re, "^[/ ]?[TtCc][Oo][Ff][Ff]", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &std_toff_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
-	  }
+	  case 'T': case 't': case 'C': case 'c':
+	    if (p[1] >= '0' && p[1] <= '2' && IS_DIGIT(p[2]) && IS_DIGIT(p[3])) {
+	      set_match (&match[0], 0, n + 4);
+	      set_match (&match[1], n, n + 4);
+	      return (STD_TONE);
+	    }
+	    if ((p[1] == 'O' || p[1] == 'o') && (p[2] == 'F' || p[2] == 'f') && (p[3] == 'F' || p[3] == 'f')) {
+	      set_match (&match[0], 0, n + 4);
+	      return (STD_TOFF);
+	    }
+	    break;
 
-	  e = regcomp (&std_dcs_re, "^[/ ]?[Dd]([0-7][0-7][0-7])", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &std_dcs_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
-	  }
-	  e = regcomp (&std_offset_re, "^[/ ]?([+-][0-9][0-9][0-9])", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &std_offset_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
-	  }
+	  case 'D': case 'd':
+	    if (IS_OCTAL(p[1]) && IS_OCTAL(p[2]) && IS_OCTAL(p[3])) {
+	      set_match (&match[0], 0, n + 4);
+	      set_match (&match[1], n + 1, n + 4);
+	      return (STD_DCS);
+	    }
+	    break;
 
-	  e = regcomp (&std_range_re, "^[/ ]?[Rr]([0-9][0-9])([mk])", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &std_range_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
-	  }
+	  case '+': case '-':
+	    if (IS_DIGIT(p[1]) && IS_DIGIT(p[2]) && IS_DIGIT(p[3])) {
+	      set_match (&match[0], 0, n + 4);
+	      set_match (&match[1], n, n + 4);
+	      return (STD_OFFSET);
+	    }
+	    break;
 
-	  e = regcomp (&dao_re, "!([A-Z][0-9 ][0-9 ]|[a-z][!-{ ][!-{ ]|T[0-9 B][0-9 ])!", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &dao_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
-	  }
+	  case 'R': case 'r':
+	    if (IS_DIGIT(p[1]) && IS_DIGIT(p[2]) && (p[3] == 'm' || p[3] == 'k')) {
+	      set_match (&match[0], 0, n + 4);
+	      set_match (&match[1], n + 1, n + 3);
+	      set_match (&match[2], n + 3, n + 4);
+	      return (STD_RANGE);
+	    }
+	    break;
+	}
+	return (STD_NONE);
+}
+
+
+/*
+ * Base 91 compressed telemetry data.
+ *
+ *	\|([!-{]{4,14})\|
+ *
+ * '|' is not in the range of base 91 digits so the first
+ * one not a digit must be the closing '|'.
+ *
+ * TODO:  Would like to restrict to even length.
+ */
 
-	  e = regcomp (&alt_re, "/A=[0-9][0-9][0-9][0-9][0-9][0-9]", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &alt_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
+static int scan_base91_tel (const char *s, regmatch_t *match)
+{
+	const char *p;
+	int k;
+
+	for (p = strchr(s, '|'); p != NULL; p = strchr(p + 1, '|')) {
+	  for (k = 0; isdigit91(p[1+k]); k++) ;
+	  if (k >= 4 && k <= 14 && p[1+k] == '|') {
+	    set_match (&match[0], p - s, (p - s) + k + 2);
+	    set_match (&match[1], (p - s) + 1, (p - s) + k + 1);
+	    return (1);
 	  }
+	}
+	return (0);
+}
+
 
-	  e = regcomp (&bad_freq_re, "[0-9][0-9][0-9]\\.[0-9][0-9][0-9]?", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &bad_freq_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
+/*
+ * !DAO!
+ *
+ *	!([A-Z][0-9 ][0-9 ]|[a-z][!-{ ][!-{ ]|T[0-9 B][0-9 ])!
+ */
+
+static int scan_dao (const char *s, regmatch_t *match)
+{
+	const char *p;
+
+	for (p = strchr(s, '!'); p != NULL; p = strchr(p + 1, '!')) {
+	  int d = p[1];
+	  int a, o;
+
+	  if (d == '\0') break;
+	  a = p[2];
+	  if (a == '\0') break;
+	  o = p[3];
+	  if (o == '\0') break;
+
+	  if (p[4] != '!') continue;
+
+	  if ((IS_UPPER(d) && (IS_DIGIT(a) || a == ' ' || (d == 'T' && a == 'B')) && (IS_DIGIT(o) || o == ' ')) ||
+	      (IS_LOWER(d) && (isdigit91(a) || a == ' ') && (isdigit91(o) || o == ' '))) {
+	    set_match (&match[0], p - s, (p - s) + 5);
+	    set_match (&match[1], (p - s) + 1, (p - s) + 4);
+	    return (1);
 	  }
+	}
+	return (0);
+}
+
+
+/*
+ * Altitude.
+ *
+ *	/A=[0-9][0-9][0-9][0-9][0-9][0-9]
+ */
 
-	  e = regcomp (&bad_tone_re, "(^|[^0-9.])([6789][0-9]\\.[0-9]|[12][0-9][0-9]\\.[0-9]|67|77|100|123)($|[^0-9.])", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &bad_tone_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
+static int scan_alt (const char *s, regmatch_t *match)
+{
+	const char *p;
+
+	for (p = strstr(s, "/A="); p != NULL; p = strstr(p + 1, "/A=")) {
+	  if (IS_DIGIT(p[3]) && IS_DIGIT(p[4]) && IS_DIGIT(p[5]) &&
+	      IS_DIGIT(p[6]) && IS_DIGIT(p[7]) && IS_DIGIT(p[8])) {
+	    set_match (&match[0], p - s, (p - s) + 9);
+	    return (1);
 	  }
+	}
+	return (0);
+}
 
-// TODO:  Would like to restrict to even length something like this:  ([!-{][!-{]){2,7}
 
-	  e = regcomp (&base91_tel_re, "\\|([!-{]{4,14})\\|", REG_EXTENDED);
-	  if (e) {
-	    regerror (e, &base91_tel_re, emsg, sizeof(emsg));
-	    dw_printf("%s:%d: %s\n", __FILE__, __LINE__, emsg);
+/*
+ * Likely frequency, not standard format.
+ *
+ *	[0-9][0-9][0-9]\.[0-9][0-9][0-9]?
+ */
+
+static int scan_bad_freq (const char *s, regmatch_t *match)
+{
+	const char *p;
+
+	for (p = strchr(s, '.'); p != NULL; p = strchr(p + 1, '.')) {
+	  if (p - s >= 3 && IS_DIGIT(p[-3]) && IS_DIGIT(p[-2]) && IS_DIGIT(p[-1]) &&
+	      IS_DIGIT(p[1]) && IS_DIGIT(p[2])) {
+	    set_match (&match[0], (p - s) - 3, (p - s) + (IS_DIGIT(p[3]) ? 4 : 3));
+	    return (1);
 	  }
+	}
+	return (0);
+}
 
-	  first_time = 0;
+
+/*
+ * Likely tone, not standard format.
+ *
+ *	(^|[^0-9.])([6789][0-9]\.[0-9]|[12][0-9][0-9]\.[0-9]|67|77|100|123)($|[^0-9.])
+ *
+ * At most one of the alternatives can be followed by the required terminator
+ * so the first one found is the only one.
+ */
+
+static int bad_tone_len (const char *p)
+{
+	int n = 0;
+
+	if (p[0] >= '6' && p[0] <= '9' && IS_DIGIT(p[1]) && p[2] == '.' && IS_DIGIT(p[3])) {
+	  n = 4;
+	}
+	else if ((p[0] == '1' || p[0] == '2') && IS_DIGIT(p[1]) && IS_DIGIT(p[2]) && p[3] == '.' && IS_DIGIT(p[4])) {
+	  n = 5;
+	}
+	else if ((p[0] == '6' || p[0] == '7') && p[1] == '7') {
+	  n = 2;
+	}
+	else if (p[0] == '1' && ((p[1] == '0' && p[2] == '0') || (p[1] == '2' && p[2] == '3'))) {
+	  n = 3;
 	}
 
+	if (n > 0 && (IS_DIGIT(p[n]) || p[n] == '.')) {
+	  n = 0;
+	}
+	return (n);
+}
+
+static int scan_bad_tone (const char *s, regmatch_t *match)
+{
+	const char *p;
+	int n;
+
+	for (p = s; *p != '\0'; p++) {
+
+	  if (p == s && IS_DIGIT(*p)) {
+	    n = bad_tone_len (p);
+	    if (n > 0) {
+	      set_match (&match[0], 0, n + (p[n] != '\0'));
+	      set_match (&match[1], 0, 0);
+	      set_match (&match[2], 0, n);
+	      return (1);
+	    }
+	  }
+	  else if ( ! IS_DIGIT(*p) && *p != '.') {
+	    n = bad_tone_len (p + 1);
+	    if (n > 0) {
+	      set_match (&match[0], p - s, (p - s) + 1 + n + (p[1+n] != '\0'));
+	      set_match (&match[1], p - s, (p - s) + 1);
+	      set_match (&match[2], (p - s) + 1, (p - s) + 1 + n);
+	      return (1);
+	    }
+	  }
+	}
+	return (0);
+}
+
+
+static void process_comment (decode_aprs_t *A, char *pstart, int clen)
+{
+#define MAXMATCH 4
+	regmatch_t match[MAXMATCH];
+	char temp[sizeof(A->g_comment)];
+	int keep_going;
+
+
 /*
  * If clen is >= 0, take only specified number of characters.
  * Otherwise, take it all.
@@ -4049,7 +4228,7 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
  * If that fails, try to obtain from object name.
  */
 
-	if (regexec (&std_freq_re, A->g_comment, MAXMATCH, match, 0) == 0) 
+	if (scan_std_freq (A->g_comment, match)) 
 	{
 	  char sftemp[30];
 	  char smtemp[10];
@@ -4117,7 +4296,9 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
 	keep_going = 1;
 	while (keep_going) {
 
-	  if (regexec (&std_tone_re, A->g_comment, MAXMATCH, match, 0) == 0) {
+	  enum std_item_e item = scan_std_item (A->g_comment, match);
+
+	  if (item == STD_TONE) {
 
 	    char sttemp[10];	/* includes leading letter */
 	    int f;
@@ -4145,7 +4326,7 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
 	    strlcpy (temp, A->g_comment + match[0].rm_eo, sizeof(temp));
 	    strlcpy (A->g_comment + match[0].rm_so, temp, sizeof(A->g_comment));
 	  }
-	  else if (regexec (&std_toff_re, A->g_comment, MAXMATCH, match, 0) == 0) {
+	  else if (item == STD_TOFF) {
 
 	    dw_printf ("NO tone\n");
 	    A->g_tone = 0;
@@ -4153,7 +4334,7 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
 	    strlcpy (temp, A->g_comment + match[0].rm_eo, sizeof(temp));
 	    strlcpy (A->g_comment + match[0].rm_so, temp, sizeof(A->g_comment));
 	  }
-	  else if (regexec (&std_dcs_re, A->g_comment, MAXMATCH, match, 0) == 0) {
+	  else if (item == STD_DCS) {
 
 	    char sttemp[10];	/* three octal digits */
 
@@ -4164,7 +4345,7 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
 	    strlcpy (temp, A->g_comment + match[0].rm_eo, sizeof(temp));
 	    strlcpy (A->g_comment + match[0].rm_so, temp, sizeof(A->g_comment)-match[0].rm_so);
 	  }
-	  else if (regexec (&std_offset_re, A->g_comment, MAXMATCH, match, 0) == 0) {
+	  else if (item == STD_OFFSET) {
 
 	    char sttemp[10];	/* includes leading sign */
 
@@ -4175,7 +4356,7 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
 	    strlcpy (temp, A->g_comment + match[0].rm_eo, sizeof(temp));
 	    strlcpy (A->g_comment + match[0].rm_so, temp, sizeof(A->g_comment)-match[0].rm_so);
 	  }
-	  else if (regexec (&std_range_re, A->g_comment, MAXMATCH, match, 0) == 0) {
+	  else if (item == STD_RANGE) {
 
 	    char sttemp[10];	/* should be two digits */
 	    char sutemp[10];	/* m for miles or k for km */
@@ -4204,7 +4385,7 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
  */
 
 
-	if (regexec (&base91_tel_re, A->g_comment, MAXMATCH, match, 0) == 0) 
+	if (scan_base91_tel (A->g_comment, match)) 
 	{
 
 	  char tdata[30];	/* Should be 4 to 14 characters. */
@@ -4233,7 +4414,7 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
  * MIC-E has resolution of .01 minute so it would make sense to have it as an option.
  */
 
-	if (regexec (&dao_re, A->g_comment, MAXMATCH, match, 0) == 0) 
+	if (scan_dao (A->g_comment, match)) 
 	{
 
 	  int d = A->g_comment[match[0].rm_so+1];
@@ -4312,7 +4493,7 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
  * Altitude in feet.  /A=123456
  */
 
-	if (regexec (&alt_re, A->g_comment, MAXMATCH, match, 0) == 0) 
+	if (scan_alt (A->g_comment, match)) 
 	{
 
           //dw_printf("start=%d, end=%d\n", (int)(match[0].rm_so), (int)(match[0].rm_eo));
@@ -4333,7 +4514,7 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
  * standardized format.
  * Don't complain if we have already found a valid value.
  */
-	if (A->g_freq == G_UNKNOWN && regexec (&bad_freq_re, A->g_comment, MAXMATCH, match, 0) == 0) 
+	if (A->g_freq == G_UNKNOWN && scan_bad_freq (A->g_comment, match)) 
 	{
 	  char bad[30];
 	  char good[30];
@@ -4359,7 +4540,7 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
 	  }
 	}
 
-	if (A->g_tone == G_UNKNOWN && regexec (&bad_tone_re, A->g_comment, MAXMATCH, match, 0) == 0) 
+	if (A->g_tone == G_UNKNOWN && scan_bad_tone (A->g_comment, match)) 
 	{
 	  char bad1[30];	/* original 99.9 or 999.9 format or one of 67 77 100 123 */
 	  char bad2[30];	/* 99.9 or 999.9 format.  ".0" appended for special cases. */
@@ -4451,6 +4632,11 @@ static void process_comment (decode_aprs_t *A, char *pstart, int clen)
  *
  *		cut -c26-999 tmp/kj4etp-9.txt | decode_aprs.exe
  *
+ *		To measure decoding speed, with a large collection
+ *		of packets, repeated n times:
+ *
+ *		./decode_aprs -b n packets.txt
+ *
  *
  * Restriction:	MIC-E message type can be problematic because it
  *		it can use unprintable characters in the information field.
@@ -4483,6 +4669,67 @@ void nmea_send_waypoint (char *wname_in, double dlat, double dlong, char symtab,
 
 
 
+static void decode_benchmark (int repeat)
+{
+	char stuff[300];
+	char *p;
+	char **lines = NULL;
+	int nlines = 0;
+	int nalloc = 0;
+	int npackets = 0;
+	int n, k;
+	clock_t start, elapsed;
+	float sec;
+
+	while (fgets(stuff, sizeof(stuff), stdin) != NULL) {
+	  p = stuff + strlen(stuff) - 1;
+	  while (p >= stuff && (*p == '\r' || *p == '\n')) {
+	    *p-- = '\0';
+	  }
+	  if (strlen(stuff) == 0 || stuff[0] == '#') {
+	    continue;
+	  }
+	  if (nlines >= nalloc) {
+	    char **more;
+
+	    nalloc = nalloc > 0 ? nalloc * 2 : 1000;
+	    more = realloc (lines, nalloc * sizeof(char *));
+	    if (more == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Out of memory after reading %d lines.\n", nlines);
+	      exit (EXIT_FAILURE);
+	    }
+	    lines = more;
+	  }
+	  lines[nlines++] = strdup(stuff);
+	}
+
+	start = clock();
+	for (k = 0; k < repeat; k++) {
+	  for (n = 0; n < nlines; n++) {
+	    packet_t pp = ax25_from_text(lines[n], 1);
+	    if (pp != NULL) {
+	      decode_aprs_t A;
+	      decode_aprs (&A, pp, 1);
+	      ax25_delete (pp);
+	      npackets++;
+	    }
+	  }
+	}
+	elapsed = clock() - start;
+	sec = (float)elapsed / CLOCKS_PER_SEC;
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("%d packets decoded in %.3f seconds.  %.0f packets per second.\n",
+			npackets, sec, sec > 0 ? npackets / sec : 0);
+
+	for (n = 0; n < nlines; n++) {
+	  free (lines[n]);
+	}
+	free (lines);
+}
+
+
 int main (int argc, char *argv[]) 
 {
 	char stuff[300];
@@ -4510,6 +4757,26 @@ int main (int argc, char *argv[])
  */
 
 #endif	
+
+/*
+ * "-b n" decodes everything n times, without printing, and reports the rate.
+ * Useful for measuring the effect of changes with a large collection of packets.
+ */
+	if (argc >= 3 && strcmp(argv[1], "-b") == 0) {
+	  int repeat = atoi(argv[2]);
+	  argc -= 2;
+	  argv += 2;
+	  if (argc >= 2) {
+	    if (freopen (argv[1], "r", stdin) == NULL) {
+	      fprintf(stderr, "Can't open %s for read.\n", argv[1]);
+	      exit(1);
+	    }
+	  }
+	  text_color_init(0);
+	  decode_benchmark (repeat);
+	  exit (0);
+	}
+
 	if (argc >= 2) {
 	  if (freopen (argv[1], "r", stdin) == NULL) {
 	    fprintf(stderr, "Can't open %s for read.\n", argv[1]);
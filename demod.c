@@ -60,6 +60,7 @@
 #include "textcolor.h"
 #include "demod_9600.h"
 #include "demod_afsk.h"
+#include "dsp_kernel.h"
 
 
 
@@ -118,6 +119,7 @@ int demod_init (struct audio_s *pa)
 	  char just_letters[16];
 	  int num_letters;
 	  int have_plus;
+	  int n;
 
 	  /*
 	   * These are derived from config file parameters.
@@ -393,6 +395,7 @@ int demod_init (struct audio_s *pa)
 		            mark, 
 	                    space,
 			    profile,
+			    &(save_audio_config_p->achan[chan].tune),
 			    D);
 
 	          if (have_plus) {
@@ -449,6 +452,7 @@ int demod_init (struct audio_s *pa)
 			save_audio_config_p->achan[chan].mark_freq, 
 	                save_audio_config_p->achan[chan].space_freq,
 			save_audio_config_p->achan[chan].profiles[0],
+			&(save_audio_config_p->achan[chan].tune),
 			D);
 
 	        if (have_plus) {
@@ -502,6 +506,7 @@ int demod_init (struct audio_s *pa)
 			save_audio_config_p->achan[chan].baud,
 			mark, space,
 			profile,
+			&(save_audio_config_p->achan[chan].tune),
 			D);
 
 	          if (have_plus) {
@@ -562,7 +567,8 @@ int demod_init (struct audio_s *pa)
 	        save_audio_config_p->achan[chan].num_slicers = MAX_SLICERS;
      	      }
 	        
-	      demod_9600_init (UPSAMPLE * save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec, save_audio_config_p->achan[chan].baud, D);
+	      demod_9600_init (UPSAMPLE * save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec, save_audio_config_p->achan[chan].baud,
+				&(save_audio_config_p->achan[chan].tune), D);
 
 	      if (strchr(save_audio_config_p->achan[chan].profiles, '+') != NULL) {
 
@@ -581,6 +587,25 @@ int demod_init (struct audio_s *pa)
 	      break;
 
 	  }  /* switch on modulation type. */
+
+	  /* Signal level reporting rates for the fixed point demodulator. */
+
+	  for (n = 0; n < MAX_SUBCHANS; n++) {
+	    struct demodulator_state_s *D = &demodulator_state[chan][n];
+
+	    if (D->use_fixed) {
+	      D->quick_attack_q31 = Q31(D->quick_attack);
+	      D->sluggish_decay_q31 = Q31(D->sluggish_decay);
+	    }
+	  }
+
+	  if (save_audio_config_p->achan[chan].tune.set != 0) {
+	    char stune[200];
+
+	    demod_tune_format (&(save_audio_config_p->achan[chan].tune), stune, sizeof(stune));
+	    text_color_set(DW_COLOR_DEBUG);
+	    dw_printf ("Channel %d: demodulator tuning %s\n", chan, stune);
+	  }
     
 	 }  /* if channel number is valid */
 
@@ -593,6 +618,148 @@ int demod_init (struct audio_s *pa)
 
 
 
+/*------------------------------------------------------------------
+ *
+ * Name:        demod_tune_parse
+ *
+ * Purpose:     Change one of the demodulator parameters normally
+ *		selected by the profile letter.
+ *
+ * Inputs:      t		- Tuning for one channel.  Accumulates
+ *				  across multiple calls.
+ *
+ *		name_eq_value	- Something like "pll_locked=0.7".
+ *				  Window type can be a name or number.
+ *
+ * Returns:     0 for success, -1 for failure.
+ *		Caller is responsible for printing the error location.
+ *
+ * Description:	This allows the same experimentation as the TUNE_...
+ *		settings in tune.h without recompiling.  The most
+ *		likely source is the output of "atest -S" parameter sweep.
+ *
+ *		Values are not applied until demod_init so the
+ *		profile letter can appear before or after.
+ *
+ *----------------------------------------------------------------*/
+
+/* Keep in same order as enum demod_tune_e in audio.h. */
+
+static const struct {
+	char *name;
+	float min;
+	float max;
+} tune_param[DT_NUM_PARAMS] = {
+	{ "pre_baud",		0.01,	4.0 },
+	{ "pre_len",		0.1,	16.0 },
+	{ "pre_window",		0,	BP_WINDOW_FLATTOP },
+	{ "ms_len",		0.1,	16.0 },
+	{ "ms_window",		0,	BP_WINDOW_FLATTOP },
+	{ "lpf_baud",		0.01,	4.0 },
+	{ "lp_len",		0.1,	16.0 },
+	{ "lp_window",		0,	BP_WINDOW_FLATTOP },
+	{ "agc_fast",		0.0,	1.0 },
+	{ "agc_slow",		0.0,	1.0 },
+	{ "hyst",		0.0,	1.0 },
+	{ "pll_locked",		0.0,	1.0 },
+	{ "pll_searching",	0.0,	1.0 },
+	{ "fixed",		0,	1 } };
+
+static const char *window_name[BP_WINDOW_FLATTOP+1] = { "truncated", "cosine", "hamming", "blackman", "flattop" };
+
+
+int demod_tune_parse (struct demod_tune_s *t, char *name_eq_value)
+{
+	char name[40];
+	char *eq, *value, *endp;
+	int p, w;
+	float f;
+
+	eq = strchr(name_eq_value, '=');
+	if (eq == NULL || eq == name_eq_value || eq - name_eq_value >= (int)sizeof(name)) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Demodulator tuning \"%s\" must be in the form name=value.\n", name_eq_value);
+	  return (-1);
+	}
+	memset (name, 0, sizeof(name));
+	memcpy (name, name_eq_value, eq - name_eq_value);
+	value = eq + 1;
+
+	for (p = 0; p < DT_NUM_PARAMS; p++) {
+	  if (strcasecmp(name, tune_param[p].name) == 0) break;
+	}
+	if (p == DT_NUM_PARAMS) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Unknown demodulator parameter \"%s\".  Expected one of:\n", name);
+	  for (p = 0; p < DT_NUM_PARAMS; p++) {
+	    dw_printf (" %s", tune_param[p].name);
+	  }
+	  dw_printf ("\n");
+	  return (-1);
+	}
+
+	if (p == DT_PRE_WINDOW || p == DT_MS_WINDOW || p == DT_LP_WINDOW) {
+	  for (w = 0; w <= BP_WINDOW_FLATTOP; w++) {
+	    if (strcasecmp(value, window_name[w]) == 0) {
+	      t->value[p] = w;
+	      t->set |= 1 << p;
+	      return (0);
+	    }
+	  }
+	}
+
+	f = strtof (value, &endp);
+	if (endp == value || *endp != '\0' || f < tune_param[p].min || f > tune_param[p].max) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Demodulator parameter %s value \"%s\" must be in range of %g to %g.\n",
+			tune_param[p].name, value, tune_param[p].min, tune_param[p].max);
+	  return (-1);
+	}
+
+	t->value[p] = f;
+	t->set |= 1 << p;
+	return (0);
+
+} /* end demod_tune_parse */
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        demod_tune_format
+ *
+ * Purpose:     Format the demodulator tuning as it would appear
+ *		in the configuration file, for display or saving.
+ *
+ * Outputs:	buf	- Something like "ms_len=1.5 pll_locked=0.7".
+ *			  Empty string if nothing set.
+ *
+ *----------------------------------------------------------------*/
+
+void demod_tune_format (struct demod_tune_s *t, char *buf, size_t buf_size)
+{
+	int p;
+	char stemp[40];
+
+	strlcpy (buf, "", buf_size);
+
+	for (p = 0; p < DT_NUM_PARAMS; p++) {
+	  if (DEMOD_TUNED(t, p)) {
+	    if (p == DT_PRE_WINDOW || p == DT_MS_WINDOW || p == DT_LP_WINDOW) {
+	      snprintf (stemp, sizeof(stemp), "%s%s=%s", buf[0] == '\0' ? "" : " ",
+			tune_param[p].name, window_name[(int)(t->value[p])]);
+	    }
+	    else {
+	      snprintf (stemp, sizeof(stemp), "%s%s=%g", buf[0] == '\0' ? "" : " ",
+			tune_param[p].name, t->value[p]);
+	    }
+	    strlcat (buf, stemp, buf_size);
+	  }
+	}
+
+} /* end demod_tune_format */
+
+
+
 /*------------------------------------------------------------------
  *
  * Name:        demod_get_sample
@@ -718,10 +885,6 @@ void demod_process_sample (int chan, int subchan, int sam)
 	D = &demodulator_state[chan][subchan];
 
 
-	/* Scale to nice number, actually -2.0 to +2.0 for extra headroom */
-
-	fsam = sam / 16384.0f;
-
 /*
  * Accumulate measure of the input signal level.
  */
@@ -732,20 +895,38 @@ void demod_process_sample (int chan, int subchan, int sam)
  * This is same as the later AGC without the normalization step.
  * We want decay to be substantially slower to get a longer
  * range idea of the received audio.
+ *
+ * The fixed point demodulator needs to avoid floating point here too.
+ * Same thing in 1/256 units of the input sample.
  */
 
-	if (fsam >= D->alevel_rec_peak) {
-	  D->alevel_rec_peak = fsam * D->quick_attack + D->alevel_rec_peak * (1.0f - D->quick_attack);
+	if (D->use_fixed) {
+	  int x = sat16(sam) << 8;
+
+	  D->alevel_rec_peak_q = track_q31 (D->alevel_rec_peak_q, x,
+		x >= D->alevel_rec_peak_q ? D->quick_attack_q31 : D->sluggish_decay_q31);
+	  D->alevel_rec_valley_q = track_q31 (D->alevel_rec_valley_q, x,
+		x <= D->alevel_rec_valley_q ? D->quick_attack_q31 : D->sluggish_decay_q31);
 	}
 	else {
-	  D->alevel_rec_peak = fsam * D->sluggish_decay + D->alevel_rec_peak * (1.0f - D->sluggish_decay);
-	}
 
-	if (fsam <= D->alevel_rec_valley) {
-	  D->alevel_rec_valley = fsam * D->quick_attack + D->alevel_rec_valley * (1.0f - D->quick_attack);
-	}
-	else  {   
-	  D->alevel_rec_valley = fsam * D->sluggish_decay + D->alevel_rec_valley * (1.0f - D->sluggish_decay);
+	  /* Scale to nice number, actually -2.0 to +2.0 for extra headroom */
+
+	  fsam = sam / 16384.0f;
+
+	  if (fsam >= D->alevel_rec_peak) {
+	    D->alevel_rec_peak = fsam * D->quick_attack + D->alevel_rec_peak * (1.0f - D->quick_attack);
+	  }
+	  else {
+	    D->alevel_rec_peak = fsam * D->sluggish_decay + D->alevel_rec_peak * (1.0f - D->sluggish_decay);
+	  }
+
+	  if (fsam <= D->alevel_rec_valley) {
+	    D->alevel_rec_valley = fsam * D->quick_attack + D->alevel_rec_valley * (1.0f - D->quick_attack);
+	  }
+	  else  {
+	    D->alevel_rec_valley = fsam * D->sluggish_decay + D->alevel_rec_valley * (1.0f - D->sluggish_decay);
+	  }
 	}
 
 
@@ -844,6 +1025,7 @@ alevel_t demod_get_audio_level (int chan, int subchan)
 {
 	struct demodulator_state_s *D;
 	alevel_t alevel;
+	float mark_peak, space_peak;
 
 	assert (chan >= 0 && chan < MAX_CHANS);
 	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
@@ -858,16 +1040,29 @@ alevel_t demod_get_audio_level (int chan, int subchan)
 
 	D = &demodulator_state[chan][subchan];
 
+	mark_peak = D->alevel_mark_peak;
+	space_peak = D->alevel_space_peak;
+
 	// Take half of peak-to-peak for received audio level.
 
 	alevel.rec = (int) (( D->alevel_rec_peak - D->alevel_rec_valley ) * 50.0f + 0.5f);
 
+	if (D->use_fixed) {
+
+	  /* Convert to same scale as floating point version. */
+
+	  alevel.rec = (int) ((D->alevel_rec_peak_q - D->alevel_rec_valley_q) * (50.0f / (256.0f * 16384.0f)) + 0.5f);
+
+	  mark_peak = D->alevel_mark_peak_q * D->fixed_level_scale;
+	  space_peak = D->alevel_space_peak_q * D->fixed_level_scale;
+	}
+
 	if (save_audio_config_p->achan[chan].modem_type == MODEM_AFSK) {
 
 	  /* For AFSK, we have mark and space amplitudes. */
 
-	  alevel.mark = (int) ((D->alevel_mark_peak ) * 100.0f + 0.5f);
-	  alevel.space = (int) ((D->alevel_space_peak ) * 100.0f + 0.5f);
+	  alevel.mark = (int) ((mark_peak ) * 100.0f + 0.5f);
+	  alevel.space = (int) ((space_peak ) * 100.0f + 0.5f);
 
 	  //alevel.ms_ratio = D->alevel_mark_peak / D->alevel_space_peak;	// TODO: remove after temp test
 	}
@@ -878,8 +1073,8 @@ alevel_t demod_get_audio_level (int chan, int subchan)
 	  /* Normally we'd expect them to be about the same. */
 	  /* However, with SDR, or other DC coupling, we could have an offset. */
 
-	  alevel.mark = (int) ((D->alevel_mark_peak) * 200.0f  + 0.5f);
-	  alevel.space = (int) ((D->alevel_space_peak) * 200.0f - 0.5f);
+	  alevel.mark = (int) ((mark_peak) * 200.0f  + 0.5f);
+	  alevel.space = (int) ((space_peak) * 200.0f - 0.5f);
 
 
 #else
@@ -888,7 +1083,7 @@ alevel_t demod_get_audio_level (int chan, int subchan)
 	  /* The "5/6" factor worked out right for the current low pass filter. */
 	  /* Will it need to be different if the filter is tweaked? */
 
-	  alevel.mark = (int) ((D->alevel_mark_peak - D->alevel_space_peak) * 100.0f * 5.0f/6.0f + 0.5f);
+	  alevel.mark = (int) ((mark_peak - space_peak) * 100.0f * 5.0f/6.0f + 0.5f);
 	  alevel.space = -1;		/* to print one number inside of ( ) */
 #endif
 	}
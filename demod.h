@@ -8,6 +8,10 @@
 
 int demod_init (struct audio_s *pa);
 
+int demod_tune_parse (struct demod_tune_s *t, char *name_eq_value);
+
+void demod_tune_format (struct demod_tune_s *t, char *buf, size_t buf_size);
+
 int demod_get_sample (int a);
 
 void demod_process_sample (int chan, int subchan, int sam);
@@ -49,10 +49,14 @@
 #include "demod_9600.h"
 #include "textcolor.h"
 #include "dsp.h"
+#include "dsp_stats.h"
+#include "dsp_kernel.h"
 
 
 static float slice_point[MAX_SUBCHANS];
 
+static int slice_point_q15[MAX_SUBCHANS];	/* Same for fixed point. */
+
 
 /* Add sample to buffer and shift the rest down. */
 
@@ -63,62 +67,15 @@ static inline void push_sample (float val, float *buff, int size)
 	buff[0] = val; 
 }
 
-
-/* FIR filter kernel. */
-
 __attribute__((hot)) __attribute__((always_inline))
-static inline float convolve (const float *__restrict__ data, const float *__restrict__ filter, int filter_size)
+static inline void push_sample_q (int val, short *buff, int size)
 {
-	float sum = 0.0f;
-	int j;
-
-#if 0
-	//  As suggested here,  http://locklessinc.com/articles/vectorize/
-	//  Unfortunately, older compilers don't recognize it.
-
-	//  Get more information by using -ftree-vectorizer-verbose=5
-
-	float *d = __builtin_assume_aligned(data, 16);
-	float *f = __builtin_assume_aligned(filter, 16);
-
-#pragma GCC ivdep
-	for (j=0; j<filter_size; j++) {
-	    sum += f[j] * d[j];
-	}
-#else
-#pragma GCC ivdep				// ignored until gcc 4.9
-	for (j=0; j<filter_size; j++) {
-	    sum += filter[j] * data[j];
-	}
-#endif
-	return (sum);
+	memmove(buff+1,buff,(size-1)*sizeof(short));
+	buff[0] = val;
 }
 
-/* Automatic gain control. */
-/* Result should settle down to 1 unit peak to peak.  i.e. -0.5 to +0.5 */
 
-__attribute__((hot)) __attribute__((always_inline))
-static inline float agc (float in, float fast_attack, float slow_decay, float *ppeak, float *pvalley)
-{
-	if (in >= *ppeak) {
-	  *ppeak = in * fast_attack + *ppeak * (1. - fast_attack);
-	}
-	else {
-	  *ppeak = in * slow_decay + *ppeak * (1. - slow_decay);
-	}
-
-	if (in <= *pvalley) {
-	  *pvalley = in * fast_attack + *pvalley * (1. - fast_attack);
-	}
-	else  {   
-	  *pvalley = in * slow_decay + *pvalley * (1. - slow_decay);
-	}
-
-	if (*ppeak > *pvalley) {
-	  return ((in - 0.5 * (*ppeak + *pvalley)) / (*ppeak - *pvalley));
-	}
-	return (0.0);
-}
+/* FIR filter and AGC kernels are in dsp_kernel.c. */
 
 
 /*------------------------------------------------------------------
@@ -133,13 +90,16 @@ static inline float agc (float in, float fast_attack, float slow_decay, float *p
  *
  *		baud		- Data rate in bits per second.
  *
+ *		tune		- Changes to the default parameters, from DEMODTUNE.
+ *				  Can be NULL.
+ *
  *		D		- Address of demodulator state.
  *
  * Returns:     None
  *		
  *----------------------------------------------------------------*/
 
-void demod_9600_init (int samples_per_sec, int baud, struct demodulator_state_s *D)
+void demod_9600_init (int samples_per_sec, int baud, struct demod_tune_s *tune, struct demodulator_state_s *D)
 {	
 	float fc;
 	int j;
@@ -189,6 +149,30 @@ void demod_9600_init (int samples_per_sec, int baud, struct demodulator_state_s
 	D->pll_searching_inertia = TUNE_PLL_SEARCHING;
 #endif
 
+/* Same thing at run time.  Those for AFSK filters are ignored. */
+
+	if (DEMOD_TUNED(tune, DT_LPF_BAUD))	D->lpf_baud = tune->value[DT_LPF_BAUD];
+	if (DEMOD_TUNED(tune, DT_LP_WINDOW))	D->lp_window = (bp_window_t)(tune->value[DT_LP_WINDOW]);
+	if (DEMOD_TUNED(tune, DT_AGC_FAST))	D->agc_fast_attack = tune->value[DT_AGC_FAST];
+	if (DEMOD_TUNED(tune, DT_AGC_SLOW))	D->agc_slow_decay = tune->value[DT_AGC_SLOW];
+	if (DEMOD_TUNED(tune, DT_PLL_LOCKED))	D->pll_locked_inertia = tune->value[DT_PLL_LOCKED];
+	if (DEMOD_TUNED(tune, DT_PLL_SEARCHING)) D->pll_searching_inertia = tune->value[DT_PLL_SEARCHING];
+
+	if (DEMOD_TUNED(tune, DT_LP_LEN)) {
+	  float lp_len = tune->value[DT_LP_LEN];
+	  int lp_size = (int) (( lp_len * (float)samples_per_sec / baud) + 0.5);
+
+	  if (lp_size < 3 || lp_size > MAX_FILTER_SIZE) {
+	    text_color_set (DW_COLOR_ERROR);
+	    dw_printf ("lp_len=%.2f gives filter size %d for %d samples/sec and %d baud.  It must be 3 to %d.  Using %.2f.\n",
+			lp_len, lp_size, samples_per_sec, baud, MAX_FILTER_SIZE, D->lp_filter_len_bits);
+	  }
+	  else {
+	    D->lp_filter_len_bits = lp_len;
+	    D->lp_filter_size = lp_size;
+	  }
+	}
+
 	fc = (float)baud * D->lpf_baud / (float)samples_per_sec;
 
 	//dw_printf ("demod_9600_init: call gen_lowpass(fc=%.2f, , size=%d, )\n", fc, D->lp_filter_size);
@@ -202,6 +186,31 @@ void demod_9600_init (int samples_per_sec, int baud, struct demodulator_state_s
 	  //dw_printf ("slice_point[%d] = %+5.2f\n", j, slice_point[j]);
 	}
 
+/*
+ * Integer fixed point version.
+ */
+
+	if (DEMOD_TUNED(tune, DT_FIXED) && tune->value[DT_FIXED] != 0) {
+
+	  D->use_fixed = 1;
+
+	  D->lp_shift = q15_shift (D->lp_filter, D->lp_filter_size);
+	  gen_q15_filter (D->lp_filter, D->lp_filter_q, D->lp_filter_size, D->lp_shift);
+
+	  D->agc_fast_q31 = Q31(D->agc_fast_attack);
+	  D->agc_slow_q31 = Q31(D->agc_slow_decay);
+	  D->pll_locked_q15 = Q15(D->pll_locked_inertia);
+	  D->pll_searching_q15 = Q15(D->pll_searching_inertia);
+
+	  /* Input is not doubled, for the upsampling, as in the float version. */
+
+	  D->fixed_level_scale = 1.0f / (256.0f * 8192.0f);
+
+	  for (j = 0; j < MAX_SUBCHANS; j++) {
+	    slice_point_q15[j] = Q15(slice_point[j]);
+	  }
+	}
+
 } /* end fsk_demod_init */
 
 
@@ -260,7 +269,11 @@ void demod_9600_init (int samples_per_sec, int baud, struct demodulator_state_s
  *
  *--------------------------------------------------------------------*/
 
-static void inline nudge_pll (int chan, int subchan, int slice, int demod_data, struct demodulator_state_s *D);
+static void inline nudge_pll (int chan, int subchan, int slice, int demod_data, float margin, struct demodulator_state_s *D);
+
+static void nudge_plls (int chan, int subchan, const int *demod_data, const float *margin, struct demodulator_state_s *D);
+
+static void process_sample_fixed (int chan, int sam, struct demodulator_state_s *D);
 
 __attribute__((hot))
 void demod_9600_process_sample (int chan, int sam, struct demodulator_state_s *D)
@@ -279,11 +292,19 @@ void demod_9600_process_sample (int chan, int sam, struct demodulator_state_s *D
 	//int j;
 	int subchan = 0;
 	int demod_data;				/* Still scrambled. */
+	ds_ticks_t t_stage = 0;
 
 
 	assert (chan >= 0 && chan < MAX_CHANS);
 	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
 
+	if (D->use_fixed) {
+	  process_sample_fixed (chan, sam, D);
+	  return;
+	}
+
+	if (dsp_stats_enabled) t_stage = dsp_stats_ticks();
+
 
 /* 
  * Filters use last 'filter_size' samples.
@@ -312,7 +333,9 @@ void demod_9600_process_sample (int chan, int sam, struct demodulator_state_s *D
  * Low pass filter to reduce noise yet pass the data. 
  */
 
-	amp = convolve (D->raw_cb, D->lp_filter, D->lp_filter_size);
+	amp = dsp_kernel.convolve (D->raw_cb, D->lp_filter, D->lp_filter_size);
+
+	if (dsp_stats_enabled) dsp_stats_lap (DS_PREFILTER, chan, subchan, 0, &t_stage);
 
 
 /*
@@ -347,7 +370,7 @@ void demod_9600_process_sample (int chan, int sam, struct demodulator_state_s *D
  * and scaling the results to be roughly in the -1.0 to +1.0 range.
  */
 
-	demod_out = agc (amp, D->agc_fast_attack, D->agc_slow_decay, &(D->m_peak), &(D->m_valley));
+	demod_out = dsp_kernel.agc (amp, D->agc_fast_attack, D->agc_slow_decay, &(D->m_peak), &(D->m_valley));
 
 
 // TODO: There is potential for multiple decoders with one filter.
@@ -368,7 +391,7 @@ void demod_9600_process_sample (int chan, int sam, struct demodulator_state_s *D
 //	  demod_data = 0;
 //	} 
 //	else {
-//	  demod_data = D->slicer[subchan].prev_demod_data;
+//	  demod_data = D->slicer.prev_demod_data[subchan];
 //	}
 
 	if (D->num_slicers <= 1) {
@@ -378,25 +401,33 @@ void demod_9600_process_sample (int chan, int sam, struct demodulator_state_s *D
 	  /* AGC should generally keep this around -1 to +1 range. */
 
 	  demod_data = demod_out > 0;
-	  nudge_pll (chan, subchan, 0, demod_data, D);
+	  nudge_pll (chan, subchan, 0, demod_data, demod_out * 2.0f, D);
 	}
 	else {
 	  int slice;
 
+	  int data[MAX_SLICERS];
+	  float margin[MAX_SLICERS];
+
 	  /* Multiple slicers each feeding its own HDLC decoder. */
 
 	  for (slice=0; slice<D->num_slicers; slice++) {
-	    demod_data = demod_out > slice_point[slice];
-	    nudge_pll (chan, subchan, slice, demod_data, D);
+	    data[slice] = demod_out > slice_point[slice];
+	    margin[slice] = (demod_out - slice_point[slice]) * 2.0f;
 	  }
+	  nudge_plls (chan, subchan, data, margin, D);
 	}
 
 } /* end demod_9600_process_sample */
 
 
 __attribute__((hot))
-static void inline nudge_pll (int chan, int subchan, int slice, int demod_data, struct demodulator_state_s *D)
+static void inline nudge_pll (int chan, int subchan, int slice, int demod_data, float margin, struct demodulator_state_s *D)
 {
+	ds_ticks_t t_start = 0;
+	ds_ticks_t t_hdlc = 0;		/* Time in HDLC so we can exclude it from PLL. */
+
+	if (dsp_stats_enabled) t_start = dsp_stats_ticks();
 
 /*
  * Next, a PLL is used to sample near the centers of the data bits.
@@ -424,10 +455,10 @@ static void inline nudge_pll (int chan, int subchan, int slice, int demod_data,
  * for improvement here.
  */
 
-	D->slicer[slice].prev_d_c_pll = D->slicer[slice].data_clock_pll;
-	D->slicer[slice].data_clock_pll += D->pll_step_per_sample;
+	D->slicer.prev_d_c_pll[slice] = D->slicer.data_clock_pll[slice];
+	D->slicer.data_clock_pll[slice] += D->pll_step_per_sample;
 
-	if (D->slicer[slice].data_clock_pll < 0 && D->slicer[slice].prev_d_c_pll > 0) {
+	if (D->slicer.data_clock_pll[slice] < 0 && D->slicer.prev_d_c_pll[slice] > 0) {
 
 	  /* Overflow. */
 
@@ -442,20 +473,29 @@ static void inline nudge_pll (int chan, int subchan, int slice, int demod_data,
 	  // Warning: 'descram' set but not used.
 	  // It's used in conditional debug code below.
 	  // descram =
-	  descramble (demod_data, &(D->slicer[slice].lfsr));
+	  descramble (demod_data, &(D->slicer.lfsr[slice]));
+
+	  ds_ticks_t t_bit = 0;
+
+	  if (dsp_stats_enabled) t_bit = dsp_stats_ticks();
 
-	  hdlc_rec_bit (chan, subchan, slice, demod_data, 1, D->slicer[slice].lfsr);
+	  hdlc_rec_bit (chan, subchan, slice, demod_data, 1, hdlc_rec_bit_quality(margin));
+
+	  if (dsp_stats_enabled) {
+	    t_hdlc = dsp_stats_ticks() - t_bit;
+	    dsp_stats_record (DS_HDLC, chan, subchan, slice, t_hdlc);
+	  }
 	}
 
-        if (demod_data != D->slicer[slice].prev_demod_data) {
+        if (demod_data != D->slicer.prev_demod_data[slice]) {
 
 	  // Note:  Test for this demodulator, not overall for channel.
 
 	  if (hdlc_rec_gathering (chan, subchan, slice)) {
-	    D->slicer[slice].data_clock_pll = (int)(D->slicer[slice].data_clock_pll * D->pll_locked_inertia);
+	    D->slicer.data_clock_pll[slice] = (int)(D->slicer.data_clock_pll[slice] * D->pll_locked_inertia);
 	  }
 	  else {
-	    D->slicer[slice].data_clock_pll = (int)(D->slicer[slice].data_clock_pll * D->pll_searching_inertia);
+	    D->slicer.data_clock_pll[slice] = (int)(D->slicer.data_clock_pll[slice] * D->pll_searching_inertia);
 	  }
 	}
 
@@ -506,11 +546,281 @@ static void inline nudge_pll (int chan, int subchan, int slice, int demod_data,
  * Remember demodulator output (pre-descrambling) so we can compare next time
  * for the DPLL sync.
  */
-	D->slicer[slice].prev_demod_data = demod_data;
+	D->slicer.prev_demod_data[slice] = demod_data;
+
+	if (dsp_stats_enabled) dsp_stats_record (DS_PLL, chan, subchan, slice, dsp_stats_ticks() - t_start - t_hdlc);
 
 } /* end nudge_pll */
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        nudge_plls
+ *
+ * Purpose:     Same as nudge_pll for all slicers of a demodulator at once.
+ *
+ * Description:	See the function of the same name in demod_afsk.c.
+ *		The only difference is that the data is scrambled.
+ *
+ *--------------------------------------------------------------------*/
+
+__attribute__((hot))
+static void nudge_plls (int chan, int subchan, const int *demod_data, const float *margin, struct demodulator_state_s *D)
+{
+	int n = D->num_slicers;
+	int sampled[MAX_SLICERS];
+	int quality[MAX_SLICERS];
+	const int *gathering;
+	int any = 0;
+	int slice;
+	ds_ticks_t t_start = 0;
+	ds_ticks_t t_hdlc = 0;
+
+	if (dsp_stats_enabled) t_start = dsp_stats_ticks();
+
+	for (slice=0; slice<n; slice++) {
+	  int prev = D->slicer.data_clock_pll[slice];
+	  int next = (int)((unsigned int)prev + (unsigned int)D->pll_step_per_sample);
+
+	  D->slicer.prev_d_c_pll[slice] = prev;
+	  D->slicer.data_clock_pll[slice] = next;
+	  sampled[slice] = (next < 0) & (prev > 0);
+	  any |= sampled[slice];
+	}
+
+	if (any) {
+	  ds_ticks_t t_bit = 0;
+
+	  for (slice=0; slice<n; slice++) {
+	    quality[slice] = 0;
+	    if (sampled[slice]) {
+	      descramble (demod_data[slice], &(D->slicer.lfsr[slice]));
+	      quality[slice] = hdlc_rec_bit_quality(margin[slice]);
+	    }
+	  }
+
+	  if (dsp_stats_enabled) t_bit = dsp_stats_ticks();
+
+	  hdlc_rec_bits (chan, subchan, n, sampled, demod_data, 1, quality);
+
+	  if (dsp_stats_enabled) {
+	    int k = 0;
+
+	    t_hdlc = dsp_stats_ticks() - t_bit;
+	    for (slice=0; slice<n; slice++) k += sampled[slice];
+	    for (slice=0; slice<n; slice++) {
+	      if (sampled[slice]) dsp_stats_record (DS_HDLC, chan, subchan, slice, t_hdlc / k);
+	    }
+	  }
+	}
+
+	gathering = hdlc_rec_gathering_all (chan, subchan);
+
+	for (slice=0; slice<n; slice++) {
+	  float inertia = gathering[slice] ? D->pll_locked_inertia : D->pll_searching_inertia;
+	  int pll = D->slicer.data_clock_pll[slice];
+	  int nudged = (int)(pll * inertia);
+
+	  D->slicer.data_clock_pll[slice] = demod_data[slice] != D->slicer.prev_demod_data[slice] ? nudged : pll;
+	  D->slicer.prev_demod_data[slice] = demod_data[slice];
+	}
+
+	if (dsp_stats_enabled) {
+	  ds_ticks_t t_pll = (dsp_stats_ticks() - t_start - t_hdlc) / n;
+
+	  for (slice=0; slice<n; slice++) {
+	    dsp_stats_record (DS_PLL, chan, subchan, slice, t_pll);
+	  }
+	}
+
+} /* end nudge_plls */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        process_sample_fixed
+ *
+ * Purpose:     Same as demod_9600_process_sample using only integer
+ *		arithmetic, for processors without a fast floating
+ *		point unit.
+ *
+ *--------------------------------------------------------------------*/
+
+static void inline nudge_pll_fixed (int chan, int subchan, int slice, int demod_data, int margin, struct demodulator_state_s *D);
+
+static void nudge_plls_fixed (int chan, int subchan, const int *demod_data, const int *margin, struct demodulator_state_s *D);
+
+__attribute__((hot))
+static void process_sample_fixed (int chan, int sam, struct demodulator_state_s *D)
+{
+	int amp;
+	int demod_out;
+	int subchan = 0;
+	int demod_data;
+	ds_ticks_t t_stage = 0;
+
+	if (dsp_stats_enabled) t_stage = dsp_stats_ticks();
+
+	/* Undo the doubling for the zero stuffing so it fits in 16 bits. */
+
+	push_sample_q (sat16(sam / 2), D->raw_cb_q, D->lp_filter_size);
+
+	amp = sat16(dsp_kernel.convolve_q15 (D->raw_cb_q, D->lp_filter_q, D->lp_filter_size) >> D->lp_shift);
+
+	if (dsp_stats_enabled) dsp_stats_lap (DS_PREFILTER, chan, subchan, 0, &t_stage);
+
+/*
+ * + and - peaks for display.
+ */
+	D->alevel_mark_peak_q = track_q31 (D->alevel_mark_peak_q, amp << 8,
+		(amp << 8) >= D->alevel_mark_peak_q ? D->quick_attack_q31 : D->sluggish_decay_q31);
+	D->alevel_space_peak_q = track_q31 (D->alevel_space_peak_q, amp << 8,
+		(amp << 8) <= D->alevel_space_peak_q ? D->quick_attack_q31 : D->sluggish_decay_q31);
+
+	demod_out = dsp_kernel.agc_q15 (amp, D->agc_fast_q31, D->agc_slow_q31, &(D->m_peak_q), &(D->m_valley_q));
+
+	if (D->num_slicers <= 1) {
+	  demod_data = demod_out > 0;
+	  nudge_pll_fixed (chan, subchan, 0, demod_data, demod_out * 2, D);
+	}
+	else {
+	  int slice;
+
+	  int data[MAX_SLICERS];
+	  int margin[MAX_SLICERS];
+
+	  for (slice=0; slice<D->num_slicers; slice++) {
+	    data[slice] = demod_out > slice_point_q15[slice];
+	    margin[slice] = (demod_out - slice_point_q15[slice]) * 2;
+	  }
+	  nudge_plls_fixed (chan, subchan, data, margin, D);
+	}
+
+} /* end process_sample_fixed */
+
+
+/* Margin is Q15 here.  Otherwise same as nudge_pll above. */
+
+__attribute__((hot))
+static void inline nudge_pll_fixed (int chan, int subchan, int slice, int demod_data, int margin, struct demodulator_state_s *D)
+{
+	ds_ticks_t t_start = 0;
+	ds_ticks_t t_hdlc = 0;
+
+	if (dsp_stats_enabled) t_start = dsp_stats_ticks();
+
+	D->slicer.prev_d_c_pll[slice] = D->slicer.data_clock_pll[slice];
+	D->slicer.data_clock_pll[slice] += D->pll_step_per_sample;
+
+	if (D->slicer.data_clock_pll[slice] < 0 && D->slicer.prev_d_c_pll[slice] > 0) {
+
+	  ds_ticks_t t_bit = 0;
+	  int quality = (abs(margin) * 255) >> 15;
+
+	  if (quality > 255) quality = 255;
+
+	  descramble (demod_data, &(D->slicer.lfsr[slice]));
+
+	  if (dsp_stats_enabled) t_bit = dsp_stats_ticks();
+
+	  hdlc_rec_bit (chan, subchan, slice, demod_data, 1, quality);
+
+	  if (dsp_stats_enabled) {
+	    t_hdlc = dsp_stats_ticks() - t_bit;
+	    dsp_stats_record (DS_HDLC, chan, subchan, slice, t_hdlc);
+	  }
+	}
+
+        if (demod_data != D->slicer.prev_demod_data[slice]) {
+
+	  int inertia = hdlc_rec_gathering (chan, subchan, slice) ? D->pll_locked_q15 : D->pll_searching_q15;
+
+	  D->slicer.data_clock_pll[slice] = (int)(((int64_t)D->slicer.data_clock_pll[slice] * inertia) >> 15);
+	}
+
+	D->slicer.prev_demod_data[slice] = demod_data;
+
+	if (dsp_stats_enabled) dsp_stats_record (DS_PLL, chan, subchan, slice, dsp_stats_ticks() - t_start - t_hdlc);
+
+} /* end nudge_pll_fixed */
+
+
+/* Same as nudge_plls with Q15 margins and integer inertia. */
+
+__attribute__((hot))
+static void nudge_plls_fixed (int chan, int subchan, const int *demod_data, const int *margin, struct demodulator_state_s *D)
+{
+	int n = D->num_slicers;
+	int sampled[MAX_SLICERS];
+	int quality[MAX_SLICERS];
+	const int *gathering;
+	int any = 0;
+	int slice;
+	ds_ticks_t t_start = 0;
+	ds_ticks_t t_hdlc = 0;
+
+	if (dsp_stats_enabled) t_start = dsp_stats_ticks();
+
+	for (slice=0; slice<n; slice++) {
+	  int prev = D->slicer.data_clock_pll[slice];
+	  int next = (int)((unsigned int)prev + (unsigned int)D->pll_step_per_sample);
+
+	  D->slicer.prev_d_c_pll[slice] = prev;
+	  D->slicer.data_clock_pll[slice] = next;
+	  sampled[slice] = (next < 0) & (prev > 0);
+	  any |= sampled[slice];
+	}
+
+	if (any) {
+	  ds_ticks_t t_bit = 0;
+
+	  for (slice=0; slice<n; slice++) {
+	    quality[slice] = 0;
+	    if (sampled[slice]) {
+	      descramble (demod_data[slice], &(D->slicer.lfsr[slice]));
+	      quality[slice] = (abs(margin[slice]) * 255) >> 15;
+	      if (quality[slice] > 255) quality[slice] = 255;
+	    }
+	  }
+
+	  if (dsp_stats_enabled) t_bit = dsp_stats_ticks();
+
+	  hdlc_rec_bits (chan, subchan, n, sampled, demod_data, 1, quality);
+
+	  if (dsp_stats_enabled) {
+	    int k = 0;
+
+	    t_hdlc = dsp_stats_ticks() - t_bit;
+	    for (slice=0; slice<n; slice++) k += sampled[slice];
+	    for (slice=0; slice<n; slice++) {
+	      if (sampled[slice]) dsp_stats_record (DS_HDLC, chan, subchan, slice, t_hdlc / k);
+	    }
+	  }
+	}
+
+	gathering = hdlc_rec_gathering_all (chan, subchan);
+
+	for (slice=0; slice<n; slice++) {
+	  int inertia = gathering[slice] ? D->pll_locked_q15 : D->pll_searching_q15;
+	  int pll = D->slicer.data_clock_pll[slice];
+	  int nudged = (int)(((int64_t)pll * inertia) >> 15);
+
+	  D->slicer.data_clock_pll[slice] = demod_data[slice] != D->slicer.prev_demod_data[slice] ? nudged : pll;
+	  D->slicer.prev_demod_data[slice] = demod_data[slice];
+	}
+
+	if (dsp_stats_enabled) {
+	  ds_ticks_t t_pll = (dsp_stats_ticks() - t_start - t_hdlc) / n;
+
+	  for (slice=0; slice<n; slice++) {
+	    dsp_stats_record (DS_PLL, chan, subchan, slice, t_pll);
+	  }
+	}
+
+} /* end nudge_plls_fixed */
+
+
+
 
 
 
@@ -4,9 +4,10 @@
 
 
 #include "fsk_demod_state.h"
+#include "audio.h"		/* for struct demod_tune_s */
 
 
-void demod_9600_init (int samples_per_sec, int baud, struct demodulator_state_s *D);
+void demod_9600_init (int samples_per_sec, int baud, struct demod_tune_s *tune, struct demodulator_state_s *D);
 
 void demod_9600_process_sample (int chan, int sam, struct demodulator_state_s *D);
 
@@ -60,6 +60,8 @@
 #include "textcolor.h"
 #include "demod_afsk.h"
 #include "dsp.h"
+#include "dsp_stats.h"
+#include "dsp_kernel.h"
 
 #define MIN(a,b) ((a)<(b)?(a):(b))
 #define MAX(a,b) ((a)>(b)?(a):(b))
@@ -86,58 +88,41 @@ static inline float z (float x, float y)
         }
 }
 
-/* Add sample to buffer and shift the rest down. */
+/* Same for the fixed point demodulator.  Coefficients are Q15. */
+/* An exact integer square root took more than twice as long. */
 
 __attribute__((hot)) __attribute__((always_inline))
-static inline void push_sample (float val, float *buff, int size)
+static inline int zq (int x, int y)
 {
-	memmove(buff+1,buff,(size-1)*sizeof(float));
-	buff[0] = val; 
-}
+	x = abs(x);
+	y = abs(y);
 
+	if (x > y) {
+	  return ((x * 30843 + y * 13435) >> 15);
+	}
+	else {
+	  return ((y * 30843 + x * 13435) >> 15);
+	}
+}
 
-/* FIR filter kernel. */
+/* Add sample to buffer and shift the rest down. */
 
 __attribute__((hot)) __attribute__((always_inline))
-static inline float convolve (const float *__restrict__ data, const float *__restrict__ filter, int filter_size)
+static inline void push_sample (float val, float *buff, int size)
 {
-	float sum = 0.0f;
-	int j;
-
-
-#pragma GCC ivdep				// ignored until gcc 4.9
-	for (j=0; j<filter_size; j++) {
-	    sum += filter[j] * data[j];
-	}
-
-	return (sum);
+	memmove(buff+1,buff,(size-1)*sizeof(float));
+	buff[0] = val; 
 }
 
-/* Automatic gain control. */
-/* Result should settle down to 1 unit peak to peak.  i.e. -0.5 to +0.5 */
-
 __attribute__((hot)) __attribute__((always_inline))
-static inline float agc (float in, float fast_attack, float slow_decay, float *ppeak, float *pvalley)
+static inline void push_sample_q (int val, short *buff, int size)
 {
-	if (in >= *ppeak) {
-	  *ppeak = in * fast_attack + *ppeak * (1.0f - fast_attack);
-	}
-	else {
-	  *ppeak = in * slow_decay + *ppeak * (1.0f - slow_decay);
-	}
+	memmove(buff+1,buff,(size-1)*sizeof(short));
+	buff[0] = val;
+}
 
-	if (in <= *pvalley) {
-	  *pvalley = in * fast_attack + *pvalley * (1.0f - fast_attack);
-	}
-	else  {   
-	  *pvalley = in * slow_decay + *pvalley * (1.0f - slow_decay);
-	}
 
-	if (*ppeak > *pvalley) {
-	  return ((in - 0.5f * (*ppeak + *pvalley)) / (*ppeak - *pvalley));
-	}
-	return (0.0f);
-}
+/* FIR filter, correlators, and AGC kernels are in dsp_kernel.c. */
 
 
 /*
@@ -149,6 +134,8 @@ static inline float agc (float in, float fast_attack, float slow_decay, float *p
 
 /* TODO: static */  float space_gain[MAX_SUBCHANS];
 
+static int space_gain_q12[MAX_SUBCHANS];	/* Same for fixed point, 1.0 = 4096. */
+
 
 
 /*------------------------------------------------------------------
@@ -162,6 +149,9 @@ static inline float agc (float in, float fast_attack, float slow_decay, float *p
  *		baud
  *		mark_freq
  *		space_freq
+ *
+ *		tune		- Changes to the profile parameters, from DEMODTUNE.
+ *				  Can be NULL.
  *	
  *		D		- Pointer to demodulator state for given channel.
  *
@@ -179,10 +169,11 @@ static inline float agc (float in, float fast_attack, float slow_decay, float *p
  *----------------------------------------------------------------*/
 
 void demod_afsk_init (int samples_per_sec, int baud, int mark_freq,
-			int space_freq, char profile, struct demodulator_state_s *D)
+			int space_freq, char profile, struct demod_tune_s *tune, struct demodulator_state_s *D)
 {
 	
 	int j;
+	float pre_len_default, ms_len_default, lp_len_default;
 	
 	memset (D, 0, sizeof(struct demodulator_state_s));
 	D->num_slicers = 1;
@@ -197,6 +188,8 @@ void demod_afsk_init (int samples_per_sec, int baud, int mark_freq,
 #endif
 
 
+/* fsk_fast_filter.h is generated for the defaults. */
+
 	if (profile == 'F') {
 
 	  if (baud != DEFAULT_BAUD ||
@@ -418,6 +411,38 @@ void demod_afsk_init (int samples_per_sec, int baud, int mark_freq,
 	D->prefilter_baud = TUNE_PRE_BAUD;
 #endif
 
+/* Same thing at run time. */
+
+	pre_len_default = D->pre_filter_len_bits;
+	ms_len_default = D->ms_filter_len_bits;
+	lp_len_default = D->lp_filter_len_bits;
+
+	if (DEMOD_TUNED(tune, DT_PRE_BAUD))	D->prefilter_baud = tune->value[DT_PRE_BAUD];
+	if (DEMOD_TUNED(tune, DT_PRE_LEN))	D->pre_filter_len_bits = tune->value[DT_PRE_LEN];
+	if (DEMOD_TUNED(tune, DT_PRE_WINDOW))	D->pre_window = (bp_window_t)(tune->value[DT_PRE_WINDOW]);
+	if (DEMOD_TUNED(tune, DT_MS_LEN))	D->ms_filter_len_bits = tune->value[DT_MS_LEN];
+	if (DEMOD_TUNED(tune, DT_MS_WINDOW))	D->ms_window = (bp_window_t)(tune->value[DT_MS_WINDOW]);
+	if (DEMOD_TUNED(tune, DT_LPF_BAUD))	D->lpf_baud = tune->value[DT_LPF_BAUD];
+	if (DEMOD_TUNED(tune, DT_LP_LEN))	D->lp_filter_len_bits = tune->value[DT_LP_LEN];
+	if (DEMOD_TUNED(tune, DT_LP_WINDOW))	D->lp_window = (bp_window_t)(tune->value[DT_LP_WINDOW]);
+	if (DEMOD_TUNED(tune, DT_AGC_FAST))	D->agc_fast_attack = tune->value[DT_AGC_FAST];
+	if (DEMOD_TUNED(tune, DT_AGC_SLOW))	D->agc_slow_decay = tune->value[DT_AGC_SLOW];
+	if (DEMOD_TUNED(tune, DT_HYST))		D->hysteresis = tune->value[DT_HYST];
+	if (DEMOD_TUNED(tune, DT_PLL_LOCKED))	D->pll_locked_inertia = tune->value[DT_PLL_LOCKED];
+	if (DEMOD_TUNED(tune, DT_PLL_SEARCHING)) D->pll_searching_inertia = tune->value[DT_PLL_SEARCHING];
+
+/*
+ * The 'F' fast path has mark and space filters generated for the default
+ * length and window.  A tuned version needs the general case or a
+ * parameter sweep would be measuring the wrong thing.
+ */
+
+	if (D->profile == 'F' && (DEMOD_TUNED(tune, DT_MS_LEN) || DEMOD_TUNED(tune, DT_MS_WINDOW))) {
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Note: Decoder 'F' can't be used with ms_len or ms_window.  Using Decoder 'A' instead.\n");
+	  D->profile = 'A';
+	}
+
 
 /*
  * Calculate constants used for timing.
@@ -433,6 +458,36 @@ void demod_afsk_init (int samples_per_sec, int baud, int mark_freq,
 	D->pre_filter_size = (int) round( D->pre_filter_len_bits * (float)samples_per_sec / (float)baud );
 	D->ms_filter_size = (int) round( D->ms_filter_len_bits * (float)samples_per_sec / (float)baud );
 	D->lp_filter_size = (int) round( D->lp_filter_len_bits * (float)samples_per_sec / (float)baud );
+
+/*
+ * A length from DEMODTUNE can give a filter too short to generate or
+ * too large for the state arrays.  Go back to the profile default
+ * rather than aborting.
+ */
+
+	if ((D->pre_filter_size < 3 || D->pre_filter_size > MAX_FILTER_SIZE) && DEMOD_TUNED(tune, DT_PRE_LEN)) {
+	  text_color_set (DW_COLOR_ERROR);
+	  dw_printf ("pre_len=%.2f gives filter size %d for %d samples/sec and %d baud.  It must be 3 to %d.  Using %.2f.\n",
+			D->pre_filter_len_bits, D->pre_filter_size, samples_per_sec, baud, MAX_FILTER_SIZE, pre_len_default);
+	  D->pre_filter_len_bits = pre_len_default;
+	  D->pre_filter_size = (int) round( D->pre_filter_len_bits * (float)samples_per_sec / (float)baud );
+	}
+
+	if ((D->ms_filter_size < 4 || D->ms_filter_size > MAX_FILTER_SIZE) && DEMOD_TUNED(tune, DT_MS_LEN)) {
+	  text_color_set (DW_COLOR_ERROR);
+	  dw_printf ("ms_len=%.2f gives filter size %d for %d samples/sec and %d baud.  It must be 4 to %d.  Using %.2f.\n",
+			D->ms_filter_len_bits, D->ms_filter_size, samples_per_sec, baud, MAX_FILTER_SIZE, ms_len_default);
+	  D->ms_filter_len_bits = ms_len_default;
+	  D->ms_filter_size = (int) round( D->ms_filter_len_bits * (float)samples_per_sec / (float)baud );
+	}
+
+	if ((D->lp_filter_size < 3 || D->lp_filter_size > MAX_FILTER_SIZE) && DEMOD_TUNED(tune, DT_LP_LEN)) {
+	  text_color_set (DW_COLOR_ERROR);
+	  dw_printf ("lp_len=%.2f gives filter size %d for %d samples/sec and %d baud.  It must be 3 to %d.  Using %.2f.\n",
+			D->lp_filter_len_bits, D->lp_filter_size, samples_per_sec, baud, MAX_FILTER_SIZE, lp_len_default);
+	  D->lp_filter_len_bits = lp_len_default;
+	  D->lp_filter_size = (int) round( D->lp_filter_len_bits * (float)samples_per_sec / (float)baud );
+	}
 	  	 
 /* Experiment with other sizes. */
 
@@ -688,6 +743,56 @@ failed experiment
 #endif
 #endif
 
+/*
+ * Integer fixed point version of everything above.
+ * The mark and space correlators must use the same scale
+ * so the amplitudes can be compared.
+ */
+
+	if (DEMOD_TUNED(tune, DT_FIXED) && tune->value[DT_FIXED] != 0) {
+	  int shift;
+
+	  D->use_fixed = 1;
+
+	  if (D->use_prefilter) {
+	    D->pre_shift = q15_shift (D->pre_filter, D->pre_filter_size);
+	    gen_q15_filter (D->pre_filter, D->pre_filter_q, D->pre_filter_size, D->pre_shift);
+	  }
+
+	  D->ms_shift = q15_shift (D->m_sin_table, D->ms_filter_size);
+	  shift = q15_shift (D->m_cos_table, D->ms_filter_size);
+	  if (shift < D->ms_shift) D->ms_shift = shift;
+	  shift = q15_shift (D->s_sin_table, D->ms_filter_size);
+	  if (shift < D->ms_shift) D->ms_shift = shift;
+	  shift = q15_shift (D->s_cos_table, D->ms_filter_size);
+	  if (shift < D->ms_shift) D->ms_shift = shift;
+
+	  gen_q15_filter (D->m_sin_table, D->m_sin_q, D->ms_filter_size, D->ms_shift);
+	  gen_q15_filter (D->m_cos_table, D->m_cos_q, D->ms_filter_size, D->ms_shift);
+	  gen_q15_filter (D->s_sin_table, D->s_sin_q, D->ms_filter_size, D->ms_shift);
+	  gen_q15_filter (D->s_cos_table, D->s_cos_q, D->ms_filter_size, D->ms_shift);
+
+	  if (D->lpf_use_fir) {
+	    D->lp_shift = q15_shift (D->lp_filter, D->lp_filter_size);
+	    gen_q15_filter (D->lp_filter, D->lp_filter_q, D->lp_filter_size, D->lp_shift);
+	  }
+	  D->lpf_iir_q15 = Q15(D->lpf_iir);
+
+	  D->agc_fast_q31 = Q31(D->agc_fast_attack);
+	  D->agc_slow_q31 = Q31(D->agc_slow_decay);
+	  D->hysteresis_q15 = Q15(D->hysteresis);
+	  D->pll_locked_q15 = Q15(D->pll_locked_inertia);
+	  D->pll_searching_q15 = Q15(D->pll_searching_inertia);
+
+	  /* Input samples are not scaled down by 16384 like the float version. */
+
+	  D->fixed_level_scale = 1.0f / (256.0f * 16384.0f);
+
+	  for (j=0; j<MAX_SUBCHANS; j++) {
+	    space_gain_q12[j] = (int)(space_gain[j] * 4096.0f + 0.5f);
+	  }
+	}
+
 }  /* fsk_gen_filter */
 
 
@@ -740,7 +845,7 @@ int main (void)
 
 
 	demod_afsk_init (modem.adev[0].samples_per_sec, modem.achan[0].baud,
-			modem.achan[0].mark_freq, modem.achan[0].space_freq, fff_profile, &ds);
+			modem.achan[0].mark_freq, modem.achan[0].space_freq, fff_profile, NULL, &ds);
 	
 	printf ("/* This is an automatically generated file.  Do not edit. */\n");
 	printf ("\n");
@@ -808,7 +913,11 @@ int main (void)
  *
  *--------------------------------------------------------------------*/
 
-static void inline nudge_pll (int chan, int subchan, int slice, int demod_data, struct demodulator_state_s *D);
+static void inline nudge_pll (int chan, int subchan, int slice, int demod_data, float margin, struct demodulator_state_s *D);
+
+static void nudge_plls (int chan, int subchan, const int *demod_data, const float *margin, struct demodulator_state_s *D);
+
+static void process_sample_fixed (int chan, int subchan, int sam, struct demodulator_state_s *D);
 
 __attribute__((hot))
 void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulator_state_s *D)
@@ -827,11 +936,19 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 
 	//int j;
 	int demod_data;
+	ds_ticks_t t_stage = 0;
 
 
 	assert (chan >= 0 && chan < MAX_CHANS);
 	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
 
+	if (D->use_fixed) {
+	  process_sample_fixed (chan, subchan, sam, D);
+	  return;
+	}
+
+	if (dsp_stats_enabled) t_stage = dsp_stats_ticks();
+
 /* 
  * Filters use last 'filter_size' samples.
  *
@@ -857,8 +974,10 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 	  float cleaner;
 
 	  push_sample (fsam, D->raw_cb, D->pre_filter_size);
-	  cleaner = convolve (D->raw_cb, D->pre_filter, D->pre_filter_size);
+	  cleaner = dsp_kernel.convolve (D->raw_cb, D->pre_filter, D->pre_filter_size);
 	  push_sample (cleaner, D->ms_in_cb, D->ms_filter_size);
+
+	  if (dsp_stats_enabled) dsp_stats_lap (DS_PREFILTER, chan, subchan, 0, &t_stage);
 	}
 	else {
 	  push_sample (fsam, D->ms_in_cb, D->ms_filter_size);
@@ -900,16 +1019,21 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 /*
  * find amplitude of "Mark" tone.
  */
-	  m_sum1 = convolve (D->ms_in_cb, D->m_sin_table, D->ms_filter_size);
-	  m_sum2 = convolve (D->ms_in_cb, D->m_cos_table, D->ms_filter_size);
+	  float sums[4];
+
+	  dsp_kernel.correlate (D->ms_in_cb, D->m_sin_table, D->m_cos_table,
+				D->s_sin_table, D->s_cos_table, D->ms_filter_size, sums);
+
+	  m_sum1 = sums[0];
+	  m_sum2 = sums[1];
 
 	  m_amp = sqrtf(m_sum1 * m_sum1 + m_sum2 * m_sum2);
 
 /*
  * Find amplitude of "Space" tone.
  */
-	  s_sum1 = convolve (D->ms_in_cb, D->s_sin_table, D->ms_filter_size);
-	  s_sum2 = convolve (D->ms_in_cb, D->s_cos_table, D->ms_filter_size);
+	  s_sum1 = sums[2];
+	  s_sum2 = sums[3];
 
 	  s_amp = sqrtf(s_sum1 * s_sum1 + s_sum2 * s_sum2);
 
@@ -930,10 +1054,10 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 	if (D->lpf_use_fir) {
 
 	  push_sample (m_amp, D->m_amp_cb, D->lp_filter_size);
-	  m_amp = convolve (D->m_amp_cb, D->lp_filter, D->lp_filter_size);
+	  m_amp = dsp_kernel.convolve (D->m_amp_cb, D->lp_filter, D->lp_filter_size);
 
 	  push_sample (s_amp, D->s_amp_cb, D->lp_filter_size);
-	  s_amp = convolve (D->s_amp_cb, D->lp_filter, D->lp_filter_size);
+	  s_amp = dsp_kernel.convolve (D->s_amp_cb, D->lp_filter, D->lp_filter_size);
 	}
 	else {
 	
@@ -1016,8 +1140,10 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 
 	/* See fsk_demod_agc.h for more information. */
 
-	m_norm = agc (m_amp, D->agc_fast_attack, D->agc_slow_decay, &(D->m_peak), &(D->m_valley));
-	s_norm = agc (s_amp, D->agc_fast_attack, D->agc_slow_decay, &(D->s_peak), &(D->s_valley));
+	m_norm = dsp_kernel.agc (m_amp, D->agc_fast_attack, D->agc_slow_decay, &(D->m_peak), &(D->m_valley));
+	s_norm = dsp_kernel.agc (s_amp, D->agc_fast_attack, D->agc_slow_decay, &(D->s_peak), &(D->s_valley));
+
+	if (dsp_stats_enabled) dsp_stats_lap (DS_CORRELATE, chan, subchan, 0, &t_stage);
 
 	if (D->num_slicers <= 1) {
 
@@ -1037,17 +1163,26 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 	    demod_data = 0;
 	  } 
 	  else {
-	    demod_data = D->slicer[subchan].prev_demod_data;
+	    demod_data = D->slicer.prev_demod_data[subchan];
 	  }
-	  nudge_pll (chan, subchan, 0, demod_data, D);
+	  nudge_pll (chan, subchan, 0, demod_data, demod_out, D);
 	}
 	else {
 	  int slice;
 
+	  int data[MAX_SLICERS];
+	  float margin[MAX_SLICERS];
+
+	  /* Scale the difference so confidence is comparable to the single slicer case. */
+	  float scale = D->m_peak > 0 ? 1.0f / D->m_peak : 0;
+
 	  for (slice=0; slice<D->num_slicers; slice++) {
-	    demod_data = m_amp > s_amp * space_gain[slice];
-	    nudge_pll (chan, subchan, slice, demod_data, D);
+	    float diff = m_amp - s_amp * space_gain[slice];
+
+	    data[slice] = diff > 0;
+	    margin[slice] = diff * scale;
 	  }
+	  nudge_plls (chan, subchan, data, margin, D);
 	}
 
 
@@ -1088,8 +1223,12 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 
 
 __attribute__((hot))
-static void inline nudge_pll (int chan, int subchan, int slice, int demod_data, struct demodulator_state_s *D)
+static void inline nudge_pll (int chan, int subchan, int slice, int demod_data, float margin, struct demodulator_state_s *D)
 {
+	ds_ticks_t t_start = 0;
+	ds_ticks_t t_hdlc = 0;		/* Time in HDLC so we can exclude it from PLL. */
+
+	if (dsp_stats_enabled) t_start = dsp_stats_ticks();
 
 /*
  * Finally, a PLL is used to sample near the centers of the data bits.
@@ -1121,37 +1260,386 @@ static void inline nudge_pll (int chan, int subchan, int slice, int demod_data,
  * because this happens for each transition from the demodulator.
  */
 
-	D->slicer[slice].prev_d_c_pll = D->slicer[slice].data_clock_pll;
-	D->slicer[slice].data_clock_pll += D->pll_step_per_sample;
+	D->slicer.prev_d_c_pll[slice] = D->slicer.data_clock_pll[slice];
+	D->slicer.data_clock_pll[slice] += D->pll_step_per_sample;
 
 	  //text_color_set(DW_COLOR_DEBUG);
 	  // dw_printf ("prev = %lx, new data clock pll = %lx\n" D->prev_d_c_pll, D->data_clock_pll);
 
-	if (D->slicer[slice].data_clock_pll < 0 && D->slicer[slice].prev_d_c_pll > 0) {
+	if (D->slicer.data_clock_pll[slice] < 0 && D->slicer.prev_d_c_pll[slice] > 0) {
 
 	  /* Overflow. */
 
-	  hdlc_rec_bit (chan, subchan, slice, demod_data, 0, -1);
+	  ds_ticks_t t_bit = 0;
+
+	  if (dsp_stats_enabled) t_bit = dsp_stats_ticks();
+
+	  hdlc_rec_bit (chan, subchan, slice, demod_data, 0, hdlc_rec_bit_quality(margin));
+
+	  if (dsp_stats_enabled) {
+	    t_hdlc = dsp_stats_ticks() - t_bit;
+	    dsp_stats_record (DS_HDLC, chan, subchan, slice, t_hdlc);
+	  }
 	}
 
-        if (demod_data != D->slicer[slice].prev_demod_data) {
+        if (demod_data != D->slicer.prev_demod_data[slice]) {
 
 	  if (hdlc_rec_gathering (chan, subchan, slice)) {
-	    D->slicer[slice].data_clock_pll = (int)(D->slicer[slice].data_clock_pll * D->pll_locked_inertia);
+	    D->slicer.data_clock_pll[slice] = (int)(D->slicer.data_clock_pll[slice] * D->pll_locked_inertia);
 	  }
 	  else {
-	    D->slicer[slice].data_clock_pll = (int)(D->slicer[slice].data_clock_pll * D->pll_searching_inertia);
+	    D->slicer.data_clock_pll[slice] = (int)(D->slicer.data_clock_pll[slice] * D->pll_searching_inertia);
 	  }
 	}
 
 /*
  * Remember demodulator output so we can compare next time.
  */
-	D->slicer[slice].prev_demod_data = demod_data;
+	D->slicer.prev_demod_data[slice] = demod_data;
+
+	if (dsp_stats_enabled) dsp_stats_record (DS_PLL, chan, subchan, slice, dsp_stats_ticks() - t_start - t_hdlc);
 
 } /* end nudge_pll */
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        nudge_plls
+ *
+ * Purpose:     Same as nudge_pll for all slicers of a demodulator at once.
+ *
+ * Inputs:	demod_data	- Data bit from each slicer.
+ *		margin		- Distance from each slice point, for quality.
+ *
+ * Description:	The common case, where none of the slicers has reached
+ *		the middle of a bit, is handled with straight line loops
+ *		over the slicer state arrays, which the compiler can turn
+ *		into SIMD instructions.  Only when some PLL overflows do
+ *		we drop into the HDLC decoder.
+ *
+ *		Adding the step as unsigned gives the same wrap around
+ *		as before without relying on signed overflow.
+ *
+ *--------------------------------------------------------------------*/
+
+__attribute__((hot))
+static void nudge_plls (int chan, int subchan, const int *demod_data, const float *margin, struct demodulator_state_s *D)
+{
+	int n = D->num_slicers;
+	int sampled[MAX_SLICERS];
+	int quality[MAX_SLICERS];
+	const int *gathering;
+	int any = 0;
+	int slice;
+	ds_ticks_t t_start = 0;
+	ds_ticks_t t_hdlc = 0;
+
+	if (dsp_stats_enabled) t_start = dsp_stats_ticks();
+
+	for (slice=0; slice<n; slice++) {
+	  int prev = D->slicer.data_clock_pll[slice];
+	  int next = (int)((unsigned int)prev + (unsigned int)D->pll_step_per_sample);
+
+	  D->slicer.prev_d_c_pll[slice] = prev;
+	  D->slicer.data_clock_pll[slice] = next;
+	  sampled[slice] = (next < 0) & (prev > 0);
+	  any |= sampled[slice];
+	}
+
+	if (any) {
+	  ds_ticks_t t_bit = 0;
+
+	  for (slice=0; slice<n; slice++) {
+	    quality[slice] = sampled[slice] ? hdlc_rec_bit_quality(margin[slice]) : 0;
+	  }
+
+	  if (dsp_stats_enabled) t_bit = dsp_stats_ticks();
+
+	  hdlc_rec_bits (chan, subchan, n, sampled, demod_data, 0, quality);
+
+	  if (dsp_stats_enabled) {
+	    int k = 0;
+
+	    t_hdlc = dsp_stats_ticks() - t_bit;
+	    for (slice=0; slice<n; slice++) k += sampled[slice];
+	    for (slice=0; slice<n; slice++) {
+	      if (sampled[slice]) dsp_stats_record (DS_HDLC, chan, subchan, slice, t_hdlc / k);
+	    }
+	  }
+	}
+
+	gathering = hdlc_rec_gathering_all (chan, subchan);
+
+	for (slice=0; slice<n; slice++) {
+	  float inertia = gathering[slice] ? D->pll_locked_inertia : D->pll_searching_inertia;
+	  int pll = D->slicer.data_clock_pll[slice];
+	  int nudged = (int)(pll * inertia);
+
+	  D->slicer.data_clock_pll[slice] = demod_data[slice] != D->slicer.prev_demod_data[slice] ? nudged : pll;
+	  D->slicer.prev_demod_data[slice] = demod_data[slice];
+	}
+
+	if (dsp_stats_enabled) {
+	  ds_ticks_t t_pll = (dsp_stats_ticks() - t_start - t_hdlc) / n;
+
+	  for (slice=0; slice<n; slice++) {
+	    dsp_stats_record (DS_PLL, chan, subchan, slice, t_pll);
+	  }
+	}
+
+} /* end nudge_plls */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        process_sample_fixed
+ *
+ * Purpose:     Same as demod_afsk_process_sample using only integer
+ *		arithmetic, for processors without a fast floating
+ *		point unit.
+ *
+ * Description:	Each step mirrors the floating point version.
+ *		Filter outputs are saturated to 16 bits so the
+ *		following filter can't overflow.  The "F" profile
+ *		fast path is not used here.
+ *
+ *--------------------------------------------------------------------*/
+
+static void inline nudge_pll_fixed (int chan, int subchan, int slice, int demod_data, int margin, int full_scale, struct demodulator_state_s *D);
+
+static void nudge_plls_fixed (int chan, int subchan, const int *demod_data, const int *margin, int full_scale, struct demodulator_state_s *D);
+
+__attribute__((hot))
+static void process_sample_fixed (int chan, int subchan, int sam, struct demodulator_state_s *D)
+{
+	int sums[4];
+	int m_sum1, m_sum2, s_sum1, s_sum2;
+	int m_amp, s_amp;
+	int m_norm, s_norm;
+	int demod_out;
+	int demod_data;
+	ds_ticks_t t_stage = 0;
+
+	if (dsp_stats_enabled) t_stage = dsp_stats_ticks();
+
+	sam = sat16(sam);
+
+	if (D->use_prefilter) {
+	  int cleaner;
+
+	  push_sample_q (sam, D->raw_cb_q, D->pre_filter_size);
+	  cleaner = dsp_kernel.convolve_q15 (D->raw_cb_q, D->pre_filter_q, D->pre_filter_size) >> D->pre_shift;
+	  push_sample_q (sat16(cleaner), D->ms_in_cb_q, D->ms_filter_size);
+
+	  if (dsp_stats_enabled) dsp_stats_lap (DS_PREFILTER, chan, subchan, 0, &t_stage);
+	}
+	else {
+	  push_sample_q (sam, D->ms_in_cb_q, D->ms_filter_size);
+	}
+
+/*
+ * Mark and space amplitudes.
+ */
+	dsp_kernel.correlate_q15 (D->ms_in_cb_q, D->m_sin_q, D->m_cos_q,
+				D->s_sin_q, D->s_cos_q, D->ms_filter_size, sums);
+
+	m_sum1 = sat16(sums[0] >> D->ms_shift);
+	m_sum2 = sat16(sums[1] >> D->ms_shift);
+	s_sum1 = sat16(sums[2] >> D->ms_shift);
+	s_sum2 = sat16(sums[3] >> D->ms_shift);
+
+	m_amp = sat16(zq(m_sum1, m_sum2));
+	s_amp = sat16(zq(s_sum1, s_sum2));
+
+/*
+ * Low pass filter before the AGC.
+ */
+	if (D->lpf_use_fir) {
+
+	  push_sample_q (m_amp, D->m_amp_cb_q, D->lp_filter_size);
+	  m_amp = sat16(dsp_kernel.convolve_q15 (D->m_amp_cb_q, D->lp_filter_q, D->lp_filter_size) >> D->lp_shift);
+
+	  push_sample_q (s_amp, D->s_amp_cb_q, D->lp_filter_size);
+	  s_amp = sat16(dsp_kernel.convolve_q15 (D->s_amp_cb_q, D->lp_filter_q, D->lp_filter_size) >> D->lp_shift);
+	}
+	else {
+	  m_amp = D->m_amp_prev_q + ((D->lpf_iir_q15 * (m_amp - D->m_amp_prev_q)) >> 15);
+	  D->m_amp_prev_q = m_amp;
+
+	  s_amp = D->s_amp_prev_q + ((D->lpf_iir_q15 * (s_amp - D->s_amp_prev_q)) >> 15);
+	  D->s_amp_prev_q = s_amp;
+	}
+
+/*
+ * Amplitudes for display.
+ */
+	D->alevel_mark_peak_q = track_q31 (D->alevel_mark_peak_q, m_amp << 8,
+		(m_amp << 8) >= D->alevel_mark_peak_q ? D->quick_attack_q31 : D->sluggish_decay_q31);
+	D->alevel_space_peak_q = track_q31 (D->alevel_space_peak_q, s_amp << 8,
+		(s_amp << 8) >= D->alevel_space_peak_q ? D->quick_attack_q31 : D->sluggish_decay_q31);
+
+	m_norm = dsp_kernel.agc_q15 (m_amp, D->agc_fast_q31, D->agc_slow_q31, &(D->m_peak_q), &(D->m_valley_q));
+	s_norm = dsp_kernel.agc_q15 (s_amp, D->agc_fast_q31, D->agc_slow_q31, &(D->s_peak_q), &(D->s_valley_q));
+
+	if (dsp_stats_enabled) dsp_stats_lap (DS_CORRELATE, chan, subchan, 0, &t_stage);
+
+	if (D->num_slicers <= 1) {
+
+	  demod_out = m_norm - s_norm;
+
+	  if (demod_out > D->hysteresis_q15) {
+	    demod_data = 1;
+	  }
+	  else if (demod_out < (- (D->hysteresis_q15))) {
+	    demod_data = 0;
+	  }
+	  else {
+	    demod_data = D->slicer.prev_demod_data[subchan];
+	  }
+	  nudge_pll_fixed (chan, subchan, 0, demod_data, demod_out, 32768, D);
+	}
+	else {
+	  int slice;
+
+	  int data[MAX_SLICERS];
+	  int margin[MAX_SLICERS];
+
+	  /* Confidence relative to mark peak as in the float version. */
+
+	  for (slice=0; slice<D->num_slicers; slice++) {
+	    int diff = m_amp - ((s_amp * space_gain_q12[slice]) >> 12);
+
+	    data[slice] = diff > 0;
+	    margin[slice] = diff;
+	  }
+	  nudge_plls_fixed (chan, subchan, data, margin, D->m_peak_q >> 8, D);
+	}
+
+} /* end process_sample_fixed */
+
+
+__attribute__((hot))
+static void inline nudge_pll_fixed (int chan, int subchan, int slice, int demod_data, int margin, int full_scale, struct demodulator_state_s *D)
+{
+	ds_ticks_t t_start = 0;
+	ds_ticks_t t_hdlc = 0;
+
+	if (dsp_stats_enabled) t_start = dsp_stats_ticks();
+
+	D->slicer.prev_d_c_pll[slice] = D->slicer.data_clock_pll[slice];
+	D->slicer.data_clock_pll[slice] += D->pll_step_per_sample;
+
+	if (D->slicer.data_clock_pll[slice] < 0 && D->slicer.prev_d_c_pll[slice] > 0) {
+
+	  /* Overflow.  Quality is only needed here so postpone the division. */
+
+	  ds_ticks_t t_bit = 0;
+	  int quality = 0;
+
+	  if (full_scale > 0) {
+	    quality = (int)(((int64_t)abs(margin) * 255) / full_scale);
+	    if (quality > 255) quality = 255;
+	  }
+
+	  if (dsp_stats_enabled) t_bit = dsp_stats_ticks();
+
+	  hdlc_rec_bit (chan, subchan, slice, demod_data, 0, quality);
+
+	  if (dsp_stats_enabled) {
+	    t_hdlc = dsp_stats_ticks() - t_bit;
+	    dsp_stats_record (DS_HDLC, chan, subchan, slice, t_hdlc);
+	  }
+	}
+
+        if (demod_data != D->slicer.prev_demod_data[slice]) {
+
+	  int inertia = hdlc_rec_gathering (chan, subchan, slice) ? D->pll_locked_q15 : D->pll_searching_q15;
+
+	  D->slicer.data_clock_pll[slice] = (int)(((int64_t)D->slicer.data_clock_pll[slice] * inertia) >> 15);
+	}
+
+	D->slicer.prev_demod_data[slice] = demod_data;
+
+	if (dsp_stats_enabled) dsp_stats_record (DS_PLL, chan, subchan, slice, dsp_stats_ticks() - t_start - t_hdlc);
+
+} /* end nudge_pll_fixed */
+
+
+/* Same as nudge_plls with integer margins and inertia. */
+
+__attribute__((hot))
+static void nudge_plls_fixed (int chan, int subchan, const int *demod_data, const int *margin, int full_scale, struct demodulator_state_s *D)
+{
+	int n = D->num_slicers;
+	int sampled[MAX_SLICERS];
+	int quality[MAX_SLICERS];
+	const int *gathering;
+	int any = 0;
+	int slice;
+	ds_ticks_t t_start = 0;
+	ds_ticks_t t_hdlc = 0;
+
+	if (dsp_stats_enabled) t_start = dsp_stats_ticks();
+
+	for (slice=0; slice<n; slice++) {
+	  int prev = D->slicer.data_clock_pll[slice];
+	  int next = (int)((unsigned int)prev + (unsigned int)D->pll_step_per_sample);
+
+	  D->slicer.prev_d_c_pll[slice] = prev;
+	  D->slicer.data_clock_pll[slice] = next;
+	  sampled[slice] = (next < 0) & (prev > 0);
+	  any |= sampled[slice];
+	}
+
+	if (any) {
+	  ds_ticks_t t_bit = 0;
+
+	  for (slice=0; slice<n; slice++) {
+	    quality[slice] = 0;
+	    if (sampled[slice] && full_scale > 0) {
+	      quality[slice] = (int)(((int64_t)abs(margin[slice]) * 255) / full_scale);
+	      if (quality[slice] > 255) quality[slice] = 255;
+	    }
+	  }
+
+	  if (dsp_stats_enabled) t_bit = dsp_stats_ticks();
+
+	  hdlc_rec_bits (chan, subchan, n, sampled, demod_data, 0, quality);
+
+	  if (dsp_stats_enabled) {
+	    int k = 0;
+
+	    t_hdlc = dsp_stats_ticks() - t_bit;
+	    for (slice=0; slice<n; slice++) k += sampled[slice];
+	    for (slice=0; slice<n; slice++) {
+	      if (sampled[slice]) dsp_stats_record (DS_HDLC, chan, subchan, slice, t_hdlc / k);
+	    }
+	  }
+	}
+
+	gathering = hdlc_rec_gathering_all (chan, subchan);
+
+	for (slice=0; slice<n; slice++) {
+	  int inertia = gathering[slice] ? D->pll_locked_q15 : D->pll_searching_q15;
+	  int pll = D->slicer.data_clock_pll[slice];
+	  int nudged = (int)(((int64_t)pll * inertia) >> 15);
+
+	  D->slicer.data_clock_pll[slice] = demod_data[slice] != D->slicer.prev_demod_data[slice] ? nudged : pll;
+	  D->slicer.prev_demod_data[slice] = demod_data[slice];
+	}
+
+	if (dsp_stats_enabled) {
+	  ds_ticks_t t_pll = (dsp_stats_ticks() - t_start - t_hdlc) / n;
+
+	  for (slice=0; slice<n; slice++) {
+	    dsp_stats_record (DS_PLL, chan, subchan, slice, t_pll);
+	  }
+	}
+
+} /* end nudge_plls_fixed */
+
+
 #endif   /* GEN_FFF */
 
 
@@ -71,8 +71,72 @@
 #include "pfilter.h"
 
 
-static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, char *mycall_xmit, 
-				regex_t *uidigi, regex_t *uitrace, int to_chan, enum preempt_e preempt, char *type_filter);
+/*
+ * The alias and wide patterns are regular expressions but, in practice,
+ * they are nearly always something simple like "^WIDE[3-7]-[1-7]$|^TEST$".
+ * Each alternative is a fixed length sequence of characters, or sets of 
+ * characters, optionally anchored at the start and/or end.
+ * These can be tested directly much faster than using regexec.
+ * Anything more complicated falls back to the compiled regular expression.
+ *
+ * The same pattern is usually used for many from/to channel combinations
+ * so we keep only one copy of each distinct pattern.
+ */
+
+struct digi_alt_s {
+	int anchor_start;			/* Pattern begins with ^ */
+	int anchor_end;				/* Pattern ends with $ */
+	int len;				/* Number of character positions. */
+	unsigned char set[AX25_MAX_ADDR_LEN][32];	/* Bit map of characters allowed */
+							/* in each position. */
+};
+
+struct digi_matcher_s {
+	char *pattern;				/* Original text. */
+	regex_t *re;				/* Compiled form for anything not simple. */
+	int fast;				/* True if alt, below, can be used instead. */
+	int nalt;				/* Number of alternatives. */
+	struct digi_alt_s *alt;
+};
+
+#define MAX_DIGI_MATCHERS (MAX_CHANS * MAX_CHANS * 2)
+
+static struct digi_matcher_s matcher[MAX_DIGI_MATCHERS];
+static int num_matchers = 0;
+
+static int alias_id[MAX_CHANS][MAX_CHANS];	/* Index into matcher for each combination. */
+static int wide_id[MAX_CHANS][MAX_CHANS];
+
+
+/*
+ * Addresses are extracted from the packet only once, rather than 
+ * for each destination channel, and results of pattern matching are
+ * remembered so each distinct pattern is tried only once per address.
+ *
+ * The results are kept in view_result, sized for the number of matchers
+ * actually configured.  Only one view is used at a time because
+ * everything received is processed by a single thread.
+ */
+
+struct digi_view_s {
+	packet_t pp;
+	int num_addr;
+	int first_not_repeated;			/* First unused digipeater position, */
+						/* or -1 if none. */
+	char addr[AX25_MAX_ADDRS][AX25_MAX_ADDR_LEN];	/* With SSID. */
+	int len[AX25_MAX_ADDRS];
+	signed char *result;			/* [matcher id * AX25_MAX_ADDRS + address position] */
+						/* -1 = not tested yet, 0 = no match, 1 = match */
+};
+
+static signed char *view_result = NULL;		/* Grows as matchers are added. */
+
+static int digi_matcher_add (char *pattern, regex_t *re);
+static void digi_view_init (struct digi_view_s *v, packet_t pp);
+static int digi_view_match (struct digi_view_s *v, int id, int r);
+
+static packet_t digipeat_match (int from_chan, packet_t pp, struct digi_view_s *v, char *mycall_rec, char *mycall_xmit, 
+				int alias, int wide, int to_chan, enum preempt_e preempt, char *type_filter);
 
 //static int filter_by_type (char *source, char *infop, char *type_filter);
 
@@ -105,10 +169,372 @@ static struct digi_config_s *save_digi_config_p;
 
 void digipeater_init (struct audio_s *p_audio_config, struct digi_config_s *p_digi_config) 
 {
+	int from_chan, to_chan;
+
 	save_audio_config_p = p_audio_config;
 	save_digi_config_p = p_digi_config;
 	
 	dedupe_init (p_digi_config->dedupe_time);
+
+	for (from_chan = 0; from_chan < MAX_CHANS; from_chan++) {
+	  for (to_chan = 0; to_chan < MAX_CHANS; to_chan++) {
+	    alias_id[from_chan][to_chan] = -1;
+	    wide_id[from_chan][to_chan] = -1;
+	    if (p_digi_config->enabled[from_chan][to_chan]) {
+	      alias_id[from_chan][to_chan] = digi_matcher_add (p_digi_config->alias_pattern[from_chan][to_chan], 
+								&(p_digi_config->alias[from_chan][to_chan]));
+	      wide_id[from_chan][to_chan] = digi_matcher_add (p_digi_config->wide_pattern[from_chan][to_chan], 
+								&(p_digi_config->wide[from_chan][to_chan]));
+	    }
+	  }
+	}
+}
+
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	digi_compile_fast
+ * 
+ * Purpose:	Try to convert a regular expression into the simple form.
+ *
+ * Inputs:	pattern	- Regular expression, POSIX extended syntax.
+ *		
+ * Outputs:	m	- nalt and alt are filled in.
+ *
+ * Returns:	1 for success.
+ *		0 if the pattern uses anything other than literal characters, 
+ *		  ".", "[...]" bracket expressions, "|", and "^" or "$" at
+ *		  the ends of an alternative.  regexec must be used in this case.
+ *
+ *------------------------------------------------------------------------------*/
+
+#define SET_ADD(set,c) ((set)[(unsigned char)(c) >> 3] |= 1 << ((unsigned char)(c) & 7))
+#define SET_HAS(set,c) ((set)[(unsigned char)(c) >> 3] & (1 << ((unsigned char)(c) & 7)))
+
+static int digi_compile_fast (struct digi_matcher_s *m, char *pattern)
+{
+	char *p;
+	int n;
+	struct digi_alt_s *a;
+
+	m->nalt = 1;
+	for (p = pattern; *p != '\0'; p++) {
+	  if (*p == '|') m->nalt++;		/* Could be more than needed due to [|] */
+	}
+	m->alt = calloc (m->nalt, sizeof (struct digi_alt_s));
+	m->nalt = 0;
+
+	p = pattern;
+	while (1) {
+
+	  a = &(m->alt[m->nalt++]);
+
+	  if (*p == '^') {
+	    a->anchor_start = 1;
+	    p++;
+	  }
+
+	  while (*p != '\0' && *p != '|') {
+
+	    if (a->len >= AX25_MAX_ADDR_LEN - 1) {
+	      return (0);			/* Longer than any address. */
+	    }
+
+	    if (*p == '$') {
+	      if (p[1] != '\0' && p[1] != '|') {
+	        return (0);
+	      }
+	      a->anchor_end = 1;
+	      p++;
+	      break;
+	    }
+	    else if (*p == '.') {
+	      for (n = 1; n < 256; n++) {
+	        SET_ADD(a->set[a->len], n);
+	      }
+	      p++;
+	    }
+	    else if (*p == '[') {
+	      int first = 1;
+
+	      p++;
+	      if (*p == '^') {
+	        return (0);
+	      }
+	      while (1) {
+	        unsigned char lo, hi;
+
+	        if (*p == '\0') return (0);
+	        if (*p == ']' && ! first) {
+	          p++;
+	          break;
+	        }
+	        if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '=')) {
+	          return (0);			/* Character class or collating element. */
+	        }
+	        lo = *p++;
+	        hi = lo;
+	        if (*p == '-' && p[1] != ']' && p[1] != '\0') {
+	          hi = p[1];
+	          p += 2;
+	          if (hi == '[' || hi < lo) return (0);
+	        }
+	        for (n = lo; n <= hi; n++) {
+	          SET_ADD(a->set[a->len], n);
+	        }
+	        first = 0;
+	      }
+	    }
+	    else if (*p == '\\') {
+	      if (p[1] == '\0' || isalnum((unsigned char)p[1])) {
+	        return (0);			/* Back reference or GNU extension. */
+	      }
+	      SET_ADD(a->set[a->len], p[1]);
+	      p += 2;
+	    }
+	    else if (strchr("*+?{}()^", *p) != NULL) {
+	      return (0);
+	    }
+	    else {
+	      SET_ADD(a->set[a->len], *p);
+	      p++;
+	    }
+	    a->len++;
+	  }
+
+	  if (*p == '\0') {
+	    break;
+	  }
+	  if (*p != '|') {
+	    return (0);				/* Something after $ */
+	  }
+	  p++;
+	}
+
+	return (1);
+
+} /* end digi_compile_fast */
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	digi_matcher_add
+ * 
+ * Purpose:	Find or create matcher for given pattern.
+ *
+ * Inputs:	pattern	- Regular expression text.
+ *
+ *		re	- Compiled form of same.
+ *		
+ * Returns:	Index into matcher table.
+ *
+ *------------------------------------------------------------------------------*/
+
+static int digi_matcher_add (char *pattern, regex_t *re)
+{
+	int n;
+	struct digi_matcher_s *m;
+
+	assert (pattern != NULL);
+
+	for (n = 0; n < num_matchers; n++) {
+	  if (strcmp(matcher[n].pattern, pattern) == 0) {
+	    return (n);
+	  }
+	}
+
+	assert (num_matchers < MAX_DIGI_MATCHERS);
+	m = &(matcher[num_matchers]);
+
+	m->pattern = strdup(pattern);
+	m->re = re;
+	m->fast = digi_compile_fast (m, pattern);
+	if ( ! m->fast) {
+	  free (m->alt);
+	  m->alt = NULL;
+	  m->nalt = 0;
+	}
+
+	num_matchers++;
+	view_result = realloc (view_result, num_matchers * AX25_MAX_ADDRS);
+	assert (view_result != NULL);
+
+	return (num_matchers - 1);
+
+} /* end digi_matcher_add */
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	digi_fast_match
+ * 
+ * Purpose:	Test whether an address matches the simple form of pattern.
+ *
+ * Returns:	1 for match, 0 for not.  Same as regexec would.
+ *
+ *------------------------------------------------------------------------------*/
+
+static int digi_alt_match_at (struct digi_alt_s *a, char *s, int offset)
+{
+	int n;
+
+	for (n = 0; n < a->len; n++) {
+	  if ( ! SET_HAS(a->set[n], s[offset+n])) {
+	    return (0);
+	  }
+	}
+	return (1);
+}
+
+static int digi_fast_match (struct digi_matcher_s *m, char *s, int slen)
+{
+	int k, offset;
+
+	for (k = 0; k < m->nalt; k++) {
+	  struct digi_alt_s *a = &(m->alt[k]);
+
+	  if (a->len > slen) continue;
+
+	  if (a->anchor_start && a->anchor_end) {
+	    if (a->len == slen && digi_alt_match_at (a, s, 0)) return (1);
+	  }
+	  else if (a->anchor_start) {
+	    if (digi_alt_match_at (a, s, 0)) return (1);
+	  }
+	  else if (a->anchor_end) {
+	    if (digi_alt_match_at (a, s, slen - a->len)) return (1);
+	  }
+	  else {
+	    for (offset = 0; offset <= slen - a->len; offset++) {
+	      if (digi_alt_match_at (a, s, offset)) return (1);
+	    }
+	  }
+	}
+	return (0);
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	digi_view_init
+ * 
+ * Purpose:	Extract the addresses from a received packet once, to be shared
+ *		by all of the destination channels.
+ *
+ * Inputs:	pp	- Packet object.
+ *		
+ * Outputs:	v	- Addresses, position of first unused digipeater.
+ *
+ * Description:	The spec says:
+ *
+ * 		The SSID in the Destination Address field of all packets is coded to specify
+ * 		the APRS digipeater path.
+ * 		If the Destination Address SSID is -0, the packet follows the standard AX.25
+ * 		digipeater ("VIA") path contained in the Digipeater Addresses field of the
+ * 		AX.25 frame.
+ * 		If the Destination Address SSID is non-zero, the packet follows one of 15
+ * 		generic APRS digipeater paths.
+ * 
+ *		What if this is non-zero but there is also a digipeater path?
+ *		I will ignore this if there is an explicit path.
+ *
+ *		Note that this modifies the input.  But only once!
+ *		Otherwise we don't want to modify the input because the 
+ *		packet could be digipeated to multiple channels.
+ *
+ *------------------------------------------------------------------------------*/
+
+static char *dest_ssid_path[16] = { 	
+			"",		/* Use VIA path */
+			"WIDE1-1",
+			"WIDE2-2",
+			"WIDE3-3",
+			"WIDE4-4",
+			"WIDE5-5",
+			"WIDE6-6",
+			"WIDE7-7",
+			"WIDE1-1",	/* North */
+			"WIDE1-1",	/* South */
+			"WIDE1-1",	/* East */
+			"WIDE1-1",	/* West */
+			"WIDE2-2",	/* North */
+			"WIDE2-2",	/* South */
+			"WIDE2-2",	/* East */
+			"WIDE2-2"  };	/* West */
+
+static void digi_view_init (struct digi_view_s *v, packet_t pp)
+{
+	int ssid;
+	int n;
+
+	if (ax25_get_num_repeaters(pp) == 0 && (ssid = ax25_get_ssid(pp, AX25_DESTINATION)) > 0) {
+	  ax25_set_addr(pp, AX25_REPEATER_1, dest_ssid_path[ssid]);
+	  ax25_set_ssid(pp, AX25_DESTINATION, 0);
+	}
+
+	v->pp = pp;
+	v->num_addr = ax25_get_num_addr(pp);
+	v->first_not_repeated = ax25_get_first_not_repeated(pp);
+
+	for (n = 0; n < v->num_addr; n++) {
+	  ax25_get_addr_with_ssid(pp, n, v->addr[n]);
+	  v->len[n] = strlen(v->addr[n]);
+	}
+
+	v->result = view_result;
+	if (num_matchers > 0) {
+	  memset (v->result, -1, num_matchers * AX25_MAX_ADDRS);
+	}
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	digi_view_match
+ * 
+ * Purpose:	Test whether address matches pattern, remembering the result.
+ *
+ * Inputs:	v	- Addresses from packet.
+ *
+ *		id	- Index into matcher table.
+ *
+ *		r	- Address position.
+ *		
+ * Returns:	1 for match, 0 for not.
+ *
+ *------------------------------------------------------------------------------*/
+
+static int digi_view_match (struct digi_view_s *v, int id, int r)
+{
+	struct digi_matcher_s *m;
+
+	assert (id >= 0 && id < num_matchers);
+	assert (r >= 0 && r < v->num_addr);
+
+	if (v->result[id * AX25_MAX_ADDRS + r] >= 0) {
+	  return (v->result[id * AX25_MAX_ADDRS + r]);
+	}
+
+	m = &(matcher[id]);
+
+	if (m->fast) {
+	  v->result[id * AX25_MAX_ADDRS + r] = digi_fast_match (m, v->addr[r], v->len[r]);
+	}
+	else {
+	  int err;
+	  char err_msg[100];
+
+	  err = regexec(m->re, v->addr[r], 0, NULL, 0);
+	  if (err != 0 && err != REG_NOMATCH) {
+	    regerror(err, m->re, err_msg, sizeof(err_msg));
+	    text_color_set (DW_COLOR_ERROR);
+	    dw_printf ("%s\n", err_msg);
+	  }
+	  v->result[id * AX25_MAX_ADDRS + r] = (err == 0);
+	}
+
+	return (v->result[id * AX25_MAX_ADDRS + r]);
 }
 
 
@@ -134,6 +560,7 @@ void digipeater_init (struct audio_s *p_audio_config, struct digi_config_s *p_di
 void digipeater (int from_chan, packet_t pp)
 {
 	int to_chan;
+	struct digi_view_s view;
 
 
 	// dw_printf ("digipeater()\n");
@@ -145,6 +572,7 @@ void digipeater (int from_chan, packet_t pp)
 	  dw_printf ("digipeater: Did not expect to receive on invalid channel %d.\n", from_chan);
 	}
 
+	view.pp = NULL;		/* Addresses extracted on first use. */
 
 /*
  * First pass:  Look at packets being digipeated to same channel.
@@ -157,14 +585,14 @@ void digipeater (int from_chan, packet_t pp)
 	    if (to_chan == from_chan) {
 	      packet_t result;
 
-	      result = digipeat_match (from_chan, pp, save_audio_config_p->achan[from_chan].mycall, 
+	      result = digipeat_match (from_chan, pp, &view, save_audio_config_p->achan[from_chan].mycall, 
 					   save_audio_config_p->achan[to_chan].mycall, 
-			&save_digi_config_p->alias[from_chan][to_chan], &save_digi_config_p->wide[from_chan][to_chan], 
+			alias_id[from_chan][to_chan], wide_id[from_chan][to_chan], 
 			to_chan, save_digi_config_p->preempt[from_chan][to_chan],
 				save_digi_config_p->filter_str[from_chan][to_chan]);
 	      if (result != NULL) {
 		dedupe_remember (pp, to_chan);
-	        tq_append (to_chan, TQ_PRIO_0_HI, result);
+	        tq_append (to_chan, TQ_PRIO_0_HI, TQ_SRC_DIGI, result);
 	      }
 	    }
 	  }
@@ -182,14 +610,14 @@ void digipeater (int from_chan, packet_t pp)
 	    if (to_chan != from_chan) {
 	      packet_t result;
 
-	      result = digipeat_match (from_chan, pp, save_audio_config_p->achan[from_chan].mycall, 
+	      result = digipeat_match (from_chan, pp, &view, save_audio_config_p->achan[from_chan].mycall, 
 					   save_audio_config_p->achan[to_chan].mycall, 
-			&save_digi_config_p->alias[from_chan][to_chan], &save_digi_config_p->wide[from_chan][to_chan], 
+			alias_id[from_chan][to_chan], wide_id[from_chan][to_chan], 
 			to_chan, save_digi_config_p->preempt[from_chan][to_chan],
 				save_digi_config_p->filter_str[from_chan][to_chan]);
 	      if (result != NULL) {
 		dedupe_remember (pp, to_chan);
-	        tq_append (to_chan, TQ_PRIO_1_LO, result);
+	        tq_append (to_chan, TQ_PRIO_1_LO, TQ_SRC_DIGI, result);
 	      }
 	    }
 	  }
@@ -206,6 +634,10 @@ void digipeater (int from_chan, packet_t pp)
  * Purpose:	A simple digipeater for APRS.
  *
  * Input:	pp		- Pointer to a packet object.
+ *
+ *		v		- Addresses from the packet, shared by all
+ *				  destination channels.  Set pp to NULL in
+ *				  here before the first call for a packet.
  *	
  *		mycall_rec	- Call of my station, with optional SSID,
  *				  associated with the radio channel where the 
@@ -216,10 +648,10 @@ void digipeater (int from_chan, packet_t pp)
  *				  packet is to be transmitted.  Could be the same as
  *				  mycall_rec or different.
  *
- *		alias		- Compiled pattern for my station aliases or 
+ *		alias		- Matcher index for my station aliases or 
  *				  "trapping" (repeating only once).
  *
- *		wide		- Compiled pattern for normal WIDEn-n digipeating.
+ *		wide		- Matcher index for normal WIDEn-n digipeating.
  *
  *		to_chan		- Channel number that we are transmitting to.
  *				  This is needed to maintain a history for 
@@ -243,33 +675,12 @@ void digipeater (int from_chan, packet_t pp)
  *
  *------------------------------------------------------------------------------*/
 
-static char *dest_ssid_path[16] = { 	
-			"",		/* Use VIA path */
-			"WIDE1-1",
-			"WIDE2-2",
-			"WIDE3-3",
-			"WIDE4-4",
-			"WIDE5-5",
-			"WIDE6-6",
-			"WIDE7-7",
-			"WIDE1-1",	/* North */
-			"WIDE1-1",	/* South */
-			"WIDE1-1",	/* East */
-			"WIDE1-1",	/* West */
-			"WIDE2-2",	/* North */
-			"WIDE2-2",	/* South */
-			"WIDE2-2",	/* East */
-			"WIDE2-2"  };	/* West */
-				  
-
-static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, char *mycall_xmit, 
-				regex_t *alias, regex_t *wide, int to_chan, enum preempt_e preempt, char *filter_str)
+static packet_t digipeat_match (int from_chan, packet_t pp, struct digi_view_s *v, char *mycall_rec, char *mycall_xmit, 
+				int alias, int wide, int to_chan, enum preempt_e preempt, char *filter_str)
 {
 	int ssid;
 	int r;
-	char repeater[AX25_MAX_ADDR_LEN];
-	int err;
-	char err_msg[100];
+	char *repeater;
 
 /*
  * First check if filtering has been configured.
@@ -292,28 +703,12 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
 	}
 
 /*
- * The spec says:
- *
- * 	The SSID in the Destination Address field of all packets is coded to specify
- * 	the APRS digipeater path.
- * 	If the Destination Address SSID is -0, the packet follows the standard AX.25
- * 	digipeater ("VIA") path contained in the Digipeater Addresses field of the
- * 	AX.25 frame.
- * 	If the Destination Address SSID is non-zero, the packet follows one of 15
- * 	generic APRS digipeater paths.
- * 
- *
- * What if this is non-zero but there is also a digipeater path?
- * I will ignore this if there is an explicit path.
- *
- * Note that this modifies the input.  But only once!
- * Otherwise we don't want to modify the input because this could be called multiple times.
+ * Addresses are extracted only the first time for this packet.
+ * This is also where a non-zero destination SSID becomes a digipeater path.
  */
 
-	if (ax25_get_num_repeaters(pp) == 0 && (ssid = ax25_get_ssid(pp, AX25_DESTINATION)) > 0) {
-	  ax25_set_addr(pp, AX25_REPEATER_1, dest_ssid_path[ssid]);
-	  ax25_set_ssid(pp, AX25_DESTINATION, 0);
-	  /* Continue with general case, below. */
+	if (v->pp == NULL) {
+	  digi_view_init (v, pp);
 	}
 
 /* 
@@ -321,13 +716,13 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
  *
  * r = index of the address position in the frame.
  */
-	r = ax25_get_first_not_repeated(pp);
+	r = v->first_not_repeated;
 
 	if (r < AX25_REPEATER_1) {
 	  return (NULL);
 	}
 
-	ax25_get_addr_with_ssid(pp, r, repeater);
+	repeater = v->addr[r];
 	ssid = ax25_get_ssid(pp, r);
 
 #if DEBUG
@@ -387,8 +782,7 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
  * For the alias pattern, we unconditionally digipeat it once.
  * i.e.  Just replace it with MYCALL don't even look at the ssid.
  */
-	err = regexec(alias,repeater,0,NULL,0);
-	if (err == 0) {
+	if (digi_view_match (v, alias, r)) {
 	  packet_t result;
 
 	  result = ax25_dup (pp);
@@ -398,11 +792,6 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
 	  ax25_set_h (result, r);
 	  return (result);
 	}
-	else if (err != REG_NOMATCH) {
-	  regerror(err, alias, err_msg, sizeof(err_msg));
-	  text_color_set (DW_COLOR_ERROR);
-	  dw_printf ("%s\n", err_msg);
-	}
 
 /* 
  * If preemptive digipeating is enabled, try matching my call 
@@ -412,16 +801,13 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
 	if (preempt != PREEMPT_OFF) {
 	  int r2;
 
-	  for (r2 = r+1; r2 < ax25_get_num_addr(pp); r2++) {
-	    char repeater2[AX25_MAX_ADDR_LEN];
-
-	    ax25_get_addr_with_ssid(pp, r2, repeater2);
+	  for (r2 = r+1; r2 < v->num_addr; r2++) {
 
 	    //text_color_set (DW_COLOR_DEBUG);
-	    //dw_printf ("test match %d %s\n", r2, repeater2);
+	    //dw_printf ("test match %d %s\n", r2, v->addr[r2]);
 
-	    if (strcmp(repeater2, mycall_rec) == 0 ||
-	        regexec(alias,repeater2,0,NULL,0) == 0) {
+	    if (strcmp(v->addr[r2], mycall_rec) == 0 ||
+	        digi_view_match (v, alias, r2)) {
 	      packet_t result;
 
 	      result = ax25_dup (pp);
@@ -464,8 +850,7 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
  * For the wide pattern, we check the ssid and decrement it.
  */
 
-	err = regexec(wide,repeater,0,NULL,0);
-	if (err == 0) {
+	if (digi_view_match (v, wide, r)) {
 
 /*
  * If ssid == 1, we simply replace the repeater with my call and
@@ -503,11 +888,6 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
 	    return (result);
 	  }
 	} 
-	else if (err != REG_NOMATCH) {
-	  regerror(err, wide, err_msg, sizeof(err_msg));
-	  text_color_set (DW_COLOR_ERROR);
-	  dw_printf ("%s\n", err_msg);
-	}
 
 
 /*
@@ -552,7 +932,7 @@ void digi_regen (int from_chan, packet_t pp)
 	    result = ax25_dup (pp); 
 	    if (result != NULL) {
 	      // TODO:  if AX.25 and has been digipeated, put in HI queue?
-	      tq_append (to_chan, TQ_PRIO_1_LO, result);
+	      tq_append (to_chan, TQ_PRIO_1_LO, TQ_SRC_DIGI, result);
 	    }
 	  }
 	}
@@ -574,11 +954,13 @@ void digi_regen (int from_chan, packet_t pp)
 
 #if DIGITEST
 
+#include <time.h>
+
 static char mycall[] = "WB2OSZ-9";
 
-static regex_t alias_re;     
+static struct audio_s test_audio_config;
 
-static regex_t wide_re;   
+static struct digi_config_s test_digi_config;
 
 static int failed;
 
@@ -590,6 +972,7 @@ static char typefilter[20] = "";
 static void test (char *in, char *out)
 {
 	packet_t pp, result;
+	struct digi_view_s view;
 	//int should_repeat;
 	char rec[256];
 	char xmit[256];
@@ -649,7 +1032,8 @@ static void test (char *in, char *out)
 
 //TODO:											Add filtering to test.
 //											V
-	result = digipeat_match (0, pp, mycall, mycall, &alias_re, &wide_re, 0, preempt, NULL);
+	view.pp = NULL;
+	result = digipeat_match (0, pp, &view, mycall, mycall, alias_id[0][0], wide_id[0][0], 0, preempt, NULL);
 	
 	if (result != NULL) {
 
@@ -679,33 +1063,183 @@ static void test (char *in, char *out)
 	dw_printf ("\n");
 }
 
+/*
+ * Compare the fast matcher against regexec for some patterns
+ * which can and can't be converted.
+ */
+
+static char *matcher_patterns[] = {
+	"^WIDE[4-7]-[1-7]|CITYD$",
+	"^WIDE[1-7]-[1-7]$|^TRACE[1-7]-[1-7]$|^MA[1-7]-[1-7]$",
+	"^WIDE1-1$|^CITY[A-Z]$|^W2.-[0-9]$",
+	"WIDE",
+	"-7$",
+	"^[]A-]X",
+	"^NJ\\.WIDE$",
+	"^(WIDE|TRACE)[1-7]-[1-7]$",		/* These need regexec. */
+	"^[^W]+$",
+	"^[[:upper:]]+-1$",
+	NULL };
+
+static char *matcher_addrs[] = {
+	"WIDE1-1", "WIDE3-2", "WIDE4-4", "WIDE7-7", "WIDE8-4", "WIDE2", "XWIDE2-2", "WIDE2-2X",
+	"TRACE3-3", "MA2-1", "CITYD", "XCITYD", "CITYDX", "CITYA", "W2X-5", "W2XY-5",
+	"NJ.WIDE", "NJXWIDE", "]X", "AX", "-X", "BX", "R1", "N8VIM-7", "WB2OSZ-1", "Q",
+	NULL };
+
+static void test_matchers (void)
+{
+	int i, j, id, fast, slow;
+	regex_t re[20];
+
+	for (i = 0; matcher_patterns[i] != NULL; i++) {
+	  if (regcomp (&re[i], matcher_patterns[i], REG_EXTENDED|REG_NOSUB) != 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Could not compile %s\n", matcher_patterns[i]);
+	    failed++;
+	    continue;
+	  }
+	  id = digi_matcher_add (matcher_patterns[i], &re[i]);
+	  dw_printf ("%-55s %s\n", matcher_patterns[i], matcher[id].fast ? "fast" : "regexec");
+
+	  for (j = 0; matcher_addrs[j] != NULL; j++) {
+	    slow = regexec (&re[i], matcher_addrs[j], 0, NULL, 0) == 0;
+	    fast = matcher[id].fast ? digi_fast_match (&matcher[id], matcher_addrs[j], strlen(matcher_addrs[j])) : slow;
+	    if (fast != slow) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Matcher for %s gave %d for %s, expected %d\n", matcher_patterns[i], fast, matcher_addrs[j], slow);
+	      text_color_set(DW_COLOR_INFO);
+	      failed++;
+	    }
+	  }
+	}
+}
+
+
+/*
+ * Throughput of address matching when a packet could go to several channels.
+ * The old way extracted the address and used regexec for each channel.
+ */
+
+#define BENCH_CHANS 4
+#define BENCH_COUNT 200000
+
+static void benchmark (void)
+{
+	static char *paths[] = {
+		"W1ABC>APRS,WIDE1-1,WIDE2-1:>test",
+		"W1ABC>APRS,N8VIM*,WIDE2-1:>test",
+		"W1ABC>APRS,R1,R2,R3*,CITYD,WIDE3-2:>test",
+		"W1ABC>APRS,TCPIP*:>test",
+		"W1ABC>APRS-3:>test" };
+	int num_paths = sizeof(paths) / sizeof(paths[0]);
+	packet_t pp[5];
+	int n, k, to_chan, r, r2, hits_old, hits_new;
+	clock_t start;
+	double t_old, t_new;
+
+	for (k = 0; k < num_paths; k++) {
+	  struct digi_view_s view;
+
+	  pp[k] = ax25_from_text (paths[k], 1);
+	  assert (pp[k] != NULL);
+	  digi_view_init (&view, pp[k]);	/* So both see destination SSID path. */
+	}
+
+	hits_old = 0;
+	start = clock();
+	for (n = 0; n < BENCH_COUNT; n++) {
+	  packet_t p = pp[n % num_paths];
+	  for (to_chan = 0; to_chan < BENCH_CHANS; to_chan++) {
+	    char repeater[AX25_MAX_ADDR_LEN];
+
+	    r = ax25_get_first_not_repeated(p);
+	    if (r < AX25_REPEATER_1) continue;
+	    ax25_get_addr_with_ssid(p, r, repeater);
+	    if (regexec(&test_digi_config.alias[0][0], repeater, 0, NULL, 0) == 0) { hits_old++; continue; }
+	    for (r2 = r+1; r2 < ax25_get_num_addr(p); r2++) {
+	      char repeater2[AX25_MAX_ADDR_LEN];
+	      ax25_get_addr_with_ssid(p, r2, repeater2);
+	      if (regexec(&test_digi_config.alias[0][0], repeater2, 0, NULL, 0) == 0) hits_old++;
+	    }
+	    if (regexec(&test_digi_config.wide[0][0], repeater, 0, NULL, 0) == 0) hits_old++;
+	  }
+	}
+	t_old = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	hits_new = 0;
+	start = clock();
+	for (n = 0; n < BENCH_COUNT; n++) {
+	  struct digi_view_s view;
+
+	  view.pp = NULL;
+	  for (to_chan = 0; to_chan < BENCH_CHANS; to_chan++) {
+	    if (view.pp == NULL) digi_view_init (&view, pp[n % num_paths]);
+	    r = view.first_not_repeated;
+	    if (r < AX25_REPEATER_1) continue;
+	    if (digi_view_match (&view, alias_id[0][0], r)) { hits_new++; continue; }
+	    for (r2 = r+1; r2 < view.num_addr; r2++) {
+	      if (digi_view_match (&view, alias_id[0][0], r2)) hits_new++;
+	    }
+	    if (digi_view_match (&view, wide_id[0][0], r)) hits_new++;
+	  }
+	}
+	t_new = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	for (k = 0; k < num_paths; k++) {
+	  ax25_delete (pp[k]);
+	}
+
+	dw_printf ("\nAddress matching, %d packets, %d channels:\n", BENCH_COUNT, BENCH_CHANS);
+	dw_printf ("  regexec per channel   %.3f sec, %.0f packets/sec\n", t_old, t_old > 0 ? BENCH_COUNT / t_old : 0.);
+	dw_printf ("  shared view, matcher  %.3f sec, %.0f packets/sec\n", t_new, t_new > 0 ? BENCH_COUNT / t_new : 0.);
+
+	if (hits_old != hits_new) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Benchmark match counts differ, %d vs. %d\n", hits_old, hits_new);
+	  text_color_set(DW_COLOR_INFO);
+	  failed++;
+	}
+}
+
+
 int main (int argc, char *argv[])
 {
 	int e;
 	failed = 0;
 	char message[256];
 
-	dedupe_init (4);
+	test_digi_config.dedupe_time = 4;
 
 /* 
  * Compile the patterns. 
  */
-	e = regcomp (&alias_re, "^WIDE[4-7]-[1-7]|CITYD$", REG_EXTENDED|REG_NOSUB);
+	test_digi_config.alias_pattern[0][0] = "^WIDE[4-7]-[1-7]|CITYD$";
+	e = regcomp (&test_digi_config.alias[0][0], test_digi_config.alias_pattern[0][0], REG_EXTENDED|REG_NOSUB);
 	if (e != 0) {
-	  regerror (e, &alias_re, message, sizeof(message));
+	  regerror (e, &test_digi_config.alias[0][0], message, sizeof(message));
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("\n%s\n\n", message);
 	  exit (1);
 	}
 
-	e = regcomp (&wide_re, "^WIDE[1-7]-[1-7]$|^TRACE[1-7]-[1-7]$|^MA[1-7]-[1-7]$", REG_EXTENDED|REG_NOSUB);
+	test_digi_config.wide_pattern[0][0] = "^WIDE[1-7]-[1-7]$|^TRACE[1-7]-[1-7]$|^MA[1-7]-[1-7]$";
+	e = regcomp (&test_digi_config.wide[0][0], test_digi_config.wide_pattern[0][0], REG_EXTENDED|REG_NOSUB);
 	if (e != 0) {
-	  regerror (e, &wide_re, message, sizeof(message));
+	  regerror (e, &test_digi_config.wide[0][0], message, sizeof(message));
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("\n%s\n\n", message);
 	  exit (1);
 	}
 
+	test_digi_config.enabled[0][0] = 1;
+
+	digipeater_init (&test_audio_config, &test_digi_config);
+
+	test_matchers ();
+
+	benchmark ();
+
 /*
  * Let's start with the most basic cases.
  */
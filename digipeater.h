@@ -34,6 +34,9 @@ struct digi_config_s {
 
 	regex_t	wide[MAX_CHANS][MAX_CHANS];
 
+	char *alias_pattern[MAX_CHANS][MAX_CHANS];	// Original text of above.  digipeater_init
+	char *wide_pattern[MAX_CHANS][MAX_CHANS];	// uses it to build a faster matcher.
+
 	int	enabled[MAX_CHANS][MAX_CHANS];
 
 	enum preempt_e { PREEMPT_OFF, PREEMPT_DROP, PREEMPT_MARK, PREEMPT_TRACE } preempt[MAX_CHANS][MAX_CHANS];
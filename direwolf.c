@@ -92,6 +92,7 @@
 #include "nmea.h"
 #include "gen_tone.h"
 #include "digipeater.h"
+#include "pfilter.h"
 #include "tq.h"
 #include "xmit.h"
 #include "ptt.h"
@@ -104,8 +105,15 @@
 #include "symbols.h"
 #include "dwgps.h"
 #include "log.h"
+#include "capture.h"
+#include "audio_ring.h"
 #include "recv.h"
 #include "morse.h"
+#include "telemetry.h"
+#include "heard.h"
+#include "dsp_stats.h"
+#include "dsp_kernel.h"
+#include "rx_latency.h"
 
 
 //static int idx_decoded = 0;
@@ -177,7 +185,10 @@ int main (int argc, char *argv[])
 	struct igate_config_s igate_config;
 	int r_opt = 0, n_opt = 0, b_opt = 0, B_opt = 0, D_opt = 0;	/* Command line options. */
 	char P_opt[16];
+	char I_opt[16];
 	char l_opt[80];
+	char R_opt[80];		/* "-R fname" capture file to replay. */
+	double z_opt = 1.0;	/* "-z n" replay speed.  0 for as fast as possible. */
 	char input_file[80];
 	
 	int t_opt = 1;		/* Text color option. */				
@@ -194,6 +205,8 @@ int main (int argc, char *argv[])
 #endif
 
 	strlcpy(l_opt, "", sizeof(l_opt));
+	strlcpy(R_opt, "", sizeof(R_opt));
+	strlcpy(I_opt, "", sizeof(I_opt));
 	strlcpy(P_opt, "", sizeof(P_opt));
 
 #if __WIN32__
@@ -322,7 +335,7 @@ int main (int argc, char *argv[])
 
 	  /* ':' following option character means arg is required. */
 
-          c = getopt_long(argc, argv, "P:B:D:c:pxr:b:n:d:q:t:Ul:Sa:",
+          c = getopt_long(argc, argv, "P:B:D:c:pxr:b:n:d:q:t:Ul:Sa:I:R:z:",
                         long_options, &option_index);
           if (c == -1)
             break;
@@ -380,6 +393,11 @@ int main (int argc, char *argv[])
 	    strlcpy (P_opt, optarg, sizeof(P_opt)); 
 	    break;	
 
+	  case 'I':				/* -I DSP kernel type, normally picked automatically. */
+
+	    strlcpy (I_opt, optarg, sizeof(I_opt));
+	    break;
+
           case 'D':				/* -D decrease AFSK demodulator sample rate */
 	 
 	    D_opt = atoi(optarg);
@@ -501,6 +519,21 @@ int main (int argc, char *argv[])
 	    strlcpy (l_opt, optarg, sizeof(l_opt));
             break;
 
+          case 'R':				/* -R for capture file to replay */
+
+	    strlcpy (R_opt, optarg, sizeof(R_opt));
+            break;
+
+          case 'z':				/* -z for replay speed */
+
+	    z_opt = atof(optarg);
+	    if (z_opt < 0) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Replay speed must not be negative.\n");
+	      usage (argv);
+	    }
+            break;
+
 	  case 'S':				/* Print symbol tables and exit. */
 
 	    symbols_init ();
@@ -622,9 +655,19 @@ int main (int argc, char *argv[])
 
 /*
  * Initialize the AFSK demodulator and HDLC decoder.
+ * First pick the best DSP kernels for this processor.
  */
+	dsp_kernel_init (I_opt);
 	multi_modem_init (&audio_config);
 
+/*
+ * Optional measurement of time taken by each step of receive processing.
+ * This must be after the demodulators are set up and before the receive threads start.
+ */
+	if (misc_config.dsp_stats_interval > 0) {
+	  dsp_stats_init (&audio_config, misc_config.dsp_stats_interval, misc_config.dsp_stats_file);
+	}
+
 /*
  * Initialize the touch tone decoder & APRStt gateway.
  */
@@ -675,6 +718,22 @@ int main (int argc, char *argv[])
 	  exit (0);
 	}
 
+/*
+ * Telemetry metadata must be set up before the IGate starts
+ * decoding packets from the Internet server.
+ */
+	telemetry_init (misc_config.tlm_max_stations);
+
+/*
+ * Heard station list must be ready before the receive thread starts.
+ */
+	heard_init (misc_config.heard_max_stations);
+
+/*
+ * Packet filters are used by the digipeater and IGate threads.
+ */
+	pfilter_init ();
+
 /*
  * Initialize the digipeater and IGate functions.
  */
@@ -714,6 +773,22 @@ int main (int argc, char *argv[])
 	log_init(misc_config.logdir);
 	beacon_init (&audio_config, &misc_config);
 
+/*
+ * Binary capture of received frames and optional playback of earlier capture.
+ */
+	capture_init (misc_config.capture_dir, misc_config.capture_max_mb);
+
+	if (strlen(R_opt) > 0) {
+	  if (capture_replay (R_opt, z_opt, &audio_config) != 0) {
+	    exit (EXIT_FAILURE);
+	  }
+	}
+
+
+/*
+ * Keep recent audio, for channels with AUDIOTRIGGER, to save when frames can't be decoded.
+ */
+	audio_ring_init (&audio_config);
 
 /*
  * Get sound samples and decode them.
@@ -764,11 +839,15 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 	//int j;
 	int h;
 	char display_retries[32];
+	double lat = G_UNKNOWN;		/* Position for heard list, if decoded. */
+	double lon = G_UNKNOWN;
 
 	assert (chan >= 0 && chan < MAX_CHANS);
 	assert (subchan >= -1 && subchan < MAX_SUBCHANS);
 	assert (slice >= 0 && slice < MAX_SLICERS);
 	assert (pp != NULL);	// 1.1J+
+
+	capture_write (chan, subchan, slice, pp, alevel, retries);
      
 	strlcpy (display_retries, "", sizeof(display_retries));
 	if (audio_config.achan[chan].fix_bits != RETRY_NONE || audio_config.achan[chan].passall) {
@@ -943,6 +1022,9 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 
 	  log_write (chan, &A, pp, alevel, retries);
 
+	  lat = A.g_lat;
+	  lon = A.g_lon;
+
 	  // Convert to NMEA waypoint sentence if we have a location.
 
  	  if (A.g_lat != G_UNKNOWN && A.g_lon != G_UNKNOWN) {
@@ -954,6 +1036,13 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 	}
 
 
+/* Remember who we heard.  Skip APRStt because DTMF tones are not really a station. */
+
+	if (subchan != -1) {
+	  heard_update (chan, pp, alevel, lat, lon);
+	}
+
+
 /* Send to another application if connected. */
 // TODO1.3:  Put a wrapper around this so we only call one function to send by all methods.
 
@@ -962,9 +1051,14 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 
 	flen = ax25_pack(pp, fbuf);
 
+	rx_latency_mark (pp, chan, RXL_APP);
+
 	server_send_rec_packet (chan, pp, fbuf, flen);
+	rx_latency_mark (pp, chan, RXL_AGW);
 	kissnet_send_rec_packet (chan, fbuf, flen);
+	rx_latency_mark (pp, chan, RXL_KISSNET);
 	kiss_send_rec_packet (chan, fbuf, flen);
+	rx_latency_mark (pp, chan, RXL_KISS);
 
 /* 
  * If it came from DTMF decoder, send it to APRStt gateway.
@@ -986,6 +1080,7 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 	  if (ax25_is_aprs(pp) && retries == RETRY_NONE) {
 
 	    igate_send_rec_packet (chan, pp);
+	    rx_latency_mark (pp, chan, RXL_IGATE);
 	  }
 
 
@@ -1007,9 +1102,12 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 	  if (ax25_is_aprs(pp) && retries == RETRY_NONE) {
 
 	    digipeater (chan, pp);
+	    rx_latency_mark (pp, chan, RXL_DIGI);
 	  }
 	}
 
+	rx_latency_mark (pp, chan, RXL_TOTAL);
+
 	ax25_delete (pp);
 	
 } /* end app_process_rec_packet */
@@ -1025,6 +1123,7 @@ static BOOL cleanup_win (int ctrltype)
 	  text_color_set(DW_COLOR_INFO);
 	  dw_printf ("\nQRT\n");
 	  log_term ();
+	  capture_term ();
 	  ptt_term ();
 	  dwgps_term ();
 	  SLEEP_SEC(1);
@@ -1041,6 +1140,7 @@ static void cleanup_linux (int x)
 	text_color_set(DW_COLOR_INFO);
 	dw_printf ("\nQRT\n");
 	log_term ();
+	capture_term ();
 	ptt_term ();
 	dwgps_term ();
 	SLEEP_SEC(1);
@@ -1070,6 +1170,8 @@ static void usage (char **argv)
 	dw_printf ("                     If > 2400, K9NG/G3RUH style encoding is used.\n");
 	dw_printf ("                     Otherwise, AFSK tones are set to 1200 & 2200.\n");
 	dw_printf ("    -D n           Divide audio sample rate by n for channel 0.\n");
+	dw_printf ("    -I k           DSP kernel type: scalar, sse2, avx2, or avx512.\n");
+	dw_printf ("                     Default is the best supported by this processor.\n");
 	dw_printf ("    -d             Debug options:\n");
 	dw_printf ("       a             a = AGWPE network protocol client.\n");
 	dw_printf ("       k             k = KISS serial port client.\n");
@@ -1095,6 +1197,8 @@ static void usage (char **argv)
 	dw_printf ("    -x             Send Xmit level calibration tones.\n");
 	dw_printf ("    -U             Print UTF-8 test string and exit.\n");
 	dw_printf ("    -S             Print symbol tables and exit.\n");
+	dw_printf ("    -R fname       Replay received frames from capture file.\n");
+	dw_printf ("    -z n           Replay speed.  1 = original timing, 0 = as fast as possible.\n");
 	dw_printf ("\n");
 
 	dw_printf ("After any options, there can be a single command line argument for the source of\n");
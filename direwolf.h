@@ -9,9 +9,13 @@
  * In version 1.2, we relax this restriction and allow more audio devices.
  * Three is probably adequate for standard version.
  * Larger reasonable numbers should also be fine.
+ *
+ * Increased to 8 so a wideband I/Q input can be split into as
+ * many as 16 radio channels.  That is also the limit for the
+ * KISS protocol which has 4 bits for the port number.
  */
 
-#define MAX_ADEVS 3			
+#define MAX_ADEVS 8			
 
 	
 /*
@@ -81,9 +85,13 @@
 #if __WIN32__
 #define PTW32_STATIC_LIB
 //#include "pthreads/pthread.h"
+/* Windows doesn't have the thread safe _r versions.  Its versions use thread local storage. */
 #define gmtime_r( _clock, _result ) \
         ( *(_result) = *gmtime( (_clock) ), \
           (_result) )
+#define localtime_r( _clock, _result ) \
+        ( *(_result) = *localtime( (_clock) ), \
+          (_result) )
 #else
 #include <pthread.h>
 #endif
@@ -46,6 +46,8 @@
 #include "audio.h"
 #include "dlq.h"
 #include "dedupe.h"
+#include "dsp_stats.h"
+#include "rx_latency.h"
 
 
 /* The queue is a linked list of these. */
@@ -73,6 +75,8 @@ struct dlq_item_s {
 	retry_t retries;		/* Effort expended to get a valid CRC. */
 
 	char spectrum[MAX_SUBCHANS*MAX_SLICERS+1];	/* "Spectrum" display for multi-decoders. */
+
+	ds_ticks_t append_ticks;	/* When added to queue, for DSP statistics. */
 };
 
 
@@ -98,7 +102,6 @@ static int recv_thread_is_waiting = 0;
 
 #endif
 
-static int dlq_is_empty (void);
 
 static int was_init = 0;			/* was initialization performed? */
 
@@ -283,6 +286,7 @@ void dlq_append (dlq_type_t type, int chan, int subchan, int slice, packet_t pp,
 	  strlcpy(pnew->spectrum, "", sizeof(pnew->spectrum));
 	else
 	  strlcpy(pnew->spectrum, spectrum, sizeof(pnew->spectrum));
+	if (dsp_stats_enabled) pnew->append_ticks = dsp_stats_ticks();
 
 #if DEBUG1
 	text_color_set(DW_COLOR_DEBUG);
@@ -613,6 +617,8 @@ int dlq_remove (dlq_type_t *type, int *chan, int *subchan, int *slice, packet_t
 	}
 #endif
 	if (result) {
+	  rx_latency_mark (*pp, *chan, RXL_QUEUE);
+	  if (dsp_stats_enabled) dsp_stats_record (DS_DLQ_WAIT, *chan, *subchan, *slice, dsp_stats_ticks() - phead->append_ticks);
 	  free (phead);
 	}
 
@@ -630,10 +636,13 @@ int dlq_remove (dlq_type_t *type, int *chan, int *subchan, int *slice, packet_t
  *
  * Returns:	True if nothing in the queue.	
  *
+ * Description:	This doesn't lock the queue so the answer could be
+ *		out of date by the time it is used.  Good enough for 
+ *		pacing something feeding the queue.
+ *
  *--------------------------------------------------------------------*/
 
-#if 0
-static int dlq_is_empty (void)
+int dlq_is_empty (void)
 {
 	if (queue_head == NULL) {
 	  return (1);
@@ -641,6 +650,5 @@ static int dlq_is_empty (void)
 	return (0);
 
 } /* end dlq_is_empty */
-#endif
 
 /* end dlq.c */
@@ -22,6 +22,8 @@ void dlq_append (dlq_type_t type, int chan, int subchan, int slice, packet_t pp,
 
 void dlq_wait_while_empty (void);
 
+int dlq_is_empty (void);
+
 int dlq_remove (dlq_type_t *type, int *chan, int *subchan, int *slice, packet_t *pp, alevel_t *alevel, retry_t *retries, char *spectrum, size_t spectrumsize); 
 
 #endif
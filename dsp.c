@@ -250,4 +250,74 @@ void gen_bandpass (float f1, float f2, float *bp_filter, int filter_size, bp_win
 	}
 }
 
+
+/*------------------------------------------------------------------
+ *
+ * Name:        q15_shift
+ *
+ * Purpose:     Pick a scale for converting filter taps to 16 bit integers.
+ *
+ * Inputs:	filter		- Floating point taps.
+ *		filter_size	- Number of taps.
+ *
+ * Returns:	Number of bits to shift the sum of products right.
+ *		Taps are multiplied by 2 to this power.
+ *
+ * Description:	We want the largest scale, for best precision, such that
+ *		each tap fits in 16 bits and the sum of products can't
+ *		overflow 32 bits for any 16 bit input.
+ *
+ *----------------------------------------------------------------*/
+
+int q15_shift (const float *filter, int filter_size)
+{
+	float big = 0;
+	float total = 0;
+	int j;
+	int shift;
+
+	for (j=0; j<filter_size; j++) {
+	  float a = fabsf(filter[j]);
+	  if (a > big) big = a;
+	  total += a;
+	}
+
+	for (shift = 30; shift > 0; shift--) {
+	  float scale = (float)(1 << shift);
+	  if (big * scale <= 32767.0f && total * scale + filter_size / 2 <= 65535.0f) {
+	    break;
+	  }
+	}
+
+	assert (shift > 0);
+	return (shift);
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        gen_q15_filter
+ *
+ * Purpose:     Convert filter taps to 16 bit integers for the
+ *		fixed point demodulators.
+ *
+ * Inputs:	filter		- Floating point taps.
+ *		filter_size	- Number of taps.
+ *		shift		- From q15_shift.  Filters used together,
+ *				  such as the mark and space correlators,
+ *				  must use the same value.
+ *
+ * Outputs:	q		- Taps multiplied by 2**shift and rounded.
+ *
+ *----------------------------------------------------------------*/
+
+void gen_q15_filter (const float *filter, short *q, int filter_size, int shift)
+{
+	int j;
+
+	for (j=0; j<filter_size; j++) {
+	  q[j] = (short) lrintf(filter[j] * (float)(1 << shift));
+	}
+}
+
 /* end dsp.c */
\ No newline at end of file
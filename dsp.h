@@ -7,4 +7,8 @@ float window (bp_window_t type, int size, int j);
 
 void gen_lowpass (float fc, float *lp_filter, int filter_size, bp_window_t wtype);
 
-void gen_bandpass (float f1, float f2, float *bp_filter, int filter_size, bp_window_t wtype);
\ No newline at end of file
+void gen_bandpass (float f1, float f2, float *bp_filter, int filter_size, bp_window_t wtype);
+
+int q15_shift (const float *filter, int filter_size);
+
+void gen_q15_filter (const float *filter, short *q, int filter_size, int shift);
@@ -0,0 +1,926 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2016  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      dsp_kernel.c
+ *
+ * Purpose:   	The innermost loops of the demodulators:  FIR filters,
+ *		mark/space correlators, and automatic gain control.
+ *
+ * Description:	Most of the CPU time is spent right here so it is worth
+ *		using the best vector instructions available.
+ *
+ *		Previously we relied on the compiler and the Makefile
+ *		guessing at the target processor.  That works fine when
+ *		building on the same machine that will run the application
+ *		but a binary package must run on the least capable processor
+ *		of the family and can't use the newer instructions.
+ *
+ *		Now we compile several versions of each kernel, for
+ *		different instruction sets, and pick the best one supported
+ *		by the processor when the application starts up.
+ *
+ *		scalar	- Portable C.  Used for everything other than x86.
+ *			  The compiler may still vectorize this for whatever
+ *			  instruction set was selected when building.
+ *
+ *		sse2	- 4 floats at a time.  Any x86_64 and most later i386.
+ *
+ *		avx2	- 8 floats at a time with fused multiply add.
+ *			  Intel Haswell (2013), AMD Excavator (2015) and later.
+ *
+ *		avx512	- 16 floats at a time.  Intel Skylake server, Ice Lake,
+ *			  AMD Zen 4 and later.
+ *
+ *		The AGC is a recursive calculation for one sample at a time
+ *		so wider vectors don't help.  A branch free SSE version,
+ *		handling peak and valley together in one register, took
+ *		twice as long as the plain C so all variants use that.
+ *		It is still a separate table entry so a faster version
+ *		could be added for some other processor.
+ *
+ *		The 16 bit integer kernels, for the fixed point demodulators,
+ *		use "pmaddwd" which multiplies pairs of 16 bit numbers and
+ *		adds adjacent products into 32 bits.  The AVX-512 form needs
+ *		the BW extension, so the avx512 variant uses the AVX2 ones.
+ *
+ *		The choice can be overridden on the command line, with
+ *		the "-I" option, for comparing performance with atest.
+ *
+ *		Results can differ very slightly between versions because
+ *		the additions are performed in a different order.
+ *
+ *---------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "direwolf.h"
+#include "textcolor.h"
+#include "dsp_kernel.h"
+
+
+#if (defined(__x86_64__) || defined(__i386__)) && (__GNUC__ >= 5 || defined(__clang__))
+#define DSP_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+/* Reduction intrinsics for AVX-512 are not in older compilers. */
+
+#if DSP_KERNEL_X86 && (__GNUC__ >= 7 || defined(__clang__))
+#define DSP_KERNEL_AVX512 1
+#endif
+
+
+
+/*-------------------------------------------------------------------
+ *
+ *	Portable C.
+ *
+ *--------------------------------------------------------------------*/
+
+
+static float convolve_scalar (const float *__restrict__ data, const float *__restrict__ filter, int filter_size)
+{
+	float sum = 0.0f;
+	int j;
+
+#pragma GCC ivdep				// ignored until gcc 4.9
+	for (j=0; j<filter_size; j++) {
+	    sum += filter[j] * data[j];
+	}
+
+	return (sum);
+}
+
+
+static void correlate_scalar (const float *__restrict__ data, const float *__restrict__ m_sin, const float *__restrict__ m_cos,
+			const float *__restrict__ s_sin, const float *__restrict__ s_cos, int filter_size, float sums[4])
+{
+	float ms = 0.0f, mc = 0.0f, ss = 0.0f, sc = 0.0f;
+	int j;
+
+#pragma GCC ivdep
+	for (j=0; j<filter_size; j++) {
+	    ms += m_sin[j] * data[j];
+	    mc += m_cos[j] * data[j];
+	    ss += s_sin[j] * data[j];
+	    sc += s_cos[j] * data[j];
+	}
+
+	sums[0] = ms;
+	sums[1] = mc;
+	sums[2] = ss;
+	sums[3] = sc;
+}
+
+
+static float agc_scalar (float in, float fast_attack, float slow_decay, float *ppeak, float *pvalley)
+{
+	if (in >= *ppeak) {
+	  *ppeak = in * fast_attack + *ppeak * (1.0f - fast_attack);
+	}
+	else {
+	  *ppeak = in * slow_decay + *ppeak * (1.0f - slow_decay);
+	}
+
+	if (in <= *pvalley) {
+	  *pvalley = in * fast_attack + *pvalley * (1.0f - fast_attack);
+	}
+	else  {
+	  *pvalley = in * slow_decay + *pvalley * (1.0f - slow_decay);
+	}
+
+	if (*ppeak > *pvalley) {
+	  return ((in - 0.5f * (*ppeak + *pvalley)) / (*ppeak - *pvalley));
+	}
+	return (0.0f);
+}
+
+
+
+/*
+ * 16 bit integer versions for the fixed point demodulators.
+ * Compilers turn these into packed multiply and add instructions
+ * for ARM NEON and others.
+ */
+
+static int convolve_q15_scalar (const short *__restrict__ data, const short *__restrict__ filter, int filter_size)
+{
+	int sum = 0;
+	int j;
+
+	for (j=0; j<filter_size; j++) {
+	    sum += filter[j] * data[j];
+	}
+
+	return (sum);
+}
+
+
+static void correlate_q15_scalar (const short *__restrict__ data, const short *__restrict__ m_sin, const short *__restrict__ m_cos,
+			const short *__restrict__ s_sin, const short *__restrict__ s_cos, int filter_size, int sums[4])
+{
+	int ms = 0, mc = 0, ss = 0, sc = 0;
+	int j;
+
+	for (j=0; j<filter_size; j++) {
+	    ms += m_sin[j] * data[j];
+	    mc += m_cos[j] * data[j];
+	    ss += s_sin[j] * data[j];
+	    sc += s_cos[j] * data[j];
+	}
+
+	sums[0] = ms;
+	sums[1] = mc;
+	sums[2] = ss;
+	sums[3] = sc;
+}
+
+
+/*
+ * Same as agc_scalar with 24 bit peak and valley and 31 bit rates.
+ *
+ * The normalized result is limited to -1.0 .. +1.0 so it can be
+ * calculated with a 32 bit division.  Anything beyond that range
+ * is off the scale for the slicer anyhow.
+ */
+
+static int agc_q15_scalar (int in, int fast_attack, int slow_decay, int *ppeak, int *pvalley)
+{
+	int x = in * 256;
+	int num, den, sh;
+
+	*ppeak = track_q31 (*ppeak, x, x >= *ppeak ? fast_attack : slow_decay);
+	*pvalley = track_q31 (*pvalley, x, x <= *pvalley ? fast_attack : slow_decay);
+
+	den = *ppeak - *pvalley;
+	if (den <= 0) {
+	  return (0);
+	}
+
+	num = x - (*ppeak >> 1) - (*pvalley >> 1);
+	if (num > den) num = den;
+	else if (num < -den) num = -den;
+
+	sh = 16 - __builtin_clz(den);
+	if (sh > 0) {
+	  num >>= sh;
+	  den >>= sh;
+	}
+	return ((num * 32768) / den);
+}
+
+
+#if DSP_KERNEL_X86
+
+/*-------------------------------------------------------------------
+ *
+ *	SSE2 - 4 at a time.
+ *
+ *--------------------------------------------------------------------*/
+
+
+__attribute__((target("sse2")))
+static inline float hsum_sse2 (__m128 v)
+{
+	v = _mm_add_ps (v, _mm_movehl_ps (v, v));
+	v = _mm_add_ss (v, _mm_shuffle_ps (v, v, 1));
+	return (_mm_cvtss_f32 (v));
+}
+
+
+__attribute__((target("sse2")))
+static float convolve_sse2 (const float *data, const float *filter, int filter_size)
+{
+	__m128 acc0 = _mm_setzero_ps();
+	__m128 acc1 = _mm_setzero_ps();
+	float sum;
+	int j = 0;
+
+	for ( ; j + 8 <= filter_size; j += 8) {
+	  acc0 = _mm_add_ps (acc0, _mm_mul_ps (_mm_loadu_ps(data + j), _mm_loadu_ps(filter + j)));
+	  acc1 = _mm_add_ps (acc1, _mm_mul_ps (_mm_loadu_ps(data + j + 4), _mm_loadu_ps(filter + j + 4)));
+	}
+	if (j + 4 <= filter_size) {
+	  acc0 = _mm_add_ps (acc0, _mm_mul_ps (_mm_loadu_ps(data + j), _mm_loadu_ps(filter + j)));
+	  j += 4;
+	}
+
+	sum = hsum_sse2 (_mm_add_ps (acc0, acc1));
+
+	for ( ; j < filter_size; j++) {
+	  sum += data[j] * filter[j];
+	}
+	return (sum);
+}
+
+
+__attribute__((target("sse2")))
+static void correlate_sse2 (const float *data, const float *m_sin, const float *m_cos,
+			const float *s_sin, const float *s_cos, int filter_size, float sums[4])
+{
+	__m128 ms = _mm_setzero_ps();
+	__m128 mc = _mm_setzero_ps();
+	__m128 ss = _mm_setzero_ps();
+	__m128 sc = _mm_setzero_ps();
+	int j = 0;
+
+	for ( ; j + 4 <= filter_size; j += 4) {
+	  __m128 d = _mm_loadu_ps (data + j);
+
+	  ms = _mm_add_ps (ms, _mm_mul_ps (d, _mm_loadu_ps(m_sin + j)));
+	  mc = _mm_add_ps (mc, _mm_mul_ps (d, _mm_loadu_ps(m_cos + j)));
+	  ss = _mm_add_ps (ss, _mm_mul_ps (d, _mm_loadu_ps(s_sin + j)));
+	  sc = _mm_add_ps (sc, _mm_mul_ps (d, _mm_loadu_ps(s_cos + j)));
+	}
+
+	sums[0] = hsum_sse2 (ms);
+	sums[1] = hsum_sse2 (mc);
+	sums[2] = hsum_sse2 (ss);
+	sums[3] = hsum_sse2 (sc);
+
+	for ( ; j < filter_size; j++) {
+	  sums[0] += data[j] * m_sin[j];
+	  sums[1] += data[j] * m_cos[j];
+	  sums[2] += data[j] * s_sin[j];
+	  sums[3] += data[j] * s_cos[j];
+	}
+}
+
+
+__attribute__((target("sse2")))
+static inline int hsum_epi32_sse2 (__m128i v)
+{
+	v = _mm_add_epi32 (v, _mm_shuffle_epi32 (v, _MM_SHUFFLE(1,0,3,2)));
+	v = _mm_add_epi32 (v, _mm_shuffle_epi32 (v, _MM_SHUFFLE(2,3,0,1)));
+	return (_mm_cvtsi128_si32 (v));
+}
+
+
+/* pmaddwd multiplies 8 pairs of 16 bit numbers and adds adjacent products. */
+
+__attribute__((target("sse2")))
+static int convolve_q15_sse2 (const short *data, const short *filter, int filter_size)
+{
+	__m128i acc = _mm_setzero_si128();
+	int sum;
+	int j = 0;
+
+	for ( ; j + 8 <= filter_size; j += 8) {
+	  acc = _mm_add_epi32 (acc, _mm_madd_epi16 (_mm_loadu_si128((const __m128i *)(data + j)),
+						    _mm_loadu_si128((const __m128i *)(filter + j))));
+	}
+
+	sum = hsum_epi32_sse2 (acc);
+
+	for ( ; j < filter_size; j++) {
+	  sum += data[j] * filter[j];
+	}
+	return (sum);
+}
+
+
+__attribute__((target("sse2")))
+static void correlate_q15_sse2 (const short *data, const short *m_sin, const short *m_cos,
+			const short *s_sin, const short *s_cos, int filter_size, int sums[4])
+{
+	__m128i ms = _mm_setzero_si128();
+	__m128i mc = _mm_setzero_si128();
+	__m128i ss = _mm_setzero_si128();
+	__m128i sc = _mm_setzero_si128();
+	int j = 0;
+
+	for ( ; j + 8 <= filter_size; j += 8) {
+	  __m128i d = _mm_loadu_si128 ((const __m128i *)(data + j));
+
+	  ms = _mm_add_epi32 (ms, _mm_madd_epi16 (d, _mm_loadu_si128((const __m128i *)(m_sin + j))));
+	  mc = _mm_add_epi32 (mc, _mm_madd_epi16 (d, _mm_loadu_si128((const __m128i *)(m_cos + j))));
+	  ss = _mm_add_epi32 (ss, _mm_madd_epi16 (d, _mm_loadu_si128((const __m128i *)(s_sin + j))));
+	  sc = _mm_add_epi32 (sc, _mm_madd_epi16 (d, _mm_loadu_si128((const __m128i *)(s_cos + j))));
+	}
+
+	sums[0] = hsum_epi32_sse2 (ms);
+	sums[1] = hsum_epi32_sse2 (mc);
+	sums[2] = hsum_epi32_sse2 (ss);
+	sums[3] = hsum_epi32_sse2 (sc);
+
+	for ( ; j < filter_size; j++) {
+	  sums[0] += data[j] * m_sin[j];
+	  sums[1] += data[j] * m_cos[j];
+	  sums[2] += data[j] * s_sin[j];
+	  sums[3] += data[j] * s_cos[j];
+	}
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ *	AVX2 - 8 at a time, with fused multiply add.
+ *
+ *--------------------------------------------------------------------*/
+
+
+__attribute__((target("avx2,fma")))
+static inline float hsum_avx2 (__m256 v)
+{
+	__m128 h = _mm_add_ps (_mm256_castps256_ps128 (v), _mm256_extractf128_ps (v, 1));
+
+	h = _mm_add_ps (h, _mm_movehl_ps (h, h));
+	h = _mm_add_ss (h, _mm_shuffle_ps (h, h, 1));
+	return (_mm_cvtss_f32 (h));
+}
+
+
+__attribute__((target("avx2,fma")))
+static float convolve_avx2 (const float *data, const float *filter, int filter_size)
+{
+	__m256 acc0 = _mm256_setzero_ps();
+	__m256 acc1 = _mm256_setzero_ps();
+	float sum;
+	int j = 0;
+
+	for ( ; j + 16 <= filter_size; j += 16) {
+	  acc0 = _mm256_fmadd_ps (_mm256_loadu_ps(data + j), _mm256_loadu_ps(filter + j), acc0);
+	  acc1 = _mm256_fmadd_ps (_mm256_loadu_ps(data + j + 8), _mm256_loadu_ps(filter + j + 8), acc1);
+	}
+	if (j + 8 <= filter_size) {
+	  acc0 = _mm256_fmadd_ps (_mm256_loadu_ps(data + j), _mm256_loadu_ps(filter + j), acc0);
+	  j += 8;
+	}
+
+	sum = hsum_avx2 (_mm256_add_ps (acc0, acc1));
+
+	for ( ; j < filter_size; j++) {
+	  sum += data[j] * filter[j];
+	}
+	return (sum);
+}
+
+
+__attribute__((target("avx2,fma")))
+static void correlate_avx2 (const float *data, const float *m_sin, const float *m_cos,
+			const float *s_sin, const float *s_cos, int filter_size, float sums[4])
+{
+	__m256 ms = _mm256_setzero_ps();
+	__m256 mc = _mm256_setzero_ps();
+	__m256 ss = _mm256_setzero_ps();
+	__m256 sc = _mm256_setzero_ps();
+	int j = 0;
+
+	for ( ; j + 8 <= filter_size; j += 8) {
+	  __m256 d = _mm256_loadu_ps (data + j);
+
+	  ms = _mm256_fmadd_ps (d, _mm256_loadu_ps(m_sin + j), ms);
+	  mc = _mm256_fmadd_ps (d, _mm256_loadu_ps(m_cos + j), mc);
+	  ss = _mm256_fmadd_ps (d, _mm256_loadu_ps(s_sin + j), ss);
+	  sc = _mm256_fmadd_ps (d, _mm256_loadu_ps(s_cos + j), sc);
+	}
+
+	sums[0] = hsum_avx2 (ms);
+	sums[1] = hsum_avx2 (mc);
+	sums[2] = hsum_avx2 (ss);
+	sums[3] = hsum_avx2 (sc);
+
+	for ( ; j < filter_size; j++) {
+	  sums[0] += data[j] * m_sin[j];
+	  sums[1] += data[j] * m_cos[j];
+	  sums[2] += data[j] * s_sin[j];
+	  sums[3] += data[j] * s_cos[j];
+	}
+}
+
+
+
+__attribute__((target("avx2,fma")))
+static inline int hsum_epi32_avx2 (__m256i v)
+{
+	__m128i h = _mm_add_epi32 (_mm256_castsi256_si128 (v), _mm256_extracti128_si256 (v, 1));
+
+	h = _mm_add_epi32 (h, _mm_shuffle_epi32 (h, _MM_SHUFFLE(1,0,3,2)));
+	h = _mm_add_epi32 (h, _mm_shuffle_epi32 (h, _MM_SHUFFLE(2,3,0,1)));
+	return (_mm_cvtsi128_si32 (h));
+}
+
+
+__attribute__((target("avx2,fma")))
+static int convolve_q15_avx2 (const short *data, const short *filter, int filter_size)
+{
+	__m256i acc = _mm256_setzero_si256();
+	int sum;
+	int j = 0;
+
+	for ( ; j + 16 <= filter_size; j += 16) {
+	  acc = _mm256_add_epi32 (acc, _mm256_madd_epi16 (_mm256_loadu_si256((const __m256i *)(data + j)),
+						    _mm256_loadu_si256((const __m256i *)(filter + j))));
+	}
+
+	sum = hsum_epi32_avx2 (acc);
+
+	for ( ; j < filter_size; j++) {
+	  sum += data[j] * filter[j];
+	}
+	return (sum);
+}
+
+
+__attribute__((target("avx2,fma")))
+static void correlate_q15_avx2 (const short *data, const short *m_sin, const short *m_cos,
+			const short *s_sin, const short *s_cos, int filter_size, int sums[4])
+{
+	__m256i ms = _mm256_setzero_si256();
+	__m256i mc = _mm256_setzero_si256();
+	__m256i ss = _mm256_setzero_si256();
+	__m256i sc = _mm256_setzero_si256();
+	int j = 0;
+
+	for ( ; j + 16 <= filter_size; j += 16) {
+	  __m256i d = _mm256_loadu_si256 ((const __m256i *)(data + j));
+
+	  ms = _mm256_add_epi32 (ms, _mm256_madd_epi16 (d, _mm256_loadu_si256((const __m256i *)(m_sin + j))));
+	  mc = _mm256_add_epi32 (mc, _mm256_madd_epi16 (d, _mm256_loadu_si256((const __m256i *)(m_cos + j))));
+	  ss = _mm256_add_epi32 (ss, _mm256_madd_epi16 (d, _mm256_loadu_si256((const __m256i *)(s_sin + j))));
+	  sc = _mm256_add_epi32 (sc, _mm256_madd_epi16 (d, _mm256_loadu_si256((const __m256i *)(s_cos + j))));
+	}
+
+	sums[0] = hsum_epi32_avx2 (ms);
+	sums[1] = hsum_epi32_avx2 (mc);
+	sums[2] = hsum_epi32_avx2 (ss);
+	sums[3] = hsum_epi32_avx2 (sc);
+
+	for ( ; j < filter_size; j++) {
+	  sums[0] += data[j] * m_sin[j];
+	  sums[1] += data[j] * m_cos[j];
+	  sums[2] += data[j] * s_sin[j];
+	  sums[3] += data[j] * s_cos[j];
+	}
+}
+
+
+#if DSP_KERNEL_AVX512
+
+/*-------------------------------------------------------------------
+ *
+ *	AVX-512 - 16 at a time.
+ *	The partial group at the end is handled with a mask.
+ *
+ *--------------------------------------------------------------------*/
+
+
+__attribute__((target("avx512f")))
+static float convolve_avx512 (const float *data, const float *filter, int filter_size)
+{
+	__m512 acc = _mm512_setzero_ps();
+	int j = 0;
+
+	for ( ; j + 16 <= filter_size; j += 16) {
+	  acc = _mm512_fmadd_ps (_mm512_loadu_ps(data + j), _mm512_loadu_ps(filter + j), acc);
+	}
+	if (j < filter_size) {
+	  __mmask16 m = (__mmask16)((1u << (filter_size - j)) - 1);
+
+	  acc = _mm512_fmadd_ps (_mm512_maskz_loadu_ps(m, data + j), _mm512_maskz_loadu_ps(m, filter + j), acc);
+	}
+	return (_mm512_reduce_add_ps (acc));
+}
+
+
+__attribute__((target("avx512f")))
+static void correlate_avx512 (const float *data, const float *m_sin, const float *m_cos,
+			const float *s_sin, const float *s_cos, int filter_size, float sums[4])
+{
+	__m512 ms = _mm512_setzero_ps();
+	__m512 mc = _mm512_setzero_ps();
+	__m512 ss = _mm512_setzero_ps();
+	__m512 sc = _mm512_setzero_ps();
+	__m512 d;
+	int j = 0;
+
+	for ( ; j + 16 <= filter_size; j += 16) {
+	  d = _mm512_loadu_ps (data + j);
+
+	  ms = _mm512_fmadd_ps (d, _mm512_loadu_ps(m_sin + j), ms);
+	  mc = _mm512_fmadd_ps (d, _mm512_loadu_ps(m_cos + j), mc);
+	  ss = _mm512_fmadd_ps (d, _mm512_loadu_ps(s_sin + j), ss);
+	  sc = _mm512_fmadd_ps (d, _mm512_loadu_ps(s_cos + j), sc);
+	}
+	if (j < filter_size) {
+	  __mmask16 m = (__mmask16)((1u << (filter_size - j)) - 1);
+
+	  d = _mm512_maskz_loadu_ps (m, data + j);
+
+	  ms = _mm512_fmadd_ps (d, _mm512_maskz_loadu_ps(m, m_sin + j), ms);
+	  mc = _mm512_fmadd_ps (d, _mm512_maskz_loadu_ps(m, m_cos + j), mc);
+	  ss = _mm512_fmadd_ps (d, _mm512_maskz_loadu_ps(m, s_sin + j), ss);
+	  sc = _mm512_fmadd_ps (d, _mm512_maskz_loadu_ps(m, s_cos + j), sc);
+	}
+
+	sums[0] = _mm512_reduce_add_ps (ms);
+	sums[1] = _mm512_reduce_add_ps (mc);
+	sums[2] = _mm512_reduce_add_ps (ss);
+	sums[3] = _mm512_reduce_add_ps (sc);
+}
+
+#endif	/* DSP_KERNEL_AVX512 */
+
+#endif	/* DSP_KERNEL_X86 */
+
+
+
+/*
+ * All of the variants, in order of preference from least to most.
+ */
+
+static const struct dsp_kernel_s variant[] = {
+	{ "scalar", convolve_scalar, correlate_scalar, agc_scalar,
+		convolve_q15_scalar, correlate_q15_scalar, agc_q15_scalar },
+#if DSP_KERNEL_X86
+	{ "sse2", convolve_sse2, correlate_sse2, agc_scalar,
+		convolve_q15_sse2, correlate_q15_sse2, agc_q15_scalar },
+	{ "avx2", convolve_avx2, correlate_avx2, agc_scalar,
+		convolve_q15_avx2, correlate_q15_avx2, agc_q15_scalar },
+#if DSP_KERNEL_AVX512
+	{ "avx512", convolve_avx512, correlate_avx512, agc_scalar,
+		convolve_q15_avx2, correlate_q15_avx2, agc_q15_scalar },
+#endif
+#endif
+};
+
+#define NUM_VARIANTS ((int)(sizeof(variant) / sizeof(variant[0])))
+
+
+struct dsp_kernel_s dsp_kernel = { "scalar", convolve_scalar, correlate_scalar, agc_scalar,
+		convolve_q15_scalar, correlate_q15_scalar, agc_q15_scalar };
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        dsp_kernel_available
+ *
+ * Purpose:     Find out whether a variant can be used on this processor.
+ *
+ * Inputs:	name	- "scalar", "sse2", "avx2", or "avx512".
+ *
+ * Returns:	1 if it was compiled in and the processor supports it.
+ *
+ * Description:	The compiler's builtin also checks that the operating system
+ *		saves the larger registers when switching tasks.
+ *
+ *--------------------------------------------------------------------*/
+
+int dsp_kernel_available (const char *name)
+{
+	if (strcmp(name, "scalar") == 0) {
+	  return (1);
+	}
+
+#if DSP_KERNEL_X86
+	__builtin_cpu_init ();
+
+	if (strcmp(name, "sse2") == 0) {
+	  return (__builtin_cpu_supports("sse2") != 0);
+	}
+	if (strcmp(name, "avx2") == 0) {
+	  return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"));
+	}
+#if DSP_KERNEL_AVX512
+	if (strcmp(name, "avx512") == 0) {
+	  return (__builtin_cpu_supports("avx512f") != 0);
+	}
+#endif
+#endif
+	return (0);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        dsp_kernel_init
+ *
+ * Purpose:     Pick the demodulator kernels to use.
+ *
+ * Inputs:	name	- NULL or empty string for the best available.
+ *			  Otherwise one of the variant names, from the
+ *			  command line, to compare performance.
+ *
+ * Description:	This must be called before any demodulator processing.
+ *		If the requested variant is unknown or can't be used on this
+ *		processor, we complain and use the best available instead.
+ *
+ *--------------------------------------------------------------------*/
+
+void dsp_kernel_init (const char *name)
+{
+	int best = 0;
+	int pick = -1;
+	int n;
+
+	for (n = 0; n < NUM_VARIANTS; n++) {
+	  if (dsp_kernel_available(variant[n].name)) {
+	    best = n;
+	  }
+	}
+
+	if (name != NULL && strlen(name) > 0) {
+	  for (n = 0; n < NUM_VARIANTS; n++) {
+	    if (strcasecmp(name, variant[n].name) == 0) {
+	      pick = n;
+	    }
+	  }
+	  if (pick < 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Unknown DSP kernel type \"%s\".  Using %s instead.\n", name, variant[best].name);
+	  }
+	  else if ( ! dsp_kernel_available(variant[pick].name)) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("This processor does not support DSP kernel type \"%s\".  Using %s instead.\n", name, variant[best].name);
+	    pick = -1;
+	  }
+	}
+
+	if (pick < 0) {
+	  pick = best;
+	}
+
+	dsp_kernel = variant[pick];
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("DSP kernels: %s  (available:", dsp_kernel.name);
+	for (n = 0; n < NUM_VARIANTS; n++) {
+	  if (dsp_kernel_available(variant[n].name)) {
+	    dw_printf (" %s", variant[n].name);
+	  }
+	}
+	dw_printf (")\n");
+
+} /* end dsp_kernel_init */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Unit test.  Compare each variant against the portable version
+ * and show how long they take.
+ *
+ *	make dkerneltest
+ *
+ *--------------------------------------------------------------------*/
+
+#if DSP_KERNEL_TEST
+
+#include <math.h>
+#include "dtime_now.h"
+
+#define MAXN 300
+
+static float frand (void)
+{
+	return ((float)rand() / (float)RAND_MAX - 0.5f);
+}
+
+int main (int argc, char *argv[])
+{
+	static float data[MAXN], t[4][MAXN];
+	static short dq[MAXN], tq[4][MAXN];
+	int errors = 0;
+	int v, n, j, k, i;
+
+	srand (1);
+	for (j = 0; j < MAXN; j++) {
+	  data[j] = frand();
+	  for (k = 0; k < 4; k++) {
+	    t[k][j] = frand();
+	    tq[k][j] = (short)(t[k][j] * 1024);
+	  }
+	  dq[j] = (short)(data[j] * 16384);		/* Sums can't overflow. */
+	}
+
+	for (v = 0; v < NUM_VARIANTS; v++) {
+	  const struct dsp_kernel_s *K = &variant[v];
+	  float peak[2] = { 0, 0 }, valley[2] = { 0, 0 };
+	  float worst = 0;
+	  int qpeak[2] = { 0, 0 }, qvalley[2] = { 0, 0 };
+	  double start, conv_ns, corr_ns, agc_ns, qconv_ns, qcorr_ns;
+	  volatile float sink = 0;
+
+	  if ( ! dsp_kernel_available(K->name)) {
+	    text_color_set(DW_COLOR_INFO);
+	    dw_printf ("%-8s not supported by this processor.\n", K->name);
+	    continue;
+	  }
+
+/*
+ * Every size from 1 up, to exercise all of the partial group handling.
+ * Allow for the different order of additions.
+ */
+
+	  for (n = 1; n <= MAXN; n++) {
+	    float expect[4], got[4], mag = 0;
+
+	    for (j = 0; j < n; j++) mag += fabsf(data[j]);
+	    mag = mag * 1e-5f + 1e-6f;
+
+	    expect[0] = convolve_scalar (data, t[0], n);
+	    got[0] = K->convolve (data, t[0], n);
+	    if (fabsf(got[0] - expect[0]) > mag) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("%s convolve size %d: expected %f, got %f\n", K->name, n, expect[0], got[0]);
+	      errors++;
+	    }
+	    if (fabsf(got[0] - expect[0]) > worst) worst = fabsf(got[0] - expect[0]);
+
+	    correlate_scalar (data, t[0], t[1], t[2], t[3], n, expect);
+	    K->correlate (data, t[0], t[1], t[2], t[3], n, got);
+	    for (k = 0; k < 4; k++) {
+	      if (fabsf(got[k] - expect[k]) > mag) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("%s correlate size %d, sum %d: expected %f, got %f\n", K->name, n, k, expect[k], got[k]);
+	        errors++;
+	      }
+	      if (fabsf(got[k] - expect[k]) > worst) worst = fabsf(got[k] - expect[k]);
+	    }
+	  }
+
+/*
+ * Integer versions must match exactly.
+ */
+	  for (n = 1; n <= MAXN; n++) {
+	    int qexpect[4], qgot[4];
+
+	    qexpect[0] = convolve_q15_scalar (dq, tq[0], n);
+	    qgot[0] = K->convolve_q15 (dq, tq[0], n);
+	    if (qgot[0] != qexpect[0]) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("%s convolve_q15 size %d: expected %d, got %d\n", K->name, n, qexpect[0], qgot[0]);
+	      errors++;
+	    }
+
+	    correlate_q15_scalar (dq, tq[0], tq[1], tq[2], tq[3], n, qexpect);
+	    K->correlate_q15 (dq, tq[0], tq[1], tq[2], tq[3], n, qgot);
+	    for (k = 0; k < 4; k++) {
+	      if (qgot[k] != qexpect[k]) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("%s correlate_q15 size %d, sum %d: expected %d, got %d\n", K->name, n, k, qexpect[k], qgot[k]);
+	        errors++;
+	      }
+	    }
+	  }
+
+/*
+ * AGC with an amplitude which ramps up and down.
+ */
+	  for (i = 0; i < 20000; i++) {
+	    float in = (1.0f + 0.8f * sinf(i * 0.001f)) * data[i % MAXN];
+	    float e = agc_scalar (in, 0.7f, 0.001f, &peak[0], &valley[0]);
+	    float g = K->agc (in, 0.7f, 0.001f, &peak[1], &valley[1]);
+
+	    if (fabsf(e - g) > 1e-3f || fabsf(peak[0] - peak[1]) > 1e-5f || fabsf(valley[0] - valley[1]) > 1e-5f) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("%s agc sample %d: expected %f, got %f\n", K->name, i, e, g);
+	      errors++;
+	      break;
+	    }
+	  }
+
+/*
+ * Integer AGC should track the float version closely
+ * and never go outside of -1.0 .. +1.0.
+ */
+	  peak[0] = 0; valley[0] = 0;
+	  for (i = 0; i < 20000; i++) {
+	    float in = (1.0f + 0.8f * sinf(i * 0.001f)) * data[i % MAXN];
+	    float e = agc_scalar (in, 0.7f, 0.001f, &peak[0], &valley[0]);
+	    int g = K->agc_q15 ((int)(in * 16384), Q31(0.7f), Q31(0.001f), &qpeak[1], &qvalley[1]);
+
+	    if (e > 1.0f) e = 1.0f;
+	    if (e < -1.0f) e = -1.0f;
+	    if (g < -32768 || g > 32768 || (i > 100 && fabsf(e - g / 32768.0f) > 0.01f)) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("%s agc_q15 sample %d: expected %f, got %f\n", K->name, i, e, g / 32768.0f);
+	      errors++;
+	      break;
+	    }
+	  }
+
+/*
+ * Timing for typical sizes.
+ */
+	  start = dtime_now();
+	  for (i = 0; i < 1000000; i++) {
+	    sink += K->convolve (data, t[0], 37 + (i & 63));
+	  }
+	  conv_ns = (dtime_now() - start) * 1000.;
+
+	  start = dtime_now();
+	  for (i = 0; i < 1000000; i++) {
+	    float s[4];
+	    K->correlate (data, t[0], t[1], t[2], t[3], 37 + (i & 63), s);
+	    sink += s[0];
+	  }
+	  corr_ns = (dtime_now() - start) * 1000.;
+
+	  start = dtime_now();
+	  for (i = 0; i < 1000000; i++) {
+	    sink += K->agc (data[i % MAXN], 0.7f, 0.001f, &peak[1], &valley[1]);
+	  }
+	  agc_ns = (dtime_now() - start) * 1000.;
+
+	  start = dtime_now();
+	  for (i = 0; i < 1000000; i++) {
+	    sink += K->convolve_q15 (dq, tq[0], 37 + (i & 63));
+	  }
+	  qconv_ns = (dtime_now() - start) * 1000.;
+
+	  start = dtime_now();
+	  for (i = 0; i < 1000000; i++) {
+	    int s[4];
+	    K->correlate_q15 (dq, tq[0], tq[1], tq[2], tq[3], 37 + (i & 63), s);
+	    sink += s[0];
+	  }
+	  qcorr_ns = (dtime_now() - start) * 1000.;
+
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("%-8s  convolve %5.1f ns,  correlate %5.1f ns,  agc %4.1f ns,  max difference %.2g\n",
+			K->name, conv_ns, corr_ns, agc_ns, worst);
+	  dw_printf ("%-8s  convolve_q15 %5.1f ns,  correlate_q15 %5.1f ns\n", "", qconv_ns, qcorr_ns);
+	  (void)sink;
+	}
+
+	dsp_kernel_init (argc > 1 ? argv[1] : NULL);
+
+	if (errors) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\nDSP kernel test FAILED!\n");
+	  exit (EXIT_FAILURE);
+	}
+
+	text_color_set(DW_COLOR_REC);
+	dw_printf ("\nDSP kernel test passed.\n");
+	exit (EXIT_SUCCESS);
+}
+
+#endif
+
+/* end dsp_kernel.c */
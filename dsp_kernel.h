@@ -0,0 +1,90 @@
+
+/* dsp_kernel.h */
+
+#ifndef DSP_KERNEL_H
+#define DSP_KERNEL_H 1
+
+#include <stdint.h>
+
+
+/*
+ * The innermost loops of the demodulators.
+ *
+ * There are several implementations, using different instruction
+ * sets, and the best one for the processor we are running on is
+ * picked at run time.  See dsp_kernel.c for details.
+ */
+
+struct dsp_kernel_s {
+
+	const char *name;
+
+	/* FIR filter.  Sum of data[j] * filter[j]. */
+
+	float (*convolve) (const float *data, const float *filter, int filter_size);
+
+	/* Mark and space correlators.  Four convolutions of the same data in one pass. */
+	/* Results, in order, are mark sin, mark cos, space sin, space cos. */
+
+	void (*correlate) (const float *data, const float *m_sin, const float *m_cos,
+			const float *s_sin, const float *s_cos, int filter_size, float sums[4]);
+
+	/* Automatic gain control.  Result should settle down to range of -0.5 to +0.5. */
+
+	float (*agc) (float in, float fast_attack, float slow_decay, float *ppeak, float *pvalley);
+
+	/* Same for the integer fixed point demodulators.  Samples and taps are 16 bits. */
+	/* Taps are scaled, by gen_q15_filter, so the 32 bit sums can't overflow. */
+
+	int (*convolve_q15) (const short *data, const short *filter, int filter_size);
+
+	void (*correlate_q15) (const short *data, const short *m_sin, const short *m_cos,
+			const short *s_sin, const short *s_cos, int filter_size, int sums[4]);
+
+	/* Peak and valley are in 1/256 units of the input.  Rates are Q31. */
+	/* Result is Q15, limited to range of -1.0 to +1.0. */
+
+	int (*agc_q15) (int in, int fast_attack, int slow_decay, int *ppeak, int *pvalley);
+};
+
+
+/*
+ * Kernels currently in use.
+ * Statically initialized to the portable version so anything
+ * that doesn't call dsp_kernel_init still works as before.
+ */
+
+extern struct dsp_kernel_s dsp_kernel;
+
+
+void dsp_kernel_init (const char *name);
+
+int dsp_kernel_available (const char *name);
+
+
+/*
+ * Helpers for the fixed point demodulators.
+ */
+
+/* Convert from float, rounding to nearest.  Q31 is for 0 to 1 only. */
+
+#define Q15(x) ((x) < 0 ? - (int)(-(x) * 32768.0f + 0.5f) : (int)((x) * 32768.0f + 0.5f))
+#define Q31(x) ((x) >= 1.0 ? 0x7fffffff : (int)((x) * 2147483648.0 + 0.5))
+
+/* Limit to range of 16 bit signed integer. */
+
+static inline int sat16 (int x)
+{
+	return (x > 32767 ? 32767 : x < -32767 ? -32767 : x);
+}
+
+/* Move value toward target by rate, in Q31, as for AGC peak and valley. */
+
+static inline int track_q31 (int value, int target, int rate)
+{
+	return (value + (int)(((int64_t)(target - value) * rate + (1 << 30)) >> 31));
+}
+
+#endif
+
+/* end dsp_kernel.h */
@@ -0,0 +1,475 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2016  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      dsp_stats.c
+ *
+ * Purpose:   	Measure where the CPU time goes in receive processing.
+ *
+ * Description:	The audio read, filters, PLL, HDLC decoder, etc. record
+ *		how long each step took, separately for each channel,
+ *		subchannel, and slicer.  We keep count, minimum, maximum,
+ *		total, and a histogram so we can estimate the 99th percentile.
+ *
+ *		Most of these happen for every audio sample so the cost
+ *		must be small.  On x86 we use the CPU time stamp counter
+ *		which takes only a few nanoseconds to read.  Elsewhere we use
+ *		the monotonic clock.  Nothing is collected unless enabled
+ *		with the DSPSTATS configuration option (or "-T" for atest).
+ *
+ *		Each stage for a channel/subchannel/slicer is updated by only
+ *		one thread so no locking is needed.  The reporting side might
+ *		see a value that is slightly out of date.  That's fine.
+ *
+ *		Results are printed periodically or, if a file name is
+ *		specified, written there in JSON format for other applications.
+ *
+ *---------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "direwolf.h"
+#include "textcolor.h"
+#include "dtime_now.h"
+#include "dsp_stats.h"
+#include "rx_latency.h"
+
+
+int dsp_stats_enabled = 0;
+
+
+/*
+ * Histogram has 4 buckets for each power of 2 so the
+ * percentile estimate is within about 20%.
+ */
+
+#define DS_HIST_BUCKETS 192
+
+struct ds_cell_s {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	unsigned int hist[DS_HIST_BUCKETS];
+};
+
+static struct ds_cell_s *cell[DS_NUM_STAGES][MAX_CHANS][MAX_SUBCHANS][MAX_SLICERS];
+
+
+/*
+ * Name used for display and level of detail for each stage.
+ */
+
+#define LEVEL_CHAN 0
+#define LEVEL_SUBCHAN 1
+#define LEVEL_SLICE 2
+
+static const struct {
+	char *name;
+	int level;
+} stage_info[DS_NUM_STAGES] = {
+	{ "audio_read", LEVEL_CHAN },
+	{ "prefilter", LEVEL_SUBCHAN },
+	{ "correlate", LEVEL_SUBCHAN },
+	{ "pll", LEVEL_SLICE },
+	{ "hdlc", LEVEL_SLICE },
+	{ "fix_bits", LEVEL_SLICE },
+	{ "dlq_wait", LEVEL_SLICE },
+	{ "sink", LEVEL_SLICE } };
+
+
+static double ticks_per_ns = 1.0;	/* Calibrated at start up. */
+
+static ds_ticks_t overhead = 0;		/* Cost of reading the clock twice. */
+					/* Subtracted from each measurement. */
+
+static double start_time;		/* For percentage of CPU time. */
+
+static int report_interval;		/* Seconds between reports. 0 for none. */
+static double next_report;
+
+static char report_file[80];		/* JSON file name or empty to print. */
+
+static dw_mutex_t report_mutex;		/* Any audio device thread can report. */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        dsp_stats_init
+ *
+ * Purpose:     Enable collection of timing statistics.
+ *
+ * Inputs:	pa		- Audio configuration.  Used to find which
+ *				  channels, subchannels, and slicers exist.
+ *
+ *		interval	- Seconds between reports.  0 means the
+ *				  application will call dsp_stats_print itself.
+ *
+ *		json_file	- If not NULL or empty, write the JSON form here
+ *				  for each report instead of printing.
+ *
+ * Description:	This must be called before the receive threads start.
+ *
+ *--------------------------------------------------------------------*/
+
+void dsp_stats_init (struct audio_s *pa, int interval, char *json_file)
+{
+	int chan, subchan, slice, stage;
+	double t0, t1;
+	ds_ticks_t c0, c1;
+	int n;
+
+	for (chan = 0; chan < MAX_CHANS; chan++) {
+	  int nsub, nslice;
+
+	  if ( ! pa->achan[chan].valid) continue;
+
+	  nsub = pa->achan[chan].num_subchan;
+	  nslice = pa->achan[chan].num_slicers;
+	  if (nsub < 1) nsub = 1;
+	  if (nsub > MAX_SUBCHANS) nsub = MAX_SUBCHANS;
+	  if (nslice < 1) nslice = 1;
+	  if (nslice > MAX_SLICERS) nslice = MAX_SLICERS;
+
+	  for (stage = 0; stage < DS_NUM_STAGES; stage++) {
+	    for (subchan = 0; subchan < (stage_info[stage].level >= LEVEL_SUBCHAN ? nsub : 1); subchan++) {
+	      for (slice = 0; slice < (stage_info[stage].level >= LEVEL_SLICE ? nslice : 1); slice++) {
+	        if (cell[stage][chan][subchan][slice] == NULL) {
+	          cell[stage][chan][subchan][slice] = calloc (1, sizeof (struct ds_cell_s));
+	          assert (cell[stage][chan][subchan][slice] != NULL);
+	          cell[stage][chan][subchan][slice]->min = UINT64_MAX;
+	        }
+	      }
+	    }
+	  }
+	}
+
+/* How fast does the clock tick? */
+
+	t0 = dtime_now();
+	c0 = dsp_stats_ticks();
+	do {
+	  t1 = dtime_now();
+	} while (t1 - t0 < 0.02);
+	c1 = dsp_stats_ticks();
+
+	ticks_per_ns = (double)(c1 - c0) / ((t1 - t0) * 1e9);
+	if (ticks_per_ns <= 0) ticks_per_ns = 1.0;
+
+/* Minimum time for back to back readings is measurement overhead. */
+
+	overhead = UINT64_MAX;
+	for (n = 0; n < 1000; n++) {
+	  c0 = dsp_stats_ticks();
+	  c1 = dsp_stats_ticks();
+	  if (c1 - c0 < overhead) overhead = c1 - c0;
+	}
+
+	report_interval = interval;
+	if (json_file != NULL) {
+	  strlcpy (report_file, json_file, sizeof(report_file));
+	}
+	else {
+	  strlcpy (report_file, "", sizeof(report_file));
+	}
+
+	dw_mutex_init (&report_mutex);
+
+	start_time = dtime_now();
+	next_report = start_time + report_interval;
+
+	dsp_stats_enabled = 1;
+
+} /* end dsp_stats_init */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        dsp_stats_record
+ *
+ * Purpose:     Add one measurement.
+ *
+ * Inputs:	stage			- from enum ds_stage_e.
+ *		chan, subchan, slice	- Use 0 for subchan or slice when
+ *					  the stage is not that detailed.
+ *		elapsed			- Ticks taken.
+ *
+ *--------------------------------------------------------------------*/
+
+__attribute__((hot))
+void dsp_stats_record (int stage, int chan, int subchan, int slice, ds_ticks_t elapsed)
+{
+	struct ds_cell_s *p;
+	int b;
+
+	if (chan < 0 || chan >= MAX_CHANS || subchan < 0 || subchan >= MAX_SUBCHANS || slice < 0 || slice >= MAX_SLICERS) {
+	  return;
+	}
+
+	p = cell[stage][chan][subchan][slice];
+	if (p == NULL) {
+	  return;
+	}
+
+	elapsed = elapsed > overhead ? elapsed - overhead : 0;
+
+	p->count++;
+	p->sum += elapsed;
+	if (elapsed < p->min) p->min = elapsed;
+	if (elapsed > p->max) p->max = elapsed;
+
+	if (elapsed < 4) {
+	  b = (int)elapsed;
+	}
+	else {
+	  int msb = 63 - __builtin_clzll(elapsed);
+	  b = msb * 4 + (int)((elapsed >> (msb - 2)) & 3);
+	  if (b >= DS_HIST_BUCKETS) b = DS_HIST_BUCKETS - 1;
+	}
+	p->hist[b]++;
+
+} /* end dsp_stats_record */
+
+
+/*
+ * Smallest value that goes into the next histogram bucket.
+ */
+
+static uint64_t bucket_limit (int b)
+{
+	b++;
+	if (b < 4) return (b);
+	if (b < 8) return (4);		/* 4 - 7 not used. */
+	return ((uint64_t)(4 + (b & 3)) << (b / 4 - 2));
+}
+
+
+/*
+ * Summary for one cell, in nanoseconds.
+ */
+
+struct ds_summary_s {
+	uint64_t count;
+	double min, avg, p99, max;
+	double total;
+};
+
+static void summarize (struct ds_cell_s *p, struct ds_summary_s *s)
+{
+	uint64_t target, n;
+	uint64_t p99;
+	int b;
+
+	memset (s, 0, sizeof(*s));
+	s->count = p->count;
+	if (s->count == 0) return;
+
+	s->min = p->min / ticks_per_ns;
+	s->max = p->max / ticks_per_ns;
+	s->total = p->sum / ticks_per_ns;
+	s->avg = s->total / s->count;
+
+	target = s->count - s->count / 100;
+	n = 0;
+	p99 = p->max;
+	for (b = 0; b < DS_HIST_BUCKETS; b++) {
+	  n += p->hist[b];
+	  if (n >= target) {
+	    p99 = bucket_limit(b);
+	    break;
+	  }
+	}
+	if (p99 > p->max) p99 = p->max;
+	s->p99 = p99 / ticks_per_ns;
+}
+
+
+static void cell_name (int stage, int chan, int subchan, int slice, char *name, size_t size)
+{
+	switch (stage_info[stage].level) {
+	  case LEVEL_CHAN:	snprintf (name, size, "%d", chan); break;
+	  case LEVEL_SUBCHAN:	snprintf (name, size, "%d.%d", chan, subchan); break;
+	  default:		snprintf (name, size, "%d.%d.%d", chan, subchan, slice); break;
+	}
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        dsp_stats_print
+ *
+ * Purpose:     Print statistics in human readable form.
+ *
+ * Description:	Times are in nanoseconds.  CPU % is total time in the
+ *		stage compared to elapsed time since start up.
+ *		The dlq_wait stage is waiting, not CPU time.
+ *
+ *--------------------------------------------------------------------*/
+
+void dsp_stats_print (void)
+{
+	int chan, subchan, slice, stage;
+	double elapsed = (dtime_now() - start_time) * 1e9;
+
+	if ( ! dsp_stats_enabled) return;
+
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("\nReceive processing time, nanoseconds:\n");
+	dw_printf ("stage       where        count       min       avg       p99       max   CPU %%\n");
+
+	for (stage = 0; stage < DS_NUM_STAGES; stage++) {
+	  for (chan = 0; chan < MAX_CHANS; chan++) {
+	    for (subchan = 0; subchan < MAX_SUBCHANS; subchan++) {
+	      for (slice = 0; slice < MAX_SLICERS; slice++) {
+	        struct ds_cell_s *p = cell[stage][chan][subchan][slice];
+	        struct ds_summary_s s;
+	        char name[20];
+
+	        if (p == NULL || p->count == 0) continue;
+
+	        summarize (p, &s);
+	        cell_name (stage, chan, subchan, slice, name, sizeof(name));
+
+	        dw_printf ("%-11s %-7s %10llu %9.0f %9.0f %9.0f %9.0f  %6.2f\n",
+			stage_info[stage].name, name, (unsigned long long)s.count,
+			s.min, s.avg, s.p99, s.max,
+			elapsed > 0 ? 100. * s.total / elapsed : 0.);
+	      }
+	    }
+	  }
+	}
+	dw_printf ("\n");
+
+} /* end dsp_stats_print */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        dsp_stats_write_json
+ *
+ * Purpose:     Write statistics in JSON form for other applications.
+ *
+ * Description:	Receive latency, from rx_latency.c, is included.
+ *
+ *--------------------------------------------------------------------*/
+
+void dsp_stats_write_json (FILE *fp)
+{
+	int chan, subchan, slice, stage;
+	int first = 1;
+	double now = dtime_now();
+
+	fprintf (fp, "{\n  \"time\": %.3f,\n  \"uptime\": %.3f,\n  \"ticks_per_ns\": %.4f,\n  \"stages\": [",
+			now, now - start_time, ticks_per_ns);
+
+	for (stage = 0; stage < DS_NUM_STAGES; stage++) {
+	  for (chan = 0; chan < MAX_CHANS; chan++) {
+	    for (subchan = 0; subchan < MAX_SUBCHANS; subchan++) {
+	      for (slice = 0; slice < MAX_SLICERS; slice++) {
+	        struct ds_cell_s *p = cell[stage][chan][subchan][slice];
+	        struct ds_summary_s s;
+
+	        if (p == NULL) continue;
+
+	        summarize (p, &s);
+
+	        fprintf (fp, "%s\n    { \"stage\": \"%s\", \"chan\": %d, \"subchan\": %d, \"slice\": %d, "
+				"\"count\": %llu, \"min_ns\": %.0f, \"avg_ns\": %.1f, \"p99_ns\": %.0f, \"max_ns\": %.0f, \"total_ns\": %.0f }",
+			first ? "" : ",",
+			stage_info[stage].name, chan,
+			stage_info[stage].level >= LEVEL_SUBCHAN ? subchan : -1,
+			stage_info[stage].level >= LEVEL_SLICE ? slice : -1,
+			(unsigned long long)s.count, s.min, s.avg, s.p99, s.max, s.total);
+	        first = 0;
+	      }
+	    }
+	  }
+	}
+	fprintf (fp, "\n  ],\n");
+
+	rx_latency_write_json (fp);
+
+	fprintf (fp, "\n}\n");
+
+} /* end dsp_stats_write_json */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        dsp_stats_poll
+ *
+ * Purpose:     Report if it is time.
+ *
+ * Description:	Called each time a buffer is read from an audio device.
+ *		The file is written under a temporary name then renamed
+ *		so a reader never sees a partial file.
+ *
+ *--------------------------------------------------------------------*/
+
+void dsp_stats_poll (void)
+{
+	double now;
+
+	if ( ! dsp_stats_enabled || report_interval <= 0) return;
+
+	now = dtime_now();
+	if (now < next_report) return;
+
+	dw_mutex_lock (&report_mutex);
+	if (now < next_report) {
+	  dw_mutex_unlock (&report_mutex);
+	  return;		/* Another thread got here first. */
+	}
+	next_report = now + report_interval;
+
+	if (strlen(report_file) > 0) {
+	  char temp[100];
+	  FILE *fp;
+
+	  snprintf (temp, sizeof(temp), "%s.tmp", report_file);
+	  fp = fopen (temp, "w");
+	  if (fp == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Can't open %s to write DSP statistics.\n", temp);
+	    dw_mutex_unlock (&report_mutex);
+	    return;
+	  }
+	  dsp_stats_write_json (fp);
+	  fclose (fp);
+#if __WIN32__
+	  remove (report_file);
+#endif
+	  rename (temp, report_file);
+	}
+	else {
+	  dsp_stats_print ();
+	}
+
+	dw_mutex_unlock (&report_mutex);
+
+} /* end dsp_stats_poll */
+
+/* end dsp_stats.c */
@@ -0,0 +1,93 @@
+
+/* dsp_stats.h */
+
+#ifndef DSP_STATS_H
+#define DSP_STATS_H 1
+
+#include <stdio.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>		/* for __rdtsc */
+#elif __WIN32__
+#include <windows.h>		/* for QueryPerformanceCounter */
+#else
+#include <time.h>
+#endif
+
+#include "audio.h"		/* for struct audio_s */
+
+
+/*
+ * Stages of receive processing that we measure.
+ * Keep in sync with stage names in dsp_stats.c.
+ */
+
+enum ds_stage_e {
+	DS_AUDIO_READ = 0,	/* Get sample from audio device.  Per channel. */
+	DS_PREFILTER,		/* Bandpass before mark/space or lowpass for 9600.  Per subchannel. */
+	DS_CORRELATE,		/* Mark/space filters, amplitude lowpass, AGC.  Per subchannel. */
+	DS_PLL,			/* Slicer and bit clock PLL, not including HDLC.  Per slicer. */
+	DS_HDLC,		/* HDLC bit processing, frame checking, and any fix_bits.  Per slicer. */
+	DS_FIX_BITS,		/* Attempts to fix a frame with bad CRC.  Per slicer. */
+	DS_DLQ_WAIT,		/* Time in received frame queue.  Per slicer. */
+	DS_SINK,		/* Processing of received frame: display, clients, digipeater, etc. */
+	DS_NUM_STAGES
+};
+
+
+/*
+ * Elapsed time is kept in "ticks," which are CPU clock cycles on x86,
+ * performance counter units on other Windows, and otherwise nanoseconds
+ * from the monotonic clock.  dsp_stats_init calibrates them.
+ */
+
+typedef uint64_t ds_ticks_t;
+
+extern int dsp_stats_enabled;		/* Test this before collecting anything */
+					/* so there is no cost when not in use. */
+
+static inline ds_ticks_t dsp_stats_ticks (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return (__rdtsc());
+#elif __WIN32__
+	LARGE_INTEGER count;
+
+	QueryPerformanceCounter (&count);
+	return ((ds_ticks_t)count.QuadPart);
+#else
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ((ds_ticks_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#endif
+}
+
+
+void dsp_stats_init (struct audio_s *pa, int interval, char *json_file);
+
+void dsp_stats_record (int stage, int chan, int subchan, int slice, ds_ticks_t elapsed);
+
+
+/*
+ * Record time since *pt for a stage and set *pt to now for the next stage.
+ */
+
+static inline void dsp_stats_lap (int stage, int chan, int subchan, int slice, ds_ticks_t *pt)
+{
+	ds_ticks_t now = dsp_stats_ticks();
+
+	dsp_stats_record (stage, chan, subchan, slice, now - *pt);
+	*pt = now;
+}
+
+void dsp_stats_poll (void);
+
+void dsp_stats_print (void);
+
+void dsp_stats_write_json (FILE *fp);
+
+#endif
+
+/* end dsp_stats.h */
@@ -174,6 +174,49 @@ struct demodulator_state_s
 	float m_valley, s_valley;
 	float m_amp_prev, s_amp_prev;
 
+/*
+ * Integer fixed point version of the above, for processors without
+ * a fast floating point unit.  Selected with DEMODTUNE fixed=1.
+ *
+ * Audio samples and filter outputs are 16 bits.  Filter taps are
+ * scaled up by 2 to the power of the corresponding shift.
+ * Peaks and valleys are in 1/256 units of the filter output.
+ * AGC rates are Q31.  Normalized values and inertia are Q15.
+ */
+	int use_fixed;
+
+	int pre_shift;
+	int ms_shift;
+	int lp_shift;
+
+	short pre_filter_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+	short m_sin_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+	short m_cos_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+	short s_sin_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+	short s_cos_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+	short lp_filter_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+
+	short raw_cb_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+	short ms_in_cb_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+	short m_amp_cb_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+	short s_amp_cb_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+
+	int lpf_iir_q15;
+	int agc_fast_q31, agc_slow_q31;
+	int quick_attack_q31, sluggish_decay_q31;
+	int hysteresis_q15;
+	int pll_locked_q15, pll_searching_q15;
+
+	int m_peak_q, s_peak_q;
+	int m_valley_q, s_valley_q;
+	int m_amp_prev_q, s_amp_prev_q;
+
+	int alevel_rec_peak_q, alevel_rec_valley_q;
+	int alevel_mark_peak_q, alevel_space_peak_q;
+
+	float fixed_level_scale;	/* Convert filter output levels, in 1/256 units, */
+					/* to same scale as the floating point version. */
+
 /*
  * For the PLL and data bit timing.
  * starting in version 1.2 we can have multiple slicers for one demodulator.
@@ -201,24 +244,29 @@ struct demodulator_state_s
  * This means adding a third variable many places
  * we are passing around the origin.
  *
+ */
+/*
+ * Each field is an array indexed by slicer, rather than an array of
+ * structures, so the compiler can advance all slicers of a
+ * demodulator together with SIMD instructions.
  */
 	struct {
 
-		signed int data_clock_pll;		// PLL for data clock recovery.
+		signed int data_clock_pll[MAX_SLICERS];	// PLL for data clock recovery.
 							// It is incremented by pll_step_per_sample
 							// for each audio sample.
 
-		signed int prev_d_c_pll;		// Previous value of above, before
+		signed int prev_d_c_pll[MAX_SLICERS];	// Previous value of above, before
 							// incrementing, to detect overflows.
 
-		int prev_demod_data;			// Previous data bit detected.
+		int prev_demod_data[MAX_SLICERS];	// Previous data bit detected.
 							// Used to look for transitions.
 
 		/* This is used only for "9600" baud data. */
 
-		int lfsr;				// Descrambler shift register.
+		int lfsr[MAX_SLICERS];			// Descrambler shift register.
 
-	} slicer [MAX_SLICERS];				// Actual number in use is num_slicers.
+	} slicer;					// Actual number in use is num_slicers.
 							// Should be in range 1 .. MAX_SLICERS,
 
 /* 
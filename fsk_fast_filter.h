@@ -0,0 +1,84 @@
+/* This is an automatically generated file.  Do not edit. */
+
+#define FFF_SAMPLES_PER_SEC 44100
+#define FFF_BAUD 1200
+#define FFF_MARK_FREQ 1200
+#define FFF_SPACE_FREQ 2200
+#define FFF_PROFILE 'F'
+
+#define CALC_M_SUM1(x) \
+	+ (0.035343f * x[1]) \
+	+ (0.020782f * x[4]) \
+	+ (0.000872f * x[7]) \
+	+ (-0.019262f * x[10]) \
+	+ (-0.034439f * x[13]) \
+	+ (-0.040752f * x[16]) \
+	+ (-0.036578f * x[19]) \
+	+ (-0.022989f * x[22]) \
+	+ (-0.003484f * x[25]) \
+	+ (0.016917f * x[28]) \
+	+ (0.032965f * x[31]) \
+	+ (0.040529f * x[34]) \
+	+ (0.037662f * x[37]) \
+	+ (0.025103f * x[40]) \
+	+ (0.006082f * x[43]) \
+	+ (-0.014503f * x[46]) \
+	+ (-0.031356f * x[49]) \
+
+#define CALC_M_SUM2(x) \
+	+ (-0.018184f * x[1]) \
+	+ (-0.031300f * x[4]) \
+	+ (-0.036360f * x[7]) \
+	+ (-0.032062f * x[10]) \
+	+ (-0.019513f * x[13]) \
+	+ (-0.001942f * x[16]) \
+	+ (0.016129f * x[19]) \
+	+ (0.030049f * x[22]) \
+	+ (0.036235f * x[25]) \
+	+ (0.033096f * x[28]) \
+	+ (0.021440f * x[31]) \
+	+ (0.004265f * x[34]) \
+	+ (-0.014007f * x[37]) \
+	+ (-0.028675f * x[40]) \
+	+ (-0.035962f * x[43]) \
+	+ (-0.033994f * x[46]) \
+	+ (-0.023278f * x[49]) \
+
+#define CALC_S_SUM1(x) \
+	+ (-0.036605f * x[1]) \
+	+ (-0.016365f * x[4]) \
+	+ (0.017309f * x[7]) \
+	+ (0.036774f * x[10]) \
+	+ (0.026048f * x[13]) \
+	+ (-0.006063f * x[16]) \
+	+ (-0.033196f * x[19]) \
+	+ (-0.033076f * x[22]) \
+	+ (-0.005801f * x[25]) \
+	+ (0.026236f * x[28]) \
+	+ (0.036734f * x[31]) \
+	+ (0.017075f * x[34]) \
+	+ (-0.016603f * x[37]) \
+	+ (-0.036650f * x[40]) \
+	+ (-0.026608f * x[43]) \
+	+ (0.005278f * x[46]) \
+	+ (0.032831f * x[49]) \
+
+#define CALC_S_SUM2(x) \
+	+ (0.006919f * x[1]) \
+	+ (0.035777f * x[4]) \
+	+ (0.035262f * x[7]) \
+	+ (0.005798f * x[10]) \
+	+ (-0.028426f * x[13]) \
+	+ (-0.039313f * x[16]) \
+	+ (-0.017925f * x[19]) \
+	+ (0.018179f * x[22]) \
+	+ (0.039358f * x[25]) \
+	+ (0.028226f * x[28]) \
+	+ (-0.006079f * x[31]) \
+	+ (-0.035394f * x[34]) \
+	+ (-0.035651f * x[37]) \
+	+ (-0.006640f * x[40]) \
+	+ (0.027823f * x[43]) \
+	+ (0.039443f * x[46]) \
+	+ (0.018682f * x[49]) \
+
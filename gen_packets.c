@@ -56,6 +56,11 @@
  *			gen_packets -n 100 -o z2.wav
  *			atest z2.wav
  *
+ *		Large test files, quickly, with other impairments:
+ *
+ *			gen_packets -f -n 10000 -O 50 -T -6 -X 5 -o z4.wav
+ *			gen_packets -f -B 9600 -r 48000 -n 10000 -o - | atest -B 9600 -
+ *
  *		
  *------------------------------------------------------------------*/
 
@@ -67,6 +72,16 @@
 #include <getopt.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
+#include <unistd.h>
+#include <time.h>
+
+#if __WIN32__
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <pthread.h>
+#endif
 
 #include "audio.h"
 #include "ax25_pad.h"
@@ -74,16 +89,42 @@
 #include "gen_tone.h"
 #include "textcolor.h"
 #include "morse.h"
+#include "fcs_calc.h"
+#include "fsk_demod_state.h"	/* for MAX_FILTER_SIZE */
+#include "dsp.h"
+#include "dtime_now.h"
 
 
 static void usage (char **argv);
 static int audio_file_open (char *fname, struct audio_s *pa);
+static int audio_file_write (unsigned char *buf, int len);
 static int audio_file_close (void);
 
 static int g_add_noise = 0;
 static float g_noise_level = 0;
 static int g_morse_wpm = 0;		/* Send morse code at this speed. */
 
+static int g_stdout_fd = -1;		/* Original stdout when writing audio there. */
+					/* Messages go to stderr instead. */
+static int g_raw = 0;			/* -R raw samples without WAV header. */
+
+#define MY_RAND_MAX 0x7fffffff
+
+static unsigned int seed = 1;		/* -S for random number generator. */
+
+/* For fast synthesis, "-f" option. */
+
+static int g_jobs = 0;			/* -j number of threads.  0 for number of processors. */
+static float g_offset = 0;		/* -O frequency offset, Hz. */
+static float g_twist = 0;		/* -T space level relative to mark, dB. */
+static float g_clip = 0;		/* -C clip at this percent of peak.  0 for none. */
+static int g_echo_usec = 0;		/* -P multipath echo delay */
+static float g_echo_db = 0;		/*    and relative level. */
+static float g_collide = 0;		/* -X percent of frames with another overlapping. */
+
+static float noise_for_packet (int i, int packet_count, int amplitude);
+static int synth_packets (char **text, int num, int packet_count, int amplitude);
+
 
 static struct audio_s modem;
 
@@ -155,6 +196,7 @@ int main(int argc, char **argv)
 	int leading_zeros = 12;		/* -z option TODO: not implemented, should replace with txdelay frames. */
 	char output_file[256];		/* -o option */
 	FILE *input_fp = NULL;		/* File or NULL for built-in message */
+	int fast = 0;			/* -f option */
 
 	strlcpy (output_file, "", sizeof(output_file));
 
@@ -174,7 +216,7 @@ int main(int argc, char **argv)
 
 	  /* ':' following option character means arg is required. */
 
-          c = getopt_long(argc, argv, "gm:s:a:b:B:r:n:o:z:82M:",
+          c = getopt_long(argc, argv, "gm:s:a:b:B:r:n:o:z:82M:fj:S:O:T:C:P:X:R",
                         long_options, &option_index);
           if (c == -1)
             break;
@@ -334,6 +376,19 @@ int main(int argc, char **argv)
             case 'o':				/* -o for Output file */
 
               strlcpy (output_file, optarg, sizeof(output_file));
+
+	      if (strcmp(output_file, "-") == 0 && g_stdout_fd < 0) {
+
+	        /* Audio goes to stdout so send messages, including */
+	        /* those still in the buffer, to stderr instead. */
+
+	        g_stdout_fd = dup (fileno(stdout));
+	        dup2 (fileno(stderr), fileno(stdout));
+	        fflush (stdout);
+#if __WIN32__
+	        _setmode (g_stdout_fd, _O_BINARY);
+#endif
+	      }
               text_color_set(DW_COLOR_INFO); 
               dw_printf ("Output file set to %s\n", output_file);
               break;
@@ -352,6 +407,65 @@ int main(int argc, char **argv)
               }
               break;
 
+            case 'f':				/* -f fast synthesis with impairments. */
+
+	      fast = 1;
+              break;
+
+            case 'j':				/* -j number of threads for -f. */
+
+	      g_jobs = atoi(optarg);
+              break;
+
+            case 'S':				/* -S seed for random numbers. */
+
+	      seed = strtoul(optarg, NULL, 0) & MY_RAND_MAX;
+              break;
+
+            case 'O':				/* -O frequency offset, Hz. */
+
+	      g_offset = atof(optarg);
+              break;
+
+            case 'T':				/* -T twist, dB.  Positive for stronger space tone. */
+
+	      g_twist = atof(optarg);
+              break;
+
+            case 'C':				/* -C clip at this percent of peak amplitude. */
+
+	      g_clip = atof(optarg);
+              if (g_clip < 1 || g_clip > 100) {
+                text_color_set(DW_COLOR_ERROR); 
+	        dw_printf ("Clipping level must be in range of 1 to 100%%.\n");
+                exit (EXIT_FAILURE);
+              }
+              break;
+
+            case 'P':				/* -P multipath echo:  microseconds,dB */
+
+	      if (sscanf (optarg, "%d,%f", &g_echo_usec, &g_echo_db) != 2 || g_echo_usec <= 0 || g_echo_usec > 100000) {
+                text_color_set(DW_COLOR_ERROR); 
+	        dw_printf ("Multipath must be delay in microseconds and relative level in dB, e.g. 250,-6\n");
+                exit (EXIT_FAILURE);
+              }
+              break;
+
+            case 'X':				/* -X percent of frames with another colliding. */
+
+	      g_collide = atof(optarg);
+              if (g_collide < 0 || g_collide > 100) {
+                text_color_set(DW_COLOR_ERROR); 
+	        dw_printf ("Collision percentage must be in range of 0 to 100.\n");
+                exit (EXIT_FAILURE);
+              }
+              break;
+
+            case 'R':				/* -R raw samples, no WAV header. */
+
+	      g_raw = 1;
+              break;
+
             case '?':
 
               /* Unknown option message was already printed. */
@@ -399,6 +513,57 @@ int main(int argc, char **argv)
         assert (modem.adev[0].num_channels == 1 || modem.adev[0].num_channels == 2);
         assert (modem.adev[0].samples_per_sec >= MIN_SAMPLES_PER_SEC && modem.adev[0].samples_per_sec <= MAX_SAMPLES_PER_SEC);
 
+/*
+ * Fast synthesis.  Get all of the messages first.
+ */
+	if (fast) {
+	  char **text = NULL;
+	  int num = 0;
+	  char str[400];
+
+	  if (g_morse_wpm > 0 || modem.adev[0].bits_per_sample != 16) {
+	    text_color_set(DW_COLOR_ERROR); 
+	    dw_printf ("The -f option is not available with Morse code or 8 bit samples.\n");
+	    exit (EXIT_FAILURE);
+	  }
+
+	  if (optind < argc) {
+	    input_fp = strcmp(argv[optind], "-") == 0 ? stdin : fopen(argv[optind], "r");
+	    if (input_fp == NULL) {
+	      text_color_set(DW_COLOR_ERROR); 
+ 	      dw_printf ("Can't open %s for read.\n", argv[optind]);
+	      exit (EXIT_FAILURE);
+	    }
+	    while (fgets (str, sizeof(str), input_fp) != NULL) {
+	      text = realloc (text, (num + 1) * sizeof(char *));
+	      text[num++] = strdup (str);
+	    }
+	    if (input_fp != stdin) {
+	      fclose (input_fp);
+	    }
+	    packet_count = 0;
+	  }
+	  else {
+	    int n = packet_count > 0 ? packet_count : 4;
+
+	    text = malloc (n * sizeof(char *));
+	    for (num = 0; num < n; num++) {
+	      snprintf (str, sizeof(str), "WB2OSZ-15>TEST:,The quick brown fox jumps over the lazy dog!  %0*d of %0*d",
+			packet_count > 0 ? 4 : 1, num + 1, packet_count > 0 ? 4 : 1, n);
+	      text[num] = strdup (str);
+	    }
+	  }
+
+	  err = synth_packets (text, num, packet_count, amplitude);
+
+	  for (i = 0; i < num; i++) {
+	    free (text[i]);
+	  }
+	  free (text);
+	  audio_file_close();
+	  return (err < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+	}
+
 /*
  * Get user packets(s) from file or stdin if specified.
  * "-n" option is ignored in this case.
@@ -466,17 +631,7 @@ int main(int argc, char **argv)
 
 	    char stemp[80];
 	
-	    if (modem.achan[0].modem_type == MODEM_SCRAMBLE) {
-	      g_noise_level = 0.33 * (amplitude / 200.0) * ((float)i / packet_count);
-	    }
-	    else if (modem.achan[0].baud < 600) {
-		/* About 2/3 should be decoded properly. */
-	      g_noise_level = amplitude *.0048 * ((float)i / packet_count);
-	    }
-	    else {
-		/* About 2/3 should be decoded properly. */
-	      g_noise_level = amplitude *.0023 * ((float)i / packet_count);
-	    }
+	    g_noise_level = noise_for_packet (i, packet_count, amplitude);
 
 	    snprintf (stemp, sizeof(stemp), "WB2OSZ-15>TEST:,The quick brown fox jumps over the lazy dog!  %04d of %04d", i, packet_count);
 
@@ -502,6 +657,486 @@ int main(int argc, char **argv)
 }
 
 
+/*------------------------------------------------------------------
+ *
+ * Name:        noise_for_packet
+ *
+ * Purpose:     Noise level for packet i of the "-n" sweep.
+ *
+ *----------------------------------------------------------------*/
+
+static float noise_for_packet (int i, int packet_count, int amplitude)
+{
+	if (modem.achan[0].modem_type == MODEM_SCRAMBLE) {
+	  return (0.33 * (amplitude / 200.0) * ((float)i / packet_count));
+	}
+	else if (modem.achan[0].baud < 600) {
+		/* About 2/3 should be decoded properly. */
+	  return (amplitude *.0048 * ((float)i / packet_count));
+	}
+	else {
+		/* About 2/3 should be decoded properly. */
+	  return (amplitude *.0023 * ((float)i / packet_count));
+	}
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Fast synthesis, "-f" option.
+ *
+ * The normal method sends one bit at a time through hdlc_send and
+ * gen_tone, the same as for transmitting, which keeps state in static
+ * variables.  Here, each frame is rendered independently into its own
+ * buffer so several can be done at once by different threads.
+ *
+ * Each frame has its own random number sequence, derived from the seed
+ * and frame number, so the result is the same regardless of the number
+ * of threads.
+ *
+ * Each frame is followed by a short gap, with noise only, as though
+ * each was a separate transmission.  For stereo, the same signal is
+ * on both channels with different noise.
+ *
+ * Impairments, applied in this order:
+ *
+ *	-X	Another frame overlaps, at random time and level.
+ *	-O	Frequency offset.  AFSK only.
+ *	-T	Twist.  Space tone level relative to mark.  AFSK only.
+ *	-P	Multipath.  Echo with given delay and relative level.
+ *	-C	Clipping, as by an overdriven audio stage.
+ *	-n	Noise, increasing from none to the same maximum
+ *		as the normal method.
+ *
+ *----------------------------------------------------------------*/
+
+#define SYNTH_GAP_SEC 0.05		/* Between frames. */
+
+struct synth_s {
+	unsigned char fbuf[AX25_MAX_PACKET_LEN+2];
+	int flen;
+	float noise;			/* Noise level for this frame. */
+	short *out;			/* Rendered audio, channels interleaved. */
+	int nout;			/* Number of samples for each channel. */
+};
+
+static struct synth_s *synth;
+static int synth_num;
+static int synth_first, synth_end;	/* Frames for current batch. */
+
+static float synth_amp;			/* Peak of signal. */
+static float synth_sine[1024];		/* Like gen_tone but finer steps. */
+static float synth_lp[MAX_FILTER_SIZE];	/* Lowpass filter for baseband, */
+static int synth_lp_size;		/* same as gen_tone. */
+
+
+/* Same as my_rand but each frame has its own sequence. */
+
+static inline int synth_rand (unsigned int *s)
+{
+	*s = ((*s * 1103515245u) + 12345) & MY_RAND_MAX;
+	return (*s);
+}
+
+
+
+/*
+ * Convert frame to bits, same as hdlc_send:  flags, bit stuffing, FCS, NRZI.
+ * Result is the signal level for each bit time.
+ */
+
+struct synth_bits_s {
+	unsigned char *bits;
+	int n;
+	int max;
+	int level;			/* NRZI output. */
+	int stuff;			/* Consecutive 1 data bits. */
+};
+
+static void synth_put_bit (struct synth_bits_s *b, int x)
+{
+	if (x == 0) {
+	  b->level = ! b->level;
+	}
+	if (b->n < b->max) {
+	  b->bits[b->n++] = b->level;
+	}
+}
+
+static void synth_put_byte (struct synth_bits_s *b, int x, int flag)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+	  synth_put_bit (b, x & 1);
+	  if ( ! flag) {
+	    if (x & 1) {
+	      b->stuff++;
+	      if (b->stuff == 5) {
+	        synth_put_bit (b, 0);
+	        b->stuff = 0;
+	      }
+	    }
+	    else {
+	      b->stuff = 0;
+	    }
+	  }
+	  x >>= 1;
+	}
+	if (flag) {
+	  b->stuff = 0;
+	}
+}
+
+static int synth_bits (struct synth_s *f, unsigned char *bits, int max)
+{
+	struct synth_bits_s b;
+	int j, fcs;
+
+	memset (&b, 0, sizeof(b));
+	b.bits = bits;
+	b.max = max;
+
+	/* Same as send_packet:  8 flags, frame with its own flags, 2 more flags. */
+
+	for (j = 0; j < 9; j++) synth_put_byte (&b, 0x7e, 1);
+	for (j = 0; j < f->flen; j++) synth_put_byte (&b, f->fbuf[j], 0);
+	fcs = fcs_calc (f->fbuf, f->flen);
+	synth_put_byte (&b, fcs & 0xff, 0);
+	synth_put_byte (&b, (fcs >> 8) & 0xff, 0);
+	for (j = 0; j < 3; j++) synth_put_byte (&b, 0x7e, 1);
+
+	if (modem.achan[0].modem_type == MODEM_SCRAMBLE) {
+	  int lfsr = 0;
+
+	  for (j = 0; j < b.n; j++) {
+	    int x = (bits[j] ^ (lfsr >> 16) ^ (lfsr >> 11)) & 1;
+	    lfsr = (lfsr << 1) | x;
+	    bits[j] = x;
+	  }
+	}
+	return (b.n);
+}
+
+
+/*
+ * Generate signal for one frame.  Caller must free the result.
+ */
+
+static float *synth_signal (struct synth_s *f, int *nsamp)
+{
+	unsigned char *bits;
+	int nbits, max, n, s;
+	int rate = modem.adev[0].samples_per_sec;
+	int baud = modem.achan[0].baud;
+	float *x;
+
+	max = (f->flen + 2) * 10 + 12 * 8;	/* Allow for worst case bit stuffing. */
+	bits = malloc (max);
+	nbits = synth_bits (f, bits, max);
+
+	n = (int) ((double)nbits * rate / baud) + 1;
+	x = calloc (n, sizeof(float));
+
+	if (modem.achan[0].modem_type == MODEM_AFSK) {
+
+	  /* Phase accumulator, upper bits index into sine table, same as gen_tone. */
+
+	  unsigned int phase = 0;
+	  unsigned int dmark = (unsigned int) ((modem.achan[0].mark_freq + g_offset) * 4294967296. / rate + 0.5);
+	  unsigned int dspace = (unsigned int) ((modem.achan[0].space_freq + g_offset) * 4294967296. / rate + 0.5);
+	  float gspace = powf(10., g_twist / 20.);
+	  int b = 0, acc = 0;
+
+	  for (s = 0; s < n; s++) {
+	    int dat = b < nbits ? bits[b] : 0;
+
+	    phase += dat ? dspace : dmark;
+	    x[s] = dat ? gspace * synth_sine[phase >> 22] : synth_sine[phase >> 22];
+
+	    /* Next bit? */
+	    acc += baud;
+	    if (acc >= rate) {
+	      acc -= rate;
+	      b++;
+	    }
+	  }
+	}
+	else {
+	  float raw[MAX_FILTER_SIZE];
+	  int s2;
+
+	  /* Twice the sample rate then lowpass filter, same as gen_tone. */
+
+	  memset (raw, 0, sizeof(raw));
+	  for (s2 = 0; s2 < 2 * n; s2++) {
+	    int b = (int) ((double)s2 * baud / (2. * rate));
+	    int dat = b < nbits ? bits[b] : 0;
+
+	    memmove (raw + 1, raw, (synth_lp_size - 1) * sizeof(float));
+	    raw[0] = dat ? synth_amp : -synth_amp;
+	    if (s2 & 1) {
+	      float sum = 0;
+	      int j;
+
+	      for (j = 0; j < synth_lp_size; j++) {
+	        sum += synth_lp[j] * raw[j];
+	      }
+	      x[s2 / 2] = sum;
+	    }
+	  }
+	}
+
+	free (bits);
+	*nsamp = n;
+	return (x);
+}
+
+
+/*
+ * Render frame k with all impairments.
+ */
+
+static void synth_render (int k)
+{
+	struct synth_s *f = &synth[k];
+	unsigned int r = (seed ^ ((unsigned int)(k + 1) * 2654435761u)) & MY_RAND_MAX;
+	int rate = modem.adev[0].samples_per_sec;
+	int nchan = modem.adev[0].num_channels;
+	int gap = rate * SYNTH_GAP_SEC;
+	int n, total, s, c;
+	float *sig, *x, scale;
+
+	synth_rand (&r);
+	synth_rand (&r);
+
+	sig = synth_signal (f, &n);
+	total = n + gap;
+
+/* Another frame overlapping this one. */
+
+	if (g_collide > 0 && synth_num > 1 && synth_rand(&r) % 10000 < g_collide * 100) {
+	  int other = (k + 1 + synth_rand(&r) % (synth_num - 1)) % synth_num;
+	  int start = synth_rand(&r) % n;
+	  float gain = powf (10., -(synth_rand(&r) % 12) / 20.);
+	  float *y;
+	  int ny;
+
+	  y = synth_signal (&synth[other], &ny);
+	  if (start + ny + gap > total) total = start + ny + gap;
+	  x = calloc (total, sizeof(float));
+	  memcpy (x, sig, n * sizeof(float));
+	  for (s = 0; s < ny; s++) {
+	    x[start + s] += gain * y[s];
+	  }
+	  free (y);
+	}
+	else {
+	  x = calloc (total, sizeof(float));
+	  memcpy (x, sig, n * sizeof(float));
+	}
+	free (sig);
+
+/* Multipath.  Work backwards so the echo is of the original. */
+
+	if (g_echo_usec > 0) {
+	  int d = (int) ((double)g_echo_usec * rate / 1000000. + 0.5);
+	  float g = powf (10., g_echo_db / 20.);
+
+	  for (s = total - 1; s >= d; s--) {
+	    x[s] += g * x[s - d];
+	  }
+	}
+
+/* Clipping. */
+
+	if (g_clip > 0) {
+	  float lim = synth_amp * g_clip / 100.;
+
+	  for (s = 0; s < total; s++) {
+	    if (x[s] > lim) x[s] = lim;
+	    else if (x[s] < -lim) x[s] = -lim;
+	  }
+	}
+
+/* Noise, same as audio_put, and convert to 16 bit. */
+
+	f->out = malloc (total * nchan * sizeof(short));
+	f->nout = total;
+	scale = 5 * f->noise * 32767 / (MY_RAND_MAX/2.0);
+
+	for (s = 0; s < total; s++) {
+	  for (c = 0; c < nchan; c++) {
+	    float v = x[s];
+
+	    if (f->noise > 0) {
+	      v += (synth_rand(&r) - MY_RAND_MAX/2) * scale;
+	    }
+	    if (v > 32767) v = 32767;
+	    if (v < -32767) v = -32767;
+	    f->out[s * nchan + c] = (short)v;
+	  }
+	}
+	free (x);
+}
+
+
+#if ! __WIN32__
+
+static void * synth_thread (void *arg)
+{
+	int t = (int)(long)arg;
+	int k;
+
+	for (k = synth_first + t; k < synth_end; k += g_jobs) {
+	  synth_render (k);
+	}
+	return (NULL);
+}
+
+#endif
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        synth_packets
+ *
+ * Purpose:     Fast synthesis of many packets, "-f" option.
+ *
+ * Inputs:	text		- Packets in monitor format.
+ *
+ *		num		- Number of them.
+ *
+ *		packet_count	- Number for "-n" sweep of noise level.
+ *				  0 for no noise.
+ *
+ *		amplitude	- "-a" option.
+ *
+ * Returns:	0 for success, -1 for error.
+ *
+ * Description:	Frames are rendered in batches by several threads then
+ *		written to the output file in order.
+ *
+ *----------------------------------------------------------------*/
+
+static int synth_packets (char **text, int num, int packet_count, int amplitude)
+{
+	int k, t;
+	int nchan = modem.adev[0].num_channels;
+	double start = dtime_now();
+	double audio_sec = 0;
+	int batch;
+	unsigned char *buf = NULL;
+	int buf_size = 0;
+
+	synth = calloc (num, sizeof(struct synth_s));
+	synth_num = num;
+
+	synth_amp = 32767. * (amplitude / 2) / 100.;
+	for (k = 0; k < 1024; k++) {
+	  synth_sine[k] = synth_amp * sin(k * 2 * M_PI / 1024.);
+	}
+
+	for (k = 0; k < num; k++) {
+	  packet_t pp = ax25_from_text (text[k], 1);
+
+	  if (pp == NULL) {
+	    text_color_set(DW_COLOR_ERROR); 
+	    dw_printf ("Invalid packet: %s\n", text[k]);
+	    free (synth);
+	    return (-1);
+	  }
+	  synth[k].flen = ax25_pack (pp, synth[k].fbuf);
+	  ax25_delete (pp);
+	  synth[k].noise = packet_count > 0 ? noise_for_packet (k + 1, packet_count, amplitude) : 0;
+	}
+
+	if (modem.achan[0].modem_type != MODEM_AFSK) {
+
+	  /* Same as gen_tone_init. */
+
+	  float filter_len_bits =  88 * 9600.0 / (44100.0 * 2.0);
+	  int samples_per_sec = modem.adev[0].samples_per_sec * 2;
+	  int baud = modem.achan[0].baud;
+
+	  synth_lp_size = (int) (( filter_len_bits * (float)samples_per_sec / baud) + 0.5);
+	  if (synth_lp_size < 10 || synth_lp_size > MAX_FILTER_SIZE) {
+	    synth_lp_size = MAX_FILTER_SIZE / 2;
+	  }
+	  gen_lowpass ((float)baud * 0.8 / (float)samples_per_sec, synth_lp, synth_lp_size, BP_WINDOW_HAMMING);
+	}
+
+#if __WIN32__
+	g_jobs = 1;
+#else
+	if (g_jobs <= 0) {
+	  g_jobs = sysconf (_SC_NPROCESSORS_ONLN);
+	}
+#endif
+	if (g_jobs <= 0) g_jobs = 1;
+	batch = g_jobs * 8;
+
+	for (synth_first = 0; synth_first < num; synth_first = synth_end) {
+
+	  synth_end = synth_first + batch;
+	  if (synth_end > num) synth_end = num;
+
+#if __WIN32__
+	  for (k = synth_first; k < synth_end; k++) {
+	    synth_render (k);
+	  }
+#else
+	  pthread_t tid[g_jobs];
+
+	  for (t = 0; t < g_jobs; t++) {
+	    if (pthread_create (&tid[t], NULL, synth_thread, (void *)(long)t) != 0) {
+	      text_color_set(DW_COLOR_ERROR); 
+	      dw_printf ("Could not create thread.\n");
+	      exit (EXIT_FAILURE);
+	    }
+	  }
+	  for (t = 0; t < g_jobs; t++) {
+	    pthread_join (tid[t], NULL);
+	  }
+#endif
+
+	  for (k = synth_first; k < synth_end; k++) {
+	    struct synth_s *f = &synth[k];
+	    int n = f->nout * nchan;
+	    int j;
+
+	    if (2 * n > buf_size) {
+	      buf_size = 2 * n;
+	      buf = realloc (buf, buf_size);
+	    }
+	    for (j = 0; j < n; j++) {
+	      buf[2*j] = f->out[j] & 0xff;
+	      buf[2*j+1] = (f->out[j] >> 8) & 0xff;
+	    }
+	    if (audio_file_write (buf, 2 * n) < 0) {
+	      text_color_set(DW_COLOR_ERROR); 
+	      dw_printf ("Error writing audio output.\n");
+	      exit (EXIT_FAILURE);
+	    }
+	    audio_sec += (double)f->nout / modem.adev[0].samples_per_sec;
+	    free (f->out);
+	    f->out = NULL;
+	  }
+	}
+
+	free (buf);
+	free (synth);
+	synth = NULL;
+
+	text_color_set(DW_COLOR_INFO); 
+	dw_printf ("%d frames, %.1f seconds of audio, in %.3f seconds with %d threads.\n",
+			num, audio_sec, dtime_now() - start, g_jobs);
+	return (0);
+
+} /* end synth_packets */
+
+
+
 static void usage (char **argv)
 {
 
@@ -517,7 +1152,17 @@ static void usage (char **argv)
 	dw_printf ("  -s <number>   Space frequency.  Default is %d.\n", DEFAULT_SPACE_FREQ);
 	dw_printf ("  -r <number>   Audio sample Rate.  Default is %d.\n", DEFAULT_SAMPLES_PER_SEC);
 	dw_printf ("  -n <number>   Generate specified number of frames with increasing noise.\n");
-	dw_printf ("  -o <file>     Send output to .wav file.\n");
+	dw_printf ("  -o <file>     Send output to .wav file.  \"-\" for stdout.\n");
+	dw_printf ("  -R            Raw samples without .wav header, e.g. for direwolf stdin.\n");
+	dw_printf ("  -S <number>   Seed for random number generator.  Default 1.\n");
+	dw_printf ("\n");
+	dw_printf ("  -f            Fast synthesis, several frames at once, with these impairments:\n");
+	dw_printf ("  -j <number>   Number of threads for -f.  Default is number of processors.\n");
+	dw_printf ("  -O <number>   Frequency offset, Hz.\n");
+	dw_printf ("  -T <number>   Twist, dB.  Positive for stronger space tone.\n");
+	dw_printf ("  -C <number>   Clip at this percentage of peak amplitude.\n");
+	dw_printf ("  -P <usec>,<dB> Multipath echo with delay and relative level.\n");
+	dw_printf ("  -X <number>   Percentage of frames with another colliding.\n");
 //	dw_printf ("  -8            8 bit audio rather than 16.\n");
 //	dw_printf ("  -2            2 channels of audio rather than 1.\n");
 //	dw_printf ("  -z <number>   Number of leading zero bits before frame.\n");
@@ -548,6 +1193,10 @@ static void usage (char **argv)
 	dw_printf ("Example:  echo -n \"WB2OSZ>WORLD:Hello, world!\" | gen_packets -a 25 -o x.wav -\n");
 	dw_printf ("\n");
         dw_printf ("    Read message from stdin and put quarter volume sound into the file x.wav.\n");
+	dw_printf ("\n");
+	dw_printf ("Example:  gen_packets -f -B 9600 -r 48000 -n 10000 -X 5 -o - | atest -B 9600 -\n");
+	dw_printf ("\n");
+        dw_printf ("    Quickly generate 10000 frames, 5%% with collisions, and decode them.\n");
 
 	exit (EXIT_FAILURE);
 }
@@ -561,6 +1210,9 @@ static void usage (char **argv)
  * Purpose:     Open a .WAV format file for output.
  *
  * Inputs:      fname		- Name of .WAV file to create.
+ *				  "-" for stdout.  The lengths in the
+ *				  header are set to the maximum because
+ *				  we can't go back and fill them in.
  *
  *		pa		- Address of structure of type audio_s.
  *				
@@ -624,7 +1276,12 @@ static int audio_file_open (char *fname, struct audio_s *pa)
 /*
  * Write the file header.  Don't know length yet.
  */
-        out_fp = fopen (fname, "wb");	
+	if (g_stdout_fd >= 0 && strcmp(fname, "-") == 0) {
+	  out_fp = fdopen (g_stdout_fd, "wb");
+	}
+	else {
+          out_fp = fopen (fname, "wb");
+	}
 	
         if (out_fp == NULL) {
            text_color_set(DW_COLOR_ERROR); dw_printf ("Couldn't open file for write: %s\n", fname);
@@ -652,7 +1309,17 @@ static int audio_file_open (char *fname, struct audio_s *pa)
 
 	assert (header.nchannels == 1 || header.nchannels == 2);
 
-        n = fwrite (&header, sizeof(header), (size_t)1, out_fp);
+	if (g_stdout_fd >= 0) {
+	  header.datasize = 0x7fffffff - sizeof(header);
+	  header.filesize = header.datasize + sizeof(header) - 8;
+	}
+
+	if (g_raw) {
+	  n = 1;
+	}
+	else {
+          n = fwrite (&header, sizeof(header), (size_t)1, out_fp);
+	}
 
 	if (n != 1) {
           text_color_set(DW_COLOR_ERROR); 
@@ -690,12 +1357,8 @@ static int audio_file_open (char *fname, struct audio_s *pa)
  *
  *----------------------------------------------------------------*/
 
-#define MY_RAND_MAX 0x7fffffff
-
-static int seed = 1;
-
 static int my_rand (void) {
-	seed = ((seed * 1103515245) + 12345) & MY_RAND_MAX;
+	seed = ((seed * 1103515245u) + 12345) & MY_RAND_MAX;
 	return (seed);
 }
 
@@ -750,6 +1413,21 @@ int audio_flush (int a)
 	return 0;
 }
 
+
+/*
+ * Write a block of samples from the fast synthesizer.
+ * These already have noise added.
+ */
+
+static int audio_file_write (unsigned char *buf, int len)
+{
+	if (fwrite (buf, (size_t)len, (size_t)1, out_fp) != 1) {
+	  return (-1);
+	}
+	byte_count += len;
+	return (len);
+}
+
 /*------------------------------------------------------------------
  *
  * Name:        audio_file_close
@@ -784,6 +1462,12 @@ static int audio_file_close (void)
 
         fflush (out_fp);
 
+	if (g_raw || g_stdout_fd >= 0) {
+	  fclose (out_fp);
+	  out_fp = NULL;
+	  return (0);
+	}
+
         fseek (out_fp, 0L, SEEK_SET);         
         n = fwrite (&header, sizeof(header), (size_t)1, out_fp);
 
@@ -42,6 +42,8 @@
 #include "multi_modem.h"
 #include "demod_9600.h"		/* for descramble() */
 #include "ptt.h"
+#include "dtime_now.h"
+#include "audio_ring.h"
 
 
 //#define TEST 1				/* Define for unit testing. */
@@ -64,49 +66,58 @@
  * It is possible to run multiple decoders concurrently by
  * having a separate set of state variables for each.
  *
+ * Version 1.4:  Each demodulator can have up to 9 slicers and each
+ * slicer has its own decoder.  The state for all slicers of one
+ * demodulator is kept together, as arrays indexed by slicer number,
+ * so they can all be advanced together with vector instructions.
+ * See hdlc_rec_bits.
+ *
  * Should have a reset function instead of initializations here.
  */
 
 struct hdlc_state_s {
 
 
-	int prev_raw;			/* Keep track of previous bit so */
+	int prev_raw[MAX_SLICERS];	/* Keep track of previous bit so */
 					/* we can look for transitions. */
 					/* Should be only 0 or 1. */
 
-	int lfsr;			/* Descrambler shift register for 9600 baud. */
+	int lfsr[MAX_SLICERS];		/* Descrambler shift register for 9600 baud. */
 
-	int prev_descram;		/* Previous descrambled for 9600 baud. */
+	int prev_descram[MAX_SLICERS];	/* Previous descrambled for 9600 baud. */
 
-	unsigned char pat_det; 		/* 8 bit pattern detector shift register. */
+	unsigned int pat_det[MAX_SLICERS];
+					/* 8 bit pattern detector shift register. */
 					/* See below for more details. */
+					/* Only the low 8 bits are used but a full */
+					/* int is friendlier for vector instructions. */
 
-	unsigned int flag4_det;		/* Last 32 raw bits to look for 4 */
+	unsigned int flag4_det[MAX_SLICERS];
+					/* Last 32 raw bits to look for 4 */
 					/* flag patterns in a row. */
 
-	unsigned char oacc;		/* Accumulator for building up an octet. */
+	unsigned int oacc[MAX_SLICERS];	/* Accumulator for building up an octet. */
 
-	int olen;			/* Number of bits in oacc. */
+	int olen[MAX_SLICERS];		/* Number of bits in oacc. */
 					/* When this reaches 8, oacc is copied */
 					/* to the frame buffer and olen is zeroed. */
 					/* The value of -1 is a special case meaning */
 					/* bits should not be accumulated. */
 
-	unsigned char frame_buf[MAX_FRAME_LEN];
-					/* One frame is kept here. */
-
-	int frame_len;			/* Number of octets in frame_buf. */
+	int frame_len[MAX_SLICERS];	/* Number of octets in frame_buf. */
 					/* Should be in range of 0 .. MAX_FRAME_LEN. */
 
-	int data_detect;		/* True when HDLC data is detected. */
+	int data_detect[MAX_SLICERS];	/* True when HDLC data is detected. */
 					/* This will not be triggered by voice or other */
 					/* noise or even tones.  */
 
-	rrbb_t rrbb;			/* Handle for bit array for raw received bits. */
-					
+	rrbb_t rrbb[MAX_SLICERS];	/* Handle for bit array for raw received bits. */
+
+	unsigned char frame_buf[MAX_SLICERS][MAX_FRAME_LEN];
+					/* One frame is kept here. */
 };
 
-static struct hdlc_state_s hdlc_state[MAX_CHANS][MAX_SUBCHANS][MAX_SLICERS];
+static struct hdlc_state_s hdlc_state[MAX_CHANS][MAX_SUBCHANS];
 
 static int num_subchan[MAX_CHANS];		//TODO1.2 use ptr rather than copy.
 
@@ -150,14 +161,14 @@ void hdlc_rec_init (struct audio_s *pa)
 	    {
 	      for (slice = 0; slice < MAX_SLICERS; slice++) {
 
-	        H = &hdlc_state[ch][sub][slice];
+	        H = &hdlc_state[ch][sub];
 
-	        H->olen = -1;
+	        H->olen[slice] = -1;
 
 		// TODO: FIX13 wasteful if not needed.
 		// Should loop on number of slicers, not max.
 
-	        H->rrbb = rrbb_new(ch, sub, slice, pa->achan[ch].modem_type == MODEM_SCRAMBLE, H->lfsr, H->prev_descram);
+	        H->rrbb[slice] = rrbb_new(ch, sub, slice, pa->achan[ch].modem_type == MODEM_SCRAMBLE, H->lfsr[slice], H->prev_descram[slice]);
 	      }
 	    }
 	  }
@@ -185,8 +196,11 @@ void hdlc_rec_init (struct audio_s *pa)
  *	
  *		is_scrambled - Is the data scrambled?
  *
- *		descram_state - Current descrambler state.  (not used - remove)
- *					
+ *		quality	- How far the demodulator output was from the
+ *			  slicing threshold, 0 to 255.  See hdlc_rec_bit_quality.
+ *			  This is saved with the bit for deciding which bits
+ *			  to try changing when the frame has a bad FCS.
+ *
  *
  * Description:	This is called once for each received bit.
  *		For each valid frame, process_rec_frame()
@@ -194,9 +208,18 @@ void hdlc_rec_init (struct audio_s *pa)
  *
  ***********************************************************************************/
 
-// TODO: int not_used_remove
+static void rec_bit_framing (int chan, int subchan, int slice, int raw, int dbit, int is_scrambled, int quality, struct hdlc_state_s *H);
+
+
+/* a where m is all ones, b where m is zero.  Used to avoid branches. */
+
+static inline unsigned int pick (unsigned int m, unsigned int a, unsigned int b)
+{
+	return ((a & m) | (b & ~m));
+}
+
 
-void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled, int not_used_remove)
+void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled, int quality)
 {
 
 	int dbit;			/* Data bit after undoing NRZI. */
@@ -213,7 +236,7 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 /*
  * Different state information for each channel / subchannel / slice.
  */
-	H = &hdlc_state[chan][subchan][slice];
+	H = &hdlc_state[chan][subchan];
 
 /*
  * Using NRZI encoding,
@@ -224,31 +247,149 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 	if (is_scrambled) {
 	  int descram;
 
-	  descram = descramble(raw, &(H->lfsr));
+	  descram = descramble(raw, &(H->lfsr[slice]));
 
-	  dbit = (descram == H->prev_descram);
-	  H->prev_descram = descram;			
-	  H->prev_raw = raw;	}
+	  dbit = (descram == H->prev_descram[slice]);
+	  H->prev_descram[slice] = descram;
+	  H->prev_raw[slice] = raw;	}
 	else {
 
-	  dbit = (raw == H->prev_raw);
-	  H->prev_raw = raw;
+	  dbit = (raw == H->prev_raw[slice]);
+	  H->prev_raw[slice] = raw;
 	}
 
 /*
  * Octets are sent LSB first.
  * Shift the most recent 8 bits thru the pattern detector.
  */
-	H->pat_det >>= 1;
+	H->pat_det[slice] = (H->pat_det[slice] >> 1) | (dbit << 7);
+
+	H->flag4_det[slice] >>= 1;
 	if (dbit) {
-	  H->pat_det |= 0x80;
+	  H->flag4_det[slice] |= 0x80000000;
 	}
 
-	H->flag4_det >>= 1;
-	if (dbit) {
-	  H->flag4_det |= 0x80000000;
+	rec_bit_framing (chan, subchan, slice, raw, dbit, is_scrambled, quality, H);
+}
+
+
+
+/***********************************************************************************
+ *
+ * Name:	hdlc_rec_bits
+ *
+ * Purpose:	Same as hdlc_rec_bit for several slicers of one demodulator at once.
+ *
+ * Inputs:	chan	- Channel number.
+ *
+ *		subchan	- Demodulator number.
+ *
+ *		num_slicers - Number of slicers for the demodulator.
+ *
+ *		sampled	- Non-zero for those slicers which have a new bit.
+ *			  Others are left alone.
+ *
+ *		raw	- Bit from the demodulator for each slicer.
+ *
+ *		is_scrambled - Is the data scrambled?
+ *
+ *		quality	- Confidence for each bit.
+ *
+ * Description:	Most of the time, all we do is shift the new bit into the
+ *		pattern detector and accumulate it into an octet.  That part
+ *		is done for all slicers at once, in a loop the compiler can
+ *		turn into vector instructions.  Anything less common, such
+ *		as a flag pattern, change of DCD, or a completed octet, goes
+ *		through the usual one slicer at a time code path.
+ *
+ ***********************************************************************************/
+
+void hdlc_rec_bits (int chan, int subchan, int num_slicers, const int *sampled, const int *raw, int is_scrambled, const int *quality)
+{
+	struct hdlc_state_s *H;
+	int dbit[MAX_SLICERS];
+	int event[MAX_SLICERS];
+	int slice;
+
+	assert (was_init == 1);
+
+	assert (chan >= 0 && chan < MAX_CHANS);
+	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
+	assert (num_slicers >= 1 && num_slicers <= MAX_SLICERS);
+
+	H = &hdlc_state[chan][subchan];
+
+/*
+ * Everything in this loop must be free of branches so the compiler
+ * can vectorize it.  Slicers without a new bit keep their previous
+ * state.  Conditions are all ones or all zeros masks.
+ */
+	for (slice = 0; slice < num_slicers; slice++) {
+	  unsigned int on = - (unsigned int)(sampled[slice] != 0);	/* All ones or zero. */
+	  unsigned int r = raw[slice] & 1;
+	  unsigned int lfsr = H->lfsr[slice];
+	  unsigned int descram = (r ^ (lfsr >> 16) ^ (lfsr >> 11)) & 1;
+	  unsigned int d, pat, f4, ev, acc;
+
+	  d = is_scrambled ? descram == H->prev_descram[slice] : r == H->prev_raw[slice];
+
+	  H->lfsr[slice] = pick (on, (lfsr << 1) | r, lfsr);
+	  H->prev_descram[slice] = pick (on, descram, H->prev_descram[slice]);
+	  H->prev_raw[slice] = pick (on, r, H->prev_raw[slice]);
+
+	  pat = (H->pat_det[slice] >> 1) | (d << 7);
+	  f4 = (H->flag4_det[slice] >> 1) | (d << 31);
+
+	  H->pat_det[slice] = pick (on, pat, H->pat_det[slice]);
+	  H->flag4_det[slice] = pick (on, f4, H->flag4_det[slice]);
+
+/*
+ * Flags, aborts (0xfe, or 0xff for EXPERIMENT12B), possible
+ * start of DCD, or completing an octet need the full treatment.
+ */
+	  acc = (H->olen[slice] >= 0) & ((pat & 0xfc) != 0x7c);	/* Not a stuffed bit. */
+
+	  ev = (pat == 0x7e) | (pat >= 0xfe) |
+			((H->data_detect[slice] == 0) & ((f4 & 0xff000000) == 0x7e000000)) |
+			(acc & (H->olen[slice] == 7));
+	  ev = - ev & on;
+
+/*
+ * Otherwise accumulate the bit into an octet.
+ */
+	  acc = - acc & on & ~ev;
+	  H->oacc[slice] = pick (acc, (H->oacc[slice] >> 1) | (d << 7), H->oacc[slice]);
+	  H->olen[slice] += acc & 1;
+
+	  event[slice] = ev;
+	  dbit[slice] = d;
+	}
+
+	for (slice = 0; slice < num_slicers; slice++) {
+	  if (sampled[slice]) {
+	    if (event[slice]) {
+	      rec_bit_framing (chan, subchan, slice, raw[slice], dbit[slice], is_scrambled, quality[slice], H);
+	    }
+	    else {
+	      rrbb_append_bit (H->rrbb[slice], raw[slice], quality[slice]);
+	    }
+	  }
 	}
+}
+
+
+
+/***********************************************************************************
+ *
+ * Name:	rec_bit_framing
+ *
+ * Purpose:	The rest of hdlc_rec_bit after the new bit has been
+ *		shifted into the pattern detector.
+ *
+ ***********************************************************************************/
 
+static void rec_bit_framing (int chan, int subchan, int slice, int raw, int dbit, int is_scrambled, int quality, struct hdlc_state_s *H)
+{
 
 /*
  * "Data Carrier detect" function based on data patterns rather than
@@ -278,21 +419,21 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
  * when listening to live signals.  Let's try 3 and see how that works out.
  */
 
-	//if (H->flag4_det == 0x7e7e7e7e) {
-	if ((H->flag4_det & 0xffffff00) == 0x7e7e7e00) {	
-	//if ((H->flag4_det & 0xffff0000) == 0x7e7e0000) {	
+	//if (H->flag4_det[slice] == 0x7e7e7e7e) {
+	if ((H->flag4_det[slice] & 0xffffff00) == 0x7e7e7e00) {	
+	//if ((H->flag4_det[slice] & 0xffff0000) == 0x7e7e0000) {	
 
-	  if ( ! H->data_detect) {
-	    H->data_detect = 1;
+	  if ( ! H->data_detect[slice]) {
+	    H->data_detect[slice] = 1;
 	    dcd_change (chan, subchan, slice, 1);
 	  }
 	}
-	//else if (H->flag4_det == 0x7e000000) {	
-	else if ((H->flag4_det & 0xffffff00) == 0x7e000000) {	
-	//else if ((H->flag4_det & 0xffff0000) == 0x7e000000) {	
+	//else if (H->flag4_det[slice] == 0x7e000000) {	
+	else if ((H->flag4_det[slice] & 0xffffff00) == 0x7e000000) {	
+	//else if ((H->flag4_det[slice] & 0xffff0000) == 0x7e000000) {	
 	  
-	  if ( ! H->data_detect) {
-	    H->data_detect = 1;
+	  if ( ! H->data_detect[slice]) {
+	    H->data_detect[slice] = 1;
 	    dcd_change (chan, subchan, slice, 1);
 	  }
 	}
@@ -304,10 +445,10 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
  */
 
   
-	if (H->pat_det == 0xff) {	
+	if (H->pat_det[slice] == 0xff) {	
 	  
-	  if ( H->data_detect ) {
-	    H->data_detect = 0;
+	  if ( H->data_detect[slice] ) {
+	    H->data_detect[slice] = 0;
 	    dcd_change (chan, subchan, slice, 0);
 	  }
 	}
@@ -320,11 +461,11 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
  */
 
 
-	rrbb_append_bit (H->rrbb, raw);
+	rrbb_append_bit (H->rrbb[slice], raw, quality);
 
-	if (H->pat_det == 0x7e) {
+	if (H->pat_det[slice] == 0x7e) {
 
-	  rrbb_chop8 (H->rrbb);
+	  rrbb_chop8 (H->rrbb[slice]);
 
 /*
  * The special pattern 01111110 indicates beginning and ending of a frame.  
@@ -343,15 +484,15 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 	  text_color_set(DW_COLOR_DEBUG);
 	  dw_printf ("\nfound flag, olen = %d, frame_len = %d\n", olen, frame_len);
 #endif
-	  if (H->olen == 7 && H->frame_len >= MIN_FRAME_LEN) {
+	  if (H->olen[slice] == 7 && H->frame_len[slice] >= MIN_FRAME_LEN) {
 
 	    unsigned short actual_fcs, expected_fcs;
 
 #if TEST
 	    int j;
-	    dw_printf ("TRADITIONAL: frame len = %d\n", H->frame_len);
-	    for (j=0; j<H->frame_len; j++) {
-	      dw_printf ("  %02x", H->frame_buf[j]);
+	    dw_printf ("TRADITIONAL: frame len = %d\n", H->frame_len[slice]);
+	    for (j=0; j<H->frame_len[slice]; j++) {
+	      dw_printf ("  %02x", H->frame_buf[slice][j]);
 	    }
 	    dw_printf ("\n");
 
@@ -365,14 +506,14 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 	    /* I think making a second pass over it and comparing is */
 	    /* easier to understand. */
 
-	    actual_fcs = H->frame_buf[H->frame_len-2] | (H->frame_buf[H->frame_len-1] << 8);
+	    actual_fcs = H->frame_buf[slice][H->frame_len[slice]-2] | (H->frame_buf[slice][H->frame_len[slice]-1] << 8);
 
-	    expected_fcs = fcs_calc (H->frame_buf, H->frame_len - 2);
+	    expected_fcs = fcs_calc (H->frame_buf[slice], H->frame_len[slice] - 2);
 
 	    if (actual_fcs == expected_fcs) {
 	      alevel_t alevel = demod_get_audio_level (chan, subchan);
 
-	      multi_modem_process_rec_frame (chan, subchan, slice, H->frame_buf, H->frame_len - 2, alevel, RETRY_NONE);   /* len-2 to remove FCS. */
+	      multi_modem_process_rec_frame (chan, subchan, slice, H->frame_buf[slice], H->frame_len[slice] - 2, alevel, RETRY_NONE, dtime_now());   /* len-2 to remove FCS. */
 	    }
 	    else {
 
@@ -392,27 +533,28 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 
 #if TEST
 	  text_color_set(DW_COLOR_DEBUG);
-	  dw_printf ("\nfound flag, channel %d.%d, %d bits in frame\n", chan, subchan, rrbb_get_len(H->rrbb) - 1);
+	  dw_printf ("\nfound flag, channel %d.%d, %d bits in frame\n", chan, subchan, rrbb_get_len(H->rrbb[slice]) - 1);
 #endif
-	  if (rrbb_get_len(H->rrbb) >= MIN_FRAME_LEN * 8) {
+	  if (rrbb_get_len(H->rrbb[slice]) >= MIN_FRAME_LEN * 8) {
 		
 	    alevel_t alevel = demod_get_audio_level (chan, subchan);
 
-	    rrbb_set_audio_level (H->rrbb, alevel);
-	    hdlc_rec2_block (H->rrbb);
+	    rrbb_set_audio_level (H->rrbb[slice], alevel);
+	    rrbb_set_flag_time (H->rrbb[slice], dtime_now());
+	    hdlc_rec2_block (H->rrbb[slice]);
 	    	/* Now owned by someone else who will free it. */
 
-	    H->rrbb = rrbb_new (chan, subchan, slice, is_scrambled, H->lfsr, H->prev_descram); /* Allocate a new one. */
+	    H->rrbb[slice] = rrbb_new (chan, subchan, slice, is_scrambled, H->lfsr[slice], H->prev_descram[slice]); /* Allocate a new one. */
 	  }
 	  else {
-	    rrbb_clear (H->rrbb, is_scrambled, H->lfsr, H->prev_descram); 
+	    rrbb_clear (H->rrbb[slice], is_scrambled, H->lfsr[slice], H->prev_descram[slice]); 
 	  }
 
-	  H->olen = 0;		/* Allow accumulation of octets. */
-	  H->frame_len = 0;
+	  H->olen[slice] = 0;		/* Allow accumulation of octets. */
+	  H->frame_len[slice] = 0;
 
 
-	  rrbb_append_bit (H->rrbb, H->prev_raw); /* Last bit of flag.  Needed to get first data bit. */
+	  rrbb_append_bit (H->rrbb[slice], H->prev_raw[slice], 255); /* Last bit of flag.  Needed to get first data bit. */
 						/* Now that we are saving other initial state information, */
 						/* it would be sensible to do the same for this instead */
 						/* of lumping it in with the frame data bits. */
@@ -424,7 +566,7 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 
 #if EXPERIMENT12B
 
-	else if (H->pat_det == 0xff) {
+	else if (H->pat_det[slice] == 0xff) {
 
 /*
  * Valid data will never have seven 1 bits in a row.
@@ -445,7 +587,7 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
  */
 
 #else
-	else if (H->pat_det == 0xfe) {
+	else if (H->pat_det[slice] == 0xfe) {
 
 /*
  * Valid data will never have 7 one bits in a row.
@@ -457,13 +599,13 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 
 #endif
 
-	  H->olen = -1;		/* Stop accumulating octets. */
-	  H->frame_len = 0;	/* Discard anything in progress. */
+	  H->olen[slice] = -1;		/* Stop accumulating octets. */
+	  H->frame_len[slice] = 0;	/* Discard anything in progress. */
 
-	  rrbb_clear (H->rrbb, is_scrambled, H->lfsr, H->prev_descram); 
+	  rrbb_clear (H->rrbb[slice], is_scrambled, H->lfsr[slice], H->prev_descram[slice]); 
 
 	}
-	else if ( (H->pat_det & 0xfc) == 0x7c ) {
+	else if ( (H->pat_det[slice] & 0xfc) == 0x7c ) {
 
 /*
  * If we have five '1' bits in a row, followed by a '0' bit,
@@ -481,20 +623,20 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
  * In all other cases, accumulate bits into octets, and complete octets
  * into the frame buffer.
  */
-	  if (H->olen >= 0) {
+	  if (H->olen[slice] >= 0) {
 
-	    H->oacc >>= 1;
+	    H->oacc[slice] >>= 1;
 	    if (dbit) {
-	      H->oacc |= 0x80;
+	      H->oacc[slice] |= 0x80;
 	    }
-	    H->olen++;
+	    H->olen[slice]++;
 
-	    if (H->olen == 8) {
-	      H->olen = 0;
+	    if (H->olen[slice] == 8) {
+	      H->olen[slice] = 0;
 
-	      if (H->frame_len < MAX_FRAME_LEN) {
-		H->frame_buf[H->frame_len] = H->oacc;
-		H->frame_len++;
+	      if (H->frame_len[slice] < MAX_FRAME_LEN) {
+		H->frame_buf[slice][H->frame_len[slice]] = H->oacc[slice];
+		H->frame_len[slice]++;
 	      }
 	    }
 	  }
@@ -537,11 +679,21 @@ int hdlc_rec_gathering (int chan, int subchan, int slice)
 	// olen>=0		992	985
 	// OR-ed		992	985
 
-	return ( hdlc_state[chan][subchan][slice].data_detect );
+	return ( hdlc_state[chan][subchan].data_detect[slice] );
 
 } /* end hdlc_rec_gathering */
 
 
+const int *hdlc_rec_gathering_all (int chan, int subchan)
+{
+	assert (chan >= 0 && chan < MAX_CHANS);
+	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
+
+	return ( hdlc_state[chan][subchan].data_detect );
+
+} /* end hdlc_rec_gathering_all */
+
+
 
 /*-------------------------------------------------------------------
  *
@@ -596,6 +748,7 @@ void dcd_change (int chan, int subchan, int slice, int state)
 
 	if (new != old) {
 	  ptt_set (OCTYPE_DCD, chan, new);
+	  audio_ring_dcd (chan, new);
 	}
 }
 
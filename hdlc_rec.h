@@ -5,7 +5,24 @@
 
 void hdlc_rec_init (struct audio_s *pa);
 
-void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled, int descram_state);
+void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled, int quality);
+
+/* Same for several slicers of one demodulator at once. */
+/* sampled[slice] is non-zero for each of those with a new bit. */
+
+void hdlc_rec_bits (int chan, int subchan, int num_slicers, const int *sampled, const int *raw, int is_scrambled, const int *quality);
+
+
+/*
+ * Convert demodulator output, relative to the slicing threshold,
+ * into the "quality" for hdlc_rec_bit.  Full scale is about 1.
+ */
+
+static inline int hdlc_rec_bit_quality (float margin)
+{
+	margin = margin < 0 ? -margin : margin;
+	return (margin >= 1.0f ? 255 : (int)(margin * 255.0f));
+}
 
 /* Provided elsewhere to process a complete frame. */
 
@@ -18,6 +35,10 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 
 int hdlc_rec_gathering (int chan, int subchan, int slice);
 
+/* Same for all slicers of the demodulator, indexed by slicer number. */
+
+const int *hdlc_rec_gathering_all (int chan, int subchan);
+
 /* Transmit needs to know when someone else is transmitting. */
 
 void dcd_change (int chan, int subchan, int slice, int state);
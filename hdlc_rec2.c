@@ -87,6 +87,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include <ctype.h>
+#include <stdlib.h>
 
 //Optimize processing by accessing directly to decoded bits
 #define RRBB_C 1
@@ -101,6 +102,9 @@
 #include "dtime_now.h"
 #include "demod_9600.h"		/* for descramble() */
 #include "audio.h"		/* for struct audio_s */
+#include "dsp_stats.h"
+#include "hdlc_rec.h"		/* for hdlc_rec_data_detect_any() */
+#include "audio_ring.h"
 //#include "ax25_pad.h"		/* for AX25_MAX_ADDR_LEN */
 
 
@@ -163,6 +167,10 @@ static int try_decode (rrbb_t block, int chan, int subchan, int slice, alevel_t
 
 static int try_to_fix_quick_now (rrbb_t block, int chan, int subchan, int slice, alevel_t alevel);
 
+static int try_to_fix_soft (rrbb_t block, int chan, int subchan, int slice, alevel_t alevel);
+
+static struct hdlc_rec2_fix_stats_s fix_stats[MAX_CHANS];
+
 static int sanity_check (unsigned char *buf, int blen, retry_t bits_flipped, enum sanity_e sanity_test);
 
 
@@ -267,12 +275,39 @@ void hdlc_rec2_block (rrbb_t block)
  * Not successful with frame in orginal form.
  * See if we can "fix" it.
  */
-	if (try_to_fix_quick_now (block, chan, subchan, slice, alevel)) {
-	  rrbb_delete (block);
-	  return;
+	if (fix_bits != RETRY_NONE) {
+	  ds_ticks_t t_fix = 0;
+	  double t_start = dtime_now();
+
+	  if (dsp_stats_enabled) t_fix = dsp_stats_ticks();
+
+	  if (save_audio_config_p->achan[chan].fix_soft > 0) {
+	    ok = try_to_fix_soft (block, chan, subchan, slice, alevel);
+	  }
+	  else {
+	    ok = try_to_fix_quick_now (block, chan, subchan, slice, alevel);
+	  }
+
+	  if (dsp_stats_enabled) dsp_stats_record (DS_FIX_BITS, chan, subchan, slice, dsp_stats_ticks() - t_fix);
+
+	  fix_stats[chan].attempted++;
+	  fix_stats[chan].fixed += ok;
+	  fix_stats[chan].elapsed += dtime_now() - t_start;
+
+	  if (ok) {
+	    rrbb_delete (block);
+	    return;
+	  }
 	}
 
 
+	/* Save the audio for later study if configured. */
+	/* Only when carrier detected so we don't save noise. */
+
+	if (hdlc_rec_data_detect_any(chan)) {
+	  audio_ring_crc_fail (chan);
+	}
+
 	if (passall) {
 	  /* Exhausted all desired fix up attempts. */
 	  /* Let thru even with bad CRC.  Of course, it still */
@@ -457,6 +492,175 @@ static int try_to_fix_quick_now (rrbb_t block, int chan, int subchan, int slice,
 
 
 
+/***********************************************************************************
+ *
+ * Name:	try_to_fix_soft
+ *
+ * Purpose:	Like try_to_fix_quick_now but try changing only the bits
+ *		which the demodulator was least sure about.
+ *
+ * Inputs:	block	- Stream of bits that might be a frame.
+ *		chan	- Radio channel from which it was received.
+ *		subchan	- Which demodulator when more than one per channel.
+ *		alevel	- Audio level for later reporting.
+ *
+ * Global In:	configuration fix_bits - Maximum level of fix up to attempt.
+ *		configuration fix_soft - Number of bits to consider.
+ *
+ * Returns:	1 for success.  "try_decode" has passed the result along to the 
+ *				processing step.
+ *		0 for failure.
+ *
+ * Description:	Each bit is saved with a confidence value, which is how far
+ *		the demodulator output was from the slicing threshold.
+ *		A bit received in error is much more likely to be one of
+ *		those near the threshold.
+ *
+ *		We pick the K least confident bits then try, in this order:
+ *
+ *			Each of them by itself.				SINGLE
+ *			Pairs of them that are adjacent.		DOUBLE
+ *			Each with the bits on both sides.		TRIPLE
+ *			Pairs of them that are not adjacent.		TWO_SEP
+ *
+ *		limited by the FIX_BITS level, as usual.
+ *		This is at most K + K*(K-1)/2 + K attempts rather than
+ *		order N for each of the first three and N squared for the last.
+ *
+ ***********************************************************************************/
+
+static int try_to_fix_soft (rrbb_t block, int chan, int subchan, int slice, alevel_t alevel)
+{
+	retry_t fix_bits = save_audio_config_p->achan[chan].fix_bits;
+	int k_max = save_audio_config_p->achan[chan].fix_soft;
+	int weak[MAX_FIX_SOFT];		/* Bit positions, least confident first. */
+	int nweak = 0;
+	int len, i, a, b;
+	retry_conf_t retry_cfg;
+
+	len = rrbb_get_len(block);
+
+	if (k_max > MAX_FIX_SOFT) k_max = MAX_FIX_SOFT;
+
+/*
+ * Keep a short sorted list of the least confident bits.
+ * Ties go to the earlier position.
+ */
+	for (i = 0; i < len; i++) {
+	  unsigned char c = rrbb_get_conf(block, i);
+	  int n;
+
+	  if (nweak == k_max && c >= rrbb_get_conf(block, weak[nweak-1])) {
+	    continue;
+	  }
+	  n = nweak < k_max ? nweak++ : nweak - 1;
+	  while (n > 0 && rrbb_get_conf(block, weak[n-1]) > c) {
+	    weak[n] = weak[n-1];
+	    n--;
+	  }
+	  weak[n] = i;
+	}
+
+	retry_cfg.type = RETRY_TYPE_SWAP;
+
+	if (fix_bits < RETRY_INVERT_SINGLE) {
+	  return 0;
+	}
+
+	retry_cfg.mode = RETRY_MODE_CONTIGUOUS;
+	retry_cfg.retry = RETRY_INVERT_SINGLE;
+	retry_cfg.u_bits.contig.nr_bits = 1;
+
+	for (a = 0; a < nweak; a++) {
+	  retry_cfg.u_bits.contig.bit_idx = weak[a];
+	  if (try_decode (block, chan, subchan, slice, alevel, retry_cfg, 0)) {
+	    return 1;
+	  }
+	}
+
+	if (fix_bits < RETRY_INVERT_DOUBLE) {
+	  return 0;
+	}
+
+	retry_cfg.retry = RETRY_INVERT_DOUBLE;
+	retry_cfg.u_bits.contig.nr_bits = 2;
+
+	for (b = 1; b < nweak; b++) {
+	  for (a = 0; a < b; a++) {
+	    if (abs(weak[a] - weak[b]) == 1) {
+	      retry_cfg.u_bits.contig.bit_idx = weak[a] < weak[b] ? weak[a] : weak[b];
+	      if (try_decode (block, chan, subchan, slice, alevel, retry_cfg, 0)) {
+	        return 1;
+	      }
+	    }
+	  }
+	}
+
+	if (fix_bits < RETRY_INVERT_TRIPLE) {
+	  return 0;
+	}
+
+	retry_cfg.retry = RETRY_INVERT_TRIPLE;
+	retry_cfg.u_bits.contig.nr_bits = 3;
+
+	for (a = 0; a < nweak; a++) {
+	  if (weak[a] >= 1 && weak[a] < len - 1) {
+	    retry_cfg.u_bits.contig.bit_idx = weak[a] - 1;
+	    if (try_decode (block, chan, subchan, slice, alevel, retry_cfg, 0)) {
+	      return 1;
+	    }
+	  }
+	}
+
+	if (fix_bits < RETRY_INVERT_TWO_SEP) {
+	  return 0;
+	}
+
+	retry_cfg.mode = RETRY_MODE_SEPARATED;
+	retry_cfg.retry = RETRY_INVERT_TWO_SEP;
+	retry_cfg.u_bits.sep.bit_idx_c = -1;
+
+	for (b = 1; b < nweak; b++) {
+	  for (a = 0; a < b; a++) {
+	    if (abs(weak[a] - weak[b]) >= 2) {
+	      retry_cfg.u_bits.sep.bit_idx_a = weak[a];
+	      retry_cfg.u_bits.sep.bit_idx_b = weak[b];
+	      if (try_decode (block, chan, subchan, slice, alevel, retry_cfg, 0)) {
+	        return 1;
+	      }
+	    }
+	  }
+	}
+
+	return 0;
+
+} /* end try_to_fix_soft */
+
+
+/***********************************************************************************
+ *
+ * Name:	hdlc_rec2_get_fix_stats
+ *
+ * Purpose:	Get counts for attempts to fix frames with bad FCS.
+ *
+ * Inputs:	chan	- Radio channel.
+ *
+ * Outputs:	fs	- Number of frames with bad FCS where fixing was
+ *			  attempted, number fixed, number of tries, and time taken.
+ *
+ * Description:	Used by atest to compare the FIX_BITS levels and SOFT option.
+ *
+ ***********************************************************************************/
+
+void hdlc_rec2_get_fix_stats (int chan, struct hdlc_rec2_fix_stats_s *fs)
+{
+	assert (chan >= 0 && chan < MAX_CHANS);
+
+	*fs = fix_stats[chan];
+}
+
+
+
 // TODO:  Remove this.  but first figure out what to do in atest.c
 
 
@@ -583,6 +787,10 @@ static int try_decode (rrbb_t block, int chan, int subchan, int slice, alevel_t
 	int retry_conf_type = retry_conf.type;
 	int retry_conf_retry = retry_conf.retry;
 
+	if (retry_conf_type != RETRY_TYPE_NONE) {
+	  fix_stats[chan].tries++;
+	}
+
 
 	H.is_scrambled = rrbb_get_is_scrambled (block);
 	H.prev_descram = rrbb_get_prev_descram (block);
@@ -763,7 +971,7 @@ static int try_decode (rrbb_t block, int chan, int subchan, int slice, alevel_t
 
 	      assert (rrbb_get_chan(block) == chan);
 	      assert (rrbb_get_subchan(block) == subchan);
-	      multi_modem_process_rec_frame (chan, subchan, slice, H.frame_buf, H.frame_len - 2, alevel, retry_conf.retry);   /* len-2 to remove FCS. */
+	      multi_modem_process_rec_frame (chan, subchan, slice, H.frame_buf, H.frame_len - 2, alevel, retry_conf.retry, rrbb_get_flag_time(block));   /* len-2 to remove FCS. */
 	      return 1;		/* success */
 
 	  } else if (passall) {
@@ -772,7 +980,7 @@ static int try_decode (rrbb_t block, int chan, int subchan, int slice, alevel_t
 	      //text_color_set(DW_COLOR_ERROR);
 	      //dw_printf ("ATTEMPTING PASSALL PROCESSING\n");
   
-	      multi_modem_process_rec_frame (chan, subchan, slice, H.frame_buf, H.frame_len - 2, alevel, RETRY_MAX);   /* len-2 to remove FCS. */
+	      multi_modem_process_rec_frame (chan, subchan, slice, H.frame_buf, H.frame_len - 2, alevel, RETRY_MAX, rrbb_get_flag_time(block));   /* len-2 to remove FCS. */
 	      return 1;		/* success */
 	    }
 	    else {
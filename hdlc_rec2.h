@@ -60,6 +60,15 @@ void hdlc_rec2_block (rrbb_t block);
 
 int hdlc_rec2_try_to_fix_later (rrbb_t block, int chan, int subchan, int slice, alevel_t alevel);
 
+struct hdlc_rec2_fix_stats_s {
+	int attempted;		/* Frames with bad FCS where fixing was tried. */
+	int fixed;		/* Number of those that were fixed. */
+	long tries;		/* Number of times bits were changed and FCS checked. */
+	double elapsed;		/* Seconds spent trying. */
+};
+
+void hdlc_rec2_get_fix_stats (int chan, struct hdlc_rec2_fix_stats_s *fs);
+
 /* Provided by the top level application to process a complete frame. */
 
 void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alevel_t level, retry_t retries, char *spectrum);
@@ -0,0 +1,488 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2016  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      heard.c
+ *
+ * Purpose:   	Keep track of stations heard on each radio channel.
+ *
+ * Description:	Every frame received over the radio is passed along here
+ *		so we can remember when each station was first and last heard,
+ *		how many frames we got, the audio level, the digipeater path
+ *		used, and the most recent position.
+ *
+ *		This is used for the AGW network protocol 'H' request and
+ *		is available to other parts of the application with the
+ *		snapshot and lookup functions.
+ *
+ *		The update happens for every received frame so it must be fast.
+ *		Each channel has a hash table indexed by the source callsign-SSID,
+ *		with the same least recently used limit as the telemetry metadata.
+ *		See lru_table.c.  The LRU list also gives us the
+ *		"most recently heard first" order for the snapshot for free.
+ *
+ *---------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#include "direwolf.h"
+#include "ax25_pad.h"
+#include "latlong.h"			// for G_UNKNOWN
+#include "textcolor.h"
+#include "heard.h"
+#include "lru_table.h"
+
+
+#define MAGIC1  0xa53333a5			/* For checking storage allocation problems. */
+#define MAGIC2  0xa54444a5
+
+
+struct h_station_s {
+	struct lru_node_s node;			/* Hash and LRU links.  Key is callsign. */
+						/* Must be first. */
+	int magic1;
+
+	struct heard_s h;			/* Information handed out to others. */
+
+	int magic2;
+};
+
+
+/*
+ * One table for each radio channel.
+ */
+
+struct h_table_s {
+
+	struct lru_table_s lru;			/* Stations, set up by heard_init. */
+
+	unsigned long updates;			/* Number of frames processed. */
+};
+
+static struct h_table_s h_table[MAX_CHANS];
+
+static int h_max_stations = 0;			/* Limit on number of entries for each channel. */
+						/* 0 means heard_init has not been called yet. */
+
+static dw_mutex_t h_mutex;			/* Updated by receive thread, read by */
+						/* AGW network server threads. */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        heard_init
+ *
+ * Purpose:     Set up the heard station storage.
+ *
+ * Inputs:	max_stations	- Maximum number of stations to remember
+ *				  for each channel.  0 for default.
+ *
+ * Description:	The main application calls this once at start up,
+ *		before any other threads are created.
+ *
+ *--------------------------------------------------------------------*/
+
+void heard_init (int max_stations)
+{
+	int chan;
+
+	if (h_max_stations != 0) {
+	  return;		/* Only once. */
+	}
+
+	if (max_stations < HEARD_MIN_STATIONS || max_stations > HEARD_MAX_STATIONS) {
+	  max_stations = HEARD_DEFAULT_STATIONS;
+	}
+
+	memset (h_table, 0, sizeof(h_table));
+
+	for (chan = 0; chan < MAX_CHANS; chan++) {
+	  lru_table_init (&(h_table[chan].lru), max_stations);
+	}
+
+	dw_mutex_init (&h_mutex);
+
+	h_max_stations = max_stations;
+
+} /* end heard_init */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        h_find
+ *
+ * Purpose:     Find entry for station on a channel.
+ *
+ * Inputs:	t	- Table for the channel.
+ *		call	- Callsign with optional SSID.
+ *		h	- Hash of callsign.
+ *
+ * Returns:	Pointer to entry or NULL if not found.
+ *
+ * Description:	Caller must hold h_mutex.
+ *
+ *--------------------------------------------------------------------*/
+
+static struct h_station_s * h_find (struct h_table_s *t, char *call, unsigned int h)
+{
+	struct h_station_s *p;
+
+	p = (struct h_station_s *) lru_table_find (&(t->lru), call, h);
+	if (p != NULL) {
+	  assert (p->magic1 == MAGIC1);
+	  assert (p->magic2 == MAGIC2);
+	}
+	return (p);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        heard_update
+ *
+ * Purpose:     Remember that we heard a station.
+ *
+ * Inputs:	chan	- Radio channel where heard.
+ *
+ *		pp	- Packet object.  The source address is the key.
+ *
+ *		alevel	- Audio level.
+ *
+ *		lat,lon	- Position if decoded from the packet, otherwise G_UNKNOWN.
+ *			  The previous position is kept when unknown.
+ *
+ * Description:	This is called for every frame received from the radio
+ *		so keep it quick.  Nothing here allocates memory after
+ *		the table has filled up.
+ *
+ *--------------------------------------------------------------------*/
+
+void heard_update (int chan, packet_t pp, alevel_t alevel, double lat, double lon)
+{
+	char call[AX25_MAX_ADDR_LEN];
+	struct h_table_s *t;
+	struct h_station_s *p;
+	unsigned int h;
+	int num_addr;
+	int n;
+	time_t now;
+
+	assert (chan >= 0 && chan < MAX_CHANS);
+
+	if (h_max_stations == 0) {
+	  return;		/* Not initialized, e.g. atest. */
+	}
+
+	num_addr = ax25_get_num_addr(pp);
+	if (num_addr < AX25_SOURCE + 1) {
+	  return;		/* Not AX.25, no source address. */
+	}
+
+	ax25_get_addr_with_ssid(pp, AX25_SOURCE, call);
+	h = lru_table_hash (call);
+	now = time(NULL);
+	t = &(h_table[chan]);
+
+	dw_mutex_lock (&h_mutex);
+
+	t->updates++;
+
+	p = h_find (t, call, h);
+
+	if (p != NULL) {
+	  lru_table_touch (&(t->lru), &(p->node));
+	}
+	else {
+
+/*
+ * Not found.  The least recently heard is recycled if at the limit.
+ */
+	  p = (struct h_station_s *) lru_table_add (&(t->lru), call, h, sizeof (struct h_station_s));
+
+	  p->magic1 = MAGIC1;
+	  p->magic2 = MAGIC2;
+
+	  p->h.chan = chan;
+	  strlcpy (p->h.call, call, sizeof(p->h.call));
+	  p->h.first_heard = now;
+	  p->h.lat = G_UNKNOWN;
+	  p->h.lon = G_UNKNOWN;
+	}
+
+	p->h.last_heard = now;
+	p->h.count++;
+	p->h.alevel = alevel;
+	p->h.direct = (ax25_get_heard(pp) == AX25_SOURCE);
+
+/* Digipeater path with "*" after those used. */
+
+	p->h.via[0] = '\0';
+	for (n = AX25_REPEATER_1; n < num_addr; n++) {
+	  char digi[AX25_MAX_ADDR_LEN];
+
+	  ax25_get_addr_with_ssid(pp, n, digi);
+	  if (n > AX25_REPEATER_1) {
+	    strlcat (p->h.via, ",", sizeof(p->h.via));
+	  }
+	  strlcat (p->h.via, digi, sizeof(p->h.via));
+	  if (ax25_get_h(pp, n)) {
+	    strlcat (p->h.via, "*", sizeof(p->h.via));
+	  }
+	}
+
+	if (lat != G_UNKNOWN && lon != G_UNKNOWN) {
+	  p->h.lat = lat;
+	  p->h.lon = lon;
+	  p->h.pos_time = now;
+	}
+
+	dw_mutex_unlock (&h_mutex);
+
+} /* end heard_update */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        heard_snapshot
+ *
+ * Purpose:     Get a copy of the stations heard on a channel.
+ *
+ * Inputs:	chan		- Radio channel.
+ *		max_result	- Size of result array.
+ *
+ * Outputs:	result		- Stations, most recently heard first.
+ *
+ * Returns:	Number of stations placed in result.
+ *
+ * Description:	Information is copied so the caller can take its time
+ *		without blocking the receive thread.
+ *
+ *--------------------------------------------------------------------*/
+
+int heard_snapshot (int chan, struct heard_s *result, int max_result)
+{
+	struct h_station_s *p;
+	int n = 0;
+
+	if (chan < 0 || chan >= MAX_CHANS || h_max_stations == 0) {
+	  return (0);
+	}
+
+	dw_mutex_lock (&h_mutex);
+
+	for (p = (struct h_station_s *) h_table[chan].lru.lru_head; p != NULL && n < max_result; p = (struct h_station_s *) p->node.lru_next) {
+	  assert (p->magic1 == MAGIC1);
+	  assert (p->magic2 == MAGIC2);
+	  result[n++] = p->h;
+	}
+
+	dw_mutex_unlock (&h_mutex);
+
+	return (n);
+
+} /* end heard_snapshot */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        heard_lookup
+ *
+ * Purpose:     Get information about one station on a channel.
+ *
+ * Inputs:	chan	- Radio channel.
+ *		call	- Callsign with optional SSID.
+ *
+ * Outputs:	result	- Copy of information if found.
+ *
+ * Returns:	1 if found, 0 if not.
+ *
+ *--------------------------------------------------------------------*/
+
+int heard_lookup (int chan, char *call, struct heard_s *result)
+{
+	struct h_station_s *p;
+
+	if (chan < 0 || chan >= MAX_CHANS || h_max_stations == 0) {
+	  return (0);
+	}
+
+	dw_mutex_lock (&h_mutex);
+
+	p = h_find (&(h_table[chan]), call, lru_table_hash(call));
+	if (p != NULL) {
+	  *result = p->h;
+	}
+
+	dw_mutex_unlock (&h_mutex);
+
+	return (p != NULL);
+
+} /* end heard_lookup */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        heard_get_stats
+ *
+ * Purpose:     Obtain statistics about the heard station storage for a channel.
+ *
+ *--------------------------------------------------------------------*/
+
+void heard_get_stats (int chan, struct heard_stats_s *stats)
+{
+	memset (stats, 0, sizeof(struct heard_stats_s));
+
+	if (chan < 0 || chan >= MAX_CHANS || h_max_stations == 0) {
+	  return;
+	}
+
+	dw_mutex_lock (&h_mutex);
+
+	stats->entries = h_table[chan].lru.entries;
+	stats->max_stations = h_max_stations;
+	stats->evictions = h_table[chan].lru.evictions;
+	stats->updates = h_table[chan].updates;
+
+	dw_mutex_unlock (&h_mutex);
+
+} /* end heard_get_stats */
+
+
+
+#if HEARDTEST
+
+/*
+ * Unit test.  Also gives an idea of how many frames per second we can handle.
+ *
+ *	make heardtest
+ */
+
+static int errors = 0;
+
+static void check (int cond, char *what)
+{
+	if ( ! cond) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FAILED: %s\n", what);
+	  errors++;
+	}
+}
+
+int main (int argc, char *argv[])
+{
+	alevel_t alevel;
+	packet_t pp;
+	struct heard_s list[20];
+	struct heard_s one;
+	struct heard_stats_s st;
+	int n;
+	char text[200];
+	packet_t many[100];
+	clock_t start;
+	double elapsed;
+
+	memset (&alevel, 0, sizeof(alevel));
+	alevel.rec = 50;
+
+	heard_init (HEARD_MIN_STATIONS);
+
+	pp = ax25_from_text ("W1ABC-9>APRS,WB2OSZ-1*,WIDE2-1:!4237.14N/07120.83W-Test", 1);
+	heard_update (0, pp, alevel, 42.619, -71.347);
+	ax25_delete (pp);
+
+	alevel.rec = 60;
+	pp = ax25_from_text ("W1ABC-9>APRS:>Status only", 1);
+	heard_update (0, pp, alevel, G_UNKNOWN, G_UNKNOWN);
+	ax25_delete (pp);
+
+	pp = ax25_from_text ("N2XYZ>APRS,WIDE1*,WIDE2-1:>Other", 1);
+	heard_update (1, pp, alevel, G_UNKNOWN, G_UNKNOWN);
+	ax25_delete (pp);
+
+	check (heard_lookup (0, "W1ABC-9", &one) == 1, "lookup W1ABC-9");
+	check (one.count == 2, "count");
+	check (one.alevel.rec == 60, "alevel");
+	check (one.direct == 1, "direct");
+	check (strcmp(one.via, "") == 0, "via empty");
+	check (one.lat > 42.6 && one.lat < 42.7 && one.lon < -71.3 && one.lon > -71.4, "position kept");
+	check (heard_lookup (0, "N2XYZ", &one) == 0, "N2XYZ not on channel 0");
+	check (heard_lookup (1, "N2XYZ", &one) == 1, "N2XYZ on channel 1");
+	check (one.direct == 0, "digipeated");
+	check (strcmp(one.via, "WIDE1*,WIDE2-1") == 0, "via path");
+
+/* Fill up channel 0 and make sure the least recently heard is recycled. */
+
+	for (n = 0; n < HEARD_MIN_STATIONS; n++) {
+	  snprintf (text, sizeof(text), "K%dAAA>APRS:>test", n);
+	  pp = ax25_from_text (text, 1);
+	  heard_update (0, pp, alevel, G_UNKNOWN, G_UNKNOWN);
+	  ax25_delete (pp);
+	}
+
+	heard_get_stats (0, &st);
+	check (st.entries == HEARD_MIN_STATIONS, "entries at limit");
+	check (st.evictions == 1, "one eviction");
+	check (heard_lookup (0, "W1ABC-9", &one) == 0, "oldest recycled");
+
+	n = heard_snapshot (0, list, 20);
+	check (n == HEARD_MIN_STATIONS, "snapshot size");
+	check (strcmp(list[0].call, "K9AAA") == 0, "most recent first");
+	check (strcmp(list[n-1].call, "K0AAA") == 0, "least recent last");
+
+/* Speed. */
+
+	for (n = 0; n < 100; n++) {
+	  snprintf (text, sizeof(text), "W%dXY-%d>APRS,WIDE1-1,WIDE2-1:>speed test", n, n % 16);
+	  many[n] = ax25_from_text (text, 1);
+	}
+
+	start = clock();
+	for (n = 0; n < 1000000; n++) {
+	  heard_update (2, many[n % 100], alevel, G_UNKNOWN, G_UNKNOWN);
+	}
+	elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	for (n = 0; n < 100; n++) {
+	  ax25_delete (many[n]);
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("%.0f updates per second.\n", elapsed > 0 ? 1000000. / elapsed : 0.);
+
+	if (errors) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\nheard test FAILED: %d errors.\n", errors);
+	  exit (EXIT_FAILURE);
+	}
+
+	text_color_set(DW_COLOR_REC);
+	dw_printf ("\nheard test passed.\n");
+	exit (EXIT_SUCCESS);
+}
+
+#endif
+
+/* end heard.c */
@@ -0,0 +1,77 @@
+
+
+/* heard.h */
+
+#ifndef HEARD_H
+#define HEARD_H 1
+
+#include <time.h>
+
+#include "ax25_pad.h"		/* for packet_t, alevel_t, AX25_MAX_ADDR_LEN */
+
+
+/*
+ * Limits for number of stations remembered on each channel.
+ */
+
+#define HEARD_MIN_STATIONS 10
+#define HEARD_DEFAULT_STATIONS 500
+#define HEARD_MAX_STATIONS 100000
+
+
+#define HEARD_VIA_LEN 80	/* Digipeater path, e.g. "W1ABC-1*,WIDE1*,WIDE2-1" */
+
+
+/*
+ * Copy of what we know about one station.
+ * This is what the snapshot function hands out so the
+ * caller does not need to worry about locking.
+ */
+
+struct heard_s {
+
+	int chan;			/* Radio channel where heard. */
+
+	char call[AX25_MAX_ADDR_LEN];	/* Source station with optional SSID. */
+
+	time_t first_heard;		/* When first heard since start up, or since */
+					/* the entry was last recycled. */
+	time_t last_heard;		/* Most recent time heard. */
+
+	int count;			/* Number of packets heard from the station. */
+
+	alevel_t alevel;		/* Audio level of most recent packet. */
+
+	int direct;			/* TRUE if the most recent packet was heard directly */
+					/* rather than through a digipeater. */
+
+	char via[HEARD_VIA_LEN];	/* Digipeater path of most recent packet. */
+					/* "*" after those that have been used.  Empty if none. */
+
+	double lat, lon;		/* Most recent position reported or G_UNKNOWN. */
+
+	time_t pos_time;		/* When the position was received.  0 if never. */
+};
+
+
+struct heard_stats_s {
+	int entries;			/* Number of stations currently stored on channel. */
+	int max_stations;		/* Limit before recycling least recently used. */
+	unsigned long evictions;	/* How many have been recycled. */
+	unsigned long updates;		/* Total number of packets processed. */
+};
+
+
+void heard_init (int max_stations);
+
+void heard_update (int chan, packet_t pp, alevel_t alevel, double lat, double lon);
+
+int heard_snapshot (int chan, struct heard_s *result, int max_result);
+
+int heard_lookup (int chan, char *call, struct heard_s *result);
+
+void heard_get_stats (int chan, struct heard_stats_s *stats);
+
+#endif
+
+/* end heard.h */
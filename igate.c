@@ -1462,6 +1462,60 @@ static void * satgate_delay_thread (void *arg)
 } /* end satgate_delay_thread */
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        tx_header
+ *
+ * Purpose:     Get the addresses, control, and protocol id for third
+ *		party packets we transmit on given channel.
+ *
+ * Inputs:	chan	- Radio channel for transmitting.
+ *
+ * Outputs:	frame	- Beginning of frame.  It's the same for every
+ *			  packet so it is built only once.
+ *
+ * Returns:	Number of bytes or -1 if my call or the via path,
+ *		from the configuration, are not valid.
+ *
+ * Description:	This is used only by the igate_recv_thread so there
+ *		is no need to worry about more than one thread.
+ *
+ *--------------------------------------------------------------------*/
+
+static int tx_header (int chan, unsigned char *frame)
+{
+	static unsigned char header[MAX_CHANS][AX25_MAX_ADDRS*7+2];
+	static int header_len[MAX_CHANS];
+
+	assert (chan >= 0 && chan < MAX_CHANS);
+
+	if (header_len[chan] == 0) {
+	  char text[AX25_MAX_ADDRS*(AX25_MAX_ADDR_LEN+1)+2];
+	  unsigned char temp[AX25_MAX_PACKET_LEN];
+	  packet_t pp;
+
+	  snprintf (text, sizeof(text), "%s>%s%d%d%s:",
+				save_audio_config_p->achan[chan].mycall,
+				APP_TOCALL, MAJOR_VERSION, MINOR_VERSION,
+				save_igate_config_p->tx_via);
+
+	  pp = ax25_from_text (text, 1);
+	  if (pp == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Tx IGate: Invalid call or via path \"%s\"\n", text);
+	    return (-1);
+	  }
+	  header_len[chan] = ax25_pack (pp, temp);
+	  memcpy (header[chan], temp, header_len[chan]);
+	  ax25_delete (pp);
+	}
+
+	memcpy (frame, header[chan], header_len[chan]);
+	return (header_len[chan]);
+
+} /* end tx_header */
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        xmit_packet
@@ -1494,8 +1548,10 @@ static void * satgate_delay_thread (void *arg)
 static void xmit_packet (char *message, int to_chan)
 {
 	packet_t pp3;
+	char src[AX25_MAX_ADDR_LEN];
+	char dest[AX25_MAX_ADDR_LEN];
 	char payload[AX25_MAX_PACKET_LEN];	/* what is max len? */
-	char *pinfo = NULL;
+	unsigned char *pinfo = NULL;
 	int info_len;
 
 	assert (to_chan >= 0 && to_chan < MAX_CHANS);
@@ -1542,57 +1598,51 @@ static void xmit_packet (char *message, int to_chan)
 
 
 /*
- * Remove the VIA path.
+ * Build the third party header from the addresses we already have,
+ * replacing the VIA path with TCPIP and my call, marked as used.
  *
  * For example, we might get something like this from the server.
  *	K1USN-1>APWW10,TCPIP*,qAC,N5JXS-F1:T#479,100,048,002,500,000,10000000<0x0d><0x0a>
  *
  * We want to reduce it to this before wrapping it as third party traffic.
- *	K1USN-1>APWW10:T#479,100,048,002,500,000,10000000<0x0d><0x0a>
- */
-
-	while (ax25_get_num_repeaters(pp3) > 0) {
-	  ax25_remove_addr (pp3, AX25_REPEATER_1);
-	}
-
-
-/* 
- * Replace the VIA path with TCPIP and my call.
- * Mark my call as having been used.
- */
-	ax25_set_addr (pp3, AX25_REPEATER_1, "TCPIP");
-	ax25_set_h (pp3, AX25_REPEATER_1);
-	ax25_set_addr (pp3, AX25_REPEATER_2, save_audio_config_p->achan[to_chan].mycall);
-	ax25_set_h (pp3, AX25_REPEATER_2);
-
-/*
- * Convert to text representation.
+ *	K1USN-1>APWW10,TCPIP,WB2OSZ-1*:T#479,100,048,002,500,000,10000000<0x0d><0x0a>
+ *
+ * This used to be done by editing the packet object, formatting it
+ * as text again, and then parsing the whole thing a second time.
  */
-	memset (payload, 0, sizeof(payload));
+	ax25_get_addr_with_ssid (pp3, AX25_SOURCE, src);
+	ax25_get_addr_with_ssid (pp3, AX25_DESTINATION, dest);
+	info_len = ax25_get_info (pp3, &pinfo);
 
-	ax25_format_addrs (pp3, payload);
-	info_len = ax25_get_info (pp3, (unsigned char **)(&pinfo));
-	(void)(info_len);
-	strlcat (payload, pinfo, sizeof(payload));
+	snprintf (payload, sizeof(payload), "%s>%s,TCPIP,%s*:", src, dest, save_audio_config_p->achan[to_chan].mycall);
 #if DEBUGx
 	text_color_set(DW_COLOR_DEBUG);
-	dw_printf ("Tx IGate: payload=%s\n", payload);
+	dw_printf ("Tx IGate: payload=%s%s\n", payload, pinfo);
 #endif
 	
 /*
  * Encapsulate for sending over radio if no reason to drop it.
+ * The frame is put together directly from our own header, which
+ * doesn't change, the third party header, and the original information.
  */
 	if (ig_to_tx_allow (pp3, to_chan)) {
-	  char radio [500];
-	  packet_t pradio;
+	  unsigned char frame[AX25_MAX_PACKET_LEN];
+	  int hlen, plen;
+	  packet_t pradio = NULL;
 
-	  snprintf (radio, sizeof(radio), "%s>%s%d%d%s:}%s",
-				save_audio_config_p->achan[to_chan].mycall,
-				APP_TOCALL, MAJOR_VERSION, MINOR_VERSION,
-				save_igate_config_p->tx_via,
-				payload);
+	  hlen = tx_header (to_chan, frame);
+	  plen = strlen(payload);
+
+	  if (hlen > 0 && hlen + 1 + plen + info_len <= AX25_MAX_PACKET_LEN) {
+	    alevel_t alevel;
 
-	  pradio = ax25_from_text (radio, 1);
+	    frame[hlen] = '}';
+	    memcpy (frame + hlen + 1, payload, plen);
+	    memcpy (frame + hlen + 1 + plen, pinfo, info_len);
+
+	    memset (&alevel, 0xff, sizeof(alevel));
+	    pradio = ax25_from_frame (frame, hlen + 1 + plen + info_len, alevel);
+	  }
 
 	  /* Oops.  Didn't have a check for NULL here. */
 	  /* Could this be the cause of rare and elusive crashes in 1.2? */
@@ -1602,12 +1652,18 @@ static void xmit_packet (char *message, int to_chan)
 	    stats_tx_igate_packets++;
 
 #if ITEST
+	    char radio [AX25_MAX_PACKET_LEN+100];
+	    unsigned char *rinfo;
+
+	    ax25_format_addrs (pradio, radio);
+	    (void) ax25_get_info (pradio, &rinfo);
+	    strlcat (radio, (char*)rinfo, sizeof(radio));
 	    text_color_set(DW_COLOR_XMIT);
 	    dw_printf ("Xmit: %s\n", radio);
 	    ax25_delete (pradio);
 #else
 	    /* This consumes packet so don't reference it again! */
-	    tq_append (to_chan, TQ_PRIO_1_LO, pradio);
+	    tq_append (to_chan, TQ_PRIO_1_LO, TQ_SRC_IGATE, pradio);
 #endif
 	    stats_rf_xmit_packets++;
 	    ig_to_tx_remember (pp3, save_igate_config_p->tx_chan, 0);	// correct. version before encapsulating it.
@@ -1615,9 +1671,8 @@ static void xmit_packet (char *message, int to_chan)
 	  else {
 	    text_color_set(DW_COLOR_ERROR);
 	    dw_printf ("Received invalid packet from IGate.\n");
-	    dw_printf ("%s\n", payload);	
+	    dw_printf ("%s%s\n", payload, pinfo);	
 	    dw_printf ("Will not attempt to transmit third party packet.\n");
-	    dw_printf ("%s\n", radio);	
 	  }
 
 	}
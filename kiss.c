@@ -808,13 +808,19 @@ void kiss_send_rec_packet (int chan, unsigned char *fbuf,  int flen)
  *
  *--------------------------------------------------------------------*/
 
-/* Return one byte (value 0 - 255) or terminate thread on error. */
+/* 
+ * Read whatever is available, up to maxlen bytes, into buf.
+ * Returns number of bytes or terminates thread on error.
+ *
+ * Originally this read one byte at a time, which meant a system call
+ * for every byte when a client app sent a large amount of data.
+ * The Windows version still reads one byte at a time because a larger 
+ * count would wait until the whole amount arrived.
+ */
 
 
-static int kiss_get (/* MYFDTYPE fd*/ void )
+static int kiss_get (unsigned char *buf, int maxlen)
 {
-	unsigned char ch;
-
 #if __WIN32__		/* Native Windows version. */
 
 	DWORD n;	
@@ -834,7 +840,7 @@ static int kiss_get (/* MYFDTYPE fd*/ void )
 
   	while (n == 0) {
 
-	  if ( ! ReadFile (nullmodem_fd, &ch, 1, &n, &ov_rd)) 
+	  if ( ! ReadFile (nullmodem_fd, buf, 1, &n, &ov_rd)) 
 	  {
 	    int err1 = GetLastError();
 
@@ -887,9 +893,9 @@ static int kiss_get (/* MYFDTYPE fd*/ void )
 
 	while ( n == 0 ) {
 
-	  n = read(pt_master_fd, &ch, (size_t)1);
+	  n = read(pt_master_fd, buf, (size_t)maxlen);
 
-	  if (n != 1) {
+	  if (n <= 0) {
 
 	    text_color_set(DW_COLOR_ERROR);
 	    dw_printf ("\nError receiving kiss message from client application.  Closing %s.\n\n", pt_slave_name);
@@ -915,10 +921,14 @@ static int kiss_get (/* MYFDTYPE fd*/ void )
 
 #if DEBUGx
 	text_color_set(DW_COLOR_DEBUG);
-	dw_printf ("kiss_get(%d) returns 0x%02x\n", fd, ch);
+	dw_printf ("kiss_get() returns %d bytes\n", (int)n);
 #endif
 
 #if DEBUG9
+	int i;
+
+	for (i = 0; i < n; i++) {
+	unsigned char ch = buf[i];
 	fprintf (log_fp, "%02x %c %c", ch, 
 			isprint(ch) ? ch : '.' , 
 			(isupper(ch>>1) || isdigit(ch>>1) || (ch>>1) == ' ') ? (ch>>1) : '.');
@@ -930,8 +940,9 @@ static int kiss_get (/* MYFDTYPE fd*/ void )
 	if (ch == '\n') fprintf (log_fp, "  LF");
 	fprintf (log_fp, "\n");
 	if (ch == FEND) fflush (log_fp);
+	}
 #endif
-	return (ch);
+	return ((int)n);
 }
 
 
@@ -939,7 +950,8 @@ static int kiss_get (/* MYFDTYPE fd*/ void )
 
 static THREAD_F kiss_listen_thread (void *arg)
 {
-	unsigned char ch;
+	unsigned char buf[KISS_READ_SIZE];
+	int n;
 			
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
@@ -948,8 +960,8 @@ static THREAD_F kiss_listen_thread (void *arg)
 
 
 	while (1) {
-	  ch = kiss_get();
-	  kiss_rec_byte (&kf, ch, kiss_debug, kiss_send_rec_packet);
+	  n = kiss_get (buf, sizeof(buf));
+	  kiss_rec_bytes (&kf, buf, n, kiss_debug, kiss_send_rec_packet);
 	}
 
 #if __WIN32__
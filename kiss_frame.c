@@ -98,6 +98,32 @@ void text_color_set (dw_color_t c)
 	return;
 }
 
+void hex_dump (unsigned char *p, int len)
+{
+	return;
+}
+
+/* Instead of the real thing, keep track of what we got so the different ways can be compared. */
+
+static int test_msg_count;
+static unsigned int test_msg_hash;
+
+static void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug)
+{
+	int k;
+
+	test_msg_count++;
+	for (k = 0; k < kiss_len; k++) {
+	  test_msg_hash = test_msg_hash * 31 + kiss_msg[k];
+	}
+	test_msg_hash = test_msg_hash * 31 + kiss_len;
+}
+
+static void test_sendfun (int chan, unsigned char *b, int len)
+{
+	return;
+}
+
 #endif
 
 
@@ -211,10 +237,8 @@ static int kiss_unwrap (unsigned char *in, int ilen, unsigned char *out)
 {
 	int olen;
 	int j;
-	int escaped_mode;
 
 	olen = 0;
-	escaped_mode = 0;
 
 	if (ilen < 2) {
 	  /* Need at least the "type indicator" byte and FEND. */
@@ -239,33 +263,51 @@ static int kiss_unwrap (unsigned char *in, int ilen, unsigned char *out)
 	  j = 0;
 	}
 
-	for ( ; j<ilen; j++) {
+/*
+ * Copy everything up to the next FESC at once rather than
+ * looking at one byte at a time.
+ */
+	while (j < ilen) {
+	  unsigned char *esc;
+	  unsigned char *p;
+	  int n;
 
-	  if (in[j] == FEND) {
+	  esc = memchr (in + j, FESC, ilen - j);
+	  n = (esc != NULL ? (int)(esc - in) : ilen) - j;
+
+	  for (p = memchr (in + j, FEND, n); p != NULL; p = memchr (p + 1, FEND, in + j + n - (p + 1))) {
 	    text_color_set(DW_COLOR_ERROR);
 	    dw_printf ("KISS frame should not have FEND in the middle.\n");
 	  }
 
-	  if (escaped_mode) {
+	  memcpy (out + olen, in + j, n);
+	  olen += n;
+	  j += n;
 
-	    if (in[j] == TFESC) {
-	      out[olen++] = FESC;
-	    }
-	    else if (in[j] == TFEND) {
-	      out[olen++] = FEND;
-	    }
-	    else {
-	      text_color_set(DW_COLOR_ERROR);
-	      dw_printf ("KISS protocol error.  Found 0x%02x after FESC.\n", in[j]);
-	    }
-	    escaped_mode = 0;
+	  if (esc == NULL) {
+	    break;
 	  }
-	  else if (in[j] == FESC) {
-	    escaped_mode = 1;
+
+	  j++;		/* Skip over FESC. */
+	  if (j >= ilen) {
+	    break;
+	  }
+
+	  if (in[j] == TFESC) {
+	    out[olen++] = FESC;
+	  }
+	  else if (in[j] == TFEND) {
+	    out[olen++] = FEND;
 	  }
 	  else {
-	    out[olen++] = in[j];
+	    if (in[j] == FEND) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("KISS frame should not have FEND in the middle.\n");
+	    }
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("KISS protocol error.  Found 0x%02x after FESC.\n", in[j]);
 	  }
+	  j++;
 	}
 	
 	return (olen);
@@ -273,10 +315,6 @@ static int kiss_unwrap (unsigned char *in, int ilen, unsigned char *out)
 }  /* end kiss_unwrap */
 
 
-#ifndef KISSTEST
-
-
-
 /*-------------------------------------------------------------------
  *
  * Name:        kiss_rec_byte 
@@ -433,6 +471,71 @@ void kiss_rec_byte (kiss_frame_t *kf, unsigned char ch, int debug, void (*sendfu
 	      	    
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        kiss_rec_bytes 
+ *
+ * Purpose:     Process a block of bytes from a KISS client app.
+ *
+ * Inputs:	kf	- Current state of building a frame.
+ *		buf	- Bytes from the input stream.
+ *		len	- Number of bytes.
+ *		debug	- Activates debug output.
+ *		sendfun	- Function to send something to the client application.
+ *
+ * Outputs:	kf	- Current state is updated.
+ *
+ * Description:	Same result as calling kiss_rec_byte for each byte but 
+ *		much faster for large amounts of data.
+ *		While collecting a frame, everything up to the next FEND
+ *		is copied at once.  The FEND, and anything outside of a frame,
+ *		goes thru kiss_rec_byte so the processing is exactly the same.
+ *
+ *-----------------------------------------------------------------*/
+
+void kiss_rec_bytes (kiss_frame_t *kf, unsigned char *buf, int len, int debug, void (*sendfun)(int,unsigned char*,int)) 
+{
+	unsigned char *p = buf;
+	unsigned char *end = buf + len;
+
+	while (p < end) {
+
+	  if (kf->state == KS_COLLECTING) {
+	    unsigned char *fend;
+	    int n, room;
+
+	    fend = memchr (p, FEND, end - p);
+	    n = (fend != NULL ? fend : end) - p;
+
+	    room = MAX_KISS_LEN - kf->kiss_len;
+	    if (n > room) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("KISS message exceeded maximum length.\n");
+	      memcpy (kf->kiss_msg + kf->kiss_len, p, room);
+	      kf->kiss_len += room;
+	    }
+	    else {
+	      memcpy (kf->kiss_msg + kf->kiss_len, p, n);
+	      kf->kiss_len += n;
+	    }
+	    p += n;
+
+	    if (fend != NULL) {
+	      kiss_rec_byte (kf, *p++, debug, sendfun);
+	    }
+	  }
+	  else {
+	    kiss_rec_byte (kf, *p++, debug, sendfun);
+	  }
+	}
+
+} /* end kiss_rec_bytes */
+
+
+#ifndef KISSTEST
+
+
+
 
 /*-------------------------------------------------------------------
  *
@@ -506,10 +609,10 @@ static void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug)
 
 	      if (ax25_get_num_repeaters(pp) >= 1 &&
 	      		ax25_get_h(pp,AX25_REPEATER_1)) {
-	        tq_append (port, TQ_PRIO_0_HI, pp);
+	        tq_append (port, TQ_PRIO_0_HI, TQ_SRC_KISS, pp);
 	      }
 	      else {
-	        tq_append (port, TQ_PRIO_1_LO, pp);
+	        tq_append (port, TQ_PRIO_1_LO, TQ_SRC_KISS, pp);
 	      }
 	    }
 	    break;
@@ -570,6 +673,9 @@ static void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug)
 } /* end kiss_process_msg */
 
 
+#endif  /* ifndef KISSTEST */
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        kiss_debug_print 
@@ -618,9 +724,6 @@ void kiss_debug_print (fromto_t fromto, char *special, unsigned char *pmsg, int
 } /* end kiss_debug_print */
 
 
-#endif
-
-
 /* Quick unit test for encapsulate & unwrap */
 
 // $ gcc -DKISSTEST kiss_frame.c ; ./a
@@ -629,6 +732,86 @@ void kiss_debug_print (fromto_t fromto, char *special, unsigned char *pmsg, int
 
 #if KISSTEST
 
+#include <time.h>
+
+/*
+ * Compare kiss_rec_byte and kiss_rec_bytes for a stream of frames with
+ * noise between them and data containing bytes which need escapes.
+ * Also measure how fast each can process the stream.
+ */
+
+#define TEST_FRAMES 20000
+#define TEST_REPEAT 10
+
+static void kiss_rec_test (void)
+{
+	unsigned char *stream;
+	int slen;
+	int f, k, r, chunk;
+	unsigned char frame[300];
+	static kiss_frame_t kf;
+	int count1, count2;
+	unsigned int hash1, hash2;
+	clock_t start;
+	double t;
+
+	stream = malloc (TEST_FRAMES * (2 * sizeof(frame) + 20));
+	slen = 0;
+	srand (1);
+
+	for (f = 0; f < TEST_FRAMES; f++) {
+	  int flen = 20 + rand() % 250;
+
+	  frame[0] = 0;		/* Data frame, channel 0. */
+	  for (k = 1; k < flen; k++) {
+	    frame[k] = (rand() % 10 == 0) ? (rand() % 2 ? FEND : FESC) : rand() % 256;
+	  }
+	  slen += kiss_encapsulate (frame, flen, stream + slen);
+	  if (f % 100 == 0) {
+	    memcpy (stream + slen, "noise", 5);
+	    slen += 5;
+	  }
+	}
+
+	memset (&kf, 0, sizeof(kf));
+	test_msg_count = 0;
+	test_msg_hash = 0;
+	start = clock();
+	for (r = 0; r < TEST_REPEAT; r++) {
+	  for (k = 0; k < slen; k++) {
+	    kiss_rec_byte (&kf, stream[k], 0, test_sendfun);
+	  }
+	}
+	t = (double)(clock() - start) / CLOCKS_PER_SEC;
+	count1 = test_msg_count;
+	hash1 = test_msg_hash;
+	dw_printf ("kiss_rec_byte:  %d frames, %.1f MB/sec\n", count1, t > 0 ? (double)slen * TEST_REPEAT / t / 1e6 : 0.);
+
+	memset (&kf, 0, sizeof(kf));
+	test_msg_count = 0;
+	test_msg_hash = 0;
+	start = clock();
+	for (r = 0; r < TEST_REPEAT; r++) {
+	  /* Odd chunk sizes so frames get split across reads. */
+	  chunk = (r % 2) ? KISS_READ_SIZE : 997;
+	  for (k = 0; k < slen; k += chunk) {
+	    kiss_rec_bytes (&kf, stream + k, (slen - k) < chunk ? (slen - k) : chunk, 0, test_sendfun);
+	  }
+	}
+	t = (double)(clock() - start) / CLOCKS_PER_SEC;
+	count2 = test_msg_count;
+	hash2 = test_msg_hash;
+	dw_printf ("kiss_rec_bytes: %d frames, %.1f MB/sec\n", count2, t > 0 ? (double)slen * TEST_REPEAT / t / 1e6 : 0.);
+
+	free (stream);
+
+	assert (count1 == TEST_FRAMES * TEST_REPEAT);
+	assert (count2 == count1);
+	assert (hash2 == hash1);
+
+	dw_printf ("KISS receive test passed OK.\n");
+}
+
 
 main ()
 {
@@ -660,6 +843,9 @@ main ()
 	assert (memcmp(din, dout, 512) == 0);
 
 	dw_printf ("Quick KISS test passed OK.\n");
+
+	kiss_rec_test ();
+
 	exit (EXIT_SUCCESS);
 }
 
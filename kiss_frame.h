@@ -25,6 +25,8 @@ enum kiss_state_e {
 
 #define MAX_NOISE_LEN 100
 
+#define KISS_READ_SIZE 4096	/* Amount to read at once from client app. */
+
 typedef struct kiss_frame_s {
 	
 	enum kiss_state_e state;
@@ -45,6 +47,8 @@ void kiss_frame_init (struct audio_s *pa);
 int kiss_encapsulate (unsigned char *in, int ilen, unsigned char *out);
 
 void kiss_rec_byte (kiss_frame_t *kf, unsigned char ch, int debug, void (*sendfun)(int,unsigned char*,int)); 
+
+void kiss_rec_bytes (kiss_frame_t *kf, unsigned char *buf, int len, int debug, void (*sendfun)(int,unsigned char*,int)); 
  
 
 typedef enum fromto_e { FROM_CLIENT=0, TO_CLIENT=1 } fromto_t;
@@ -548,64 +548,6 @@ void kissnet_send_rec_packet (int chan, unsigned char *fbuf, int flen)
 
 
 
-/*-------------------------------------------------------------------
- *
- * Name:        read_from_socket
- *
- * Purpose:     Read from socket until we have desired number of bytes.
- *
- * Inputs:	fd		- file descriptor.
- *		ptr		- address where data should be placed.
- *		len		- desired number of bytes.
- *
- * Description:	Just a wrapper for the "read" system call but it should
- *		never return fewer than the desired number of bytes.
- *
- * 		Not really needed for KISS because we are dealing with
- *		a stream of bytes rather than message blocks.
- *
- *--------------------------------------------------------------------*/
-
-static int read_from_socket (int fd, char *ptr, int len)
-{
-	int got_bytes = 0;
-
-#if DEBUG
-	text_color_set(DW_COLOR_DEBUG);
-	dw_printf ("read_from_socket (%d, %p, %d)\n", fd, ptr, len);
-#endif
-	while (got_bytes < len) {
-	  int n;
-
-#if __WIN32__
-
-//TODO: any flags for send/recv?
-
-	  n = recv (fd, ptr + got_bytes, len - got_bytes, 0);
-#else
-	  n = read (fd, ptr + got_bytes, len - got_bytes);
-#endif
-
-#if DEBUG
-	  text_color_set(DW_COLOR_DEBUG);
-	  dw_printf ("read_from_socket: n = %d\n", n);
-#endif
-	  if (n <= 0) {
-	    return (n);
-	  }
-
-	  got_bytes += n;
-	}
-	assert (got_bytes >= 0 && got_bytes <= len);
-
-#if DEBUG
-	text_color_set(DW_COLOR_DEBUG);
-	dw_printf ("read_from_socket: return %d\n", got_bytes);
-#endif
-	return (got_bytes);
-}
-
-
 /*-------------------------------------------------------------------
  *
  * Name:        kissnet_listen_thread
@@ -623,12 +565,17 @@ static int read_from_socket (int fd, char *ptr, int len)
  *--------------------------------------------------------------------*/
 
 
-/* Return one byte (value 0 - 255) */
+/*
+ * Read whatever is available, up to maxlen bytes, into buf.
+ * Returns number of bytes.  Waits for client to connect if necessary.
+ *
+ * Originally this got one byte at a time which meant a system call
+ * for every byte when a client app sent a large amount of data.
+ */
 
 
-static int kiss_get (void)
+static int kiss_get (unsigned char *buf, int maxlen)
 {
-	unsigned char ch;
 	int n;
 
 	while (1) {
@@ -637,25 +584,31 @@ static int kiss_get (void)
 	    SLEEP_SEC(1);			/* Not connected.  Try again later. */
 	  }
 
-	  /* Just get one byte at a time. */
-
-	  n = read_from_socket (client_sock, (char *)(&ch), 1);
+#if __WIN32__
+	  n = recv (client_sock, (char *)buf, maxlen, 0);
+#else
+	  n = read (client_sock, buf, maxlen);
+#endif
 
-	  if (n == 1) {
+	  if (n > 0) {
 #if DEBUG9
-	    dw_printf (log_fp, "%02x %c %c", ch, 
+	    int i;
+	    for (i = 0; i < n; i++) {
+	      unsigned char ch = buf[i];
+	      fprintf (log_fp, "%02x %c %c", ch, 
 			isprint(ch) ? ch : '.' , 
 			(isupper(ch>>1) || isdigit(ch>>1) || (ch>>1) == ' ') ? (ch>>1) : '.');
-	    if (ch == FEND) fprintf (log_fp, "  FEND");
-	    if (ch == FESC) fprintf (log_fp, "  FESC");
-	    if (ch == TFEND) fprintf (log_fp, "  TFEND");
-	    if (ch == TFESC) fprintf (log_fp, "  TFESC");
-	    if (ch == '\r') fprintf (log_fp, "  CR");
-	    if (ch == '\n') fprintf (log_fp, "  LF");
-	    fprintf (log_fp, "\n");
-	    if (ch == FEND) fflush (log_fp);
+	      if (ch == FEND) fprintf (log_fp, "  FEND");
+	      if (ch == FESC) fprintf (log_fp, "  FESC");
+	      if (ch == TFEND) fprintf (log_fp, "  TFEND");
+	      if (ch == TFESC) fprintf (log_fp, "  TFESC");
+	      if (ch == '\r') fprintf (log_fp, "  CR");
+	      if (ch == '\n') fprintf (log_fp, "  LF");
+	      fprintf (log_fp, "\n");
+	      if (ch == FEND) fflush (log_fp);
+	    }
 #endif
-	    return(ch);	
+	    return (n);	
 	  }
 
           text_color_set(DW_COLOR_ERROR);
@@ -673,7 +626,8 @@ static int kiss_get (void)
 
 static void * kissnet_listen_thread (void *arg)
 {
-	unsigned char ch;
+	unsigned char buf[KISS_READ_SIZE];
+	int n;
 			
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
@@ -681,8 +635,8 @@ static void * kissnet_listen_thread (void *arg)
 #endif
 
 	while (1) {
-	  ch = kiss_get();
-	  kiss_rec_byte (&kf, ch, kiss_debug, kissnet_send_rec_packet);
+	  n = kiss_get (buf, sizeof(buf));
+	  kiss_rec_bytes (&kf, buf, n, kiss_debug, kissnet_send_rec_packet);
 	}  
 
 	return (NULL);	/* to suppress compiler warning. */
@@ -28,6 +28,12 @@
  *		unreadable, format, write separated properties into 
  *		CSV format for easy reading and later processing.
  *
+ *		Writing to a file, especially on a slow SD card, could
+ *		hold up the receive path.  Lines are put into a queue
+ *		and a separate thread takes care of the file.
+ *		Adding to the queue never waits.  If the queue fills up,
+ *		because the file can't keep up, records are dropped and
+ *		counted.
  *
  *------------------------------------------------------------------*/
 
@@ -42,6 +48,12 @@
 #include <unistd.h>
 #include <errno.h>
 
+#if __WIN32__
+#include <io.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
 
 #include "direwolf.h"
 #include "ax25_pad.h"
@@ -50,6 +62,48 @@
 #include "log.h"
 
 
+/*
+ * Queue of lines waiting to be written.
+ *
+ * Any thread can add to it without locking.  Each slot has a sequence
+ * number which tells whether it is free for the next writer or ready
+ * for the reader.  Only one thread at a time, holding log_mutex, takes
+ * lines out and writes them to the file.
+ */
+
+#define LOG_QUEUE_SIZE 256		/* Must be power of 2. */
+
+#define LOG_TEXT_SIZE 1024		/* Everything after chan & time. */
+
+static struct log_rec_s {
+	unsigned int seq;
+	int chan;
+	time_t now;
+	char text[LOG_TEXT_SIZE];
+} log_queue[LOG_QUEUE_SIZE];
+
+static unsigned int enq_pos;		/* Next slot for adding. */
+static unsigned int deq_pos;		/* Next slot for writing.  Protected by log_mutex. */
+
+static unsigned int log_dropped;	/* Records dropped because queue was full. */
+
+static dw_mutex_t log_mutex;		/* For the file and taking from queue. */
+
+#define LOG_WRITE_INTERVAL_MS 250	/* How often the writer thread checks queue. */
+
+#define LOG_SYNC_INTERVAL 15		/* Seconds between forcing data to the disk. */
+
+
+static void log_flush_queue (void);
+static void log_close (void);
+
+#if __WIN32__
+static unsigned __stdcall log_thread (void *arg);
+#else
+static void * log_thread (void *arg);
+#endif
+
+
 /*
  * CSV format needs quotes if value contains comma or quote.
  */
@@ -104,6 +158,7 @@ static void quote_for_csv (char *out, size_t outsize, const char *in) {
 static char g_log_dir[80];
 static FILE *g_log_fp;
 static char g_open_fname[20];
+static char g_log_buf[64*1024];		/* Big buffer so data goes out in large chunks. */
 
 
 void log_init (char *path) 
@@ -153,6 +208,43 @@ void log_init (char *path)
 	    strlcpy (g_log_dir, ".", sizeof(g_log_dir));
 	  }
 	}
+
+/*
+ * Start up thread to do the actual writing.
+ */
+	int j;
+
+	for (j = 0; j < LOG_QUEUE_SIZE; j++) {
+	  log_queue[j].seq = j;
+	}
+	enq_pos = 0;
+	deq_pos = 0;
+	log_dropped = 0;
+
+	dw_mutex_init (&log_mutex);
+
+#if __WIN32__
+	HANDLE log_th;
+
+	log_th = (HANDLE)_beginthreadex (NULL, 0, log_thread, NULL, 0, NULL);
+	if (log_th == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not create log file thread\n");
+	  strlcpy (g_log_dir, "", sizeof(g_log_dir));
+	  return;
+	}
+#else
+	pthread_t log_tid;
+	int e;
+
+	e = pthread_create (&log_tid, NULL, log_thread, NULL);
+	if (e != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror("Could not create log file thread");
+	  strlcpy (g_log_dir, "", sizeof(g_log_dir));
+	  return;
+	}
+#endif
 }
 
 
@@ -173,79 +265,49 @@ void log_init (char *path)
  *
  *		retries	- Amount of effort to get a good CRC.
  *
+ * Description:	The line is formatted and put in the queue.
+ *		The time is recorded here but converted to date and
+ *		file name later by the writer thread.
+ *
  *------------------------------------------------------------------*/
 
 void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_t retries)
 {
-	time_t now; 		// make 'now' a parameter so we can process historical data ???
-	char fname[20];
-	struct tm tm;
+	unsigned int pos;
+	struct log_rec_s *r;
 
 
 	if (strlen(g_log_dir) == 0) return;
 
-	// Generate the file name from current date, UTC.
-
-	now = time(NULL);
-	(void)gmtime_r (&now, &tm);	
-
-	// Microsoft doesn't recognize %F as equivalent to %Y-%m-%d
-
-	strftime (fname, sizeof(fname), "%Y-%m-%d.log", &tm);
-
-	// Close current file if name has changed
+	// Claim the next free slot in the queue.
 
-	if (g_log_fp != NULL && strcmp(fname, g_open_fname) != 0) {
-	  log_term ();
-	}
-
-	// Open for append if not already open.
-
-	if (g_log_fp == NULL) {
-	  char full_path[120];
-	  struct stat st;
-	  int already_there;
-
-	  strlcpy (full_path, g_log_dir, sizeof(full_path));
-#if __WIN32__
-	  strlcat (full_path, "\\", sizeof(full_path));
-#else
-	  strlcat (full_path, "/", sizeof(full_path));
-#endif
-	  strlcat (full_path, fname, sizeof(full_path));
-
-	  // See if it already exists.
-	  // This is used later to write a header if it did not exist already.
-
-	  already_there = stat(full_path,&st) == 0;
-
-	  text_color_set(DW_COLOR_INFO);
-	  dw_printf("Opening log file \"%s\".\n", fname);
+	pos = __atomic_load_n (&enq_pos, __ATOMIC_RELAXED);
+	while (1) {
+	  int diff;
 
-	  g_log_fp = fopen (full_path, "a");
+	  r = &(log_queue[pos & (LOG_QUEUE_SIZE - 1)]);
+	  diff = (int)(__atomic_load_n (&(r->seq), __ATOMIC_ACQUIRE) - pos);
 
-	  if (g_log_fp != NULL) {
-	    strlcpy (g_open_fname, fname, sizeof(g_open_fname));
+	  if (diff == 0) {
+	    if (__atomic_compare_exchange_n (&enq_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	      break;
+	    }
+	    // Someone else got it.  pos now has the new value.
 	  }
-	  else {
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf("Can't open log file \"%s\" for write.\n", full_path);
-	    dw_printf ("%s\n", strerror(errno));
-	    strlcpy (g_open_fname, "", sizeof(g_open_fname));
+	  else if (diff < 0) {
+	    // Full.  Writer isn't keeping up.  Don't wait for it.
+	    __atomic_add_fetch (&log_dropped, 1, __ATOMIC_RELAXED);
 	    return;
 	  }
-
-	  // Write a header suitable for importing into a spreadsheet
-	  // only if this will be the first line.
-	
-	  if ( ! already_there) {
-	    fprintf (g_log_fp, "chan,utime,isotime,source,heard,level,error,dti,name,symbol,latitude,longitude,speed,course,altitude,frequency,offset,tone,system,status,comment\n");
+	  else {
+	    pos = __atomic_load_n (&enq_pos, __ATOMIC_RELAXED);
 	  }
 	}
 
-	if (g_log_fp != NULL) {
+	r->chan = chan;
+	r->now = time(NULL);	// make 'now' a parameter so we can process historical data ???
 
-	  char itime[24];
+	{
 	  char heard[AX25_MAX_ADDR_LEN+1];
 	  int h;
 	  char stemp[256];
@@ -261,11 +323,6 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	  char alevel_text[32];
 
 
-
-	  // Microsoft doesn't recognize %T as equivalent to %H:%M:%S
-
-	  strftime (itime, sizeof(itime), "%Y-%m-%dT%H:%M:%SZ", &tm);
-
           /* Who are we hearing?   Original station or digipeater? */
 	  /* Similar code in direwolf.c.  Combine into one function? */
 
@@ -326,32 +383,200 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	  strlcpy (stone, "", sizeof(stone));  if (A->g_tone   != G_UNKNOWN) snprintf (stone, sizeof(stone), "%.1f", A->g_tone);
 	                       if (A->g_dcs    != G_UNKNOWN) snprintf (stone, sizeof(stone), "D%03o", A->g_dcs);
 
-	  fprintf (g_log_fp, "%d,%d,%s,%s,%s,%s,%d,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s\n", 
-			chan, (int)now, itime, 
+	  snprintf (r->text, sizeof(r->text), "%s,%s,%s,%d,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s", 
 			A->g_src, heard, alevel_text, (int)retries, sdti,
 			sname, ssymbol,
 			slat, slon, sspd, scse, salt, 
 			sfreq, soffs, stone, 
 			smfr, sstatus, stelemetry, scomment);
+	}
+
+	// Now the writer can have it.
+
+	__atomic_store_n (&(r->seq), pos + 1, __ATOMIC_RELEASE);
+
+} /* end log_write */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	log_thread
+ *
+ * Purpose:	Periodically write whatever is in the queue.
+ *
+ *------------------------------------------------------------------*/
+
+#if __WIN32__
+static unsigned __stdcall log_thread (void *arg)
+#else
+static void * log_thread (void *arg)
+#endif
+{
+	while (1) {
+
+	  SLEEP_MS (LOG_WRITE_INTERVAL_MS);
 
+	  dw_mutex_lock (&log_mutex);
+	  log_flush_queue ();
+	  dw_mutex_unlock (&log_mutex);
+	}
+
+	return (0);	/* Unreachable but avoid compiler warning. */
+
+} /* end log_thread */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	log_flush_queue
+ *
+ * Purpose:	Write everything in the queue to the file.
+ *		Caller must hold log_mutex.
+ *
+ * Description:	Lines accumulate in a large stdio buffer and are
+ *		flushed once for the whole batch.  Every so often
+ *		the data is forced out to the disk.  A new file is
+ *		started when the date, UTC, changes.
+ *
+ *------------------------------------------------------------------*/
+
+static void log_flush_queue (void)
+{
+	static time_t last_sync = 0;
+	static int need_sync = 0;
+	static unsigned int reported = 0;
+	static time_t open_day = -1;		/* Day number, UTC, of g_open_fname. */
+	unsigned int dropped;
+	int count = 0;
+	time_t now;
+
+	while (1) {
+	  struct log_rec_s *r = &(log_queue[deq_pos & (LOG_QUEUE_SIZE - 1)]);
+	  struct tm tm;
+	  char itime[24];
+
+	  if ((int)(__atomic_load_n (&(r->seq), __ATOMIC_ACQUIRE) - (deq_pos + 1)) < 0) {
+	    break;	// Empty or next one not finished yet.
+	  }
+
+	  (void)gmtime_r (&(r->now), &tm);
+
+	  // Close current file if date has changed.
+
+	  if (g_log_fp != NULL && r->now / 86400 != open_day) {
+	    char fname[20];
+
+	    // Microsoft doesn't recognize %F as equivalent to %Y-%m-%d
+
+	    strftime (fname, sizeof(fname), "%Y-%m-%d.log", &tm);
+	    if (strcmp(fname, g_open_fname) != 0) {
+	      log_close ();
+	    }
+	  }
+
+	  // Open for append if not already open.
+
+	  if (g_log_fp == NULL) {
+	    char fname[20];
+	    char full_path[120];
+	    struct stat st;
+	    int already_there;
+
+	    strftime (fname, sizeof(fname), "%Y-%m-%d.log", &tm);
+
+	    strlcpy (full_path, g_log_dir, sizeof(full_path));
+#if __WIN32__
+	    strlcat (full_path, "\\", sizeof(full_path));
+#else
+	    strlcat (full_path, "/", sizeof(full_path));
+#endif
+	    strlcat (full_path, fname, sizeof(full_path));
+
+	    // See if it already exists.
+	    // This is used later to write a header if it did not exist already.
+
+	    already_there = stat(full_path,&st) == 0;
+
+	    text_color_set(DW_COLOR_INFO);
+	    dw_printf("Opening log file \"%s\".\n", fname);
+
+	    g_log_fp = fopen (full_path, "a");
+
+	    if (g_log_fp != NULL) {
+	      setvbuf (g_log_fp, g_log_buf, _IOFBF, sizeof(g_log_buf));
+	      strlcpy (g_open_fname, fname, sizeof(g_open_fname));
+	      open_day = r->now / 86400;
+
+	      // Write a header suitable for importing into a spreadsheet
+	      // only if this will be the first line.
+	
+	      if ( ! already_there) {
+	        fprintf (g_log_fp, "chan,utime,isotime,source,heard,level,error,dti,name,symbol,latitude,longitude,speed,course,altitude,frequency,offset,tone,system,status,comment\n");
+	      }
+	    }
+	    else {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf("Can't open log file \"%s\" for write.\n", full_path);
+	      dw_printf ("%s\n", strerror(errno));
+	      strlcpy (g_open_fname, "", sizeof(g_open_fname));
+	    }
+	  }
+
+	  if (g_log_fp != NULL) {
+
+	    // Microsoft doesn't recognize %T as equivalent to %H:%M:%S
+
+	    strftime (itime, sizeof(itime), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+	    fprintf (g_log_fp, "%d,%d,%s,%s\n", r->chan, (int)(r->now), itime, r->text);
+	    count++;
+	  }
+
+	  // Give the slot back for reuse.
+
+	  __atomic_store_n (&(r->seq), deq_pos + LOG_QUEUE_SIZE, __ATOMIC_RELEASE);
+	  deq_pos++;
+	}
+
+	if (count > 0) {
 	  fflush (g_log_fp);
+	  need_sync = 1;
 	}
 
-} /* end log_write */
+	now = time(NULL);
+	if (need_sync && g_log_fp != NULL && now - last_sync >= LOG_SYNC_INTERVAL) {
+#if __WIN32__
+	  _commit (_fileno(g_log_fp));
+#else
+	  fsync (fileno(g_log_fp));
+#endif
+	  last_sync = now;
+	  need_sync = 0;
+	}
+
+	dropped = __atomic_load_n (&log_dropped, __ATOMIC_RELAXED);
+	if (dropped != reported) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Log file can't keep up.  %u records dropped so far.\n", dropped);
+	  reported = dropped;
+	}
+
+} /* end log_flush_queue */
 
 
 
 /*------------------------------------------------------------------
  *
- * Function:	log_term
+ * Function:	log_close
  *
  * Purpose:	Close any open log file.
- *		Called when exiting or when date changes.
+ *		Called when date changes.  Caller must hold log_mutex.
  *
  *------------------------------------------------------------------*/
 
-
-void log_term (void)
+static void log_close (void)
 {
 	if (g_log_fp != NULL) {
 
@@ -364,6 +589,40 @@ void log_term (void)
 	  strlcpy (g_open_fname, "", sizeof(g_open_fname));
 	}
 
+} /* end log_close */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	log_term
+ *
+ * Purpose:	Write anything remaining in the queue and close 
+ *		the log file.  Called when exiting.
+ *
+ * Description:	This is called from the signal handler which might
+ *		have interrupted the writer thread while it had
+ *		the lock.  Don't wait forever for it.
+ *
+ *------------------------------------------------------------------*/
+
+
+void log_term (void)
+{
+	int n;
+
+	if (strlen(g_log_dir) == 0) return;
+
+	for (n = 0; n < 20; n++) {
+	  if (dw_mutex_try_lock (&log_mutex)) {
+	    log_flush_queue ();
+	    log_close ();
+	    dw_mutex_unlock (&log_mutex);
+	    return;
+	  }
+	  SLEEP_MS (50);
+	}
+
 } /* end log_term */
 
 
@@ -0,0 +1,237 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2016  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      lru_table.c
+ *
+ * Purpose:   	Hash table of stations with a limit on the number of entries.
+ *
+ * Description:	Used for the telemetry metadata and the heard station list.
+ *		Both need quick lookup by callsign-SSID and must not grow
+ *		forever when an IGate sees thousands of stations.
+ *
+ *		Entries are also kept in least recently used order.  When the
+ *		limit is reached, the entry not referenced for the longest time
+ *		is recycled for the new one.
+ *
+ *		The caller's structure starts with a struct lru_node_s.
+ *		There is no locking here.  The caller must provide it.
+ *
+ *---------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "direwolf.h"
+#include "lru_table.h"
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        lru_table_init
+ *
+ * Purpose:     Set up an empty table.
+ *
+ * Inputs:	t		- Table to initialize.
+ *		max_entries	- Maximum number of entries before recycling.
+ *
+ *--------------------------------------------------------------------*/
+
+void lru_table_init (struct lru_table_s *t, int max_entries)
+{
+	unsigned int nbuckets;
+
+	memset (t, 0, sizeof(struct lru_table_s));
+
+/* Keep the average chain length to one or less. */
+
+	nbuckets = 64;
+	while (nbuckets < (unsigned int)max_entries) {
+	  nbuckets <<= 1;
+	}
+	t->hash_mask = nbuckets - 1;
+	t->hash = calloc (nbuckets, sizeof (struct lru_node_s *));
+	assert (t->hash != NULL);
+
+	t->max_entries = max_entries;
+
+} /* end lru_table_init */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        lru_table_hash
+ *
+ * Purpose:     Hash function for station name.
+ *
+ *--------------------------------------------------------------------*/
+
+unsigned int lru_table_hash (char *key)
+{
+	unsigned int h = 5381;
+	unsigned char *p;
+
+	for (p = (unsigned char *)key; *p != '\0'; p++) {
+	  h = ((h << 5) + h) ^ *p;
+	}
+	return (h);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        lru_unlink, lru_push
+ *
+ * Purpose:     Take entry out of the LRU list, put at most recently used end.
+ *
+ *--------------------------------------------------------------------*/
+
+static void lru_unlink (struct lru_table_s *t, struct lru_node_s *p)
+{
+	if (p->lru_prev != NULL) p->lru_prev->lru_next = p->lru_next;
+	else t->lru_head = p->lru_next;
+
+	if (p->lru_next != NULL) p->lru_next->lru_prev = p->lru_prev;
+	else t->lru_tail = p->lru_prev;
+
+	p->lru_prev = NULL;
+	p->lru_next = NULL;
+}
+
+static void lru_push (struct lru_table_s *t, struct lru_node_s *p)
+{
+	p->lru_prev = NULL;
+	p->lru_next = t->lru_head;
+	if (t->lru_head != NULL) t->lru_head->lru_prev = p;
+	t->lru_head = p;
+	if (t->lru_tail == NULL) t->lru_tail = p;
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        lru_table_find
+ *
+ * Purpose:     Find entry for a station.
+ *
+ * Inputs:	t	- Table.
+ *		key	- Station name with optional SSID.
+ *		h	- lru_table_hash(key).
+ *
+ * Returns:	Pointer to entry or NULL if not found.
+ *
+ * Description:	The LRU order is not changed.  Use lru_table_touch for that.
+ *
+ *--------------------------------------------------------------------*/
+
+struct lru_node_s * lru_table_find (struct lru_table_s *t, char *key, unsigned int h)
+{
+	struct lru_node_s *p;
+
+	for (p = t->hash[h & t->hash_mask]; p != NULL; p = p->hnext) {
+	  if (p->hash == h && strcmp(key, p->key) == 0) {
+	    return (p);
+	  }
+	}
+	return (NULL);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        lru_table_touch
+ *
+ * Purpose:     Mark entry as most recently used.
+ *
+ *--------------------------------------------------------------------*/
+
+void lru_table_touch (struct lru_table_s *t, struct lru_node_s *p)
+{
+	if (p != t->lru_head) {
+	  lru_unlink (t, p);
+	  lru_push (t, p);
+	}
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        lru_table_add
+ *
+ * Purpose:     Add a new entry, recycling the least recently used if full.
+ *
+ * Inputs:	t	- Table.
+ *		key	- Station name with optional SSID.  Must not be present already.
+ *		h	- lru_table_hash(key).
+ *		size	- Size of the caller's structure, which starts
+ *			  with struct lru_node_s.
+ *
+ * Returns:	Pointer to entry, all zero except for the node.
+ *		It is now the most recently used.
+ *
+ * Description:	The caller can compare t->evictions before and after
+ *		to find out if an entry was recycled.
+ *
+ *--------------------------------------------------------------------*/
+
+struct lru_node_s * lru_table_add (struct lru_table_s *t, char *key, unsigned int h, size_t size)
+{
+	struct lru_node_s *p;
+	struct lru_node_s **pprev;
+
+	assert (size >= sizeof (struct lru_node_s));
+
+	if (t->entries >= t->max_entries && t->lru_tail != NULL) {
+
+	  p = t->lru_tail;
+
+	  for (pprev = &(t->hash[p->hash & t->hash_mask]); *pprev != p; pprev = &((*pprev)->hnext)) {
+	    assert (*pprev != NULL);
+	  }
+	  *pprev = p->hnext;
+
+	  lru_unlink (t, p);
+	  t->entries--;
+	  t->evictions++;
+	}
+	else {
+	  p = malloc (size);
+	  assert (p != NULL);
+	}
+
+	memset (p, 0, size);
+
+	p->hash = h;
+	strlcpy (p->key, key, sizeof(p->key));
+
+	p->hnext = t->hash[h & t->hash_mask];
+	t->hash[h & t->hash_mask] = p;
+
+	lru_push (t, p);
+	t->entries++;
+
+	return (p);
+
+} /* end lru_table_add */
+
+/* end lru_table.c */
@@ -0,0 +1,54 @@
+
+/* lru_table.h */
+
+#ifndef LRU_TABLE_H
+#define LRU_TABLE_H 1
+
+#include "ax25_pad.h"		/* for AX25_MAX_ADDR_LEN */
+
+
+/*
+ * Put this at the beginning of the structure being stored so
+ * a pointer to one can be converted to a pointer to the other.
+ */
+
+struct lru_node_s {
+
+	struct lru_node_s *hnext;		/* Next in same hash bucket. */
+
+	struct lru_node_s *lru_prev;		/* Neighbors in least recently used list. */
+	struct lru_node_s *lru_next;		/* Most recently used is at the head. */
+
+	unsigned int hash;			/* Hash of key. */
+
+	char key[AX25_MAX_ADDR_LEN];		/* Station with optional SSID. */
+};
+
+
+struct lru_table_s {
+
+	struct lru_node_s **hash;		/* Buckets, allocated by lru_table_init. */
+	unsigned int hash_mask;			/* Number of buckets - 1.  Always power of 2. */
+
+	struct lru_node_s *lru_head;		/* Most recently used. */
+	struct lru_node_s *lru_tail;		/* Least recently used, next to be recycled. */
+
+	int max_entries;			/* Limit on number of entries. */
+	int entries;				/* Current number of entries. */
+	unsigned long evictions;		/* Number of times an entry was recycled. */
+};
+
+
+void lru_table_init (struct lru_table_s *t, int max_entries);
+
+unsigned int lru_table_hash (char *key);
+
+struct lru_node_s * lru_table_find (struct lru_table_s *t, char *key, unsigned int h);
+
+void lru_table_touch (struct lru_table_s *t, struct lru_node_s *p);
+
+struct lru_node_s * lru_table_add (struct lru_table_s *t, char *key, unsigned int h, size_t size);
+
+#endif
+
+/* end lru_table.h */
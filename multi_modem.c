@@ -88,6 +88,8 @@
 #include "hdlc_rec.h"
 #include "hdlc_rec2.h"
 #include "dlq.h"
+#include "rx_latency.h"
+#include "audio_ring.h"
 
 
 // Properties of the radio channels.
@@ -108,7 +110,10 @@ static struct {
 
 
 
-#define PROCESS_AFTER_BITS 2
+/*
+ * Wait this many bit times, after the first candidate, for
+ * others to finish.  Set with RXHOLD in the configuration file.
+ */
 
 static int process_age[MAX_CHANS];
 
@@ -144,6 +149,8 @@ void multi_modem_init (struct audio_s *pa)
 
 	memset (candidate, 0, sizeof(candidate));
 
+	rx_latency_init ();
+
 	demod_init (save_audio_config_p);
 	hdlc_rec_init (save_audio_config_p);
 
@@ -154,7 +161,7 @@ void multi_modem_init (struct audio_s *pa)
 	      dw_printf("Internal error, chan=%d, %s, %d\n", chan, __FILE__, __LINE__);
 	      save_audio_config_p->achan[chan].baud = DEFAULT_BAUD;
 	    }
-	    process_age[chan] = PROCESS_AFTER_BITS * save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec / save_audio_config_p->achan[chan].baud;
+	    process_age[chan] = save_audio_config_p->achan[chan].rx_hold_bits * save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec / save_audio_config_p->achan[chan].baud;
 	    //crc_queue_of_last_to_app[chan] = NULL;
 	  }
 	}
@@ -353,6 +360,8 @@ void multi_modem_process_sample (int chan, int audio_sample)
  *				 Use -2 to indicate DTMF message.)
  *		retries	- Level of bit correction used.
  *
+ *		flag_time - When the closing flag was found, from dtime_now().
+ *
  *
  * Description:	Add to list of candidates.  Best one will be picked later.
  *
@@ -438,7 +447,7 @@ void multi_modem_process_sample (int chan, int audio_sample)
 	than one.
 */
 
-void multi_modem_process_rec_frame (int chan, int subchan, int slice, unsigned char *fbuf, int flen, alevel_t alevel, retry_t retries)
+void multi_modem_process_rec_frame (int chan, int subchan, int slice, unsigned char *fbuf, int flen, alevel_t alevel, retry_t retries, double flag_time)
 {
 	packet_t pp;
 
@@ -455,6 +464,9 @@ void multi_modem_process_rec_frame (int chan, int subchan, int slice, unsigned c
 	  return;	/* oops!  why would it fail? */
 	}
 
+	ax25_set_rx_time (pp, flag_time);
+	rx_latency_mark (pp, chan, RXL_DECODE);
+
 
 /*
  * If only one demodulator/slicer, push it thru and forget about all this foolishness.
@@ -462,6 +474,8 @@ void multi_modem_process_rec_frame (int chan, int subchan, int slice, unsigned c
 	if (save_audio_config_p->achan[chan].num_subchan == 1 &&
 	    save_audio_config_p->achan[chan].num_slicers == 1) {
 
+	  rx_latency_mark (pp, chan, RXL_HOLD);
+	  audio_ring_decoded (chan, retries);
 	  dlq_append (DLQ_REC_FRAME, chan, subchan, slice, pp, alevel, retries, "");
 	  return;
 	}
@@ -641,6 +655,9 @@ static void pick_best_candidate (int chan)
 	j = subchan_from_n(best_n);
 	k = slice_from_n(best_n);
 
+	rx_latency_mark (candidate[chan][j][k].packet_p, chan, RXL_HOLD);
+	audio_ring_decoded (chan, candidate[chan][j][k].retries);
+
 	dlq_append (DLQ_REC_FRAME, chan, j, k,
 		candidate[chan][j][k].packet_p,
 		candidate[chan][j][k].alevel,
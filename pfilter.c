@@ -44,6 +44,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <math.h>
+#include <time.h>
 
 #if __WIN32__
 char *strsep(char **stringp, const char *delim);
@@ -57,6 +59,9 @@ char *strsep(char **stringp, const char *delim);
 #include "pfilter.h"
 
 
+//#define DEBUG_RANGE 1		/* Print calculated distance for range filter. */
+
+
 
 typedef enum token_type_e { TOKEN_AND, TOKEN_OR, TOKEN_NOT, TOKEN_LPAREN, TOKEN_RPAREN, TOKEN_FILTER_SPEC, TOKEN_EOL } token_type_t;
 
@@ -64,6 +69,13 @@ typedef enum token_type_e { TOKEN_AND, TOKEN_OR, TOKEN_NOT, TOKEN_LPAREN, TOKEN_
 #define MAX_FILTER_LEN 1024
 #define MAX_TOKEN_LEN 1024
 
+/*
+ * Result for a filter spec which needs the decoded APRS packet,
+ * when it has not been decoded yet.  See pfilter.
+ */
+
+#define PF_UNKNOWN 2
+
 typedef struct pfstate_s {
 
 	int from_chan;				/* From and to channels.   MAX_CHANS is used for IGate. */
@@ -86,6 +98,7 @@ typedef struct pfstate_s {
 
 /*
  * Packet split into separate parts.
+ * This is done only if the result can't be decided without it.
  * Most interesting fields are:
  *		g_src		- source address
  *		g_symbol_table	- / \ or overlay
@@ -94,6 +107,7 @@ typedef struct pfstate_s {
  *		g_name		- for object or item
  *		g_comment
  */
+	int decoded_ok;				/* True after decode_aprs was called. */
 	decode_aprs_t decoded;
 
 /*
@@ -107,6 +121,7 @@ typedef struct pfstate_s {
 
 
 
+static int evaluate (pfstate_t *pf);
 static int parse_expr (pfstate_t *pf);
 static int parse_or_expr (pfstate_t *pf);
 static int parse_and_expr (pfstate_t *pf);
@@ -116,12 +131,83 @@ static int parse_filter_spec (pfstate_t *pf);
 static void next_token (pfstate_t *pf);
 static void print_error (pfstate_t *pf, char *msg);
 
-static int filt_bodgu (pfstate_t *pf, char *pattern);
+static int filt_bodgu (pfstate_t *pf, const char *pattern);
 static int filt_t (pfstate_t *pf);
 static int filt_r (pfstate_t *pf);
+static int filt_a (pfstate_t *pf);
 static int filt_s (pfstate_t *pf);
 
 
+/*
+ * Range and area filters are evaluated for every packet with a position.
+ * For an IGate, that could be thousands of packets per second from the
+ * Internet server, mostly from stations nowhere near us.
+ *
+ * The first time we see a range filter spec, it is converted to a
+ * latitude / longitude bounding box which contains the whole circle.
+ * Anything outside of the box is rejected with a few comparisons
+ * and we only need the trigonometry for positions inside the box.
+ * An area filter is already a box so there is nothing else to do.
+ *
+ * The converted form is remembered, keyed by the filter spec text,
+ * so we don't need to parse the numbers again each time.
+ */
+
+struct pf_area_s {
+	char kind;				/* 'r' for range or 'a' for area. */
+
+	double lat, lon, dist;			/* Range:  center and radius in km. */
+
+	double lat_min, lat_max;		/* Bounding box latitude. */
+
+	int lon_all;				/* Range reaches a pole so longitude can be anything. */
+	double lon_half;			/* Range: +- this from center longitude. */
+
+	double lon_w, lon_e;			/* Area:  West and east edges. */
+						/* West > east means it crosses 180 degrees. */
+};
+
+#define MAX_AREA_CACHE 64			/* Way more than anyone would need. */
+#define MAX_AREA_SPEC 80
+
+static struct {
+	char spec[MAX_AREA_SPEC];
+	struct pf_area_s area;
+} area_cache[MAX_AREA_CACHE];
+
+static int area_cache_count = 0;
+
+static int area_cache_enabled = 0;		/* Set by pfilter_init.  Other applications, */
+						/* which don't call it, parse every time. */
+static dw_mutex_t area_cache_mutex;
+
+#define PF_EARTH_RADIUS_KM 6371			/* Same as used by ll_distance_km. */
+
+static int area_compile (pfstate_t *pf, struct pf_area_s *a);
+static int area_inside (struct pf_area_s *a, double lat, double lon);
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        pfilter_init
+ *
+ * Purpose:     One time initialization before any threads use pfilter.
+ *
+ * Description:	The main application calls this so the converted form
+ *		of range and area filters can be shared by multiple threads.
+ *
+ *--------------------------------------------------------------------*/
+
+void pfilter_init (void)
+{
+	if ( ! area_cache_enabled) {
+	  dw_mutex_init (&area_cache_mutex);
+	  area_cache_count = 0;
+	  area_cache_enabled = 1;
+	}
+}
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        pfilter.c
@@ -144,6 +230,15 @@ static int filt_s (pfstate_t *pf);
  * Description:	This might be running in multiple threads at the same time so
  *		no static data allowed and take other thread-safe precautions.
  *
+ *		Decoding the APRS information is the expensive part and
+ *		often not needed.  The first time thru, the filter specs
+ *		which can be answered from the addresses and raw information
+ *		part are evaluated and the others are considered unknown.
+ *		With a broad filter from the IGate server, most packets
+ *		are accepted or rejected at this point.  Only if the
+ *		overall result is still unknown, do we decode the packet
+ *		and evaluate the expression again.
+ *
  *--------------------------------------------------------------------*/
 
 int pfilter (int from_chan, int to_chan, char *filter, packet_t pp)
@@ -182,28 +277,60 @@ int pfilter (int from_chan, int to_chan, char *filter, packet_t pp)
 	}
 
 	pfstate.pp = pp;
-	decode_aprs (&pfstate.decoded, pp, 1);	
+	pfstate.decoded_ok = 0;
+
+	result = evaluate (&pfstate);
+
+	if (result == PF_UNKNOWN) {
+	  decode_aprs (&pfstate.decoded, pp, 1);
+	  pfstate.decoded_ok = 1;
+
+	  result = evaluate (&pfstate);
+	}
+	return (result);
+
+} /* end pfilter */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        evaluate
+ *
+ * Purpose:     Evaluate the whole filter expression once.
+ *
+ * Inputs:	pf	- Pointer to current state information.
+ *
+ * Returns:	 1 = yes
+ *		 0 = no
+ *		-1 = error detected
+ *		PF_UNKNOWN = need to decode packet first.
+ *
+ *--------------------------------------------------------------------*/
 
-	next_token(&pfstate);
+static int evaluate (pfstate_t *pf)
+{
+	int result;
+
+	pf->nexti = 0;
+	next_token(pf);
 	
-	if (pfstate.token_type == TOKEN_EOL) {
+	if (pf->token_type == TOKEN_EOL) {
 	  /* Empty filter means reject all. */
 	  result = 0;
 	}
 	else {
-	  result = parse_expr (&pfstate);
+	  result = parse_expr (pf);
 
-	  if (pfstate.token_type != TOKEN_AND && 
-		pfstate.token_type != TOKEN_OR && 
-		pfstate.token_type != TOKEN_EOL) {
+	  if (pf->token_type != TOKEN_AND && 
+		pf->token_type != TOKEN_OR && 
+		pf->token_type != TOKEN_EOL) {
 
-	    print_error (&pfstate, "Expected logical operator or end of line here.");
+	    print_error (pf, "Expected logical operator or end of line here.");
 	    result = -1;
 	  }
 	}
 	return (result);
-
-} /* end pfilter */
+}
 
 
 
@@ -312,6 +439,10 @@ static void next_token (pfstate_t *pf)
  * Returns:	 1 = yes
  *		 0 = no
  *		-1 = error detected
+ *		PF_UNKNOWN = can't tell without decoding the packet.
+ *
+ *		Unknown is true or false as needed to make the
+ *		outcome certain.  e.g.  0 & unknown is 0.
  *
  *--------------------------------------------------------------------*/
 
@@ -340,7 +471,9 @@ static int parse_or_expr (pfstate_t *pf)
 	  next_token (pf);
 	  e = parse_and_expr (pf);
 	  if (e < 0) return (-1);
-	  result |= e;
+	  if (result == 1 || e == 1) result = 1;
+	  else if (result == PF_UNKNOWN || e == PF_UNKNOWN) result = PF_UNKNOWN;
+	  else result = 0;
 	}
 
 	return (result);
@@ -361,7 +494,9 @@ static int parse_and_expr (pfstate_t *pf)
 	  next_token (pf);
 	  e = parse_primary (pf);
 	  if (e < 0) return (-1);
-	  result &= e;
+	  if (result == 0 || e == 0) result = 0;
+	  else if (result == PF_UNKNOWN || e == PF_UNKNOWN) result = PF_UNKNOWN;
+	  else result = 1;
 	}
 
 	return (result);
@@ -394,6 +529,7 @@ static int parse_primary (pfstate_t *pf)
 	  next_token (pf);
 	  e = parse_primary (pf);
 	  if (e < 0) result = -1;
+	  else if (e == PF_UNKNOWN) result = PF_UNKNOWN;
 	  else result = ! e;
 	}
 	else if (pf->token_type == TOKEN_FILTER_SPEC) {
@@ -418,6 +554,7 @@ static int parse_primary (pfstate_t *pf)
  * Returns:	 1 = yes
  *		 0 = no
  *		-1 = error detected
+ *		PF_UNKNOWN = need decoded packet.
  *
  *--------------------------------------------------------------------*/
 
@@ -441,11 +578,18 @@ static int parse_filter_spec (pfstate_t *pf)
 
 	else if (pf->token_str[0] == 'b' && ispunct(pf->token_str[1])) {
 	  /* Budlist - source address */
-	  result = filt_bodgu (pf, pf->decoded.g_src);
+	  ax25_get_addr_with_ssid (pf->pp, AX25_SOURCE, addr);
+	  result = filt_bodgu (pf, addr);
 	}
 	else if (pf->token_str[0] == 'o' && ispunct(pf->token_str[1])) {
 	  /* Object or item name */
-	  result = filt_bodgu (pf, pf->decoded.g_name);
+	  if (pf->decoded_ok) {
+	    result = filt_bodgu (pf, pf->decoded.g_name);
+	  }
+	  else {
+	    /* Only check for errors in the spec. */
+	    result = filt_bodgu (pf, "") < 0 ? -1 : PF_UNKNOWN;
+	  }
 	}
 	else if (pf->token_str[0] == 'd' && ispunct(pf->token_str[1])) {
 	  int n;
@@ -474,11 +618,17 @@ static int parse_filter_spec (pfstate_t *pf)
 	}
 	else if (pf->token_str[0] == 'g' && ispunct(pf->token_str[1])) {
 	  /* Addressee of message. */
-	  if (ax25_get_dti(pf->pp) == ':') {
+	  if (ax25_get_dti(pf->pp) != ':') {
+	    result = 0;
+	  }
+	  else if (pf->decoded_ok) {
 	    result = filt_bodgu (pf, pf->decoded.g_addressee);
 	  }
+	  else if (filt_bodgu (pf, "") < 0) {
+	    result = -1;
+	  }
 	  else {
-	    result = 0;
+	    result = PF_UNKNOWN;
 	  }
 	}
 	else if (pf->token_str[0] == 'u' && ispunct(pf->token_str[1])) {
@@ -498,7 +648,6 @@ static int parse_filter_spec (pfstate_t *pf)
 
 	else if (pf->token_str[0] == 't' && ispunct(pf->token_str[1])) {
 	  
-	  ax25_get_addr_with_ssid (pf->pp, AX25_DESTINATION, addr);
 	  result = filt_t (pf);
 	}
 
@@ -509,6 +658,13 @@ static int parse_filter_spec (pfstate_t *pf)
 	  result = filt_r (pf);
 	}
 
+/* area */
+
+	else if (pf->token_str[0] == 'a' && ispunct(pf->token_str[1])) {
+	  /* area - rectangle */
+	  result = filt_a (pf);
+	}
+
 /* symbol */
 
 	else if (pf->token_str[0] == 's' && ispunct(pf->token_str[1])) {
@@ -558,7 +714,7 @@ static int parse_filter_spec (pfstate_t *pf)
  *
  *------------------------------------------------------------------------------*/
 
-static int filt_bodgu (pfstate_t *pf, char *arg)
+static int filt_bodgu (pfstate_t *pf, const char *arg)
 {
 	char str[MAX_TOKEN_LEN];
 	char *cp;
@@ -761,61 +917,256 @@ static int filt_t (pfstate_t *pf)
  *		 0 = no
  *		-1 = error detected
  *
- * Description:	
+ * Description:	Quickly reject anything outside the bounding box
+ *		before calculating the actual distance.
  *
  *------------------------------------------------------------------------------*/
 
 static int filt_r (pfstate_t *pf)
+{
+	struct pf_area_s a;
+
+	if (area_compile (pf, &a) < 0) {
+	  return (-1);
+	}
+
+	if ( ! pf->decoded_ok) {
+	  return (PF_UNKNOWN);
+	}
+
+	if (pf->decoded.g_lat == G_UNKNOWN || pf->decoded.g_lon == G_UNKNOWN) {
+	  return (0);
+	}
+
+	return (area_inside (&a, pf->decoded.g_lat, pf->decoded.g_lon));
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	filt_a
+ * 
+ * Purpose:	Is it inside of a rectangular area.
+ *
+ * Inputs:	pf	- Pointer to current state information.	
+ *			  token_str should contain something of format:
+ *
+ *				a/latN/lonW/latS/lonE
+ *
+ *			  This is the same order as the APRS-IS server side filter.
+ *			  Use negative numbers for south and west.
+ *			  If lonW is greater than lonE, the area crosses 180 degrees.
+ *
+ * Returns:	 1 = yes
+ *		 0 = no
+ *		-1 = error detected
+ *
+ *------------------------------------------------------------------------------*/
+
+static int filt_a (pfstate_t *pf)
+{
+	struct pf_area_s a;
+
+	if (area_compile (pf, &a) < 0) {
+	  return (-1);
+	}
+
+	if ( ! pf->decoded_ok) {
+	  return (PF_UNKNOWN);
+	}
+
+	if (pf->decoded.g_lat == G_UNKNOWN || pf->decoded.g_lon == G_UNKNOWN) {
+	  return (0);
+	}
+
+	return (area_inside (&a, pf->decoded.g_lat, pf->decoded.g_lon));
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	area_compile
+ * 
+ * Purpose:	Get converted form of range or area filter spec.
+ *
+ * Inputs:	pf	- Pointer to current state information.	
+ *			  token_str should contain range or area filter spec.
+ *
+ * Outputs:	a	- Center, radius, and bounding box.
+ *
+ * Returns:	 0 = OK
+ *		-1 = error detected and reported.
+ *
+ * Description:	Look for previous result in the cache.  If not found,
+ *		parse the spec and add it.  Bad specs are not cached
+ *		so the error message is repeated each time, as before.
+ *
+ *------------------------------------------------------------------------------*/
+
+static int area_compile (pfstate_t *pf, struct pf_area_s *a)
 {
 	char str[MAX_TOKEN_LEN];
 	char *cp;
 	char sep[2];
 	char *v;
-	double dlat, dlon, ddist, km;
+	double num[4];
+	int n, nnum;
+	int i;
+	static const char *missing_r[3] = { "Missing latitude for Range filter.",
+					"Missing longitude for Range filter.",
+					"Missing distance for Range filter." };
+	static const char *missing_a[4] = { "Missing north latitude for Area filter.",
+					"Missing west longitude for Area filter.",
+					"Missing south latitude for Area filter.",
+					"Missing east longitude for Area filter." };
+
+	if (area_cache_enabled) {
+	  int found = 0;
+
+	  dw_mutex_lock (&area_cache_mutex);
+	  for (i = 0; i < area_cache_count; i++) {
+	    if (strcmp(pf->token_str, area_cache[i].spec) == 0) {
+	      *a = area_cache[i].area;
+	      found = 1;
+	      break;
+	    }
+	  }
+	  dw_mutex_unlock (&area_cache_mutex);
 
+	  if (found) {
+	    return (0);
+	  }
+	}
 
 	strlcpy (str, pf->token_str, sizeof(str));
 	sep[0] = str[1];
 	sep[1] = '\0';
 	cp = str + 2;
 
-	if (pf->decoded.g_lat == G_UNKNOWN || pf->decoded.g_lon == G_UNKNOWN) {
-	  return (0);
-	}
+	memset (a, 0, sizeof(struct pf_area_s));
+	a->kind = str[0];
+	nnum = a->kind == 'r' ? 3 : 4;
 
-	v = strsep (&cp, sep);
-	if (v == NULL) {
-	  print_error (pf, "Missing latitude for Range filter.");
-	  return (-1);
+	for (n = 0; n < nnum; n++) {
+	  v = strsep (&cp, sep);
+	  if (v == NULL) {
+	    print_error (pf, (char *)(a->kind == 'r' ? missing_r[n] : missing_a[n]));
+	    return (-1);
+	  }
+	  num[n] = atof(v);
 	}
-	dlat = atof(v);
 
-	v = strsep (&cp, sep);
-	if (v == NULL) {
-	  print_error (pf, "Missing longitude for Range filter.");
-	  return (-1);
+	if (a->kind == 'r') {
+	  double ang;		/* Radius as angle, in radians, from center of earth. */
+
+	  a->lat = num[0];
+	  a->lon = num[1];
+	  a->dist = num[2];
+
+	  ang = a->dist / PF_EARTH_RADIUS_KM;
+
+	  a->lat_min = a->lat - ang * 180 / M_PI;
+	  a->lat_max = a->lat + ang * 180 / M_PI;
+
+	  /* Widest part of circle is not at the center latitude but this */
+	  /* gives the exact longitude limits for a circle on a sphere. */
+
+	  if (a->lat_max >= 90 || a->lat_min <= -90 ||
+		sin(ang) >= cos(a->lat * M_PI / 180)) {
+	    a->lon_all = 1;
+	  }
+	  else {
+	    a->lon_half = asin(sin(ang) / cos(a->lat * M_PI / 180)) * 180 / M_PI;
+	  }
+
+	  /* Allow a little slop so the box never rejects something the */
+	  /* distance calculation would accept due to rounding. */
+
+	  a->lat_min -= 0.0001;
+	  a->lat_max += 0.0001;
+	  a->lon_half += 0.0001;
+	}
+	else {
+	  a->lat_max = num[0];
+	  a->lon_w = num[1];
+	  a->lat_min = num[2];
+	  a->lon_e = num[3];
+
+	  if (a->lat_max < a->lat_min) {
+	    print_error (pf, "North latitude must not be less than south latitude for Area filter.");
+	    return (-1);
+	  }
 	}
-	dlon = atof(v);
 
-	v = strsep (&cp, sep);
-	if (v == NULL) {
-	  print_error (pf, "Missing distance for Range filter.");
-	  return (-1);
+	if (area_cache_enabled && strlen(pf->token_str) < MAX_AREA_SPEC) {
+
+	  dw_mutex_lock (&area_cache_mutex);
+
+	  for (i = 0; i < area_cache_count; i++) {
+	    if (strcmp(pf->token_str, area_cache[i].spec) == 0) {
+	      break;		/* Another thread got here first. */
+	    }
+	  }
+	  if (i == area_cache_count && area_cache_count < MAX_AREA_CACHE) {
+	    strlcpy (area_cache[i].spec, pf->token_str, sizeof(area_cache[i].spec));
+	    area_cache[i].area = *a;
+	    area_cache_count++;
+	  }
+
+	  dw_mutex_unlock (&area_cache_mutex);
 	}
-	ddist = atof(v);
 
-	km = ll_distance_km (dlat, dlon, pf->decoded.g_lat, pf->decoded.g_lon);
+	return (0);
 
+} /* end area_compile */
 
-	text_color_set (DW_COLOR_DEBUG);
 
-	dw_printf ("Calculated distance = %.3f km\n", km);
+/*------------------------------------------------------------------------------
+ *
+ * Name:	area_inside
+ * 
+ * Purpose:	Is location inside of range or area?
+ *
+ * Inputs:	a	 - Converted form of filter spec.
+ *		lat, lon - Location from packet.
+ *
+ * Returns:	 1 = yes
+ *		 0 = no
+ *
+ *------------------------------------------------------------------------------*/
 
-	if (km <= ddist) {
-	  return (1);
+static int area_inside (struct pf_area_s *a, double lat, double lon)
+{
+	double km;
+
+	if (lat < a->lat_min || lat > a->lat_max) {
+	  return (0);
 	}
 
-	return (0);
+	if (a->kind == 'a') {
+	  if (a->lon_w <= a->lon_e) {
+	    return (lon >= a->lon_w && lon <= a->lon_e);
+	  }
+	  return (lon >= a->lon_w || lon <= a->lon_e);
+	}
+
+	if ( ! a->lon_all) {
+	  double dlon = fabs(lon - a->lon);
+
+	  if (dlon > 180) dlon = 360 - dlon;
+	  if (dlon > a->lon_half) {
+	    return (0);
+	  }
+	}
+
+	km = ll_distance_km (a->lat, a->lon, lat, lon);
+
+#if DEBUG_RANGE
+	text_color_set (DW_COLOR_DEBUG);
+	dw_printf ("Calculated distance = %.3f km\n", km);
+#endif
+
+	return (km <= a->dist);
 }
 
 
@@ -868,6 +1219,16 @@ static int filt_s (pfstate_t *pf)
 	  return (-1);
 	}
 
+	if ( ! pf->decoded_ok) {
+	  /* Only check for errors in the spec. */
+	  alt = strsep (&cp, sep);
+	  if (alt != NULL && strlen(alt) == 0) {
+	    print_error (pf, "Missing alternate symbols for Symbol filter.");
+	    return (-1);
+	  }
+	  return (PF_UNKNOWN);
+	}
+
 	if (pf->decoded.g_symbol_table == '/' && strchr(pri, pf->decoded.g_symbol_code) != NULL) {
 	  /* Found in primary symbols. All done. */
 	  return (1);
@@ -967,10 +1328,13 @@ static void print_error (pfstate_t *pf, char *msg)
 
 static int error_count = 0;
 static void pftest (int test_num, char *filter, char *packet, int expected);
+static void area_benchmark (void);
 
 int main ()
 {
 
+	pfilter_init ();
+
 	dw_printf ("Quick test for packet filtering.\n");
 	dw_printf ("Some error messages are normal.  Look at the final success/fail message.\n");
 
@@ -1066,8 +1430,24 @@ int main ()
 	pftest (130, "r/42.6/-71.3/10", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Chelmsford MA", 1);
 	pftest (131, "r/42.6/-71.3/10", "WA1PLE-5>APWW10,W1MHL,N8VIM,WIDE2*:@022301h4208.75N/07115.16WoAPRS-IS for Win32", 0);
 
+	pftest (132, "r/42.6/-71.3/10", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:>Status has no position", 0);
+	pftest (133, "r/42.6/-71.3/10 | r/42.1/-71.3/10", "WA1PLE-5>APWW10,W1MHL,N8VIM,WIDE2*:@022301h4208.75N/07115.16WoAPRS-IS for Win32", 1);
+
+	pftest (135, "a/43/-72/42/-71", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Chelmsford MA", 1);
+	pftest (136, "a/43/-72/42.7/-71", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Chelmsford MA", 0);
+	pftest (137, "a/43/-71.3/42/-71", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Chelmsford MA", 0);
+	pftest (138, "a/43/170/42/-71", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Chelmsford MA", 1);
+	pftest (139, "a/43/-70/42/170", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Chelmsford MA", 0);
+
 	pftest (140, "( t/t & b/WB2OSZ ) | ( t/o & ! r/42.6/-71.3/1 )", "WB2OSZ>APDW12:;home     *111111z4237.14N/07120.83W-Chelmsford MA", 1);
 
+	/* Decided with or without decoding the packet. */
+	pftest (141, "t/m & r/42.6/-71.3/10", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Chelmsford MA", 0);
+	pftest (142, "b/WB2OSZ-5 | r/1/1/1", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Chelmsford MA", 1);
+	pftest (143, "! r/42.6/-71.3/10 | t/m", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Chelmsford MA", 0);
+	pftest (144, "t/p & ! ( s/-> | o/home )", "WB2OSZ-5>APDW12:!4237.14N/07120.83W-PHG7140Chelmsford MA", 0);
+	pftest (145, "b/WB2OSZ-5 | r/42.6/-71.3", "WB2OSZ-5>APDW12,WIDE1-1,WIDE2-1:!4237.14NS07120.83W#PHG7140Chelmsford MA", -1);
+
 	pftest (150, "s/->", "WB2OSZ-5>APDW12:!4237.14NS07120.83W#PHG7140Chelmsford MA", 0);
 	pftest (151, "s/->", "WB2OSZ-5>APDW12:!4237.14N/07120.83W-PHG7140Chelmsford MA", 1);
 	pftest (152, "s/->", "WB2OSZ-5>APDW12:!4237.14N/07120.83W>PHG7140Chelmsford MA", 1);
@@ -1100,6 +1480,10 @@ int main ()
 	pftest (203, "!", "CWAPID>APRS:;CWAttttz *DDHHMMzLATLONICONADVISETYPE{seq#", -1);
 	pftest (203, "t/w t/w", "CWAPID>APRS:;CWAttttz *DDHHMMzLATLONICONADVISETYPE{seq#", -1);
 	pftest (204, "r/42.6/-71.3", "WA1PLE-5>APWW10,W1MHL,N8VIM,WIDE2*:@022301h4208.75N/07115.16WoAPRS-IS for Win32", -1);
+	pftest (205, "a/43/-72/42", "WA1PLE-5>APWW10,W1MHL,N8VIM,WIDE2*:@022301h4208.75N/07115.16WoAPRS-IS for Win32", -1);
+	pftest (206, "a/42/-72/43/-71", "WA1PLE-5>APWW10,W1MHL,N8VIM,WIDE2*:@022301h4208.75N/07115.16WoAPRS-IS for Win32", -1);
+
+	area_benchmark ();
 
 
 	if (error_count > 0) {
@@ -1134,6 +1518,83 @@ static void pftest (int test_num, char *filter, char *monitor, int expected)
 	ax25_delete (pp);
 }
 
+
+
+/*
+ * Compare the bounding box shortcut against plain distance calculation
+ * for a large number of random locations, then see how long each takes.
+ */
+
+#define BENCH_NUM_POS 200000
+
+static void area_benchmark (void)
+{
+	static double plat[BENCH_NUM_POS], plon[BENCH_NUM_POS];
+	static char *specs[] = { "r/42.6/-71.3/10", "r/42.6/-71.3/50", "r/42.6/-71.3/1000",
+				"r/-33.9/151.2/100", "r/0/179.9/500", "r/89.5/0/200", "r/60/-150/3000" };
+	int nspecs = sizeof(specs) / sizeof(specs[0]);
+	struct pf_area_s area[sizeof(specs) / sizeof(specs[0])];
+	pfstate_t pf;
+	int n, j;
+	int hits = 0;
+	clock_t start;
+	double t_fast, t_slow;
+	volatile int sink = 0;
+
+	memset (&pf, 0, sizeof(pf));
+	srand (1);
+	for (n = 0; n < BENCH_NUM_POS; n++) {
+	  plat[n] = (double)rand() / RAND_MAX * 180 - 90;
+	  plon[n] = (double)rand() / RAND_MAX * 360 - 180;
+	}
+	/* Concentrate some around the centers so we exercise the edges. */
+	for (n = 0; n < BENCH_NUM_POS / 2; n++) {
+	  struct pf_area_s *a;
+	  strlcpy (pf.token_str, specs[n % nspecs], sizeof(pf.token_str));
+	  area_compile (&pf, &(area[n % nspecs]));
+	  a = &(area[n % nspecs]);
+	  plat[n] = a->lat + ((double)rand() / RAND_MAX - 0.5) * 4 * a->dist / 111;
+	  plon[n] = a->lon + ((double)rand() / RAND_MAX - 0.5) * 4 * a->dist / 111;
+	  if (plat[n] > 90) plat[n] = 90;
+	  if (plat[n] < -90) plat[n] = -90;
+	  if (plon[n] > 180) plon[n] -= 360;
+	  if (plon[n] < -180) plon[n] += 360;
+	}
+
+	for (n = 0; n < BENCH_NUM_POS; n++) {
+	  for (j = 0; j < nspecs; j++) {
+	    int fast = area_inside (&(area[j]), plat[n], plon[n]);
+	    int slow = ll_distance_km (area[j].lat, area[j].lon, plat[n], plon[n]) <= area[j].dist;
+	    if (fast != slow) {
+	      text_color_set (DW_COLOR_ERROR);
+	      dw_printf ("Range mismatch for %s at %.5f %.5f\n", specs[j], plat[n], plon[n]);
+	      error_count++;
+	    }
+	    hits += fast;
+	  }
+	}
+
+	start = clock();
+	for (n = 0; n < BENCH_NUM_POS; n++) {
+	  for (j = 0; j < nspecs; j++) {
+	    sink += area_inside (&(area[j]), plat[n], plon[n]);
+	  }
+	}
+	t_fast = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	start = clock();
+	for (n = 0; n < BENCH_NUM_POS; n++) {
+	  for (j = 0; j < nspecs; j++) {
+	    sink += ll_distance_km (area[j].lat, area[j].lon, plat[n], plon[n]) <= area[j].dist;
+	  }
+	}
+	t_slow = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	text_color_set (DW_COLOR_INFO);
+	dw_printf ("Range filter: %d positions x %d ranges, %d inside.\n", BENCH_NUM_POS, nspecs, hits);
+	dw_printf ("Bounding box first %.3f sec, distance only %.3f sec.\n", t_fast, t_slow);
+}
+
 #endif /* if TEST */
 
 /* end pfilter.c */
@@ -1,4 +1,6 @@
 
 /* pfilter.h */
 
-int pfilter (int from_chan, int to_chan, char *filter, packet_t pp);
\ No newline at end of file
+void pfilter_init (void);
+
+int pfilter (int from_chan, int to_chan, char *filter, packet_t pp);
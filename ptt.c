@@ -126,6 +126,7 @@ typedef int HANDLE;
 #include "textcolor.h"
 #include "audio.h"
 #include "ptt.h"
+#include "dtime_now.h"
 
 
 #if __WIN32__
@@ -351,8 +352,48 @@ static HANDLE ptt_fd[MAX_CHANS][NUM_OCTYPES];
 static RIG *rig[MAX_CHANS][NUM_OCTYPES];
 #endif
 
+#if __WIN32__
+#else
+static int gpio_value_fd[MAX_CHANS][NUM_OCTYPES];
+					/* /sys/class/gpio/gpioN/value for output. */
+static int gpio_input_fd[MAX_CHANS][NUM_ICTYPES];
+					/* Same for input.  These are kept open, */
+					/* rather than opening and closing for */
+					/* every change, to minimize key-up time. */
+#endif
+
 static char otnames[NUM_OCTYPES][8];
 
+
+/*
+ * Key-up timing for each channel.
+ *
+ * Assert time is how long it takes ptt_set to turn on PTT
+ * with whatever method is used: serial port control line,
+ * GPIO, parallel port, or hamlib.
+ *
+ * Audio time is from turning on PTT until the first audio
+ * was written to the sound system.  See ptt_audio_written.
+ */
+
+static struct {
+	int count;			/* Number of times PTT was turned on. */
+	double assert_total;		/* Seconds.  Divide by count for average. */
+	double assert_max;
+	int audio_count;
+	double audio_total;
+	double audio_max;
+	double key_time;		/* When PTT was last turned on. */
+} key_stats[MAX_CHANS];			/* Protected by key_stats_mutex. */
+
+static volatile int waiting_for_audio[MAX_CHANS];
+					/* Set when PTT turned on, cleared */
+					/* when first audio is written. */
+
+static int key_stats_last_printed[MAX_CHANS];
+
+static dw_mutex_t key_stats_mutex;
+
 void ptt_init (struct audio_s *audio_config_p)
 {
 	int ch;
@@ -373,6 +414,24 @@ void ptt_init (struct audio_s *audio_config_p)
 	strlcpy (otnames[OCTYPE_DCD], "DCD", sizeof(otnames[OCTYPE_DCD]));
 	strlcpy (otnames[OCTYPE_FUTURE], "FUTURE", sizeof(otnames[OCTYPE_FUTURE]));
 
+	memset (key_stats, 0, sizeof(key_stats));
+	memset ((void*)waiting_for_audio, 0, sizeof(waiting_for_audio));
+	memset (key_stats_last_printed, 0, sizeof(key_stats_last_printed));
+	dw_mutex_init (&key_stats_mutex);
+
+#if __WIN32__
+#else
+	for (ch = 0; ch < MAX_CHANS; ch++) {
+	  int k;
+	  for (k = 0; k < NUM_OCTYPES; k++) {
+	    gpio_value_fd[ch][k] = -1;
+	  }
+	  for (k = 0; k < NUM_ICTYPES; k++) {
+	    gpio_input_fd[ch][k] = -1;
+	  }
+	}
+#endif
+
 
 	for (ch = 0; ch < MAX_CHANS; ch++) {
 	  int ot;
@@ -607,6 +666,29 @@ void ptt_init (struct audio_s *audio_config_p)
 	    }
 	  }
 	}
+
+/*
+ * Open the "value" files now and keep them open.
+ * Any failure will be reported, and tried again, when used.
+ */
+	for (ch = 0; ch < MAX_CHANS; ch++) {
+	  if (save_audio_config_p->achan[ch].valid) {
+	    int ot;
+	    char stemp[80];
+	    for (ot = 0; ot < NUM_OCTYPES; ot++) {
+	      if (audio_config_p->achan[ch].octrl[ot].ptt_method == PTT_METHOD_GPIO) {
+	        snprintf (stemp, sizeof(stemp), "/sys/class/gpio/gpio%d/value", audio_config_p->achan[ch].octrl[ot].ptt_gpio);
+	        gpio_value_fd[ch][ot] = open(stemp, O_WRONLY);
+	      }
+	    }
+	    for (ot = 0; ot < NUM_ICTYPES; ot++) {
+	      if (audio_config_p->achan[ch].ictrl[ot].method == PTT_METHOD_GPIO) {
+	        snprintf (stemp, sizeof(stemp), "/sys/class/gpio/gpio%d/value", audio_config_p->achan[ch].ictrl[ot].gpio);
+	        gpio_input_fd[ch][ot] = open(stemp, O_RDONLY);
+	      }
+	    }
+	  }
+	}
 #endif
 
 
@@ -792,6 +874,7 @@ void ptt_set (int ot, int chan, int ptt_signal)
 
 	int ptt = ptt_signal;
 	int ptt2 = ptt_signal;
+	double start_time = 0;
 
 	assert (ot >= 0 && ot < NUM_OCTYPES);
 	assert (chan >= 0 && chan < MAX_CHANS);
@@ -809,6 +892,10 @@ void ptt_set (int ot, int chan, int ptt_signal)
 	  return;
 	}
 
+	if (ot == OCTYPE_PTT && ptt_signal) {
+	  start_time = dtime_now();
+	}
+
 /* 
  * Inverted output? 
  */
@@ -879,30 +966,33 @@ void ptt_set (int ot, int chan, int ptt_signal)
 #else
 
 	if (save_audio_config_p->achan[chan].octrl[ot].ptt_method == PTT_METHOD_GPIO) {
-	  int fd;
 	  char stemp[80];
 
-	  snprintf (stemp, sizeof(stemp), "/sys/class/gpio/gpio%d/value", save_audio_config_p->achan[chan].octrl[ot].ptt_gpio);
+	  if (gpio_value_fd[chan][ot] < 0) {
 
-	  fd = open(stemp, O_WRONLY);
-	  if (fd < 0) {
-	    int e = errno;
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("Error opening %s to set %s signal.\n", stemp, otnames[ot]);
-	    dw_printf ("%s\n", strerror(e));
-	    return;
+	    snprintf (stemp, sizeof(stemp), "/sys/class/gpio/gpio%d/value", save_audio_config_p->achan[chan].octrl[ot].ptt_gpio);
+
+	    gpio_value_fd[chan][ot] = open(stemp, O_WRONLY);
+	    if (gpio_value_fd[chan][ot] < 0) {
+	      int e = errno;
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Error opening %s to set %s signal.\n", stemp, otnames[ot]);
+	      dw_printf ("%s\n", strerror(e));
+	      return;
+	    }
 	  }
 
-	  snprintf (stemp, sizeof(stemp), "%d", ptt);
+	  stemp[0] = ptt ? '1' : '0';
 
-	  if (write (fd, stemp, 1) != 1) {
+	  lseek (gpio_value_fd[chan][ot], (off_t)0, SEEK_SET);
+	  if (write (gpio_value_fd[chan][ot], stemp, 1) != 1) {
 	    int e = errno;
 	    text_color_set(DW_COLOR_ERROR);
 	    dw_printf ("Error setting GPIO %d for %s\n", save_audio_config_p->achan[chan].octrl[ot].ptt_gpio, otnames[ot]);
 	    dw_printf ("%s\n", strerror(e));
+	    close (gpio_value_fd[chan][ot]);		/* Try opening again next time. */
+	    gpio_value_fd[chan][ot] = -1;
 	  }
-	  close (fd);
-
 	}
 #endif
 	
@@ -968,6 +1058,23 @@ void ptt_set (int ot, int chan, int ptt_signal)
 	}
 #endif
 
+/*
+ * Keep track of how long it took to key up the transmitter.
+ */
+	if (start_time != 0 && save_audio_config_p->achan[chan].octrl[ot].ptt_method != PTT_METHOD_NONE) {
+	  double now = dtime_now();
+	  double elapsed = now - start_time;
+
+	  dw_mutex_lock (&key_stats_mutex);
+	  key_stats[chan].count++;
+	  key_stats[chan].assert_total += elapsed;
+	  if (elapsed > key_stats[chan].assert_max) {
+	    key_stats[chan].assert_max = elapsed;
+	  }
+	  key_stats[chan].key_time = now;
+	  waiting_for_audio[chan] = 1;
+	  dw_mutex_unlock (&key_stats_mutex);
+	}
 
 } /* end ptt_set */
 
@@ -998,28 +1105,36 @@ int get_input (int it, int chan)
 #if __WIN32__
 #else
 	if (save_audio_config_p->achan[chan].ictrl[it].method == PTT_METHOD_GPIO) {
-	  int fd;
 	  char stemp[80];
 
-	  snprintf (stemp, sizeof(stemp), "/sys/class/gpio/gpio%d/value", save_audio_config_p->achan[chan].ictrl[it].gpio);
+	  if (gpio_input_fd[chan][it] < 0) {
 
-	  fd = open(stemp, O_RDONLY);
-	  if (fd < 0) {
-	    int e = errno;
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("Error opening %s to check input.\n", stemp);
-	    dw_printf ("%s\n", strerror(e));
-	    return -1;
+	    snprintf (stemp, sizeof(stemp), "/sys/class/gpio/gpio%d/value", save_audio_config_p->achan[chan].ictrl[it].gpio);
+
+	    gpio_input_fd[chan][it] = open(stemp, O_RDONLY);
+	    if (gpio_input_fd[chan][it] < 0) {
+	      int e = errno;
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Error opening %s to check input.\n", stemp);
+	      dw_printf ("%s\n", strerror(e));
+	      return -1;
+	    }
 	  }
 
-	  char vtemp[2];
-	  if (read (fd, vtemp, 1) != 1) {
+/*
+ * A sysfs attribute must be read from the beginning to get the current value.
+ */
+	  char vtemp[2] = { '0', '\0' };
+	  lseek (gpio_input_fd[chan][it], (off_t)0, SEEK_SET);
+	  if (read (gpio_input_fd[chan][it], vtemp, 1) != 1) {
 	    int e = errno;
 	    text_color_set(DW_COLOR_ERROR);
 	    dw_printf ("Error getting GPIO %d value\n", save_audio_config_p->achan[chan].ictrl[it].gpio);
 	    dw_printf ("%s\n", strerror(e));
+	    close (gpio_input_fd[chan][it]);		/* Try opening again next time. */
+	    gpio_input_fd[chan][it] = -1;
+	    return -1;
 	  }
-	  close (fd);
 
 	  if (atoi(vtemp) != save_audio_config_p->achan[chan].ictrl[it].invert) {
 	    return 1;
@@ -1070,7 +1185,23 @@ void ptt_term (void)
 #endif
 	        ptt_fd[n][ot] = INVALID_HANDLE_VALUE;
 	      }
+#if __WIN32__
+#else
+	      if (gpio_value_fd[n][ot] >= 0) {
+	        close (gpio_value_fd[n][ot]);
+	        gpio_value_fd[n][ot] = -1;
+	      }
+#endif
 	    }
+#if __WIN32__
+#else
+	    for (ot = 0; ot < NUM_ICTYPES; ot++) {
+	      if (gpio_input_fd[n][ot] >= 0) {
+	        close (gpio_input_fd[n][ot]);
+	        gpio_input_fd[n][ot] = -1;
+	      }
+	    }
+#endif
 	  }
 	}
 
@@ -1093,6 +1224,101 @@ void ptt_term (void)
 }
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        ptt_audio_written
+ *
+ * Purpose:    	Note the time when audio is first written to the
+ *		sound system after PTT was turned on.
+ *
+ * Inputs:	a	- Audio device number, not channel.
+ *
+ * Description:	This is called by audio_flush each time a buffer is
+ *		sent to the sound system, so it must be quick when
+ *		there is nothing to do.
+ *
+ *		Any time beyond what the radio needs to get up to full
+ *		power is wasted and adds to the real TXDELAY.
+ *
+ *--------------------------------------------------------------------*/
+
+void ptt_audio_written (int a)
+{
+	int ch;
+
+	assert (a >= 0 && a < MAX_ADEVS);
+
+	for (ch = ADEVFIRSTCHAN(a); ch < ADEVFIRSTCHAN(a) + save_audio_config_p->adev[a].num_channels; ch++) {
+
+	  if (waiting_for_audio[ch]) {
+	    double now = dtime_now();
+
+	    dw_mutex_lock (&key_stats_mutex);
+	    if (waiting_for_audio[ch]) {
+	      double elapsed = now - key_stats[ch].key_time;
+
+	      if (elapsed < 0) elapsed = 0;
+	      key_stats[ch].audio_count++;
+	      key_stats[ch].audio_total += elapsed;
+	      if (elapsed > key_stats[ch].audio_max) {
+	        key_stats[ch].audio_max = elapsed;
+	      }
+	      waiting_for_audio[ch] = 0;
+	    }
+	    dw_mutex_unlock (&key_stats_mutex);
+	  }
+	}
+
+} /* end ptt_audio_written */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        ptt_print_stats
+ *
+ * Purpose:    	Print key-up timing for one channel.
+ *
+ * Description:	This is called along with the audio statistics, "-a" option.
+ *		Nothing is printed if the transmitter was not keyed since last time.
+ *
+ *		The configured TXDELAY is shown for comparison.  The time
+ *		until audio starts is in addition to that.
+ *
+ *--------------------------------------------------------------------*/
+
+void ptt_print_stats (int chan)
+{
+	int count, audio_count;
+	double assert_total, assert_max, audio_total, audio_max;
+
+	assert (chan >= 0 && chan < MAX_CHANS);
+
+	dw_mutex_lock (&key_stats_mutex);
+	count = key_stats[chan].count;
+	assert_total = key_stats[chan].assert_total;
+	assert_max = key_stats[chan].assert_max;
+	audio_count = key_stats[chan].audio_count;
+	audio_total = key_stats[chan].audio_total;
+	audio_max = key_stats[chan].audio_max;
+	dw_mutex_unlock (&key_stats_mutex);
+
+	if (count == key_stats_last_printed[chan]) {
+	  return;
+	}
+	key_stats_last_printed[chan] = count;
+
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("PTT CH%d: %d key-ups, assert avg %.2f, max %.2f ms",
+		chan, count, 1000. * assert_total / count, 1000. * assert_max);
+	if (audio_count > 0) {
+	  dw_printf (", first audio avg %.1f, max %.1f ms",
+		1000. * audio_total / audio_count, 1000. * audio_max);
+	}
+	dw_printf (", TXDELAY %d ms\n", save_audio_config_p->achan[chan].txdelay * 10);
+
+} /* end ptt_print_stats */
+
+
 
 
 /*
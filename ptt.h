@@ -17,6 +17,10 @@ void ptt_term (void);
 
 int get_input (int it, int chan);
 
+void ptt_audio_written (int a);
+
+void ptt_print_stats (int chan);
+
 #endif
 
 
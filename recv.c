@@ -104,6 +104,8 @@
 #include "recv.h"
 #include "dtmf.h"
 #include "aprs_tt.h"
+#include "dsp_stats.h"
+#include "audio_ring.h"
 
 
 #if __WIN32__
@@ -225,11 +227,19 @@ static void * recv_adev_thread (void *arg)
 
 	  for (c=0; c<num_chan; c++)
 	  {
+	    ds_ticks_t t_read = 0;
+
+	    if (dsp_stats_enabled) t_read = dsp_stats_ticks();
+
 	    audio_sample = demod_get_sample (a);
+
+	    if (dsp_stats_enabled) dsp_stats_record (DS_AUDIO_READ, first_chan + c, 0, 0, dsp_stats_ticks() - t_read);
 	  
  	    if (audio_sample >= 256 * 256) 
 	      eof = 1;
 
+	    audio_ring_put (first_chan + c, audio_sample);
+
 	    multi_modem_process_sample(first_chan + c, audio_sample);
 
 
@@ -309,7 +319,13 @@ void recv_process (void)
 				ok, (int)type, chan, pp);
 #endif
 	  if (ok) {
-		app_process_rec_packet (chan, subchan, slice, pp, alevel, retries, spectrum);
+	    ds_ticks_t t_sink = 0;
+
+	    if (dsp_stats_enabled) t_sink = dsp_stats_ticks();
+
+	    app_process_rec_packet (chan, subchan, slice, pp, alevel, retries, spectrum);
+
+	    if (dsp_stats_enabled) dsp_stats_record (DS_SINK, chan, subchan, slice, dsp_stats_ticks() - t_sink);
 	  }
 #if DEBUG
 	  else {
@@ -137,6 +137,8 @@ void rrbb_clear (rrbb_t b, int is_scrambled, int descram_state, int prev_descram
 	b->alevel.mark = 9999;
 	b->alevel.space = 9999;
 
+	b->flag_time = 0;
+
 	b->len = 0;
 
 	b->is_scrambled = is_scrambled;
@@ -153,6 +155,7 @@ void rrbb_clear (rrbb_t b, int is_scrambled, int descram_state, int prev_descram
  *
  * Inputs:	Handle for sample array.
  *		Value for the sample.
+ *		Confidence, 0 to 255, from demodulator.
  *
  ***********************************************************************************/
 
@@ -419,6 +422,47 @@ alevel_t rrbb_get_audio_level (rrbb_t b)
 }
 
 
+/***********************************************************************************
+ *
+ * Name:	rrbb_set_flag_time	
+ *
+ * Purpose:	Set time when the closing flag of the frame was found.
+ *
+ * Inputs:	b		Handle for bit array.
+ *		flag_time	Time as returned by dtime_now().
+ *		
+ ***********************************************************************************/
+
+void rrbb_set_flag_time (rrbb_t b, double flag_time)
+{
+	assert (b != NULL);
+	assert (b->magic1 == MAGIC1);
+	assert (b->magic2 == MAGIC2);
+
+	b->flag_time = flag_time;
+}
+
+
+/***********************************************************************************
+ *
+ * Name:	rrbb_get_flag_time	
+ *
+ * Purpose:	Get time when the closing flag of the frame was found.
+ *
+ * Inputs:	b	Handle for bit array.
+ *		
+ ***********************************************************************************/
+
+double rrbb_get_flag_time (rrbb_t b)
+{
+	assert (b != NULL);
+	assert (b->magic1 == MAGIC1);
+	assert (b->magic2 == MAGIC2);
+
+	return (b->flag_time);
+}
+
+
 
 /***********************************************************************************
  *
@@ -33,6 +33,7 @@ typedef struct rrbb_s {
 	int slice;		/* Which slicer. */
 
 	alevel_t alevel;	/* Received audio level at time of frame capture. */
+	double flag_time;	/* When closing flag was found, dtime_now() format. */
 	unsigned int len;	/* Current number of samples in array. */
 
 	int is_scrambled;	/* Is data scrambled G3RUH / K9NG style? */
@@ -41,6 +42,11 @@ typedef struct rrbb_s {
 
 	unsigned char fdata[MAX_NUM_BITS];
 
+	unsigned char fconf[MAX_NUM_BITS];	/* Confidence for each bit, from demodulator. */
+						/* 0 is right at the slicing threshold, */
+						/* 255 is very sure.  Used to decide which */
+						/* bits are most likely wrong when fixing. */
+
 	int magic2;
 } *rrbb_t;
 
@@ -51,12 +57,13 @@ rrbb_t rrbb_new (int chan, int subchan, int slice, int is_scrambled, int descram
 void rrbb_clear (rrbb_t b, int is_scrambled, int descram_state, int prev_descram);
 
 
-static inline /*__attribute__((always_inline))*/ void rrbb_append_bit (rrbb_t b, const unsigned char val)
+static inline /*__attribute__((always_inline))*/ void rrbb_append_bit (rrbb_t b, const unsigned char val, const unsigned char conf)
 {
 	if (b->len >= MAX_NUM_BITS) {
 	  return;	/* Silently discard if full. */
 	}
 	b->fdata[b->len] = val;
+	b->fconf[b->len] = conf;
 	b->len++;
 }
 
@@ -65,6 +72,11 @@ static inline /*__attribute__((always_inline))*/ unsigned char rrbb_get_bit (con
 	return (b->fdata[ind]);
 }
 
+static inline /*__attribute__((always_inline))*/ unsigned char rrbb_get_conf (const rrbb_t b, const int ind)
+{
+	return (b->fconf[ind]);
+}
+
 
 void rrbb_chop8 (rrbb_t b);
 
@@ -84,6 +96,9 @@ int rrbb_get_slice (rrbb_t b);
 void rrbb_set_audio_level (rrbb_t b, alevel_t alevel);
 alevel_t rrbb_get_audio_level (rrbb_t b);
 
+void rrbb_set_flag_time (rrbb_t b, double flag_time);
+double rrbb_get_flag_time (rrbb_t b);
+
 int rrbb_get_is_scrambled (rrbb_t b);
 int rrbb_get_descram_state (rrbb_t b);
 int rrbb_get_prev_descram (rrbb_t b);
@@ -0,0 +1,272 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2016  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      rx_latency.c
+ *
+ * Purpose:   	Measure how long it takes a received frame to get
+ *		from the radio to the applications.
+ *
+ * Description:	The HDLC decoder notes the time when the closing flag
+ *		is found.  This follows the frame through the bit fixing,
+ *		picking the best of several demodulators, the received
+ *		frame queue, and finally the applications: AGW and KISS
+ *		clients, IGate, and digipeater.
+ *
+ *		This happens only once for each frame so the cost is
+ *		insignificant and it is always enabled.
+ *
+ *		Note that audio buffering before the demodulator is not
+ *		included.  That depends on the sound system and is
+ *		typically a few tens of milliseconds.
+ *
+ *		Results are printed along with the audio statistics, "-a"
+ *		option, and included in the DSPSTATS JSON file.
+ *
+ *---------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+#include "direwolf.h"
+#include "ax25_pad.h"
+#include "textcolor.h"
+#include "dtime_now.h"
+#include "rx_latency.h"
+
+
+static const char *point_name[RXL_NUM_POINTS] = {
+	"decode", "hold", "queue", "app",
+	"agw", "kissnet", "kiss", "igate", "digi", "total" };
+
+
+/*
+ * Upper limit, in seconds, for each bucket of the histogram.
+ * Last bucket is for anything longer than the previous limit.
+ */
+
+static const double limit[RXL_NUM_BUCKETS-1] = { 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1, 2 };
+
+
+static struct rxl_stats_s stats[MAX_CHANS][RXL_NUM_POINTS];	/* Protected by rxl_mutex. */
+
+static int stats_last_printed[MAX_CHANS];			/* Count of first step when last printed. */
+
+static dw_mutex_t rxl_mutex;	/* Updated by the receive threads for each audio device */
+				/* as well as the received frame processing thread. */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rx_latency_init
+ *
+ * Purpose:     Initialize before any of the receive threads start.
+ *
+ *--------------------------------------------------------------------*/
+
+void rx_latency_init (void)
+{
+	memset (stats, 0, sizeof(stats));
+	memset (stats_last_printed, 0, sizeof(stats_last_printed));
+
+	dw_mutex_init (&rxl_mutex);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rx_latency_mark
+ *
+ * Purpose:     Record time for a received frame reaching a certain point.
+ *
+ * Inputs:	pp	- Received packet.  Those which did not come from
+ *			  a demodulator, such as beacons and APRStt, are ignored.
+ *
+ *		chan	- Radio channel where it was received.
+ *
+ *		point	- One of RXL_... from rx_latency.h.
+ *			  For the steps along the way, we measure the time since
+ *			  the previous step.  For the destinations, we measure
+ *			  the time since the closing flag.
+ *
+ *--------------------------------------------------------------------*/
+
+void rx_latency_mark (packet_t pp, int chan, int point)
+{
+	double now, elapsed, rx_time;
+	struct rxl_stats_s *st;
+	int b;
+
+	assert (point >= 0 && point < RXL_NUM_POINTS);
+
+	if (pp == NULL || chan < 0 || chan >= MAX_CHANS) {
+	  return;
+	}
+
+	rx_time = ax25_get_rx_time(pp);
+	if (rx_time == 0) {
+	  return;
+	}
+
+	now = dtime_now();
+
+	if (point < RXL_FIRST_SINK) {
+	  elapsed = now - ax25_get_rx_mark(pp);
+	  ax25_set_rx_mark (pp, now);
+	}
+	else {
+	  elapsed = now - rx_time;
+	}
+	if (elapsed < 0) elapsed = 0;
+
+	for (b = 0; b < RXL_NUM_BUCKETS - 1 && elapsed > limit[b]; b++) {
+	  /* Find bucket. */
+	}
+
+	dw_mutex_lock (&rxl_mutex);
+
+	st = &(stats[chan][point]);
+	st->hist[b]++;
+	st->count++;
+	st->total += elapsed;
+	if (elapsed > st->max) {
+	  st->max = elapsed;
+	}
+
+	dw_mutex_unlock (&rxl_mutex);
+
+} /* end rx_latency_mark */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rx_latency_get_stats
+ *
+ * Purpose:     Get a copy of the statistics for one channel and point.
+ *
+ *--------------------------------------------------------------------*/
+
+void rx_latency_get_stats (int chan, int point, struct rxl_stats_s *st)
+{
+	assert (chan >= 0 && chan < MAX_CHANS);
+	assert (point >= 0 && point < RXL_NUM_POINTS);
+
+	dw_mutex_lock (&rxl_mutex);
+	*st = stats[chan][point];
+	dw_mutex_unlock (&rxl_mutex);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rx_latency_print_stats
+ *
+ * Purpose:     Print latency histograms for one channel.
+ *
+ * Description:	This is called along with the audio statistics, "-a" option.
+ *		Nothing is printed if nothing has been received since last time.
+ *
+ *--------------------------------------------------------------------*/
+
+void rx_latency_print_stats (int chan)
+{
+	struct rxl_stats_s st[RXL_NUM_POINTS];
+	int p, b;
+
+	assert (chan >= 0 && chan < MAX_CHANS);
+
+	dw_mutex_lock (&rxl_mutex);
+	memcpy (st, stats[chan], sizeof(st));
+	dw_mutex_unlock (&rxl_mutex);
+
+	if (st[RXL_DECODE].count == stats_last_printed[chan]) {
+	  return;
+	}
+	stats_last_printed[chan] = st[RXL_DECODE].count;
+
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("Receive latency CH%d, ms:", chan);
+	for (b = 0; b < RXL_NUM_BUCKETS - 1; b++) {
+	  dw_printf (" <%g", limit[b] * 1000.);
+	}
+	dw_printf (" more\n");
+
+	for (p = 0; p < RXL_NUM_POINTS; p++) {
+	  if (st[p].count == 0) continue;
+
+	  dw_printf ("  %-7s ", point_name[p]);
+	  for (b = 0; b < RXL_NUM_BUCKETS; b++) {
+	    dw_printf (" %d", st[p].hist[b]);
+	  }
+	  dw_printf (",  count %d, avg %.1f, max %.1f ms\n",
+		st[p].count, 1000. * st[p].total / st[p].count, 1000. * st[p].max);
+	}
+
+} /* end rx_latency_print_stats */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rx_latency_write_json
+ *
+ * Purpose:     Write statistics as JSON object members for other applications.
+ *
+ * Description:	This writes "latency_limits_ms" and "latency" members,
+ *		without the enclosing braces, so it can be included
+ *		in the DSP statistics file.
+ *
+ *--------------------------------------------------------------------*/
+
+void rx_latency_write_json (FILE *fp)
+{
+	int chan, p, b;
+	int first = 1;
+
+	fprintf (fp, "  \"latency_limits_ms\": [");
+	for (b = 0; b < RXL_NUM_BUCKETS - 1; b++) {
+	  fprintf (fp, "%s%g", b == 0 ? "" : ", ", limit[b] * 1000.);
+	}
+	fprintf (fp, "],\n  \"latency\": [");
+
+	for (chan = 0; chan < MAX_CHANS; chan++) {
+	  for (p = 0; p < RXL_NUM_POINTS; p++) {
+	    struct rxl_stats_s st;
+
+	    rx_latency_get_stats (chan, p, &st);
+	    if (st.count == 0) continue;
+
+	    fprintf (fp, "%s\n    { \"point\": \"%s\", \"chan\": %d, \"count\": %d, \"avg_ms\": %.3f, \"max_ms\": %.3f, \"hist\": [",
+			first ? "" : ",", point_name[p], chan, st.count,
+			1000. * st.total / st.count, 1000. * st.max);
+	    for (b = 0; b < RXL_NUM_BUCKETS; b++) {
+	      fprintf (fp, "%s%d", b == 0 ? "" : ", ", st.hist[b]);
+	    }
+	    fprintf (fp, "] }");
+	    first = 0;
+	  }
+	}
+	fprintf (fp, "\n  ]");
+
+} /* end rx_latency_write_json */
+
+/* end rx_latency.c */
@@ -0,0 +1,70 @@
+
+/* rx_latency.h */
+
+#ifndef RX_LATENCY_H
+#define RX_LATENCY_H 1
+
+#include <stdio.h>
+
+#include "ax25_pad.h"		/* for packet_t */
+
+
+/*
+ * Points where we measure time for a received frame.
+ *
+ * The first group are steps along the way.  Each is the time
+ * since the end of the previous step.
+ *
+ * The second group are the times when the frame was handed over to
+ * each destination.  These are measured from the closing flag.
+ *
+ * Keep in sync with names in rx_latency.c.
+ */
+
+enum rxl_point_e {
+	RXL_DECODE = 0,		/* Closing flag to valid frame, including any fix bits. */
+	RXL_HOLD,		/* Waiting for other demodulators / slicers before picking best. */
+	RXL_QUEUE,		/* Waiting in received frame queue. */
+	RXL_APP,		/* Decoding, display, logging before sending to clients. */
+
+	RXL_AGW,		/* Given to AGW network protocol clients. */
+	RXL_KISSNET,		/* Given to KISS TCP clients. */
+	RXL_KISS,		/* Given to serial port and pseudo terminal KISS. */
+	RXL_IGATE,		/* Given to IGate. */
+	RXL_DIGI,		/* Digipeater finished. */
+	RXL_TOTAL,		/* Receive processing finished. */
+
+	RXL_NUM_POINTS
+};
+
+#define RXL_FIRST_SINK RXL_AGW
+
+
+/*
+ * Histogram of latency.
+ * Upper limits of the buckets are in rx_latency.c.  The last catches everything longer.
+ */
+
+#define RXL_NUM_BUCKETS 12
+
+struct rxl_stats_s {
+	int hist[RXL_NUM_BUCKETS];
+	int count;
+	double total;			/* Seconds.  Divide by count for average. */
+	double max;
+};
+
+
+void rx_latency_init (void);
+
+void rx_latency_mark (packet_t pp, int chan, int point);
+
+void rx_latency_get_stats (int chan, int point, struct rxl_stats_s *st);
+
+void rx_latency_print_stats (int chan);
+
+void rx_latency_write_json (FILE *fp);
+
+#endif
+
+/* end rx_latency.h */
@@ -49,7 +49,7 @@
  *			'V'	Transmit UI data frame.
  *				Generate audio for transmission.
  *
- *			'H'	Report recently heard stations.  Not implemented yet.
+ *			'H'	Report recently heard stations.
  *
  *			'K'	Transmit raw AX.25 frame.
  *		
@@ -135,6 +135,7 @@
 #include "textcolor.h"
 #include "audio.h"
 #include "server.h"
+#include "heard.h"
 
 
 
@@ -264,6 +265,37 @@ struct agwpe_s {
 static void send_to_client (int client, void *reply_p);
 
 
+/*
+ * For the 'H' heard stations reply.
+ */
+
+#define MAX_AGW_HEARD 20		/* AGWPE gives us at most this many. */
+
+#define AGW_SYSTEMTIME_SIZE 16		/* Windows SYSTEMTIME: 8 little endian 16 bit values. */
+
+#define AGW_PORT_INFO_LEN 40		/* Room for one port in 'G' reply, e.g. "Port16 seventh soundcard right;" */
+
+static void agw_systemtime (struct tm *tm, unsigned char *out)
+{
+	int v[8];
+	int n;
+
+	v[0] = tm->tm_year + 1900;
+	v[1] = tm->tm_mon + 1;
+	v[2] = tm->tm_wday;
+	v[3] = tm->tm_mday;
+	v[4] = tm->tm_hour;
+	v[5] = tm->tm_min;
+	v[6] = tm->tm_sec;
+	v[7] = 0;			/* milliseconds */
+
+	for (n = 0; n < 8; n++) {
+	  out[n*2] = v[n] & 0xff;
+	  out[n*2+1] = (v[n] >> 8) & 0xff;
+	}
+}
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        debug_print 
@@ -1257,11 +1289,12 @@ static THREAD_F cmd_listen_thread (void *arg)
 	      {
 		struct {
 		  struct agwpe_s hdr;
-	 	  char info[200];
+	 	  char info[10 + MAX_CHANS * AGW_PORT_INFO_LEN];
 		} reply;
 
 
 		int j, count;
+		char ports[MAX_CHANS * AGW_PORT_INFO_LEN];
 
 
 	        memset (&reply, 0, sizeof(reply));
@@ -1278,32 +1311,31 @@ static THREAD_F cmd_listen_thread (void *arg)
 
 #if 1
 		// No other place cares about total number.
+		// Count only what fits so the number agrees with the list.
 
 		count = 0;
-		for (j=0; j<MAX_CHANS; j++) {
-	 	  if (save_audio_config_p->achan[j].valid) {
-		    count++;
-		  }
-		}
-		snprintf (reply.info, sizeof(reply.info), "%d;", count);
+		ports[0] = '\0';
 
 		for (j=0; j<MAX_CHANS; j++) {
 	 	  if (save_audio_config_p->achan[j].valid) {
-		    char stemp[100];
+		    char stemp[AGW_PORT_INFO_LEN];
 		    int a = ACHAN2ADEV(j);
 		    // If I was really ambitious, some description could be provided.
 		    static const char *names[8] = { "first", "second", "third", "fourth", "fifth", "sixth", "seventh", "eighth" };
 
 		    if (save_audio_config_p->adev[a].num_channels == 1) {
 		      snprintf (stemp, sizeof(stemp), "Port%d %s soundcard mono;", j+1, names[a]);
-		      strlcat (reply.info, stemp, sizeof(reply.info));
 		    }
 		    else {
 		      snprintf (stemp, sizeof(stemp), "Port%d %s soundcard %s;", j+1, names[a], j&1 ? "right" : "left");
-		      strlcat (reply.info, stemp, sizeof(reply.info));
+		    }
+		    if (strlen(ports) + strlen(stemp) < sizeof(ports)) {
+		      strlcat (ports, stemp, sizeof(ports));
+		      count++;
 		    }
 		  }
 		}
+		snprintf (reply.info, sizeof(reply.info), "%d;%s", count, ports);
 
 #else
 		if (num_channels == 1) {
@@ -1367,29 +1399,59 @@ static THREAD_F cmd_listen_thread (void *arg)
 
 	    case 'H':				/* Ask about recently heard stations. */
 
+	      /*
+	       * One reply for each station, most recently heard first, up to 20.
+	       * call_from is the station heard.
+	       * Data is a line of text, nul terminated, followed by
+	       * the first and last heard times in the Windows SYSTEMTIME form.
+	       * If nothing has been heard, we send a single reply with
+	       * empty call_from and no data.
+	       */
 	      {
-#if 0						/* This information is not being collected. */
+		struct heard_s heard[MAX_AGW_HEARD];
+		int num_heard;
+		int j;
 		struct {
 		  struct agwpe_s hdr;
-	 	  char info[100];
+	 	  char info[100+2*AGW_SYSTEMTIME_SIZE];
 		} reply;
 
+		num_heard = heard_snapshot (cmd.hdr.portx, heard, MAX_AGW_HEARD);
 
 	        memset (&reply.hdr, 0, sizeof(reply.hdr));
 	        reply.hdr.datakind = 'H';
+	        reply.hdr.portx = cmd.hdr.portx;
 
-		// TODO:  Implement properly.  
+		if (num_heard == 0) {
+	          reply.hdr.data_len_NETLE = host2netle(0);
+	          send_to_client (client, &reply);
+		}
 
-	        reply.hdr.portx = cmd.hdr.portx
+		for (j = 0; j < num_heard; j++) {
+		  struct tm tm_first, tm_last;
+		  char s_first[32], s_last[32];
+		  int len;
 
-	        strlcpy (reply.hdr.call_from, "WB2OSZ-15", sizeof(reply.hdr.call_from));
+		  localtime_r (&(heard[j].first_heard), &tm_first);
+		  localtime_r (&(heard[j].last_heard), &tm_last);
+		  strftime (s_first, sizeof(s_first), "%a %d %b %H:%M:%S", &tm_first);
+		  strftime (s_last, sizeof(s_last), "%a %d %b %H:%M:%S", &tm_last);
 
-	        strlcpy (agwpe_msg.data, ..., sizeof(agwpe_msg.data));
+	          memset (reply.info, 0, sizeof(reply.info));
+	          strlcpy (reply.hdr.call_from, heard[j].call, sizeof(reply.hdr.call_from));
 
-	        reply.hdr.data_len_NETLE = host2netle(strlen(reply.info));
+		  snprintf (reply.info, 100, "%-9s %s  %s", heard[j].call, s_first, s_last);
+		  len = strlen(reply.info) + 1;
 
-	        send_to_client (client, &reply);
-#endif
+		  agw_systemtime (&tm_first, (unsigned char *)(reply.info + len));
+		  len += AGW_SYSTEMTIME_SIZE;
+		  agw_systemtime (&tm_last, (unsigned char *)(reply.info + len));
+		  len += AGW_SYSTEMTIME_SIZE;
+
+	          reply.hdr.data_len_NETLE = host2netle(len);
+
+	          send_to_client (client, &reply);
+		}
 	      }
 	      break;
 	    
@@ -1462,7 +1524,7 @@ static THREAD_F cmd_listen_thread (void *arg)
 		  /* xastir when using the AGW interface.  */
 		  /* The current version uses only the 'V' message, not 'K' for transmitting. */
 
-		  tq_append (cmd.hdr.portx, TQ_PRIO_1_LO, pp);
+		  tq_append (cmd.hdr.portx, TQ_PRIO_1_LO, TQ_SRC_AGW, pp);
 
 		}
 	      }
@@ -1510,10 +1572,10 @@ static THREAD_F cmd_listen_thread (void *arg)
 
 		  if (ax25_get_num_repeaters(pp) >= 1 &&
 		      ax25_get_h(pp,AX25_REPEATER_1)) {
-		    tq_append (cmd.hdr.portx, TQ_PRIO_0_HI, pp);
+		    tq_append (cmd.hdr.portx, TQ_PRIO_0_HI, TQ_SRC_AGW, pp);
 		  }
 		  else {
-		    tq_append (cmd.hdr.portx, TQ_PRIO_1_LO, pp);
+		    tq_append (cmd.hdr.portx, TQ_PRIO_1_LO, TQ_SRC_AGW, pp);
 		  }
 		}
 	      }
@@ -1713,7 +1775,7 @@ static THREAD_F cmd_listen_thread (void *arg)
 		  dw_printf ("Failed to create frame from AGW 'M' message.\n");
 		}
 		else {
-		  tq_append (cmd.hdr.portx, TQ_PRIO_1_LO, pp);
+		  tq_append (cmd.hdr.portx, TQ_PRIO_1_LO, TQ_SRC_AGW, pp);
 		}
 	      }
 	      break;
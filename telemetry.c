@@ -56,12 +56,14 @@
 #include <string.h>
 #include <math.h>
 #include <ctype.h>
+#include <time.h>
 
 #include "direwolf.h"
 #include "ax25_pad.h"			// for packet_t, AX25_MAX_ADDR_LEN
 #include "decode_aprs.h"		// for decode_aprs_t, G_UNKNOWN  
 #include "textcolor.h"
 #include "telemetry.h"
+#include "lru_table.h"
 
 
 #define MAX(x,y) ((x)>(y) ? (x) : (y))
@@ -86,12 +88,10 @@
  */
 
 struct t_metadata_s {
+	struct lru_node_s node;			/* Hash and LRU links.  Key is station */
+						/* name with optional SSID.  Must be first. */
 	int magic1;
 
-	struct t_metadata_s * pnext;		/* Next in linked list. */
-
-	char station[AX25_MAX_ADDR_LEN];	/* Station name with optional SSID. */
-
 	char project[40];			/* Description for data. */
 						/* "Project Name" or "project title" in the spec. */
 
@@ -111,11 +111,140 @@ struct t_metadata_s {
 };
 
 
-static 	struct t_metadata_s * md_list_head = NULL;
+/*
+ * Originally we had a single linked list, searched from the beginning for
+ * every telemetry packet and metadata message, and it grew forever.
+ * That is fine for a few local stations heard over the radio but an IGate
+ * can see telemetry from thousands of stations on the Internet server.
+ *
+ * In version 1.4, we use a hash table for lookup and keep the entries
+ * in least recently used order.  When the limit is reached, the entry
+ * not referenced for the longest time is recycled for the new station.
+ * See lru_table.c.
+ */
+
+static struct lru_table_s md_table;		/* Set up by telemetry_init. */
+static int md_initialized = 0;
+
+static unsigned long md_lookups = 0;		/* Total number of lookups. */
+
+static unsigned long md_prev_lookups = 0;	/* For calculating lookup rate */
+static time_t md_prev_time = 0;			/* in telemetry_get_stats. */
+
+static dw_mutex_t md_mutex;			/* Decoding happens in receive, IGate, */
+						/* and other threads. */
+
 
 static void t_data_process (struct t_metadata_s *pm, int seq, float araw[T_NUM_ANALOG], int ndp[T_NUM_ANALOG], int draw[T_NUM_DIGITAL], char *output, size_t outputsize); 
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        telemetry_init
+ *
+ * Purpose:     Set up the metadata storage.
+ *
+ * Inputs:	max_stations	- Maximum number of stations to remember.
+ *				  0 for default.
+ *
+ * Description:	The main application calls this once at start up,
+ *		before any other threads are created.
+ *		Other applications, such as decode_aprs and atest,
+ *		don't bother and get the default when first used.
+ *
+ *--------------------------------------------------------------------*/
+
+void telemetry_init (int max_stations)
+{
+	if (md_initialized) {
+	  return;		/* Only once. */
+	}
+
+	if (max_stations < TLM_MIN_STATIONS || max_stations > TLM_MAX_STATIONS) {
+	  max_stations = TLM_DEFAULT_STATIONS;
+	}
+
+	lru_table_init (&md_table, max_stations);
+
+	dw_mutex_init (&md_mutex);
+
+	md_initialized = 1;
+
+	md_prev_time = time(NULL);
+
+} /* end telemetry_init */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        telemetry_get_stats
+ *
+ * Purpose:     Obtain statistics about the metadata storage.
+ *
+ * Outputs:	stats	- Number of entries, limit, evictions, and
+ *			  lookup rate since the previous call.
+ *
+ *--------------------------------------------------------------------*/
+
+void telemetry_get_stats (struct telemetry_stats_s *stats)
+{
+	time_t now;
+
+	telemetry_init (0);
+
+	dw_mutex_lock (&md_mutex);
+
+	now = time(NULL);
+
+	stats->entries = md_table.entries;
+	stats->max_stations = md_table.max_entries;
+	stats->evictions = md_table.evictions;
+	stats->lookups = md_lookups;
+	if (now > md_prev_time) {
+	  stats->lookups_per_sec = (float)(md_lookups - md_prev_lookups) / (float)(now - md_prev_time);
+	}
+	else {
+	  stats->lookups_per_sec = 0;
+	}
+
+	md_prev_lookups = md_lookups;
+	md_prev_time = now;
+
+	dw_mutex_unlock (&md_mutex);
+
+} /* end telemetry_get_stats */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        telemetry_print_stats
+ *
+ * Purpose:     Print statistics about the metadata storage.
+ *
+ * Description:	This is called along with the audio statistics, "-a" option.
+ *		Nothing is printed if there were no lookups since last time.
+ *
+ *--------------------------------------------------------------------*/
+
+void telemetry_print_stats (void)
+{
+	static unsigned long last_lookups = 0;
+	struct telemetry_stats_s st;
+
+	telemetry_get_stats (&st);
+
+	if (st.lookups == last_lookups) {
+	  return;
+	}
+	last_lookups = st.lookups;
+
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("Telemetry metadata: %d of %d stations, %lu recycled, %.1f lookups/sec\n",
+		st.entries, st.max_stations, st.evictions, st.lookups_per_sec);
+
+} /* end telemetry_print_stats */
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        t_get_metadata
@@ -127,11 +256,16 @@ static void t_data_process (struct t_metadata_s *pm, int seq, float araw[T_NUM_A
  *
  * Returns:	Pointer to metadata.
  *
+ * Description:	Caller must hold md_mutex while using the result because 
+ *		the entry could be recycled for a different station.
+ *
  *--------------------------------------------------------------------*/
 
 static struct t_metadata_s * t_get_metadata (char *station)
 {
 	struct t_metadata_s *p;
+	unsigned long evictions;
+	unsigned int h;
 	int n;
 
 #if DEBUG3
@@ -139,22 +273,36 @@ static struct t_metadata_s * t_get_metadata (char *station)
 	dw_printf ("t_get_metadata (station=%s)\n", station);
 #endif
 
-	for (p = md_list_head; p != NULL; p = p->pnext) {
-	  if (strcmp(station, p->station) == 0) {
+	assert (md_initialized);
 
-	    assert (p->magic1 == MAGIC1);
-	    assert (p->magic2 == MAGIC2);
+	md_lookups++;
 
-	    return (p);
-	  }
+	h = lru_table_hash (station);
+
+	p = (struct t_metadata_s *) lru_table_find (&md_table, station, h);
+	if (p != NULL) {
+
+	  assert (p->magic1 == MAGIC1);
+	  assert (p->magic2 == MAGIC2);
+
+	  lru_table_touch (&md_table, &(p->node));
+	  return (p);
 	}
 
-	p = malloc (sizeof (struct t_metadata_s));
-	memset (p, 0, sizeof (struct t_metadata_s));
+/*
+ * Not found.  The least recently used is recycled if at the limit.
+ */
+
+	evictions = md_table.evictions;
+
+	p = (struct t_metadata_s *) lru_table_add (&md_table, station, h, sizeof (struct t_metadata_s));
+
+	if (evictions == 0 && md_table.evictions > 0) {
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Telemetry metadata now at limit of %d stations.  Least recently used will be discarded.\n", md_table.max_entries);
+	}
 
 	p->magic1 = MAGIC1;
-	
-	strlcpy (p->station, station, sizeof(p->station));
 
 	for (n = 0; n < T_NUM_ANALOG; n++) {
 	  snprintf (p->name[n], sizeof(p->name[n]), "A%d", n+1);
@@ -178,9 +326,6 @@ static struct t_metadata_s * t_get_metadata (char *station)
 
 	p->magic2 = MAGIC2;
 
-	p->pnext = md_list_head;
-	md_list_head = p;
-
 	assert (p->magic1 == MAGIC1);
 	assert (p->magic2 == MAGIC2);
 
@@ -279,11 +424,6 @@ void telemetry_data_original (char *station, char *info, int quiet, char *output
 	strlcpy (output, "", outputsize);
 	strlcpy (comment, "", commentsize);
 
-	pm = t_get_metadata(station);
-
-	assert (pm->magic1 == MAGIC1);
-	assert (pm->magic2 == MAGIC2);
-
 	seq = 0;
 	for (n = 0; n < T_NUM_ANALOG; n++) {
 	  araw[n] = G_UNKNOWN;
@@ -392,8 +532,16 @@ void telemetry_data_original (char *station, char *info, int quiet, char *output
 
 #endif
 
+	telemetry_init (0);
+
+	dw_mutex_lock (&md_mutex);
+
+	pm = t_get_metadata(station);
+
 	t_data_process (pm, seq, araw, ndp, draw, output, outputsize);
 
+	dw_mutex_unlock (&md_mutex);
+
 } /* end telemtry_data_original */
 
 
@@ -467,11 +615,6 @@ void telemetry_data_base91 (char *station, char *cdata, char *output, size_t out
 
 	strlcpy (output, "", outputsize);
 
-	pm = t_get_metadata(station);
-
-	assert (pm->magic1 == MAGIC1);
-	assert (pm->magic2 == MAGIC2);
-
 	seq = 0;
 	for (n = 0; n < T_NUM_ANALOG; n++) {
 	  araw[n] = G_UNKNOWN;
@@ -518,8 +661,16 @@ void telemetry_data_base91 (char *station, char *cdata, char *output, size_t out
 
 #endif
 
+	telemetry_init (0);
+
+	dw_mutex_lock (&md_mutex);
+
+	pm = t_get_metadata(station);
+
 	t_data_process (pm, seq, araw, ndp, draw, output, outputsize);
 
+	dw_mutex_unlock (&md_mutex);
+
 } /* end telemtry_data_base91 */
 
 
@@ -574,6 +725,10 @@ void telemetry_name_message (char *station, char *msg)
 	  *p = '\0';
 	} 
 
+	telemetry_init (0);
+
+	dw_mutex_lock (&md_mutex);
+
 	pm = t_get_metadata(station);
 	assert (pm->magic1 == MAGIC1);
 	assert (pm->magic2 == MAGIC2);
@@ -599,6 +754,8 @@ void telemetry_name_message (char *station, char *msg)
 	}
 #endif
 
+	dw_mutex_unlock (&md_mutex);
+
 } /* end telemetry_name_message */
 
 
@@ -650,6 +807,10 @@ void telemetry_unit_label_message (char *station, char *msg)
 	  *p = '\0';
 	} 
 
+	telemetry_init (0);
+
+	dw_mutex_lock (&md_mutex);
+
 	pm = t_get_metadata(station);
 	assert (pm->magic1 == MAGIC1);
 	assert (pm->magic2 == MAGIC2);
@@ -675,6 +836,8 @@ void telemetry_unit_label_message (char *station, char *msg)
 	}
 #endif
 
+	dw_mutex_unlock (&md_mutex);
+
 } /* end telemetry_unit_label_message */
 
 
@@ -727,6 +890,10 @@ void telemetry_coefficents_message (char *station, char *msg, int quiet)
 	  *p = '\0';
 	} 
 
+	telemetry_init (0);
+
+	dw_mutex_lock (&md_mutex);
+
 	pm = t_get_metadata(station);
 	assert (pm->magic1 == MAGIC1);
 	assert (pm->magic2 == MAGIC2);
@@ -772,6 +939,8 @@ void telemetry_coefficents_message (char *station, char *msg, int quiet)
 	}
 #endif
 
+	dw_mutex_unlock (&md_mutex);
+
 } /* end telemetry_coefficents_message */
 
 
@@ -807,6 +976,10 @@ void telemetry_bit_sense_message (char *station, char *msg, int quiet)
 	dw_printf ("\n%s\n\n", msg);
 #endif
 
+	telemetry_init (0);
+
+	dw_mutex_lock (&md_mutex);
+
 	pm = t_get_metadata(station);
 	assert (pm->magic1 == MAGIC1);
 	assert (pm->magic2 == MAGIC2);
@@ -858,6 +1031,8 @@ void telemetry_bit_sense_message (char *station, char *msg, int quiet)
 
 #endif
 
+	dw_mutex_unlock (&md_mutex);
+
 } /* end telemetry_bit_sense_message */
 
 
@@ -1019,6 +1194,8 @@ static void t_data_process (struct t_metadata_s *pm, int seq, float araw[T_NUM_A
 
 int main ( )
 {
+	int n;
+	struct t_metadata_s *pm;
 	char result[120];
 	char comment[40];
 	int errors = 0;
@@ -1030,6 +1207,8 @@ int main ( )
 	text_color_set(DW_COLOR_INFO);
 	dw_printf ("Unit test for telemetry decoding functions...\n");	
 
+	telemetry_init (TLM_MIN_STATIONS);
+
 #if DEBUG1
 
 	text_color_set(DW_COLOR_INFO);
@@ -1159,7 +1338,6 @@ int main ( )
 
 	telemetry_name_message ("N0QBF-11", "Battery,Btemp,ATemp,Pres,Alt,Camra,Chut,Sun,10m,ATV");
 
-	struct t_metadata_s *pm;
 	pm = t_get_metadata("N0QBF-11");
 
 	if (strcmp(pm->name[0],  "Battery") != 0 ||
@@ -1330,6 +1508,57 @@ int main ( )
 	}
 
 
+
+/*
+ * Least recently used should be recycled when limit is reached.
+ * M0XER-3 was used most recently so it should survive.
+ */
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("part 5\n");	
+
+	{
+	  struct telemetry_stats_s st;
+	  char station[AX25_MAX_ADDR_LEN];
+
+	  telemetry_get_stats (&st);
+	  int entries_before = st.entries;
+
+	  for (n = 0; n < TLM_MIN_STATIONS - entries_before; n++) {
+	    snprintf (station, sizeof(station), "N%dXX", n);
+	    telemetry_name_message (station, "Volts");
+	  }
+	  telemetry_data_base91 ("M0XER-3", "DyR.&^<A!.", result, sizeof(result));
+
+	  telemetry_get_stats (&st);
+	  if (st.entries != TLM_MIN_STATIONS || st.evictions != 0) {
+	    errors++; text_color_set(DW_COLOR_ERROR); dw_printf ("Wrong result, test 501\n");
+	  }
+
+	  telemetry_name_message ("W1AW", "Volts");
+
+	  telemetry_get_stats (&st);
+	  if (st.entries != TLM_MIN_STATIONS || st.evictions != 1) {
+	    errors++; text_color_set(DW_COLOR_ERROR); dw_printf ("Wrong result, test 502\n");
+	  }
+
+	  telemetry_data_base91 ("M0XER-3", "DyR.&^<A!.", result, sizeof(result));
+
+	  if (strcmp(result, "10mW research balloon: Seq=3273, Vbat=4.472 V, Vsolar=0.516 V, Temp=-24.3 C, Sat=13") != 0) {
+	    errors++; text_color_set(DW_COLOR_ERROR); dw_printf ("Wrong result, test 503\n");
+	  }
+
+	  pm = t_get_metadata("W1AW");
+	  if (strcmp(pm->name[0], "Volts") != 0) {
+	    errors++; text_color_set(DW_COLOR_ERROR); dw_printf ("Wrong result, test 504\n");
+	  }
+
+	  telemetry_get_stats (&st);
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Telemetry metadata: %d of %d stations, %lu evictions, %lu lookups.\n", 
+			st.entries, st.max_stations, st.evictions, st.lookups);
+	}
+
 /* final score. */
 
 	if (errors != 0) {
@@ -2,6 +2,30 @@
 
 /* telemetry.h */
 
+
+/*
+ * Limits for number of stations with telemetry metadata.
+ */
+
+#define TLM_MIN_STATIONS 10
+#define TLM_DEFAULT_STATIONS 1000
+#define TLM_MAX_STATIONS 100000
+
+
+struct telemetry_stats_s {
+	int entries;			/* Number of stations currently stored. */
+	int max_stations;		/* Limit before recycling least recently used. */
+	unsigned long evictions;	/* How many have been recycled. */
+	unsigned long lookups;		/* Total number of lookups. */
+	float lookups_per_sec;		/* Rate since previous telemetry_get_stats call. */
+};
+
+void telemetry_init (int max_stations);
+
+void telemetry_get_stats (struct telemetry_stats_s *stats);
+
+void telemetry_print_stats (void);
+
 void telemetry_data_original (char *station, char *info, int quiet, char *output, size_t outputsize, char *comment, size_t commentsize);
  
 void telemetry_data_base91 (char *station, char *cdata, char *output, size_t outputsize);
@@ -33,6 +33,11 @@
  *
  * Revisions:	1.2 - Enhance for multiple audio devices.
  *
+ *		1.4 - Separate lock for each channel.  Keep tail pointer
+ *			and count so append doesn't need to walk the list.
+ *			Configurable limits for each priority and source.
+ *			Statistics for time spent waiting in queue.
+ *
  *---------------------------------------------------------------*/
 
 #include <stdio.h>
@@ -47,15 +52,40 @@
 #include "audio.h"
 #include "tq.h"
 #include "dedupe.h"
+#include "dtime_now.h"
 
 
 
 
 static packet_t queue_head[MAX_CHANS][TQ_NUM_PRIO];	/* Head of linked list for each queue. */
 
+static packet_t queue_tail[MAX_CHANS][TQ_NUM_PRIO];	/* Last in list so we can append without */
+							/* walking the whole thing. */
+
+static int queue_count[MAX_CHANS][TQ_NUM_PRIO];		/* Number in each queue. */
+
+static int src_count[MAX_CHANS][TQ_NUM_SRC];		/* Number from each source, all priorities. */
+
+
+static dw_mutex_t tq_mutex[MAX_CHANS];			/* Critical section for updating queues. */
+							/* One for each channel so producers for */
+							/* different channels don't get in each other's way. */
+
+static struct tq_stats_s stats[MAX_CHANS];		/* Protected by tq_mutex of channel. */
+
+static int stats_last_printed[MAX_CHANS];		/* Total removed when last printed. */
+
+
+/*
+ * Upper limit, in seconds, for each bucket of the wait time histogram.
+ * Last bucket is for anything longer than the previous limit.
+ */
+
+static const double wait_limit[TQ_WAIT_NUM_BUCKETS-1] = { 0.1, 0.25, 0.5, 1, 2, 5, 10, 30 };
+
+
+static const char *src_name[TQ_NUM_SRC] = { "OTHER", "BEACON", "DIGI", "IGATE", "KISS", "AGW", "APRSTT" };
 
-static dw_mutex_t tq_mutex;				/* Critical section for updating queues. */
-							/* Just one for all queues. */
 
 #if __WIN32__
 
@@ -127,14 +157,21 @@ void tq_init (struct audio_s *audio_config_p)
 	for (c=0; c<MAX_CHANS; c++) {
 	  for (p=0; p<TQ_NUM_PRIO; p++) {
 	    queue_head[c][p] = NULL;
+	    queue_tail[c][p] = NULL;
+	    queue_count[c][p] = 0;
 	  }
+	  memset (src_count[c], 0, sizeof(src_count[c]));
+	  memset (&(stats[c]), 0, sizeof(stats[c]));
+	  stats_last_printed[c] = 0;
 	}
 
 /*
- * Mutex to coordinate access to the queue.
+ * Mutex to coordinate access to the queues.
  */
 
-	dw_mutex_init(&tq_mutex);
+	for (c=0; c<MAX_CHANS; c++) {
+	  dw_mutex_init(&(tq_mutex[c]));
+	}
 
 /*
  * Windows and Linux have different wake up methods.
@@ -192,6 +229,9 @@ void tq_init (struct audio_s *audio_config_p)
  *
  *		prio	- Priority, use TQ_PRIO_0_HI or TQ_PRIO_1_LO.
  *
+ *		src	- Which part of the application is sending it.
+ *			  One of TQ_SRC_BEACON, TQ_SRC_DIGI, etc.
+ *
  *		pp	- Address of packet object.
  *				Caller should NOT make any references to
  *				it after this point because it could
@@ -210,19 +250,20 @@ void tq_init (struct audio_s *audio_config_p)
  *
  *--------------------------------------------------------------------*/
 
-void tq_append (int chan, int prio, packet_t pp)
+void tq_append (int chan, int prio, int src, packet_t pp)
 {
-	packet_t plast;
-	packet_t pnext;
+	int limit_prio, limit_src;
+	int too_many;
 
 
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
-	dw_printf ("tq_append (chan=%d, prio=%d, pp=%p)\n", chan, prio, pp);
+	dw_printf ("tq_append (chan=%d, prio=%d, src=%d, pp=%p)\n", chan, prio, src, pp);
 #endif
 
 
 	assert (prio >= 0 && prio < TQ_NUM_PRIO);
+	assert (src >= 0 && src < TQ_NUM_SRC);
 
 	if (pp == NULL) {
 	  text_color_set(DW_COLOR_DEBUG);
@@ -268,48 +309,78 @@ void tq_append (int chan, int prio, packet_t pp)
  * Limit was 20.  Changed to 100 in version 1.2 as a workaround.
  *
  * Implementing the 6PACK protocol is probably the proper solution.
+ *
+ * In version 1.4, the limit can be set with TXQLIMIT in the configuration file,
+ * for each priority and for each source.  It still applies only to APRS packets.
  */
 
-	if (ax25_is_aprs(pp) && tq_count(chan,prio) > 100) {
-	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("Transmit packet queue for channel %d is too long.  Discarding packet.\n", chan);
-	  dw_printf ("Perhaps the channel is so busy there is no opportunity to send.\n");
-	  ax25_delete(pp);
-	  return;
-	}
+	limit_prio = save_audio_config_p->achan[chan].txq_limit_prio[prio];
+	limit_src = save_audio_config_p->achan[chan].txq_limit_src[src];
+
+	ax25_set_queue_info (pp, src, dtime_now());
 
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
 	dw_printf ("tq_append: enter critical section\n");
 #endif
 
-	dw_mutex_lock (&tq_mutex);
+	dw_mutex_lock (&(tq_mutex[chan]));
 
-//	was_empty = 1;
-//	for (c=0; c<tq_num_channels; c++) {
-//	  for (p=0; p<TQ_NUM_PRIO; p++) {
-//	    if (queue_head[c][p] != NULL)
-//	       was_empty = 0;
-//	  }
-//	}
+	too_many = 0;
+	if (ax25_is_aprs(pp)) {
+	  if (limit_prio > 0 && queue_count[chan][prio] > limit_prio) {
+	    too_many = 1;
+	  }
+	  else if (limit_src > 0 && src_count[chan][src] > limit_src) {
+	    too_many = 2;
+	  }
+	}
 
-	if (queue_head[chan][prio] == NULL) {
-	  queue_head[chan][prio] = pp;
+	if (too_many) {
+	  stats[chan].discarded[prio]++;
 	}
 	else {
-	  plast = queue_head[chan][prio];
-	  while ((pnext = ax25_get_nextp(plast)) != NULL) {
-	    plast = pnext;
+	  ax25_set_nextp (pp, NULL);
+	  if (queue_head[chan][prio] == NULL) {
+	    queue_head[chan][prio] = pp;
+	  }
+	  else {
+	    ax25_set_nextp (queue_tail[chan][prio], pp);
+	  }
+	  queue_tail[chan][prio] = pp;
+	  queue_count[chan][prio]++;
+	  src_count[chan][src]++;
+
+	  stats[chan].appended[prio]++;
+	  stats[chan].from_src[src]++;
+	  if (queue_count[chan][prio] > stats[chan].max_depth[prio]) {
+	    stats[chan].max_depth[prio] = queue_count[chan][prio];
 	  }
-	  ax25_set_nextp (plast, pp);
 	}
 
-	dw_mutex_unlock (&tq_mutex);
+	dw_mutex_unlock (&(tq_mutex[chan]));
 
 
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
 	dw_printf ("tq_append: left critical section\n");
+#endif
+
+	if (too_many) {
+	  text_color_set(DW_COLOR_ERROR);
+	  if (too_many == 1) {
+	    dw_printf ("Transmit packet queue for channel %d is too long.  Discarding packet.\n", chan);
+	  }
+	  else {
+	    dw_printf ("Too many packets from %s waiting for transmit on channel %d.  Discarding packet.\n", src_name[src], chan);
+	  }
+	  dw_printf ("Perhaps the channel is so busy there is no opportunity to send.\n");
+	  ax25_delete(pp);
+	  return;
+	}
+
+#if DEBUG
+	text_color_set(DW_COLOR_DEBUG);
 	dw_printf ("tq_append (): about to wake up xmit thread.\n");
 #endif
 
@@ -362,7 +433,7 @@ void tq_wait_while_empty (int chan)
 #endif
 	assert (chan >= 0 && chan < MAX_CHANS);
 
-	dw_mutex_lock (&tq_mutex);
+	dw_mutex_lock (&(tq_mutex[chan]));
 
 #if DEBUG
 	//text_color_set(DW_COLOR_DEBUG);
@@ -370,7 +441,7 @@ void tq_wait_while_empty (int chan)
 #endif
 	is_empty = tq_is_empty(chan);
 
-	dw_mutex_unlock (&tq_mutex);
+	dw_mutex_unlock (&(tq_mutex[chan]));
 
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
@@ -455,20 +526,39 @@ packet_t tq_remove (int chan, int prio)
 	dw_printf ("tq_remove(%d,%d) enter critical section\n", chan, prio);
 #endif
 
-	dw_mutex_lock (&tq_mutex);
+	assert (chan >= 0 && chan < MAX_CHANS);
+	assert (prio >= 0 && prio < TQ_NUM_PRIO);
+
+	dw_mutex_lock (&(tq_mutex[chan]));
 
 	if (queue_head[chan][prio] == NULL) {
 
 	  result_p = NULL;
 	}
 	else {
+	  double wait;
+	  int b;
 
 	  result_p = queue_head[chan][prio];
 	  queue_head[chan][prio] = ax25_get_nextp(result_p);
+	  if (queue_head[chan][prio] == NULL) {
+	    queue_tail[chan][prio] = NULL;
+	  }
 	  ax25_set_nextp (result_p, NULL);
+	  queue_count[chan][prio]--;
+	  src_count[chan][ax25_get_queue_src(result_p)]--;
+
+	  wait = dtime_now() - ax25_get_queue_time(result_p);
+	  for (b = 0; b < TQ_WAIT_NUM_BUCKETS - 1 && wait > wait_limit[b]; b++) ;
+	  stats[chan].wait_hist[prio][b]++;
+	  stats[chan].wait_total[prio] += wait;
+	  if (wait > stats[chan].wait_max[prio]) {
+	    stats[chan].wait_max[prio] = wait;
+	  }
+	  stats[chan].removed[prio]++;
 	}
 	 
-	dw_mutex_unlock (&tq_mutex);
+	dw_mutex_unlock (&(tq_mutex[chan]));
 
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
@@ -486,6 +576,41 @@ packet_t tq_remove (int chan, int prio)
 }
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        tq_peek
+ *
+ * Purpose:     Look at the packet at the head of the specified transmit queue
+ *		without removing it.
+ *
+ * Inputs:	chan	- Channel, 0 is first.
+ *
+ *		prio	- Priority, use TQ_PRIO_0_HI or TQ_PRIO_1_LO.
+ *
+ * Returns:	Pointer to packet object or NULL if queue is empty.
+ *		Caller must not modify or delete it.
+ *
+ * Description:	Only the transmit thread for the channel removes packets
+ *		so the packet stays at the head, and a following tq_remove
+ *		by the same thread will return it.
+ *
+ *--------------------------------------------------------------------*/
+
+packet_t tq_peek (int chan, int prio)
+{
+	packet_t result_p;
+
+	assert (chan >= 0 && chan < MAX_CHANS);
+	assert (prio >= 0 && prio < TQ_NUM_PRIO);
+
+	dw_mutex_lock (&(tq_mutex[chan]));
+	result_p = queue_head[chan][prio];
+	dw_mutex_unlock (&(tq_mutex[chan]));
+
+	return (result_p);
+}
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        tq_is_empty
@@ -534,20 +659,17 @@ static int tq_is_empty (int chan)
 
 int tq_count (int chan, int prio)
 {
-
-	packet_t p;
 	int n;
 
+	if (chan < 0 || chan >= MAX_CHANS || prio < 0 || prio >= TQ_NUM_PRIO) {
+	  return (0);
+	}
 
-/* Don't bother with critical section. */
-/* Only used for debugging a problem. */
+/* Count is kept up to date by append and remove so no need to walk the list. */
 
-	n = 0;
-	p = queue_head[chan][prio];
-	while (p != NULL) {
-	  n++;
-	  p = ax25_get_nextp(p);
-	}
+	dw_mutex_lock (&(tq_mutex[chan]));
+	n = queue_count[chan][prio];
+	dw_mutex_unlock (&(tq_mutex[chan]));
 
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
@@ -558,4 +680,101 @@ int tq_count (int chan, int prio)
 
 } /* end tq_count */
 
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        tq_src_name
+ *
+ * Purpose:     Name of packet source, as used in configuration file and reports.
+ *
+ * Inputs:	src	- One of TQ_SRC_...
+ *
+ *--------------------------------------------------------------------*/
+
+const char *tq_src_name (int src)
+{
+	if (src < 0 || src >= TQ_NUM_SRC) {
+	  return ("?");
+	}
+	return (src_name[src]);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        tq_get_stats
+ *
+ * Purpose:     Get a copy of the statistics for one channel.
+ *
+ * Inputs:	chan	- Channel, 0 is first.
+ *
+ * Outputs:	st	- Counts, high water mark, and histogram of
+ *			  time waiting in queue, for each priority.
+ *
+ *--------------------------------------------------------------------*/
+
+void tq_get_stats (int chan, struct tq_stats_s *st)
+{
+	int p;
+
+	assert (chan >= 0 && chan < MAX_CHANS);
+
+	dw_mutex_lock (&(tq_mutex[chan]));
+	*st = stats[chan];
+	for (p = 0; p < TQ_NUM_PRIO; p++) {
+	  st->depth[p] = queue_count[chan][p];
+	}
+	dw_mutex_unlock (&(tq_mutex[chan]));
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        tq_print_stats
+ *
+ * Purpose:     Print transmit queue statistics for one channel.
+ *
+ * Inputs:	chan	- Channel, 0 is first.
+ *
+ * Description:	This is called along with the audio statistics, "-a" option.
+ *		Nothing is printed if nothing has been transmitted since last time.
+ *
+ *		If packets are spending a long time waiting in the queue,
+ *		the radio channel is the bottleneck.
+ *
+ *--------------------------------------------------------------------*/
+
+void tq_print_stats (int chan)
+{
+	struct tq_stats_s st;
+	int p, b, total;
+
+	assert (chan >= 0 && chan < MAX_CHANS);
+
+	tq_get_stats (chan, &st);
+
+	total = st.removed[TQ_PRIO_0_HI] + st.removed[TQ_PRIO_1_LO];
+	if (total == stats_last_printed[chan]) {
+	  return;
+	}
+	stats_last_printed[chan] = total;
+
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("Transmit queue CH%d:", chan);
+	for (b = 0; b < TQ_WAIT_NUM_BUCKETS - 1; b++) {
+	  dw_printf (" <%gs", wait_limit[b]);
+	}
+	dw_printf (" more\n");
+
+	for (p = 0; p < TQ_NUM_PRIO; p++) {
+	  dw_printf ("  %s  ", p == TQ_PRIO_0_HI ? "HI" : "LO");
+	  for (b = 0; b < TQ_WAIT_NUM_BUCKETS; b++) {
+	    dw_printf (" %d", st.wait_hist[p][b]);
+	  }
+	  dw_printf (",  sent %d, avg wait %.2f, max %.2f sec, depth %d, max %d, discarded %d\n",
+		st.removed[p], st.removed[p] > 0 ? st.wait_total[p] / st.removed[p] : 0.,
+		st.wait_max[p], st.depth[p], st.max_depth[p], st.discarded[p]);
+	}
+}
+
 /* end tq.c */
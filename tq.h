@@ -11,7 +11,8 @@
 #define TQ_H 1
 
 #include "ax25_pad.h"
-#include "audio.h"
+
+struct audio_s;				/* audio.h includes this file. */
 
 #define TQ_NUM_PRIO 2				/* Number of priorities. */
 
@@ -19,17 +20,59 @@
 #define TQ_PRIO_1_LO 1
 
 
+/*
+ * Which part of the application put the packet in the queue.
+ * Used for limiting the queue length and for statistics.
+ */
+
+enum tq_src_e { TQ_SRC_OTHER = 0, TQ_SRC_BEACON, TQ_SRC_DIGI, TQ_SRC_IGATE, 
+		TQ_SRC_KISS, TQ_SRC_AGW, TQ_SRC_APRSTT };
+
+#define TQ_NUM_SRC 7
+
+
+/*
+ * Histogram of time packets spent waiting in the queue.
+ * Upper limits of the buckets are in tq.c.  The last catches everything longer.
+ */
+
+#define TQ_WAIT_NUM_BUCKETS 9
+
+struct tq_stats_s {
+
+	int depth[TQ_NUM_PRIO];			/* Number in queue now. */
+	int max_depth[TQ_NUM_PRIO];		/* Largest number seen. */
+
+	int appended[TQ_NUM_PRIO];		/* Total added. */
+	int removed[TQ_NUM_PRIO];		/* Total taken out for transmission. */
+	int discarded[TQ_NUM_PRIO];		/* Rejected because a limit was reached. */
+
+	int from_src[TQ_NUM_SRC];		/* Total added by each source. */
+
+	int wait_hist[TQ_NUM_PRIO][TQ_WAIT_NUM_BUCKETS];
+	double wait_total[TQ_NUM_PRIO];		/* Seconds.  Divide by removed for average. */
+	double wait_max[TQ_NUM_PRIO];
+};
+
 
 void tq_init (struct audio_s *audio_config_p);
 
-void tq_append (int chan, int prio, packet_t pp);
+void tq_append (int chan, int prio, int src, packet_t pp);
 
 void tq_wait_while_empty (int chan);
 
 packet_t tq_remove (int chan, int prio);
 
+packet_t tq_peek (int chan, int prio);
+
 int tq_count (int chan, int prio);
 
+const char *tq_src_name (int src);
+
+void tq_get_stats (int chan, struct tq_stats_s *stats);
+
+void tq_print_stats (int chan);
+
 #endif
 
 /* end tq.h */
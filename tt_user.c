@@ -913,7 +913,7 @@ static void xmit_object_report (int i, int first_time)
 
 	  dedupe_remember (pp, save_tt_config_p->obj_xmit_chan);
 
-	  tq_append (save_tt_config_p->obj_xmit_chan, TQ_PRIO_1_LO, pp);
+	  tq_append (save_tt_config_p->obj_xmit_chan, TQ_PRIO_1_LO, TQ_SRC_APRSTT, pp);
 	}
 	else {
 	  ax25_delete (pp);
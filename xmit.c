@@ -102,14 +102,41 @@ static int xmit_bits_per_sec[MAX_CHANS];	/* Data transmission rate. */
 					/* this case but could be different with other */
 					/* modulation techniques. */
 
+static int xmit_max_burst[MAX_CHANS];	/* Maximum time, in mSec, for one transmission */
+					/* when combining queued frames.  0 to disable. */
+
+static int xmit_digi_latency[MAX_CHANS];	/* Low priority frames are not added to a burst */
+					/* beyond this many mSec so digipeated frames */
+					/* arriving meanwhile don't wait too long. */
+					/* 0 for no limit other than above. */
+
 static int g_debug_xmit_packet;		/* print packet in hexadecimal form for debugging. */
 
 
+/*
+ * Airtime efficiency for each channel:  payload bits over total time the
+ * transmitter was on.  Only the transmit thread for the channel updates these.
+ */
+
+static struct {
+	int transmissions;
+	int frames;
+	double payload_bits;		/* Frame contents, not counting flags, CRC, bit stuffing. */
+	double keyed_sec;		/* Time from PTT on to PTT off. */
+	int last_printed;		/* transmissions when last printed. */
+} airtime[MAX_CHANS];
+
+
 
 #define BITS_TO_MS(b,ch) (((b)*1000)/xmit_bits_per_sec[(ch)])
 
 #define MS_TO_BITS(ms,ch) (((ms)*xmit_bits_per_sec[(ch)])/1000)
 
+/* Upper limit for bits to send frame of length n, including CRC, worst case */
+/* bit stuffing, and closing flag. */
+
+#define FRAME_BITS_MAX(n) ((((n)+2)*8*6)/5 + 8)
+
 
 #if __WIN32__
 static unsigned __stdcall xmit_thread (void *arg);
@@ -130,6 +157,7 @@ static dw_mutex_t audio_out_dev_mutex[MAX_ADEVS];
 
 static int wait_for_clear_channel (int channel, int nowait, int slotttime, int persist);
 static void xmit_ax25_frames (int c, int p, packet_t pp);
+static int burst_next_prio (int c, int num_bits, int post_bits);
 static void xmit_speech (int c, packet_t pp);
 static void xmit_morse (int c, packet_t pp, int wpm);
 
@@ -207,6 +235,9 @@ void xmit_init (struct audio_s *p_modem, int debug_xmit_packet)
 	  xmit_persist[j] = p_modem->achan[j].persist;
 	  xmit_txdelay[j] = p_modem->achan[j].txdelay;
 	  xmit_txtail[j] = p_modem->achan[j].txtail;
+	  xmit_max_burst[j] = p_modem->achan[j].max_burst;
+	  xmit_digi_latency[j] = p_modem->achan[j].digi_latency;
+	  memset (&(airtime[j]), 0, sizeof(airtime[j]));
 	}
 
 #if DEBUG
@@ -498,6 +529,12 @@ static void * xmit_thread (void *arg)
 		  ax25_delete (pp);
 
 		} /* wait for clear channel. */
+
+/*
+ * Start over with the high priority queue so anything that
+ * arrived there while we were busy doesn't wait behind the low priority packets.
+ */
+		break;
 	    } /* for high priority then low priority */
 	  }
 	}
@@ -560,6 +597,15 @@ static void * xmit_thread (void *arg)
  *		we try setting the maximum number automatically.
  *		1 for digipeated frames, 7 for others.
  *
+ * Version 1.4:	On a busy digipeater, most of the time can be taken up by
+ *		TXDELAY for each separate transmission.  When MAXBURST is
+ *		configured, we keep adding frames, high priority first,
+ *		as long as the whole transmission can be kept under that
+ *		time.  Low priority frames are added only while under the 
+ *		DIGILATENCY time so a digipeated frame, arriving while we are
+ *		transmitting, is not held up too long.
+ *		Without MAXBURST it works the same as before.
+ *
  *--------------------------------------------------------------------*/
 
 
@@ -580,6 +626,8 @@ static void xmit_ax25_frames (int c, int p, packet_t pp)
 
 	int maxframe;		/* Maximum number of frames for one transmission. */
 	int numframe;		/* Number of frames sent during this transmission. */
+	int payload_bits;	/* Frame contents, for airtime efficiency. */
+	int np;			/* Priority of additional frame. */
 
 /*
  * These are for timing of a transmission.
@@ -645,6 +693,7 @@ static void xmit_ax25_frames (int c, int p, packet_t pp)
 	nb = hdlc_send_frame (c, fbuf, flen);
 	num_bits += nb;
 	numframe = 1;
+	payload_bits = flen * 8;
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
 	dw_printf ("xmit_thread: flen=%d, nb=%d, num_bits=%d, numframe=%d\n", flen, nb, num_bits, numframe);
@@ -655,17 +704,30 @@ static void xmit_ax25_frames (int c, int p, packet_t pp)
  * Additional packets if available and not exceeding max.
  */
 
-	while (numframe < maxframe && tq_count (c,p) > 0) {
+	post_flags = MS_TO_BITS(xmit_txtail[c] * 10, c) / 8;
+
+	while (1) {
+
+	  if (xmit_max_burst[c] > 0) {
+	    np = burst_next_prio (c, num_bits, post_flags * 8);
+	    if (np < 0) break;
+	  }
+	  else {
+	    np = p;
+	    if (numframe >= maxframe || tq_count (c,p) == 0) break;
+	  }
 
-	  pp = tq_remove (c, p);
+	  pp = tq_remove (c, np);
 #if DEBUG
 	 text_color_set(DW_COLOR_DEBUG);
-	 dw_printf ("xmit_thread: tq_remove(chan=%d, prio=%d) returned %p\n", c, p, pp);
+	 dw_printf ("xmit_thread: tq_remove(chan=%d, prio=%d) returned %p\n", c, np, pp);
 #endif
+	 if (pp == NULL) break;
+
 	 ax25_format_addrs (pp, stemp);
 	 info_len = ax25_get_info (pp, &pinfo);
 	 text_color_set(DW_COLOR_XMIT);
-	 dw_printf ("[%d%c] ", c, p==TQ_PRIO_0_HI ? 'H' : 'L');
+	 dw_printf ("[%d%c] ", c, np==TQ_PRIO_0_HI ? 'H' : 'L');
 	 dw_printf ("%s", stemp);			/* stations followed by : */
 	 ax25_safe_print ((char *)pinfo, info_len, ! ax25_is_aprs(pp));
 	 dw_printf ("\n");
@@ -686,6 +748,7 @@ static void xmit_ax25_frames (int c, int p, packet_t pp)
 	  nb = hdlc_send_frame (c, fbuf, flen);
 	  num_bits += nb;
 	  numframe++;
+	  payload_bits += flen * 8;
 #if DEBUG
 	  text_color_set(DW_COLOR_DEBUG);
 	  dw_printf ("xmit_thread: flen=%d, nb=%d, num_bits=%d, numframe=%d\n", flen, nb, num_bits, numframe);
@@ -697,7 +760,6 @@ static void xmit_ax25_frames (int c, int p, packet_t pp)
  * Need TXTAIL because we don't know exactly when the sound is done.
  */
 
-	post_flags = MS_TO_BITS(xmit_txtail[c] * 10, c) / 8;
 	nb = hdlc_send_flags (c, post_flags, 1);
 	num_bits += nb;
 #if DEBUG
@@ -766,9 +828,123 @@ static void xmit_ax25_frames (int c, int p, packet_t pp)
 		
 	ptt_set (OCTYPE_PTT, c, 0);
 
+	airtime[c].transmissions++;
+	airtime[c].frames += numframe;
+	airtime[c].payload_bits += payload_bits;
+	airtime[c].keyed_sec += dtime_now() - time_ptt;
+
 } /* end xmit_ax25_frames */
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        burst_next_prio
+ *
+ * Purpose:     Decide whether another queued frame can be added to
+ *		the current transmission.
+ *
+ * Inputs:	c		- Channel number.
+ *
+ *		num_bits	- Bits already in this transmission, 
+ *				  including TXDELAY flags.
+ *
+ *		post_bits	- Bits that will be needed for TXTAIL.
+ *
+ * Returns:	Priority of the queue to take the next frame from,
+ *		or -1 if nothing should be added.
+ *
+ * Description:	The high priority queue is always considered first.
+ *		If its first frame won't fit, we stop rather than letting
+ *		a low priority frame get ahead of it.
+ *
+ *		Packets for SPEECH or MORSE also end the burst so they
+ *		are sent the usual way, not as HDLC frames.
+ *
+ *--------------------------------------------------------------------*/
+
+static int burst_next_prio (int c, int num_bits, int post_bits)
+{
+	int p;
+
+	for (p = 0; p < TQ_NUM_PRIO; p++) {
+	  packet_t pp;
+	  unsigned char fbuf[AX25_MAX_PACKET_LEN+2];
+	  int flen;
+
+	  if (p != TQ_PRIO_0_HI && xmit_digi_latency[c] > 0 && 
+			BITS_TO_MS(num_bits, c) >= xmit_digi_latency[c]) {
+	    return (-1);
+	  }
+
+	  pp = tq_peek (c, p);
+	  if (pp == NULL) {
+	    continue;
+	  }
+
+	  if (ax25_is_aprs (pp)) {
+	    char dest[AX25_MAX_ADDR_LEN];
+
+	    ax25_get_addr_no_ssid(pp, AX25_DESTINATION, dest);
+	    if (strcmp(dest, "SPEECH") == 0 || strcmp(dest, "MORSE") == 0) {
+	      return (-1);		/* Not an HDLC frame.  Leave it for xmit_thread. */
+	    }
+	  }
+
+	  flen = ax25_pack (pp, fbuf);
+	  if (BITS_TO_MS(num_bits + FRAME_BITS_MAX(flen) + post_bits, c) > xmit_max_burst[c]) {
+	    return (-1);
+	  }
+	  return (p);
+	}
+
+	return (-1);
+
+} /* end burst_next_prio */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        xmit_print_stats
+ *
+ * Purpose:     Print airtime efficiency for one channel.
+ *
+ * Inputs:	chan	- Channel number.
+ *
+ * Description:	This is called along with the audio statistics, "-a" option.
+ *		Nothing is printed if there were no transmissions since last time.
+ *
+ *		Efficiency is the frame contents, in bits, divided by the
+ *		total time the transmitter was on.  The difference is
+ *		TXDELAY, TXTAIL, flags, CRC, and bit stuffing.
+ *		Sending several frames in one transmission, see MAXBURST,
+ *		should improve this.
+ *
+ *--------------------------------------------------------------------*/
+
+void xmit_print_stats (int chan)
+{
+	double eff;
+
+	if (chan < 0 || chan >= MAX_CHANS || ! save_audio_config_p->achan[chan].valid) {
+	  return;
+	}
+	if (airtime[chan].transmissions == airtime[chan].last_printed) {
+	  return;
+	}
+	airtime[chan].last_printed = airtime[chan].transmissions;
+
+	eff = 0;
+	if (airtime[chan].keyed_sec > 0 && xmit_bits_per_sec[chan] > 0) {
+	  eff = 100. * airtime[chan].payload_bits / (airtime[chan].keyed_sec * xmit_bits_per_sec[chan]);
+	}
+
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("Airtime CH%d: %d transmissions, %d frames, %.1f sec keyed, %.0f payload bits, efficiency %.1f%%\n",
+		chan, airtime[chan].transmissions, airtime[chan].frames,
+		airtime[chan].keyed_sec, airtime[chan].payload_bits, eff);
+}
+
+
 
 /*-------------------------------------------------------------------
  *
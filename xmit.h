@@ -17,6 +17,8 @@ extern void xmit_set_slottime (int channel, int value);
 extern void xmit_set_txtail (int channel, int value);
 
 
+extern void xmit_print_stats (int chan);
+
 extern int xmit_speak_it (char *script, int c, char *msg);
 
 #endif